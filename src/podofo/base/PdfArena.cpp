@@ -0,0 +1,257 @@
+/***************************************************************************
+ *   Copyright (C) 2006 by Dominik Seichter                                *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ *                                                                         *
+ *   In addition, as a special exception, the copyright holders give       *
+ *   permission to link the code of portions of this program with the      *
+ *   OpenSSL library under certain conditions as described in each         *
+ *   individual source file, and distribute linked combinations            *
+ *   including the two.                                                    *
+ *   You must obey the GNU General Public License in all respects          *
+ *   for all of the code used other than OpenSSL.  If you modify           *
+ *   file(s) with this exception, you may extend this exception to your    *
+ *   version of the file(s), but you are not obligated to do so.  If you   *
+ *   do not wish to do so, delete this exception statement from your       *
+ *   version.  If you delete this exception statement from all source      *
+ *   files in the program, then also delete it here.                       *
+ ***************************************************************************/
+
+#include "PdfArena.h"
+#include "PdfDefinesPrivate.h"
+
+#include "util/PdfMutexWrapper.h"
+
+#include <new>
+
+#if defined(PODOFO_MULTI_THREAD)
+#  if defined(_MSC_VER)
+#    define PODOFO_THREAD_LOCAL __declspec(thread)
+#  else
+#    define PODOFO_THREAD_LOCAL __thread
+#  endif
+#else
+#  define PODOFO_THREAD_LOCAL
+#endif
+
+namespace PoDoFo {
+
+/** Prepended to every block returned by PdfArena::Allocate.
+ *  Holds the arena of the block or NULL if the block
+ *  was allocated from the heap.
+ */
+union TArenaBlockHeader {
+    PdfArena* pArena;
+    double    dAlign;
+};
+
+/** The innermost PdfArenaScope of the current thread
+ */
+static PODOFO_THREAD_LOCAL PdfArenaScope* s_pCurrentScope = NULL;
+
+/** The size of a block for nSize bytes including its header
+ */
+static inline size_t GetBlockSize( size_t nSize )
+{
+    return sizeof(TArenaBlockHeader) + ((nSize + 7) & ~static_cast<size_t>(7));
+}
+
+PdfArena::PdfArena( size_t nChunkSize )
+    : m_nChunkSize( nChunkSize ), m_nSize( 0 ), m_pCurrent( NULL ), m_pEnd( NULL ),
+      m_pMutex( new Util::PdfMutex() )
+{
+    for( int i = 0; i < PODOFO_ARENA_FREE_LISTS; i++ )
+        m_apFree[i] = NULL;
+}
+
+PdfArena::~PdfArena()
+{
+    Clear();
+    delete m_pMutex;
+}
+
+void PdfArena::Clear()
+{
+    Util::PdfMutexWrapper wrapper( *m_pMutex );
+
+    for( size_t i = 0; i < m_vecChunks.size(); i++ )
+        podofo_free( m_vecChunks[i] );
+
+    m_vecChunks.clear();
+    m_nSize    = 0;
+    m_pCurrent = NULL;
+    m_pEnd     = NULL;
+
+    for( int i = 0; i < PODOFO_ARENA_FREE_LISTS; i++ )
+        m_apFree[i] = NULL;
+}
+
+PdfArena* PdfArena::GetCurrent()
+{
+    return s_pCurrentScope ? s_pCurrentScope->m_pArena : NULL;
+}
+
+void* PdfArena::Allocate( size_t nSize )
+{
+    size_t             nBlockSize = GetBlockSize( nSize );
+    PdfArenaScope*     pScope     = s_pCurrentScope;
+    TArenaBlockHeader* pHeader;
+
+    if( pScope )
+    {
+        pHeader = static_cast<TArenaBlockHeader*>(pScope->Allocate( nBlockSize ));
+        pHeader->pArena = pScope->m_pArena;
+    }
+    else
+    {
+        pHeader = static_cast<TArenaBlockHeader*>(::operator new( nBlockSize ));
+        pHeader->pArena = NULL;
+    }
+
+    return pHeader + 1;
+}
+
+void PdfArena::Free( void* pMemory, size_t nSize )
+{
+    if( !pMemory )
+        return;
+
+    TArenaBlockHeader* pHeader = static_cast<TArenaBlockHeader*>(pMemory) - 1;
+    if( !pHeader->pArena )
+    {
+        ::operator delete( pHeader );
+        return;
+    }
+
+    // Otherwise the memory is released together with its arena
+    PdfArenaScope* pScope = s_pCurrentScope;
+    if( pScope && pScope->m_pArena == pHeader->pArena )
+        pScope->Free( pHeader, GetBlockSize( nSize ) );
+}
+
+char* PdfArena::AllocateChunk( size_t nSize )
+{
+    Util::PdfMutexWrapper wrapper( *m_pMutex );
+
+    m_vecChunks.reserve( m_vecChunks.size() + 1 );
+    char* pChunk = static_cast<char*>(podofo_malloc( nSize ));
+    if( !pChunk )
+        throw std::bad_alloc();
+
+    m_vecChunks.push_back( pChunk );
+    m_nSize += nSize;
+
+    return pChunk;
+}
+
+void PdfArena::AcquireSpace( PdfArenaScope* pScope )
+{
+    Util::PdfMutexWrapper wrapper( *m_pMutex );
+
+    pScope->m_pCurrent = m_pCurrent;
+    pScope->m_pEnd     = m_pEnd;
+    m_pCurrent         = NULL;
+    m_pEnd             = NULL;
+
+    for( int i = 0; i < PODOFO_ARENA_FREE_LISTS; i++ )
+    {
+        pScope->m_apFree[i] = m_apFree[i];
+        m_apFree[i]         = NULL;
+    }
+}
+
+void PdfArena::ReleaseSpace( PdfArenaScope* pScope )
+{
+    Util::PdfMutexWrapper wrapper( *m_pMutex );
+
+    // Scopes on several threads may release their space,
+    // so only the largest one is kept
+    if( pScope->m_pEnd - pScope->m_pCurrent > m_pEnd - m_pCurrent )
+    {
+        m_pCurrent = pScope->m_pCurrent;
+        m_pEnd     = pScope->m_pEnd;
+    }
+
+    // The deleted blocks are kept likewise, unless another
+    // thread has released its blocks already
+    for( int i = 0; i < PODOFO_ARENA_FREE_LISTS; i++ )
+    {
+        if( !m_apFree[i] )
+            m_apFree[i] = pScope->m_apFree[i];
+    }
+}
+
+PdfArenaScope::PdfArenaScope( PdfArena* pArena )
+    : m_pArena( pArena ), m_pPrevious( s_pCurrentScope ), m_bInstalled( false ),
+      m_pCurrent( NULL ), m_pEnd( NULL )
+{
+    // A nested scope of the same arena shares the state of the outer scope
+    if( !m_pArena || (m_pPrevious && m_pPrevious->m_pArena == m_pArena) )
+        return;
+
+    m_pArena->AcquireSpace( this );
+
+    s_pCurrentScope = this;
+    m_bInstalled    = true;
+}
+
+PdfArenaScope::~PdfArenaScope()
+{
+    if( m_bInstalled )
+    {
+        m_pArena->ReleaseSpace( this );
+        s_pCurrentScope = m_pPrevious;
+    }
+}
+
+void* PdfArenaScope::Allocate( size_t nSize )
+{
+    size_t nList = nSize / 8 - 1;
+    if( nList < PODOFO_ARENA_FREE_LISTS && m_apFree[nList] )
+    {
+        void* pBlock   = m_apFree[nList];
+        m_apFree[nList] = *static_cast<void**>(pBlock);
+        return pBlock;
+    }
+
+    if( static_cast<size_t>(m_pEnd - m_pCurrent) < nSize )
+    {
+        // Large blocks get a chunk of their own, so that
+        // the free space of the current chunk is not wasted
+        if( nSize > m_pArena->m_nChunkSize / 4 )
+            return m_pArena->AllocateChunk( nSize );
+
+        m_pCurrent = m_pArena->AllocateChunk( m_pArena->m_nChunkSize );
+        m_pEnd     = m_pCurrent + m_pArena->m_nChunkSize;
+    }
+
+    void* pBlock = m_pCurrent;
+    m_pCurrent += nSize;
+    return pBlock;
+}
+
+void PdfArenaScope::Free( void* pBlock, size_t nSize )
+{
+    size_t nList = nSize / 8 - 1;
+    if( nList < PODOFO_ARENA_FREE_LISTS )
+    {
+        *static_cast<void**>(pBlock) = m_apFree[nList];
+        m_apFree[nList] = pBlock;
+    }
+}
+
+};
@@ -0,0 +1,216 @@
+/***************************************************************************
+ *   Copyright (C) 2006 by Dominik Seichter                                *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ *                                                                         *
+ *   In addition, as a special exception, the copyright holders give       *
+ *   permission to link the code of portions of this program with the      *
+ *   OpenSSL library under certain conditions as described in each         *
+ *   individual source file, and distribute linked combinations            *
+ *   including the two.                                                    *
+ *   You must obey the GNU General Public License in all respects          *
+ *   for all of the code used other than OpenSSL.  If you modify           *
+ *   file(s) with this exception, you may extend this exception to your    *
+ *   version of the file(s), but you are not obligated to do so.  If you   *
+ *   do not wish to do so, delete this exception statement from your       *
+ *   version.  If you delete this exception statement from all source      *
+ *   files in the program, then also delete it here.                       *
+ ***************************************************************************/
+
+#ifndef _PDF_ARENA_H_
+#define _PDF_ARENA_H_
+
+#include "PdfDefines.h"
+#include "util/PdfMutex.h"
+
+namespace PoDoFo {
+
+class PdfArenaScope;
+
+/** Number of free lists of a PdfArenaScope.
+ *  Blocks of up to PODOFO_ARENA_FREE_LISTS * 8 bytes
+ *  are recycled while parsing.
+ */
+#define PODOFO_ARENA_FREE_LISTS 64
+
+/** A memory arena for the objects of a parsed document.
+ *
+ *  PdfObject and all PdfDataType subclasses (PdfDictionary, 
+ *  PdfArray, PdfName, PdfString, ...) are allocated
+ *  from the arena of the current thread's PdfArenaScope.
+ *  Without a PdfArenaScope they are allocated from the heap.
+ *
+ *  The arena hands out memory from large chunks. Memory of
+ *  deleted objects is only reused while a PdfArenaScope of the
+ *  arena is active on the deleting thread; otherwise it is released
+ *  all at once by Clear() or the destructor. All objects allocated
+ *  from the arena must have been deleted before the arena is cleared.
+ *
+ *  The free space of the current chunk and the deleted blocks
+ *  are kept by the arena when a PdfArenaScope ends, so that the
+ *  next scope, e.g. for loading an object on demand, continues
+ *  to use them instead of starting a new chunk.
+ *
+ *  PdfParser allocates parsed objects from the arena set with
+ *  PdfParser::SetArena. PdfMemDocument owns an arena if
+ *  PdfMemDocument::SetUseArena was called.
+ *
+ *  Memory owned by the objects themselves, e.g. the buffer of a 
+ *  PdfString or the nodes of a PdfDictionary, is not allocated
+ *  from the arena.
+ */
+class PODOFO_API PdfArena {
+    friend class PdfArenaScope;
+
+ public:
+    /** Create a new, empty arena.
+     *
+     *  \param nChunkSize size in bytes of the chunks, which are
+     *                    allocated from the heap
+     */
+    PdfArena( size_t nChunkSize = 65536 );
+
+    /** Release all memory of the arena.
+     */
+    ~PdfArena();
+
+    /** Release all memory of the arena at once.
+     *  
+     *  No object allocated from this arena may be alive
+     *  and no PdfArenaScope of this arena may be active.
+     */
+    void Clear();
+
+    /** 
+     *  \returns the number of bytes allocated from the heap by this arena
+     */
+    inline size_t GetSize() const;
+
+    /** 
+     *  \returns the arena of the current thread's PdfArenaScope or NULL
+     */
+    static PdfArena* GetCurrent();
+
+    /** Allocate memory from the arena of the current thread's 
+     *  PdfArenaScope or from the heap if there is none.
+     *
+     *  \param nSize number of bytes to allocate
+     *  \returns a pointer to the memory. std::bad_alloc is thrown
+     *           if no memory is available.
+     *
+     *  \see Free
+     */
+    static void* Allocate( size_t nSize );
+
+    /** Free memory allocated with Allocate.
+     *
+     *  \param pMemory memory returned by Allocate or NULL
+     *  \param nSize the size passed to Allocate
+     */
+    static void Free( void* pMemory, size_t nSize );
+
+ private:
+    /** Allocate a new chunk from the heap.
+     *  This method is thread safe.
+     *
+     *  \param nSize size of the chunk in bytes
+     */
+    char* AllocateChunk( size_t nSize );
+
+    /** Hand the free space of the current chunk and the
+     *  deleted blocks kept by the arena over to a new scope.
+     *  This method is thread safe.
+     *
+     *  \param pScope the scope which is installed
+     */
+    void AcquireSpace( PdfArenaScope* pScope );
+
+    /** Give the free space and the deleted blocks of a scope
+     *  which ends back to the arena.
+     *  This method is thread safe.
+     *
+     *  \param pScope the scope which is removed
+     */
+    void ReleaseSpace( PdfArenaScope* pScope );
+
+    // Prevent use of copy constructor and assignment operator.
+    PdfArena( const PdfArena & );
+    PdfArena & operator=( const PdfArena & );
+
+ private:
+    std::vector<char*> m_vecChunks;
+    size_t             m_nChunkSize;
+    size_t             m_nSize;
+    char*              m_pCurrent; ///< Free space of the current chunk,
+    char*              m_pEnd;     ///< which is not used by any PdfArenaScope
+    Util::PdfMutex*    m_pMutex;   ///< Guards all members but m_nChunkSize
+
+    void*              m_apFree[PODOFO_ARENA_FREE_LISTS]; ///< Deleted blocks of ended scopes
+};
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+size_t PdfArena::GetSize() const
+{
+    return m_nSize;
+}
+
+/** As long as a PdfArenaScope exists, PdfObjects and PdfDataTypes 
+ *  created by the same thread are allocated from its arena.
+ *
+ *  Scopes can be nested; the innermost scope is used. Each thread 
+ *  which allocates from the same arena needs its own PdfArenaScope.
+ *
+ *  A PdfArenaScope is usually created on the stack.
+ */
+class PODOFO_API PdfArenaScope {
+    friend class PdfArena;
+
+ public:
+    /** Allocate objects from pArena on the current thread
+     *  until the scope is destroyed.
+     *
+     *  \param pArena an arena or NULL in which case the 
+     *                scope has no effect
+     */
+    PdfArenaScope( PdfArena* pArena );
+
+    ~PdfArenaScope();
+
+ private:
+    void* Allocate( size_t nSize );
+    void  Free( void* pBlock, size_t nSize );
+
+    // Prevent use of copy constructor and assignment operator.
+    PdfArenaScope( const PdfArenaScope & );
+    PdfArenaScope & operator=( const PdfArenaScope & );
+
+ private:
+    PdfArena*      m_pArena;
+    PdfArenaScope* m_pPrevious;
+    bool           m_bInstalled;
+
+    char*          m_pCurrent; ///< Free space of the current chunk
+    char*          m_pEnd;
+
+    void*          m_apFree[PODOFO_ARENA_FREE_LISTS]; ///< Deleted blocks by size
+};
+
+};
+
+#endif // _PDF_ARENA_H_
@@ -0,0 +1,1482 @@
+/***************************************************************************
+ *   Copyright (C) 2007 by Dominik Seichter                                *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ *                                                                         *
+ *   In addition, as a special exception, the copyright holders give       *
+ *   permission to link the code of portions of this program with the      *
+ *   OpenSSL library under certain conditions as described in each         *
+ *   individual source file, and distribute linked combinations            *
+ *   including the two.                                                    *
+ *   You must obey the GNU General Public License in all respects          *
+ *   for all of the code used other than OpenSSL.  If you modify           *
+ *   file(s) with this exception, you may extend this exception to your    *
+ *   version of the file(s), but you are not obligated to do so.  If you   *
+ *   do not wish to do so, delete this exception statement from your       *
+ *   version.  If you delete this exception statement from all source      *
+ *   files in the program, then also delete it here.                       *
+ ***************************************************************************/
+
+
+#include "PdfCMap.h"
+
+#include "PdfDefinesPrivate.h"
+
+#include "PdfDictionary.h"
+#include "PdfInputStream.h"
+#include "PdfName.h"
+#include "PdfObject.h"
+#include "PdfStream.h"
+#include "PdfString.h"
+#include "PdfTokenizer.h"
+#include "util/PdfMutexWrapper.h"
+
+#include <string.h>
+
+/** Maximum number of streams referring to each other using /UseCMap
+ */
+#define PDF_CMAP_MAX_DEPTH 8
+
+/** Maximum length of a destination string in bytes
+ */
+#define PDF_CMAP_MAX_STRING 512
+
+namespace PoDoFo {
+
+namespace {
+
+/** A codespace range of codes with 1 to 4 bytes,
+ *  where every byte of a code has to be in the range
+ *  of the corresponding bytes of cLow and cHigh.
+ */
+struct TCodeSpaceRange {
+    int           nBytes;
+    unsigned char cLow[4];
+    unsigned char cHigh[4];
+};
+
+/** A range of codes mapped to consecutive unicode strings or CIDs.
+ *
+ *  A code nCode in the range is mapped to the unicode string nLength
+ *  values long at position nValue in the pool, where
+ *  nDelta + (nCode - nFirst) is added to the last value of the string.
+ *  A code is mapped to the CID nDelta + (nCode - nFirst), 
+ *  codes in notdef ranges are all mapped to the CID nDelta.
+ */
+struct TCodeRange {
+    pdf_uint32 nFirst;
+    pdf_uint32 nLast;
+    pdf_uint32 nValue;
+    pdf_uint32 nDelta;
+    pdf_uint32 nLength;
+};
+
+typedef std::vector<TCodeSpaceRange>    TVecCodeSpaceRanges;
+typedef std::vector<TCodeRange>         TVecCodeRanges;
+typedef std::map<pdf_uint32,TCodeRange> TMapCodeRanges;
+
+enum ECMapTokenType {
+    eCMapTokenType_HexString,
+    eCMapTokenType_String,
+    eCMapTokenType_Name,
+    eCMapTokenType_ArrayStart,
+    eCMapTokenType_ArrayEnd,
+    eCMapTokenType_Keyword
+};
+
+struct TCMapToken {
+    ECMapTokenType eType;
+    const char*    pszStart; ///< Start of the token without delimiters
+    pdf_long       lLen;     ///< Length of the token without delimiters
+};
+
+/** The sections of a CMap containing mappings
+ */
+enum ECMapSection {
+    eCMapSection_None,
+    eCMapSection_CodeSpaceRange,
+    eCMapSection_BfChar,
+    eCMapSection_BfRange,
+    eCMapSection_CidChar,
+    eCMapSection_CidRange,
+    eCMapSection_NotDefChar,
+    eCMapSection_NotDefRange
+};
+
+inline pdf_utf16be ToBigEndian( pdf_utf16be nValue )
+{
+#ifdef PODOFO_IS_LITTLE_ENDIAN
+    return static_cast<pdf_utf16be>(((nValue & 0xff00) >> 8) | ((nValue & 0xff) << 8));
+#else
+    return nValue;
+#endif // PODOFO_IS_LITTLE_ENDIAN
+}
+
+/** Find the range containing a code using a binary search
+ *
+ *  \returns the range or NULL if no range contains the code
+ */
+inline const TCodeRange* FindRange( const TVecCodeRanges & rvecRanges, pdf_uint32 nCode )
+{
+    // Find the first range starting after nCode,
+    // only the range before it can contain nCode
+    size_t nLow  = 0;
+    size_t nHigh = rvecRanges.size();
+    while( nLow < nHigh ) 
+    {
+        size_t nMid = nLow + (nHigh - nLow) / 2;
+        if( rvecRanges[nMid].nFirst <= nCode )
+            nLow = nMid + 1;
+        else
+            nHigh = nMid;
+    }
+
+    if( !nLow || nCode > rvecRanges[nLow-1].nLast )
+        return NULL;
+
+    return &rvecRanges[nLow-1];
+}
+
+inline bool IsInCodeSpaceRange( const TCodeSpaceRange & rRange, const unsigned char* pData )
+{
+    for( int i=0;i<rRange.nBytes;i++ ) 
+    {
+        if( pData[i] < rRange.cLow[i] || pData[i] > rRange.cHigh[i] )
+            return false;
+    }
+
+    return true;
+}
+
+/** Add a range to the ranges of a CMap being parsed,
+ *  the range replaces the mappings of all codes it contains.
+ *
+ *  \param rmapRanges existing ranges which do not overlap each other
+ *  \param rRange the new range
+ *  \param bIncrement true if the values of the range increment
+ *                    with every code, false for notdef ranges
+ */
+void InsertRange( TMapCodeRanges & rmapRanges, const TCodeRange & rRange, bool bIncrement )
+{
+    TMapCodeRanges::iterator it = rmapRanges.upper_bound( rRange.nFirst );
+    if( it != rmapRanges.begin() )
+        --it;
+
+    while( it != rmapRanges.end() && (*it).second.nFirst <= rRange.nLast )
+    {
+        TCodeRange existing = (*it).second;
+        if( existing.nLast < rRange.nFirst ) 
+        {
+            ++it;
+            continue;
+        }
+
+        rmapRanges.erase( it++ );
+
+        // Keep the parts of an existing range before and after the new range
+        if( existing.nFirst < rRange.nFirst ) 
+        {
+            TCodeRange before = existing;
+            before.nLast = rRange.nFirst - 1;
+            rmapRanges[before.nFirst] = before;
+        }
+
+        if( existing.nLast > rRange.nLast ) 
+        {
+            TCodeRange after = existing;
+            after.nFirst = rRange.nLast + 1;
+            if( bIncrement )
+                after.nDelta += after.nFirst - existing.nFirst;
+            rmapRanges[after.nFirst] = after;
+        }
+    }
+
+    rmapRanges[rRange.nFirst] = rRange;
+}
+
+/** Read the next token of a CMap
+ *
+ *  \param rpszPos position in the CMap, set to the end of the token
+ *  \param pszEnd the end of the CMap
+ *  \param rToken the token which was read
+ *
+ *  \returns false if the end of the CMap was reached
+ */
+bool ReadToken( const char* & rpszPos, const char* pszEnd, TCMapToken & rToken )
+{
+    const char* pszPos = rpszPos;
+
+    // Skip whitespace and comments
+    while( pszPos < pszEnd ) 
+    {
+        if( PdfTokenizer::IsWhitespace( *pszPos ) )
+            ++pszPos;
+        else if( *pszPos == '%' )
+        {
+            while( pszPos < pszEnd && *pszPos != '\r' && *pszPos != '\n' )
+                ++pszPos;
+        }
+        else
+            break;
+    }
+
+    if( pszPos >= pszEnd )
+    {
+        rpszPos = pszPos;
+        return false;
+    }
+
+    rToken.eType    = eCMapTokenType_Keyword;
+    rToken.pszStart = pszPos;
+    switch( *pszPos ) 
+    {
+        case '<':
+            if( pszPos + 1 < pszEnd && pszPos[1] == '<' ) 
+            {
+                pszPos += 2;
+                break;
+            }
+
+            rToken.eType    = eCMapTokenType_HexString;
+            rToken.pszStart = ++pszPos;
+            while( pszPos < pszEnd && *pszPos != '>' )
+                ++pszPos;
+
+            rToken.lLen = pszPos - rToken.pszStart;
+            if( pszPos < pszEnd )
+                ++pszPos;
+
+            rpszPos = pszPos;
+            return true;
+
+        case '>':
+            pszPos += ( pszPos + 1 < pszEnd && pszPos[1] == '>' ) ? 2 : 1;
+            break;
+
+        case '[':
+            rToken.eType = eCMapTokenType_ArrayStart;
+            ++pszPos;
+            break;
+
+        case ']':
+            rToken.eType = eCMapTokenType_ArrayEnd;
+            ++pszPos;
+            break;
+
+        case '(':
+        {
+            // Strings are not needed and only skipped
+            int nDepth = 1;
+            rToken.eType = eCMapTokenType_String;
+            ++pszPos;
+            while( pszPos < pszEnd && nDepth ) 
+            {
+                if( *pszPos == '\\' )
+                    ++pszPos;
+                else if( *pszPos == '(' )
+                    ++nDepth;
+                else if( *pszPos == ')' )
+                    --nDepth;
+
+                ++pszPos;
+            }
+
+            if( pszPos > pszEnd )
+                pszPos = pszEnd;
+            break;
+        }
+
+        case '/':
+            rToken.eType    = eCMapTokenType_Name;
+            rToken.pszStart = ++pszPos;
+            while( pszPos < pszEnd && !PdfTokenizer::IsWhitespace( *pszPos ) && !PdfTokenizer::IsDelimiter( *pszPos ) )
+                ++pszPos;
+            break;
+
+        default:
+            while( pszPos < pszEnd && !PdfTokenizer::IsWhitespace( *pszPos ) && !PdfTokenizer::IsDelimiter( *pszPos ) )
+                ++pszPos;
+
+            // A single delimiter like { or )
+            if( pszPos == rToken.pszStart ) 
+                ++pszPos;
+            break;
+    }
+
+    rToken.lLen = pszPos - rToken.pszStart;
+    rpszPos     = pszPos;
+    return true;
+}
+
+/** Decode the bytes of a hex string token
+ *
+ *  \param rToken a hex string token
+ *  \param pBuffer the bytes are written to this buffer
+ *  \param nBufferLen the size of the buffer
+ *
+ *  \returns the number of bytes or -1 if the string
+ *           is invalid or longer than the buffer
+ */
+int DecodeHexString( const TCMapToken & rToken, unsigned char* pBuffer, int nBufferLen )
+{
+    if( rToken.eType != eCMapTokenType_HexString )
+        return -1;
+
+    int  nLen = 0;
+    bool bLow = false;
+    for( pdf_long i=0;i<rToken.lLen;i++ ) 
+    {
+        const unsigned char c = static_cast<unsigned char>(rToken.pszStart[i]);
+        if( PdfTokenizer::IsWhitespace( c ) )
+            continue;
+
+        const int nValue = PdfTokenizer::GetHexValue( c );
+        if( nValue == static_cast<int>(PdfTokenizer::HEX_NOT_FOUND) )
+            return -1;
+
+        if( bLow ) 
+        {
+            pBuffer[nLen-1] |= static_cast<unsigned char>(nValue);
+        }
+        else
+        {
+            if( nLen == nBufferLen )
+                return -1;
+
+            // An odd number of digits is padded with a 0
+            pBuffer[nLen++] = static_cast<unsigned char>(nValue << 4);
+        }
+
+        bLow = !bLow;
+    }
+
+    return nLen;
+}
+
+/** Read a character code of 1 to 4 bytes from a hex string token
+ *
+ *  \returns the number of bytes of the code or 0 if the token is no valid code
+ */
+int ReadCodeToken( const TCMapToken & rToken, pdf_uint32* pnCode )
+{
+    unsigned char cBuffer[4];
+    const int     nLen = DecodeHexString( rToken, cBuffer, 4 );
+    if( nLen <= 0 )
+        return 0;
+
+    *pnCode = 0;
+    for( int i=0;i<nLen;i++ )
+        *pnCode = (*pnCode << 8) | cBuffer[i];
+
+    return nLen;
+}
+
+/** Read a CID from a number token
+ *
+ *  \returns false if the token is no valid CID
+ */
+bool ReadCIDToken( const TCMapToken & rToken, pdf_uint32* pnCID )
+{
+    if( rToken.eType != eCMapTokenType_Keyword || !rToken.lLen || rToken.lLen > 9 )
+        return false;
+
+    *pnCID = 0;
+    for( pdf_long i=0;i<rToken.lLen;i++ ) 
+    {
+        if( rToken.pszStart[i] < '0' || rToken.pszStart[i] > '9' )
+            return false;
+
+        *pnCID = *pnCID * 10 + (rToken.pszStart[i] - '0');
+    }
+
+    return true;
+}
+
+inline bool IsKeyword( const TCMapToken & rToken, const char* pszKeyword )
+{
+    return rToken.eType == eCMapTokenType_Keyword 
+        && static_cast<size_t>(rToken.lLen) == strlen( pszKeyword )
+        && strncmp( rToken.pszStart, pszKeyword, rToken.lLen ) == 0;
+}
+
+/** Create the sorted table of ranges of a parsed CMap,
+ *  adjacent ranges with consecutive values are merged.
+ *
+ *  \param rmapRanges the ranges
+ *  \param rvecRanges the table is written to this vector
+ *  \param pvecPool the pool of unicode strings for unicode ranges,
+ *                  NULL for CID ranges
+ *  \param bIncrement true if the values of the ranges increment
+ *                    with every code, false for notdef ranges
+ */
+void CompileRanges( const TMapCodeRanges & rmapRanges, TVecCodeRanges & rvecRanges, 
+                    const std::vector<pdf_utf16be>* pvecPool, bool bIncrement )
+{
+    rvecRanges.reserve( rmapRanges.size() );
+
+    TMapCodeRanges::const_iterator it = rmapRanges.begin();
+    while( it != rmapRanges.end() ) 
+    {
+        const TCodeRange & rRange = (*it).second;
+        if( !rvecRanges.empty() && rvecRanges.back().nLast + 1 == rRange.nFirst ) 
+        {
+            TCodeRange & rLast  = rvecRanges.back();
+            bool         bMerge = false;
+            if( !bIncrement )
+                bMerge = rLast.nDelta == rRange.nDelta;
+            else if( !pvecPool )
+                bMerge = rLast.nDelta + (rRange.nFirst - rLast.nFirst) == rRange.nDelta;
+            else if( rLast.nLength == 1 && rRange.nLength == 1 )
+                bMerge = static_cast<pdf_utf16be>((*pvecPool)[rLast.nValue] + rLast.nDelta + (rRange.nFirst - rLast.nFirst)) 
+                    == static_cast<pdf_utf16be>((*pvecPool)[rRange.nValue] + rRange.nDelta);
+
+            if( bMerge ) 
+            {
+                rLast.nLast = rRange.nLast;
+                ++it;
+                continue;
+            }
+        }
+
+        rvecRanges.push_back( rRange );
+        ++it;
+    }
+}
+
+/** Calculate the FNV-1a hash of a CMap
+ */
+pdf_uint64 HashCMap( const char* pszData, pdf_long lLen )
+{
+    const pdf_uint64 nPrime = (static_cast<pdf_uint64>(1) << 40) | 0x1b3;
+    pdf_uint64       nHash  = (static_cast<pdf_uint64>(0xcbf29ce4) << 32) | 0x84222325;
+
+    for( pdf_long i=0;i<lLen;i++ ) 
+    {
+        nHash ^= static_cast<unsigned char>(pszData[i]);
+        nHash *= nPrime;
+    }
+
+    return nHash;
+}
+
+/** 
+ *  \returns true if the codes of a predefined CMap are UCS-2 or UTF-16 
+ *           values, like the codes of UniGB-UCS2-H or UniJIS-UTF16-V
+ */
+bool IsUnicodeCMapName( const std::string & rsName, bool* pbUTF16 )
+{
+    if( rsName.compare( 0, 3, "Uni" ) != 0 )
+        return false;
+
+    *pbUTF16 = rsName.find( "-UTF16-" ) != std::string::npos;
+    return *pbUTF16 || rsName.find( "-UCS2-" ) != std::string::npos;
+}
+
+};
+
+struct PdfCMap::TCMapData {
+    std::string              m_sName;
+    TVecCodeSpaceRanges      m_vecCodeSpaces;
+    TVecCodeRanges           m_vecUnicode;    ///< Sorted bfchar and bfrange mappings
+    TVecCodeRanges           m_vecCIDs;       ///< Sorted cidchar and cidrange mappings
+    TVecCodeRanges           m_vecNotDef;     ///< Sorted notdefchar and notdefrange mappings
+    std::vector<pdf_utf16be> m_vecPool;       ///< Unicode strings of m_vecUnicode
+    int                      m_nMinCodeLen;   ///< Shortest code of all mappings in bytes
+    int                      m_nMaxCodeLen;   ///< Longest code of all mappings in bytes
+    long                     m_lRefCount;
+
+    bool                     m_bCached;       ///< True if the CMap is in the map of the PdfCMapCache
+    pdf_uint64               m_nHash;
+    std::string              m_sSource;       ///< The parsed data of a cached CMap
+    PdfCMap                  m_useCMap;       ///< The /UseCMap of a cached CMap
+};
+
+struct PdfCMapCache::TCMapBuilder {
+    TCMapBuilder()
+        : nMinCodeLen( 4 ), nMaxCodeLen( 0 )
+    {
+    }
+
+    void AddCodeLength( int nBytes ) 
+    {
+        if( nBytes < nMinCodeLen )
+            nMinCodeLen = nBytes;
+        if( nBytes > nMaxCodeLen )
+            nMaxCodeLen = nBytes;
+    }
+
+    void AddUnicodeRange( pdf_uint32 nFirst, pdf_uint32 nLast, const pdf_utf16be* pUnicode, pdf_uint32 nLength )
+    {
+        TCodeRange range;
+        range.nFirst  = nFirst;
+        range.nLast   = nLast;
+        range.nValue  = static_cast<pdf_uint32>(vecPool.size());
+        range.nDelta  = 0;
+        range.nLength = nLength;
+
+        vecPool.insert( vecPool.end(), pUnicode, pUnicode + nLength );
+        InsertRange( mapUnicode, range, true );
+    }
+
+    /** Add a range mapped to a unicode string given as hex string token
+     */
+    bool AddUnicodeRange( pdf_uint32 nFirst, pdf_uint32 nLast, const TCMapToken & rToken )
+    {
+        unsigned char cBuffer[PDF_CMAP_MAX_STRING];
+        pdf_utf16be   unicode[PDF_CMAP_MAX_STRING / 2];
+        const int     nLen = DecodeHexString( rToken, cBuffer, PDF_CMAP_MAX_STRING );
+        if( nLen <= 0 )
+            return false;
+
+        // A single byte is used as unicode value, 
+        // any other odd byte at the end is ignored
+        int nLength;
+        if( nLen == 1 ) 
+        {
+            unicode[0] = cBuffer[0];
+            nLength    = 1;
+        }
+        else
+        {
+            nLength = nLen / 2;
+            for( int i=0;i<nLength;i++ )
+                unicode[i] = static_cast<pdf_utf16be>((cBuffer[2*i] << 8) | cBuffer[2*i+1]);
+        }
+
+        AddUnicodeRange( nFirst, nLast, unicode, nLength );
+        return true;
+    }
+
+    void AddCIDRange( pdf_uint32 nFirst, pdf_uint32 nLast, pdf_uint32 nCID, bool bNotDef )
+    {
+        TCodeRange range;
+        range.nFirst  = nFirst;
+        range.nLast   = nLast;
+        range.nValue  = 0;
+        range.nDelta  = nCID;
+        range.nLength = 0;
+
+        InsertRange( bNotDef ? mapNotDef : mapCIDs, range, !bNotDef );
+    }
+
+    /** Add one entry of a section of a CMap
+     *
+     *  \param pTokens the operands of the entry
+     */
+    void AddEntry( ECMapSection eSection, const TCMapToken* pTokens );
+
+    /** Add the mappings of a bfrange entry with an array of unicode strings
+     *
+     *  \param rpszPos position of the first token in the array, set to the end of the array
+     */
+    void AddArrayEntry( const TCMapToken* pTokens, const char* & rpszPos, const char* pszEnd );
+
+    /** Parse a CMap and add its codespace ranges and mappings
+     */
+    void Parse( const char* pszData, pdf_long lLen );
+
+    std::string              sName;
+    TVecCodeSpaceRanges      vecCodeSpaces;
+    TMapCodeRanges           mapUnicode;
+    TMapCodeRanges           mapCIDs;
+    TMapCodeRanges           mapNotDef;
+    std::vector<pdf_utf16be> vecPool;
+    int                      nMinCodeLen;
+    int                      nMaxCodeLen;
+};
+
+void PdfCMapCache::TCMapBuilder::AddEntry( ECMapSection eSection, const TCMapToken* pTokens )
+{
+    pdf_uint32 nFirst;
+    pdf_uint32 nLast;
+    pdf_uint32 nCID;
+    int        nBytes = ReadCodeToken( pTokens[0], &nFirst );
+    if( !nBytes )
+        return;
+
+    switch( eSection ) 
+    {
+        case eCMapSection_CodeSpaceRange:
+        {
+            unsigned char cHigh[4];
+            TCodeSpaceRange range;
+            range.nBytes = DecodeHexString( pTokens[0], range.cLow, 4 );
+            if( DecodeHexString( pTokens[1], cHigh, 4 ) != range.nBytes )
+                return;
+
+            memcpy( range.cHigh, cHigh, sizeof(cHigh) );
+            vecCodeSpaces.push_back( range );
+            return;
+        }
+
+        case eCMapSection_BfChar:
+            if( AddUnicodeRange( nFirst, nFirst, pTokens[1] ) )
+                AddCodeLength( nBytes );
+            return;
+
+        case eCMapSection_BfRange:
+            if( ReadCodeToken( pTokens[1], &nLast ) && nFirst <= nLast && AddUnicodeRange( nFirst, nLast, pTokens[2] ) )
+                AddCodeLength( nBytes );
+            return;
+
+        case eCMapSection_CidChar:
+        case eCMapSection_NotDefChar:
+            if( ReadCIDToken( pTokens[1], &nCID ) ) 
+            {
+                AddCIDRange( nFirst, nFirst, nCID, eSection == eCMapSection_NotDefChar );
+                AddCodeLength( nBytes );
+            }
+            return;
+
+        case eCMapSection_CidRange:
+        case eCMapSection_NotDefRange:
+            if( ReadCodeToken( pTokens[1], &nLast ) && nFirst <= nLast && ReadCIDToken( pTokens[2], &nCID ) )
+            {
+                AddCIDRange( nFirst, nLast, nCID, eSection == eCMapSection_NotDefRange );
+                AddCodeLength( nBytes );
+            }
+            return;
+
+        case eCMapSection_None:
+        default:
+            return;
+    }
+}
+
+void PdfCMapCache::TCMapBuilder::AddArrayEntry( const TCMapToken* pTokens, const char* & rpszPos, const char* pszEnd )
+{
+    pdf_uint32 nFirst;
+    pdf_uint32 nLast;
+    int        nBytes = ReadCodeToken( pTokens[0], &nFirst );
+    bool       bValid = nBytes && ReadCodeToken( pTokens[1], &nLast ) && nFirst <= nLast;
+
+    // Every code of the range is mapped to one string of the array
+    TCMapToken token;
+    pdf_uint32 nCode = nFirst;
+    while( ReadToken( rpszPos, pszEnd, token ) && token.eType != eCMapTokenType_ArrayEnd )
+    {
+        if( bValid && nCode <= nLast && AddUnicodeRange( nCode, nCode, token ) ) 
+        {
+            AddCodeLength( nBytes );
+            // Do not wrap around after the last code
+            if( nCode == nLast )
+                bValid = false;
+            ++nCode;
+        }
+    }
+}
+
+void PdfCMapCache::TCMapBuilder::Parse( const char* pszData, pdf_long lLen )
+{
+    const char*  pszPos   = pszData;
+    const char*  pszEnd   = pszData + lLen;
+    ECMapSection eSection = eCMapSection_None;
+    TCMapToken   tokens[3];
+    int          nTokens  = 0;
+    int          nArity   = 0;
+    TCMapToken   token;
+    TCMapToken   previous;
+
+    previous.eType = eCMapTokenType_Keyword;
+    previous.lLen  = 0;
+    while( ReadToken( pszPos, pszEnd, token ) ) 
+    {
+        if( eSection != eCMapSection_None ) 
+        {
+            if( token.eType == eCMapTokenType_Keyword && token.lLen > 3 && strncmp( token.pszStart, "end", 3 ) == 0 )
+            {
+                eSection = eCMapSection_None;
+            }
+            else if( token.eType == eCMapTokenType_ArrayStart && eSection == eCMapSection_BfRange && nTokens == 2 )
+            {
+                AddArrayEntry( tokens, pszPos, pszEnd );
+                nTokens = 0;
+            }
+            else if( token.eType == eCMapTokenType_HexString || token.eType == eCMapTokenType_Keyword )
+            {
+                tokens[nTokens++] = token;
+                if( nTokens == nArity ) 
+                {
+                    AddEntry( eSection, tokens );
+                    nTokens = 0;
+                }
+            }
+            else
+            {
+                // Skip invalid entries
+                nTokens = 0;
+            }
+
+            continue;
+        }
+
+        if( token.eType == eCMapTokenType_Keyword ) 
+        {
+            nTokens = 0;
+            if( IsKeyword( token, "begincodespacerange" ) ) 
+            {
+                eSection = eCMapSection_CodeSpaceRange;
+                nArity   = 2;
+            }
+            else if( IsKeyword( token, "beginbfchar" ) ) 
+            {
+                eSection = eCMapSection_BfChar;
+                nArity   = 2;
+            }
+            else if( IsKeyword( token, "beginbfrange" ) ) 
+            {
+                eSection = eCMapSection_BfRange;
+                nArity   = 3;
+            }
+            else if( IsKeyword( token, "begincidchar" ) ) 
+            {
+                eSection = eCMapSection_CidChar;
+                nArity   = 2;
+            }
+            else if( IsKeyword( token, "begincidrange" ) ) 
+            {
+                eSection = eCMapSection_CidRange;
+                nArity   = 3;
+            }
+            else if( IsKeyword( token, "beginnotdefchar" ) ) 
+            {
+                eSection = eCMapSection_NotDefChar;
+                nArity   = 2;
+            }
+            else if( IsKeyword( token, "beginnotdefrange" ) ) 
+            {
+                eSection = eCMapSection_NotDefRange;
+                nArity   = 3;
+            }
+            else if( IsKeyword( token, "usecmap" ) && previous.eType == eCMapTokenType_Name ) 
+            {
+                PdfCMapCache::MergeCMap( *this, PdfCMapCache::GetPredefinedCMap( 
+                                             PdfName( std::string( previous.pszStart, previous.lLen ) ) ) );
+            }
+        }
+        else if( token.eType == eCMapTokenType_Name && previous.eType == eCMapTokenType_Name 
+                 && previous.lLen == 8 && strncmp( previous.pszStart, "CMapName", 8 ) == 0 )
+        {
+            sName.assign( token.pszStart, token.lLen );
+        }
+
+        previous = token;
+    }
+}
+
+// The mutex has to be defined before the maps,
+// so that it is still alive when the maps are destroyed.
+// The map of all CMaps has to be destroyed after
+// all other containers holding CMaps.
+Util::PdfMutex                    PdfCMapCache::s_mutex;
+PdfCMapCache::TMapCMaps           PdfCMapCache::s_mapCMaps;
+PdfCMapCache::TMapPredefinedCMaps PdfCMapCache::s_mapPredefined;
+std::vector<std::string>          PdfCMapCache::s_vecDirectories;
+std::deque<PdfCMap>               PdfCMapCache::s_dequeRecent;
+size_t                            PdfCMapCache::s_nCacheSize = 64;
+
+PdfCMap::PdfCMap()
+    : m_pData( NULL )
+{
+}
+
+PdfCMap::PdfCMap( TCMapData* pData )
+    : m_pData( pData )
+{
+    if( m_pData )
+        m_pData->m_lRefCount++;
+}
+
+PdfCMap::PdfCMap( const PdfCMap & rhs )
+    : m_pData( NULL )
+{
+    this->operator=( rhs );
+}
+
+PdfCMap::~PdfCMap()
+{
+    this->DerefBuffer();
+}
+
+const PdfCMap & PdfCMap::operator=( const PdfCMap & rhs )
+{
+    // Self assignment is a no-op
+    if( this == &rhs )
+        return rhs;
+
+    Util::PdfMutexWrapper mutex( PdfCMapCache::s_mutex );
+
+    DerefBuffer();
+
+    m_pData = rhs.m_pData;
+    if( m_pData )
+        m_pData->m_lRefCount++;
+
+    return *this;
+}
+
+void PdfCMap::DerefBuffer()
+{
+    if( !m_pData ) 
+        return;
+
+    Util::PdfMutexWrapper mutex( PdfCMapCache::s_mutex );
+    TCMapData* pData = m_pData;
+    m_pData = NULL;
+
+    if( !(--pData->m_lRefCount) )
+    {
+        if( pData->m_bCached ) 
+        {
+            std::pair<PdfCMapCache::TMapCMaps::iterator,PdfCMapCache::TMapCMaps::iterator> range = 
+                PdfCMapCache::s_mapCMaps.equal_range( pData->m_nHash );
+            while( range.first != range.second ) 
+            {
+                if( (*range.first).second == pData ) 
+                {
+                    PdfCMapCache::s_mapCMaps.erase( range.first );
+                    break;
+                }
+
+                ++range.first;
+            }
+        }
+
+        delete pData;
+    }
+}
+
+bool PdfCMap::IsEmpty() const
+{
+    return !m_pData || (m_pData->m_vecUnicode.empty() && m_pData->m_vecCIDs.empty());
+}
+
+const std::string & PdfCMap::GetName() const
+{
+    static const std::string sEmpty;
+
+    return m_pData ? m_pData->m_sName : sEmpty;
+}
+
+bool PdfCMap::HasCodeSpaceRanges() const
+{
+    return m_pData && !m_pData->m_vecCodeSpaces.empty();
+}
+
+bool PdfCMap::HasUnicodeMappings() const
+{
+    return m_pData && !m_pData->m_vecUnicode.empty();
+}
+
+bool PdfCMap::HasCIDMappings() const
+{
+    return m_pData && !m_pData->m_vecCIDs.empty();
+}
+
+int PdfCMap::ReadCode( const char* pszData, pdf_long lLen, pdf_uint32* pnCode ) const
+{
+    if( !m_pData || !pszData || !pnCode ) 
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
+    }
+
+    return this->ReadCode( m_pData, reinterpret_cast<const unsigned char*>(pszData), lLen, pnCode );
+}
+
+int PdfCMap::ReadCode( const TCMapData* pCodeSpaces, const unsigned char* pData, pdf_long lLen, pdf_uint32* pnCode ) const
+{
+    pdf_uint32 nCode = 0;
+    int        nMax  = lLen < 4 ? static_cast<int>(lLen) : 4;
+    int        n;
+
+    const TVecCodeSpaceRanges & rvecCodeSpaces = pCodeSpaces->m_vecCodeSpaces;
+    if( !rvecCodeSpaces.empty() ) 
+    {
+        for( n=1;n<=nMax;n++ ) 
+        {
+            nCode = (nCode << 8) | pData[n-1];
+            for( TVecCodeSpaceRanges::const_iterator it = rvecCodeSpaces.begin(); it != rvecCodeSpaces.end(); ++it )
+            {
+                if( (*it).nBytes == n && IsInCodeSpaceRange( *it, pData ) ) 
+                {
+                    *pnCode = nCode;
+                    return n;
+                }
+            }
+        }
+
+        // An invalid code has the length of the first codespace range
+        // matching its first byte or the length of the shortest range
+        int nBytes = 4;
+        for( TVecCodeSpaceRanges::const_iterator it = rvecCodeSpaces.begin(); it != rvecCodeSpaces.end(); ++it )
+        {
+            if( pData[0] >= (*it).cLow[0] && pData[0] <= (*it).cHigh[0] ) 
+            {
+                nBytes = (*it).nBytes;
+                break;
+            }
+
+            if( (*it).nBytes < nBytes )
+                nBytes = (*it).nBytes;
+        }
+
+        if( nBytes > lLen )
+            return 0;
+
+        *pnCode = 0;
+        for( n=0;n<nBytes;n++ )
+            *pnCode = (*pnCode << 8) | pData[n];
+
+        return nBytes;
+    }
+
+    // Without codespace ranges, read the shortest code which is mapped
+    const TVecCodeRanges & rvecRanges = m_pData->m_vecUnicode.empty() ? m_pData->m_vecCIDs : m_pData->m_vecUnicode;
+    if( nMax > m_pData->m_nMaxCodeLen )
+        nMax = m_pData->m_nMaxCodeLen;
+
+    for( n=1;n<=nMax;n++ ) 
+    {
+        nCode = (nCode << 8) | pData[n-1];
+        if( n >= m_pData->m_nMinCodeLen && FindRange( rvecRanges, nCode ) ) 
+        {
+            *pnCode = nCode;
+            return n;
+        }
+    }
+
+    // An unmapped code has the length of the longest code
+    if( nMax < m_pData->m_nMinCodeLen )
+        return 0;
+
+    *pnCode = nCode;
+    return nMax;
+}
+
+pdf_utf16be PdfCMap::GetUnicodeValue( pdf_uint32 nCode ) const
+{
+    if( !m_pData )
+        return 0;
+
+    const TCodeRange* pRange = FindRange( m_pData->m_vecUnicode, nCode );
+    if( !pRange )
+        return 0;
+
+    if( pRange->nLength > 1 )
+        return m_pData->m_vecPool[pRange->nValue];
+
+    return static_cast<pdf_utf16be>(m_pData->m_vecPool[pRange->nValue] + pRange->nDelta + (nCode - pRange->nFirst));
+}
+
+bool PdfCMap::GetCode( pdf_utf16be nUnicodeValue, pdf_uint32* pnCode ) const
+{
+    if( !m_pData )
+        return false;
+
+    TVecCodeRanges::const_iterator it = m_pData->m_vecUnicode.begin();
+    while( it != m_pData->m_vecUnicode.end() ) 
+    {
+        if( (*it).nLength == 1 ) 
+        {
+            const pdf_uint32 nFirstValue = m_pData->m_vecPool[(*it).nValue] + (*it).nDelta;
+            if( nUnicodeValue >= nFirstValue && nUnicodeValue - nFirstValue <= (*it).nLast - (*it).nFirst )
+            {
+                *pnCode = (*it).nFirst + (nUnicodeValue - nFirstValue);
+                return true;
+            }
+        }
+
+        ++it;
+    }
+
+    return false;
+}
+
+pdf_uint32 PdfCMap::GetCID( pdf_uint32 nCode ) const
+{
+    if( !m_pData )
+        return 0;
+
+    const TCodeRange* pRange = FindRange( m_pData->m_vecCIDs, nCode );
+    if( pRange )
+        return pRange->nDelta + (nCode - pRange->nFirst);
+
+    pRange = FindRange( m_pData->m_vecNotDef, nCode );
+    return pRange ? pRange->nDelta : 0;
+}
+
+pdf_long PdfCMap::DecodeToUnicode( const char* pszData, pdf_long lLen, pdf_utf16be* pBuffer, pdf_long lBufferLen, 
+                                   const PdfCMap* pCodeSpaces ) const
+{
+    if( !m_pData || (!pszData && lLen) || (!pBuffer && lBufferLen) ) 
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
+    }
+
+    const TCMapData* pSpaces = ( pCodeSpaces && pCodeSpaces->HasCodeSpaceRanges() ) ? pCodeSpaces->m_pData : m_pData;
+    const unsigned char* pData   = reinterpret_cast<const unsigned char*>(pszData);
+    const TCodeRange*    pRange  = NULL;
+    pdf_long             lPos    = 0;
+    pdf_long             lOutLen = 0;
+    pdf_uint32           nCode;
+
+    while( lPos < lLen ) 
+    {
+        const int nBytes = this->ReadCode( pSpaces, pData + lPos, lLen - lPos, &nCode );
+        if( !nBytes )
+            break;
+
+        lPos += nBytes;
+
+        // Consecutive codes are often in the same range
+        if( !pRange || nCode < pRange->nFirst || nCode > pRange->nLast )
+            pRange = FindRange( m_pData->m_vecUnicode, nCode );
+
+        if( !pRange ) 
+        {
+            if( lOutLen < lBufferLen )
+                pBuffer[lOutLen] = 0;
+            ++lOutLen;
+            continue;
+        }
+
+        const pdf_utf16be* pUnicode = &(m_pData->m_vecPool[pRange->nValue]);
+        for( pdf_uint32 i=0;i<pRange->nLength - 1;i++ ) 
+        {
+            if( lOutLen < lBufferLen )
+                pBuffer[lOutLen] = ToBigEndian( pUnicode[i] );
+            ++lOutLen;
+        }
+
+        if( lOutLen < lBufferLen )
+            pBuffer[lOutLen] = ToBigEndian( static_cast<pdf_utf16be>(pUnicode[pRange->nLength - 1] + pRange->nDelta + (nCode - pRange->nFirst)) );
+        ++lOutLen;
+    }
+
+    return lOutLen;
+}
+
+PdfString PdfCMap::DecodeToUnicode( const PdfString & rEncodedString, const PdfCMap* pCodeSpaces ) const
+{
+    // Most strings are short enough to be decoded on the stack
+    const pdf_long BUFFER_LEN = 256;
+    pdf_utf16be    buffer[BUFFER_LEN];
+
+    const char*    pszData = rEncodedString.GetString();
+    const pdf_long lLen    = rEncodedString.GetLength();
+    pdf_long       lUnicodeLen = this->DecodeToUnicode( pszData, lLen, buffer, BUFFER_LEN, pCodeSpaces );
+    if( lUnicodeLen <= BUFFER_LEN )
+        return PdfString( buffer, lUnicodeLen );
+
+    pdf_utf16be* pBuffer = static_cast<pdf_utf16be*>(podofo_calloc( lUnicodeLen, sizeof(pdf_utf16be) ));
+    if( !pBuffer ) 
+    {
+        PODOFO_RAISE_ERROR( ePdfError_OutOfMemory );
+    }
+
+    PdfString ret;
+    try { 
+        this->DecodeToUnicode( pszData, lLen, pBuffer, lUnicodeLen, pCodeSpaces );
+        ret = PdfString( pBuffer, lUnicodeLen );
+    } catch( PdfError & e ) {
+        podofo_free( pBuffer );
+        e.AddToCallstack( __FILE__, __LINE__ );
+        throw e;
+    }
+
+    podofo_free( pBuffer );
+    return ret;
+}
+
+pdf_long PdfCMap::DecodeToCIDs( const char* pszData, pdf_long lLen, pdf_uint32* pBuffer, pdf_long lBufferLen ) const
+{
+    if( !m_pData || (!pszData && lLen) || (!pBuffer && lBufferLen) ) 
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
+    }
+
+    const unsigned char* pData   = reinterpret_cast<const unsigned char*>(pszData);
+    const TCodeRange*    pRange  = NULL;
+    pdf_long             lPos    = 0;
+    pdf_long             lOutLen = 0;
+    pdf_uint32           nCode;
+
+    while( lPos < lLen ) 
+    {
+        const int nBytes = this->ReadCode( m_pData, pData + lPos, lLen - lPos, &nCode );
+        if( !nBytes )
+            break;
+
+        lPos += nBytes;
+
+        // Consecutive codes are often in the same range
+        if( !pRange || nCode < pRange->nFirst || nCode > pRange->nLast )
+            pRange = FindRange( m_pData->m_vecCIDs, nCode );
+
+        if( lOutLen < lBufferLen ) 
+        {
+            if( pRange )
+                pBuffer[lOutLen] = pRange->nDelta + (nCode - pRange->nFirst);
+            else
+            {
+                const TCodeRange* pNotDef = FindRange( m_pData->m_vecNotDef, nCode );
+                pBuffer[lOutLen] = pNotDef ? pNotDef->nDelta : 0;
+            }
+        }
+
+        ++lOutLen;
+    }
+
+    return lOutLen;
+}
+
+// -----------------------------------------------------
+// PdfCMapCache
+// -----------------------------------------------------
+PdfCMap PdfCMapCache::GetCMap( const PdfObject* pObject )
+{
+    return GetCMap( pObject, 0 );
+}
+
+PdfCMap PdfCMapCache::GetCMap( const PdfObject* pObject, int nDepth )
+{
+    if( !pObject ) 
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
+    }
+
+    if( pObject->IsName() )
+        return GetPredefinedCMap( pObject->GetName() );
+
+    if( !pObject->HasStream() ) 
+    {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDataType, "A CMap has to be a stream or a name" );
+    }
+
+    if( nDepth > PDF_CMAP_MAX_DEPTH ) 
+    {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidStream, "Too many CMaps referring to each other using /UseCMap" );
+    }
+
+    PdfCMap useCMap;
+    const PdfObject* pUseCMap = pObject->GetIndirectKey( "UseCMap" );
+    if( pUseCMap && (pUseCMap->IsName() || pUseCMap->HasStream()) )
+        useCMap = GetCMap( pUseCMap, nDepth + 1 );
+
+    char*    pBuffer;
+    pdf_long lLen;
+    pObject->GetStream()->GetFilteredCopy( &pBuffer, &lLen );
+
+    PdfCMap cmap;
+    try { 
+        cmap = GetCMap( pBuffer, lLen, useCMap );
+    } catch( PdfError & e ) {
+        podofo_free( pBuffer );
+        e.AddToCallstack( __FILE__, __LINE__ );
+        throw e;
+    }
+
+    podofo_free( pBuffer );
+    return cmap;
+}
+
+PdfCMap PdfCMapCache::GetCMap( const char* pszData, pdf_long lLen )
+{
+    return GetCMap( pszData, lLen, PdfCMap() );
+}
+
+PdfCMap PdfCMapCache::GetCMap( const char* pszData, pdf_long lLen, const PdfCMap & rUseCMap )
+{
+    if( !pszData && lLen ) 
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
+    }
+
+    const pdf_uint64 nHash = HashCMap( pszData, lLen );
+    std::pair<TMapCMaps::iterator,TMapCMaps::iterator> range;
+
+    {
+        Util::PdfMutexWrapper mutex( s_mutex );
+        range = s_mapCMaps.equal_range( nHash );
+        for( ; range.first != range.second; ++range.first ) 
+        {
+            const PdfCMap::TCMapData* pData = (*range.first).second;
+            if( pData->m_useCMap == rUseCMap && pData->m_sSource.length() == static_cast<size_t>(lLen)
+                && memcmp( pData->m_sSource.data(), pszData, lLen ) == 0 )
+            {
+                PdfCMap cmap( (*range.first).second );
+                AddRecentCMap( cmap );
+                return cmap;
+            }
+        }
+    }
+
+    // Do not block other threads while parsing the CMap,
+    // if another thread was faster its CMap is used
+    TCMapBuilder builder;
+    MergeCMap( builder, rUseCMap );
+    builder.Parse( pszData, lLen );
+
+    PdfCMap::TCMapData* pNewData = CompileCMap( builder );
+    pNewData->m_nHash   = nHash;
+    pNewData->m_sSource.assign( pszData, lLen );
+    pNewData->m_useCMap = rUseCMap;
+
+    Util::PdfMutexWrapper mutex( s_mutex );
+    range = s_mapCMaps.equal_range( nHash );
+    for( ; range.first != range.second; ++range.first ) 
+    {
+        PdfCMap::TCMapData* pData = (*range.first).second;
+        if( pData->m_useCMap == rUseCMap && pData->m_sSource == pNewData->m_sSource )
+        {
+            delete pNewData;
+
+            PdfCMap cmap( pData );
+            AddRecentCMap( cmap );
+            return cmap;
+        }
+    }
+
+    pNewData->m_bCached = true;
+    s_mapCMaps.insert( TMapCMaps::value_type( nHash, pNewData ) );
+
+    PdfCMap cmap( pNewData );
+    AddRecentCMap( cmap );
+    return cmap;
+}
+
+PdfCMap PdfCMapCache::GetPredefinedCMap( const PdfName & rName )
+{
+    const std::string & rsName = rName.GetName();
+
+    // The mutex is locked while reading a predefined CMap,
+    // as they are only read once per process
+    Util::PdfMutexWrapper mutex( s_mutex );
+    TMapPredefinedCMaps::const_iterator it = s_mapPredefined.find( rsName );
+    if( it != s_mapPredefined.end() )
+        return (*it).second;
+
+    // Predefined CMaps using this CMap with usecmap find an invalid CMap
+    // while it is read, so that they cannot refer to each other endlessly
+    s_mapPredefined[rsName] = PdfCMap();
+
+    TCMapBuilder builder;
+    bool         bFound  = false;
+    bool         bUTF16  = false;
+    if( rsName == "Identity-H" || rsName == "Identity-V" ) 
+    {
+        TCodeSpaceRange range;
+        range.nBytes   = 2;
+        range.cLow[0]  = range.cLow[1]  = 0x00;
+        range.cHigh[0] = range.cHigh[1] = 0xff;
+
+        builder.vecCodeSpaces.push_back( range );
+        builder.AddCIDRange( 0x0000, 0xffff, 0, false );
+        builder.AddCodeLength( 2 );
+        bFound = true;
+    }
+    else if( rsName.find_first_of( "/\\" ) == std::string::npos && rsName.compare( 0, 1, "." ) != 0 )
+    {
+        // The name is used as filename only if it cannot refer to another directory
+        std::vector<std::string>::const_iterator itDir = s_vecDirectories.begin();
+        while( !bFound && itDir != s_vecDirectories.end() ) 
+        {
+            const std::string sPath = *itDir + "/" + rsName;
+            FILE*             hFile = fopen( sPath.c_str(), "rb" );
+            if( hFile ) 
+            {
+                fclose( hFile );
+
+                PdfFileInputStream stream( sPath.c_str() );
+                std::string        sData;
+                char               buffer[4096];
+                pdf_long           lRead;
+                while( (lRead = stream.Read( buffer, sizeof(buffer) )) > 0 )
+                    sData.append( buffer, lRead );
+
+                builder.Parse( sData.data(), sData.length() );
+                bFound = true;
+            }
+
+            ++itDir;
+        }
+    }
+
+    // The codes of unicode CMaps are mapped to themselves, so that text
+    // using them can be decoded without their CMap resource file
+    if( IsUnicodeCMapName( rsName, &bUTF16 ) )
+    {
+        TCodeSpaceRange range;
+        range.nBytes   = 2;
+        range.cLow[0]  = range.cLow[1]  = 0x00;
+        range.cHigh[0] = range.cHigh[1] = 0xff;
+        if( bUTF16 ) 
+        {
+            range.cHigh[0] = 0xd7;
+            builder.vecCodeSpaces.push_back( range );
+            range.cLow[0]  = 0xe0;
+            range.cHigh[0] = 0xff;
+            builder.vecCodeSpaces.push_back( range );
+
+            range.nBytes   = 4;
+            range.cLow[0]  = 0xd8;
+            range.cHigh[0] = 0xdb;
+            range.cLow[1]  = 0x00;
+            range.cHigh[1] = 0xff;
+            range.cLow[2]  = 0xdc;
+            range.cHigh[2] = 0xdf;
+            range.cLow[3]  = 0x00;
+            range.cHigh[3] = 0xff;
+            builder.vecCodeSpaces.push_back( range );
+
+            // Surrogate pairs with the same high surrogate are a range
+            for( pdf_uint32 nHigh = 0xd800; nHigh <= 0xdbff; nHigh++ ) 
+            {
+                const pdf_utf16be pair[2] = { static_cast<pdf_utf16be>(nHigh), 0xdc00 };
+                builder.AddUnicodeRange( (nHigh << 16) | 0xdc00, (nHigh << 16) | 0xdfff, pair, 2 );
+            }
+
+            builder.AddCodeLength( 4 );
+        }
+        else
+            builder.vecCodeSpaces.push_back( range );
+
+        const pdf_utf16be first = 0x0000;
+        builder.AddUnicodeRange( 0x0000, 0xffff, &first, 1 );
+        builder.AddCodeLength( 2 );
+        bFound = true;
+    }
+
+    PdfCMap cmap;
+    if( bFound ) 
+    {
+        if( builder.sName.empty() )
+            builder.sName = rsName;
+
+        cmap = PdfCMap( CompileCMap( builder ) );
+    }
+
+    s_mapPredefined[rsName] = cmap;
+    return cmap;
+}
+
+void PdfCMapCache::AddCMapDirectory( const char* pszDirectory )
+{
+    if( !pszDirectory ) 
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
+    }
+
+    Util::PdfMutexWrapper mutex( s_mutex );
+    s_vecDirectories.push_back( pszDirectory );
+
+    // CMaps which were not found before may be in the new directory
+    TMapPredefinedCMaps::iterator it = s_mapPredefined.begin();
+    while( it != s_mapPredefined.end() ) 
+    {
+        if( !(*it).second.IsValid() )
+            s_mapPredefined.erase( it++ );
+        else
+            ++it;
+    }
+}
+
+void PdfCMapCache::ClearCMapDirectories()
+{
+    Util::PdfMutexWrapper mutex( s_mutex );
+    s_vecDirectories.clear();
+}
+
+void PdfCMapCache::SetCacheSize( size_t nSize )
+{
+    Util::PdfMutexWrapper mutex( s_mutex );
+    s_nCacheSize = nSize;
+    while( s_dequeRecent.size() > s_nCacheSize )
+        s_dequeRecent.pop_front();
+}
+
+void PdfCMapCache::EmptyCache()
+{
+    Util::PdfMutexWrapper mutex( s_mutex );
+    s_mapPredefined.clear();
+    s_dequeRecent.clear();
+}
+
+void PdfCMapCache::AddRecentCMap( const PdfCMap & rCMap )
+{
+    if( !s_nCacheSize || (!s_dequeRecent.empty() && s_dequeRecent.back() == rCMap) )
+        return;
+
+    s_dequeRecent.push_back( rCMap );
+    while( s_dequeRecent.size() > s_nCacheSize )
+        s_dequeRecent.pop_front();
+}
+
+void PdfCMapCache::MergeCMap( TCMapBuilder & rBuilder, const PdfCMap & rCMap )
+{
+    const PdfCMap::TCMapData* pData = rCMap.m_pData;
+    if( !pData )
+        return;
+
+    rBuilder.vecCodeSpaces.insert( rBuilder.vecCodeSpaces.end(), pData->m_vecCodeSpaces.begin(), pData->m_vecCodeSpaces.end() );
+
+    const pdf_uint32 nPoolOffset = static_cast<pdf_uint32>(rBuilder.vecPool.size());
+    rBuilder.vecPool.insert( rBuilder.vecPool.end(), pData->m_vecPool.begin(), pData->m_vecPool.end() );
+
+    TVecCodeRanges::const_iterator it;
+    for( it = pData->m_vecUnicode.begin(); it != pData->m_vecUnicode.end(); ++it ) 
+    {
+        TCodeRange range = *it;
+        range.nValue += nPoolOffset;
+        InsertRange( rBuilder.mapUnicode, range, true );
+    }
+
+    for( it = pData->m_vecCIDs.begin(); it != pData->m_vecCIDs.end(); ++it ) 
+        InsertRange( rBuilder.mapCIDs, *it, true );
+
+    for( it = pData->m_vecNotDef.begin(); it != pData->m_vecNotDef.end(); ++it ) 
+        InsertRange( rBuilder.mapNotDef, *it, false );
+
+    if( !pData->m_vecUnicode.empty() || !pData->m_vecCIDs.empty() || !pData->m_vecNotDef.empty() ) 
+    {
+        rBuilder.AddCodeLength( pData->m_nMinCodeLen );
+        rBuilder.AddCodeLength( pData->m_nMaxCodeLen );
+    }
+}
+
+PdfCMap::TCMapData* PdfCMapCache::CompileCMap( const TCMapBuilder & rBuilder )
+{
+    PdfCMap::TCMapData* pData = new PdfCMap::TCMapData();
+    pData->m_sName         = rBuilder.sName;
+    pData->m_vecCodeSpaces = rBuilder.vecCodeSpaces;
+    pData->m_vecPool       = rBuilder.vecPool;
+    pData->m_lRefCount     = 0;
+    pData->m_bCached       = false;
+    pData->m_nHash         = 0;
+
+    // Codes are 2 bytes long, if the CMap has no mappings
+    pData->m_nMinCodeLen   = rBuilder.nMaxCodeLen ? rBuilder.nMinCodeLen : 2;
+    pData->m_nMaxCodeLen   = rBuilder.nMaxCodeLen ? rBuilder.nMaxCodeLen : 2;
+
+    CompileRanges( rBuilder.mapUnicode, pData->m_vecUnicode, &rBuilder.vecPool, true );
+    CompileRanges( rBuilder.mapCIDs,    pData->m_vecCIDs,    NULL,              true );
+    CompileRanges( rBuilder.mapNotDef,  pData->m_vecNotDef,  NULL,              false );
+
+    return pData;
+}
+
+}; // PoDoFo
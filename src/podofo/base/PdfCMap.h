@@ -0,0 +1,373 @@
+/***************************************************************************
+ *   Copyright (C) 2007 by Dominik Seichter                                *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ *                                                                         *
+ *   In addition, as a special exception, the copyright holders give       *
+ *   permission to link the code of portions of this program with the      *
+ *   OpenSSL library under certain conditions as described in each         *
+ *   individual source file, and distribute linked combinations            *
+ *   including the two.                                                    *
+ *   You must obey the GNU General Public License in all respects          *
+ *   for all of the code used other than OpenSSL.  If you modify           *
+ *   file(s) with this exception, you may extend this exception to your    *
+ *   version of the file(s), but you are not obligated to do so.  If you   *
+ *   do not wish to do so, delete this exception statement from your       *
+ *   version.  If you delete this exception statement from all source      *
+ *   files in the program, then also delete it here.                       *
+ ***************************************************************************/
+
+
+#ifndef _PDF_CMAP_H_
+#define _PDF_CMAP_H_
+
+#include "PdfDefines.h"
+#include "util/PdfMutex.h"
+
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace PoDoFo {
+
+class PdfCMapCache;
+class PdfName;
+class PdfObject;
+class PdfString;
+
+/**
+ * A compiled CMap, which maps character codes of 1 to 4 bytes
+ * to unicode strings (like a /ToUnicode CMap) or to CIDs 
+ * (like the /Encoding CMap of a Type0 font).
+ *
+ * The codespace ranges of the CMap determine how many bytes
+ * are read for each character code. All bfchar, bfrange, cidchar
+ * and cidrange entries are stored as sorted tables of ranges,
+ * so that a code is found using a binary search.
+ *
+ * A PdfCMap is only a handle to the compiled data, it is
+ * reference counted and can be copied freely. The data is never
+ * changed after the CMap was parsed, so it can be shared by several
+ * fonts and accessed from several threads at once.
+ *
+ * \see PdfCMapCache
+ */
+class PODOFO_API PdfCMap {
+    friend class PdfCMapCache;
+
+ public:
+    /** Create an invalid handle which refers to no CMap
+     */
+    PdfCMap();
+
+    /** Copy an existing handle
+     */
+    PdfCMap( const PdfCMap & rhs );
+
+    ~PdfCMap();
+
+    const PdfCMap & operator=( const PdfCMap & rhs );
+
+    /** 
+     *  \returns true if both handles refer to the same CMap
+     */
+    inline bool operator==( const PdfCMap & rhs ) const;
+
+    /** 
+     *  \returns true if this handle refers to a CMap
+     */
+    inline bool IsValid() const;
+
+    /** 
+     *  \returns true if this CMap maps no codes to unicode values or CIDs
+     */
+    bool IsEmpty() const;
+
+    /** 
+     *  \returns the value of /CMapName in the CMap or an empty string
+     */
+    const std::string & GetName() const;
+
+    /** 
+     *  \returns true if the CMap defines any codespace ranges
+     */
+    bool HasCodeSpaceRanges() const;
+
+    /** 
+     *  \returns true if the CMap has bfchar or bfrange entries
+     */
+    bool HasUnicodeMappings() const;
+
+    /** 
+     *  \returns true if the CMap has cidchar or cidrange entries
+     */
+    bool HasCIDMappings() const;
+
+    /** Read the next character code from a string
+     *
+     *  If the CMap has no codespace ranges, the shortest code
+     *  which has a unicode mapping is read.
+     *
+     *  \param pszData the encoded string
+     *  \param lLen length of pszData in bytes
+     *  \param pnCode the character code is written to this value
+     *
+     *  \returns the number of bytes of the code or 0 if pszData
+     *           ends with an incomplete code
+     */
+    int ReadCode( const char* pszData, pdf_long lLen, pdf_uint32* pnCode ) const;
+
+    /** Get the unicode value of a character code
+     *
+     *  \param nCode a character code
+     *
+     *  \returns the first unicode value in host byte order
+     *           or 0 if the code is not mapped
+     */
+    pdf_utf16be GetUnicodeValue( pdf_uint32 nCode ) const;
+
+    /** Get the character code of a unicode value,
+     *  this is a slow linear search over all ranges.
+     *
+     *  \param nUnicodeValue a unicode value in host byte order
+     *  \param pnCode the character code is written to this value
+     *
+     *  \returns true if a code mapping to nUnicodeValue was found
+     */
+    bool GetCode( pdf_utf16be nUnicodeValue, pdf_uint32* pnCode ) const;
+
+    /** Get the CID of a character code
+     *
+     *  \param nCode a character code
+     *
+     *  \returns the CID of the code, its notdef CID or 0
+     */
+    pdf_uint32 GetCID( pdf_uint32 nCode ) const;
+
+    /** Decode a string to unicode in one pass.
+     *
+     *  At most lBufferLen values are written to pBuffer, 
+     *  so the required size of the buffer can be calculated
+     *  by calling this method with a NULL buffer.
+     *  Codes without a mapping are decoded to 0.
+     *
+     *  \param pszData the encoded string
+     *  \param lLen length of pszData in bytes
+     *  \param pBuffer the UTF-16BE values are written to this buffer
+     *  \param lBufferLen size of pBuffer in values
+     *  \param pCodeSpaces the codespace ranges of this CMap are used to
+     *                     read the codes if it has any, e.g. the /Encoding
+     *                     CMap of a font while decoding using its /ToUnicode CMap.
+     *                     If NULL, the codespace ranges of this CMap are used.
+     *
+     *  \returns the number of UTF-16 values of the decoded string
+     */
+    pdf_long DecodeToUnicode( const char* pszData, pdf_long lLen, pdf_utf16be* pBuffer, pdf_long lBufferLen, 
+                              const PdfCMap* pCodeSpaces = NULL ) const;
+
+    /** Decode a string to unicode in one pass.
+     *
+     *  \param rEncodedString the encoded string
+     *  \param pCodeSpaces use the codespace ranges of this CMap to read the codes
+     *
+     *  \returns a unicode PdfString
+     *
+     *  \see DecodeToUnicode
+     */
+    PdfString DecodeToUnicode( const PdfString & rEncodedString, const PdfCMap* pCodeSpaces = NULL ) const;
+
+    /** Decode a string to CIDs in one pass.
+     *
+     *  \param pszData the encoded string
+     *  \param lLen length of pszData in bytes
+     *  \param pBuffer the CIDs are written to this buffer
+     *  \param lBufferLen size of pBuffer in values
+     *
+     *  \returns the number of CIDs of the decoded string
+     *
+     *  \see DecodeToUnicode
+     */
+    pdf_long DecodeToCIDs( const char* pszData, pdf_long lLen, pdf_uint32* pBuffer, pdf_long lBufferLen ) const;
+
+ private:
+    struct TCMapData;
+
+    /** Take a reference to some CMap data,
+     *  the mutex of the PdfCMapCache has to be locked.
+     */
+    explicit PdfCMap( TCMapData* pData );
+
+    /**
+     * Destroy the CMap data if the reference count is 0
+     */
+    void DerefBuffer();
+
+    /** Read the next character code from a string
+     *
+     *  \param pCodeSpaces the codespace ranges of this CMap are used,
+     *                     if it has none the code lengths of the mappings
+     *                     of this CMap are used
+     *
+     *  \see ReadCode
+     */
+    int ReadCode( const TCMapData* pCodeSpaces, const unsigned char* pData, pdf_long lLen, pdf_uint32* pnCode ) const;
+
+ private:
+    TCMapData* m_pData;
+};
+
+/**
+ * A process wide cache of compiled CMaps. 
+ *
+ * CMap streams are looked up by a hash of their data,
+ * so fonts in different documents using the same /ToUnicode
+ * or /Encoding CMap share a single compiled CMap.
+ * A CMap is freed once no font uses it anymore and it is
+ * not among the most recently requested CMaps.
+ *
+ * Predefined CMaps are looked up by name. Identity-H and
+ * Identity-V are built in, all other predefined CMaps are read
+ * from the CMap resource files of Adobe in the directories 
+ * added using AddCMapDirectory. The UCS-2 and UTF-16 CMaps
+ * like UniJIS-UTF16-H additionally map their codes to unicode.
+ *
+ * All methods of this class are thread safe.
+ */
+class PODOFO_API PdfCMapCache {
+ public:
+    /** Get the compiled CMap of an object
+     *
+     *  \param pObject either a stream containing a CMap
+     *                 or the name of a predefined CMap
+     *
+     *  \returns a handle to the CMap, which is invalid if 
+     *           pObject is the name of an unknown CMap
+     */
+    static PdfCMap GetCMap( const PdfObject* pObject );
+
+    /** Get the compiled CMap of some data
+     *
+     *  \param pszData a CMap
+     *  \param lLen length of pszData in bytes
+     *
+     *  \returns a handle to the CMap
+     */
+    static PdfCMap GetCMap( const char* pszData, pdf_long lLen );
+
+    /** Get a predefined CMap
+     *
+     *  \param rName the name of a predefined CMap, e.g. Identity-H
+     *
+     *  \returns a handle to the CMap, which is invalid if the CMap is unknown
+     */
+    static PdfCMap GetPredefinedCMap( const PdfName & rName );
+
+    /** Add a directory containing the CMap resource files of Adobe,
+     *  which are searched for predefined CMaps in the order
+     *  the directories were added. Predefined CMaps which were
+     *  not found before are searched again.
+     *
+     *  \param pszDirectory path to a directory
+     */
+    static void AddCMapDirectory( const char* pszDirectory );
+
+    /** Remove all directories added using AddCMapDirectory.
+     *  Predefined CMaps which were read from them stay
+     *  in the cache until EmptyCache is called.
+     */
+    static void ClearCMapDirectories();
+
+    /** Set the number of recently requested CMaps,
+     *  which are kept in memory even if no font uses them anymore.
+     *
+     *  \param nSize number of CMaps, the default is 64
+     */
+    static void SetCacheSize( size_t nSize );
+
+    /** Remove all CMaps from the cache.
+     *  CMaps are freed once they are not used
+     *  by any font anymore.
+     */
+    static void EmptyCache();
+
+ private:
+    /** No instances of this class can be created
+     */
+    PdfCMapCache();
+
+    struct TCMapBuilder;
+
+    /** Get the compiled CMap of an object
+     *
+     *  \param nDepth number of CMaps referring to pObject using /UseCMap
+     */
+    static PdfCMap GetCMap( const PdfObject* pObject, int nDepth );
+
+    /** Get the compiled CMap of some data
+     *
+     *  \param rUseCMap the mappings of this CMap are used as base
+     */
+    static PdfCMap GetCMap( const char* pszData, pdf_long lLen, const PdfCMap & rUseCMap );
+
+    /** Keep a CMap alive as one of the recently requested CMaps,
+     *  the mutex has to be locked.
+     */
+    static void AddRecentCMap( const PdfCMap & rCMap );
+
+    /** Add all mappings of a CMap to a CMap which is being parsed
+     */
+    static void MergeCMap( TCMapBuilder & rBuilder, const PdfCMap & rCMap );
+
+    /** Create the sorted tables of a parsed CMap
+     */
+    static PdfCMap::TCMapData* CompileCMap( const TCMapBuilder & rBuilder );
+
+ private:
+    typedef std::multimap<pdf_uint64,PdfCMap::TCMapData*> TMapCMaps;
+    typedef std::map<std::string,PdfCMap>                 TMapPredefinedCMaps;
+
+    static Util::PdfMutex            s_mutex;
+
+    static TMapCMaps                 s_mapCMaps;       ///< CMaps in use by the hash of their data
+    static TMapPredefinedCMaps       s_mapPredefined;  ///< Predefined CMaps by name
+    static std::vector<std::string>  s_vecDirectories; ///< Directories of CMap resource files
+    static std::deque<PdfCMap>       s_dequeRecent;    ///< Recently requested CMaps
+    static size_t                    s_nCacheSize;
+
+    friend class PdfCMap;
+};
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+bool PdfCMap::operator==( const PdfCMap & rhs ) const
+{
+    return m_pData == rhs.m_pData;
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+bool PdfCMap::IsValid() const
+{
+    return m_pData != NULL;
+}
+
+}; // PoDoFo
+
+#endif // _PDF_CMAP_H_
@@ -34,8 +34,8 @@
 #include "PdfContentsTokenizer.h"
 
 #include "PdfCanvas.h"
+#include "PdfFilter.h"
 #include "PdfInputDevice.h"
-#include "PdfOutputStream.h"
 #include "PdfStream.h"
 #include "PdfVecObjects.h"
 #include "PdfData.h"
@@ -113,13 +113,22 @@ void PdfContentsTokenizer::SetCurrentContentsStream( const PdfObject* pObject )
     PODOFO_RAISE_LOGIC_IF( pObject == NULL, "Content stream object == NULL!" );
 
     const PdfStream* pStream = pObject->GetStream();
+    if( !pStream )
+    {
+        // a canvas dictionary without a stream is an empty page
+        m_device = PdfRefCountedInputDevice( "", static_cast<size_t>(0) );
+        return;
+    }
 
-    PdfRefCountedBuffer buffer(0);
-    PdfBufferOutputStream stream( &buffer );
-    if( pStream )
-        pStream->GetFilteredCopy( &stream );
-
-    m_device = PdfRefCountedInputDevice( buffer.GetBuffer(), buffer.GetSize() );
+    // Decode the stream while it is tokenized instead of inflating
+    // the whole contents into memory first
+    PdfFilteredInputStream* pFiltered = pStream->CreateFilteredInputStream();
+    try {
+        m_device = PdfRefCountedInputDevice( new PdfStreamInputDevice( pFiltered, true ) );
+    } catch( ... ) {
+        delete pFiltered;
+        throw;
+    }
 }
 
 bool PdfContentsTokenizer::GetNextToken( const char*& pszToken , EPdfTokenType* peType )
@@ -35,6 +35,7 @@
 #define _PDF_DATATYPE_H_
 
 #include "PdfDefines.h"
+#include "PdfArena.h"
 
 namespace PoDoFo {
 
@@ -58,6 +59,13 @@ class PODOFO_API PdfDataType {
  public:
     virtual ~PdfDataType();
 
+    /** Datatypes created with new are allocated from the
+     *  arena of the current PdfArenaScope, if any.
+     *  \see PdfArena
+     */
+    inline static void* operator new( size_t nSize ) { return PdfArena::Allocate( nSize ); }
+    inline static void operator delete( void* pMemory, size_t nSize ) { PdfArena::Free( pMemory, nSize ); }
+
     /** Write the complete datatype to a file.
      *  \param pDevice write the object to this device
      *  \param eWriteMode additional options for writing this object
@@ -0,0 +1,445 @@
+/***************************************************************************
+ *   Copyright (C) 2007 by Dominik Seichter                                *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ *                                                                         *
+ *   In addition, as a special exception, the copyright holders give       *
+ *   permission to link the code of portions of this program with the      *
+ *   OpenSSL library under certain conditions as described in each         *
+ *   individual source file, and distribute linked combinations            *
+ *   including the two.                                                    *
+ *   You must obey the GNU General Public License in all respects          *
+ *   for all of the code used other than OpenSSL.  If you modify           *
+ *   file(s) with this exception, you may extend this exception to your    *
+ *   version of the file(s), but you are not obligated to do so.  If you   *
+ *   do not wish to do so, delete this exception statement from your       *
+ *   version.  If you delete this exception statement from all source      *
+ *   files in the program, then also delete it here.                       *
+ ***************************************************************************/
+
+
+#include "PdfDeferredStream.h"
+
+#include "PdfEncrypt.h"
+#include "PdfInputStream.h"
+#include "PdfObject.h"
+#include "PdfOutputDevice.h"
+#include "PdfOutputStream.h"
+#include "PdfVecObjects.h"
+#include "PdfDefinesPrivate.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <vector>
+
+// The data of a source is read in blocks of this size
+#define PODOFO_DEFERRED_BLOCK_SIZE 65536
+
+namespace PoDoFo {
+
+/** Reads at most a given number of bytes from a file,
+ *  starting at an offset.
+ */
+class PdfFileRangeInputStream : public PdfFileInputStream {
+ public:
+    PdfFileRangeInputStream( const char* pszFilename, pdf_long lOffset, pdf_long lLength )
+        : PdfFileInputStream( pszFilename ), m_lLeft( lLength )
+    {
+        if( fseeko( this->GetHandle(), lOffset, SEEK_SET ) == -1 )
+        {
+            PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDeviceOperation, "Failed to seek to the start of the stream data" );
+        }
+    }
+
+    virtual pdf_long Read( char* pBuffer, pdf_long lLen, pdf_long* pTotalLeft = 0 )
+    {
+        if( lLen > m_lLeft )
+            lLen = m_lLeft;
+
+        if( !lLen )
+            return 0;
+
+        pdf_long lRead = PdfFileInputStream::Read( pBuffer, lLen, pTotalLeft );
+        m_lLeft -= lRead;
+        return lRead;
+    }
+
+ private:
+    pdf_long m_lLeft;
+};
+
+/** Reads an input stream without taking ownership of it
+ */
+class PdfForwardingInputStream : public PdfInputStream {
+ public:
+    PdfForwardingInputStream( PdfInputStream* pStream )
+        : m_pStream( pStream )
+    {
+    }
+
+    virtual pdf_long Read( char* pBuffer, pdf_long lLen, pdf_long* pTotalLeft = 0 )
+    {
+        return m_pStream->Read( pBuffer, lLen, pTotalLeft );
+    }
+
+ private:
+    PdfInputStream* m_pStream;
+};
+
+PdfFileStreamSource::PdfFileStreamSource( const char* pszFilename, pdf_long lOffset, pdf_long lLength )
+    : m_sFilename( pszFilename ? pszFilename : "" ), m_lOffset( lOffset ), m_lLength( lLength )
+{
+    if( !pszFilename )
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
+    }
+
+    // Fail early if the file cannot be read
+    PdfFileInputStream stream( pszFilename );
+    const pdf_long     lFileLength = stream.GetFileLength();
+
+    if( m_lOffset < 0 || m_lOffset > lFileLength || 
+        (m_lLength >= 0 && m_lOffset + m_lLength > lFileLength) )
+    {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_ValueOutOfRange, "The range of the stream data is not inside the file" );
+    }
+
+    if( m_lLength < 0 )
+        m_lLength = lFileLength - m_lOffset;
+}
+
+PdfInputStream* PdfFileStreamSource::Open() const
+{
+    return new PdfFileRangeInputStream( m_sFilename.c_str(), m_lOffset, m_lLength );
+}
+
+pdf_long PdfFileStreamSource::GetLength() const
+{
+    return m_lLength;
+}
+
+PdfInputStreamSource::PdfInputStreamSource( PdfInputStream* pStream, pdf_long lLength )
+    : m_pStream( pStream ), m_lLength( lLength ), m_bOpened( false )
+{
+    if( !pStream )
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
+    }
+}
+
+PdfInputStreamSource::~PdfInputStreamSource()
+{
+    delete m_pStream;
+}
+
+PdfInputStream* PdfInputStreamSource::Open() const
+{
+    if( m_bOpened )
+    {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_InternalLogic, "The input stream of a PdfInputStreamSource can be read only once" );
+    }
+
+    m_bOpened = true;
+    return new PdfForwardingInputStream( m_pStream );
+}
+
+pdf_long PdfInputStreamSource::GetLength() const
+{
+    return m_lLength;
+}
+
+PdfDeferredStream::PdfDeferredStream( PdfObject* pParent, PdfObject* pLength )
+    : PdfStream( pParent ), m_pSource( NULL ), m_bFlateSettings( false ), m_pLength( pLength ),
+      m_pStream( NULL ), m_pBufferStream( NULL ), m_lLength( 0 ), m_bBuffered( true )
+{
+    if( !m_pLength )
+    {
+        // The length object is written after the stream only if it gets
+        // a higher object number, so a free object number is not reused
+        PdfVecObjects* pOwner = pParent->GetOwner();
+        m_pLength = new PdfObject( PdfReference( static_cast<unsigned int>(pOwner->GetObjectCount()), 0 ),
+                                   PdfVariant( static_cast<pdf_int64>(PODOFO_LL_LITERAL(0)) ) );
+        pOwner->push_back( m_pLength );
+    }
+
+    m_pParent->GetDictionary().AddKey( PdfName::KeyLength, m_pLength->Reference() );
+}
+
+PdfDeferredStream::~PdfDeferredStream()
+{
+    delete m_pSource;
+    delete m_pStream;
+    delete m_pBufferStream;
+}
+
+void PdfDeferredStream::SetSource( PdfStreamSource* pSource, const TVecFilters & vecFilters )
+{
+    if( !pSource )
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
+    }
+
+    try {
+        PODOFO_RAISE_LOGIC_IF( m_bAppend, "SetSource() failed because EndAppend() was not yet called!" );
+
+        // Set the filter keys and clear the stream by appending no data
+        this->BeginAppend( vecFilters, true, true );
+        this->EndAppend();
+    } catch( PdfError & e ) {
+        delete pSource;
+
+        e.AddToCallstack( __FILE__, __LINE__ );
+        throw e;
+    }
+
+    const TFlateSettings* pFlateSettings = this->GetEncodeFlateSettings();
+    m_bFlateSettings = (pFlateSettings != NULL);
+    if( pFlateSettings )
+        m_flateSettings = *pFlateSettings;
+
+    m_pSource    = pSource;
+    m_vecFilters = vecFilters;
+    m_buffer     = PdfRefCountedBuffer();
+    m_bBuffered  = false;
+    m_lLength    = vecFilters.size() ? -1 : pSource->GetLength();
+}
+
+void PdfDeferredStream::SetRawSource( PdfStreamSource* pSource )
+{
+    if( !pSource )
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
+    }
+
+    if( m_bAppend )
+    {
+        delete pSource;
+        PODOFO_RAISE_ERROR_INFO( ePdfError_InternalLogic, "SetRawSource() failed because EndAppend() was not yet called!" );
+    }
+
+    delete m_pSource;
+    m_pSource = pSource;
+    m_vecFilters.clear();
+    m_buffer    = PdfRefCountedBuffer();
+    m_bBuffered = false;
+    m_lLength   = pSource->GetLength();
+}
+
+void PdfDeferredStream::Write( PdfOutputDevice* pDevice, PdfEncrypt* pEncrypt )
+{
+    pDevice->Print( "stream\n" );
+
+    // The data is written again after the length was counted,
+    // and an input stream source cannot be read a second time
+    const bool bLengthOnly = pDevice->IsLengthOnly();
+    if( bLengthOnly )
+        this->BufferSource();
+
+    const pdf_long lStart = pDevice->Tell();
+    if( pEncrypt && 
+        pEncrypt->GetEncryptAlgorithm() != PdfEncrypt::ePdfEncryptAlgorithm_RC4V1 && 
+        pEncrypt->GetEncryptAlgorithm() != PdfEncrypt::ePdfEncryptAlgorithm_RC4V2 )
+    {
+        // Only RC4 can encrypt block by block, all other data 
+        // has to be encrypted at once
+        this->BufferSource();
+
+        const pdf_long lOutputLen = pEncrypt->CalculateStreamLength( m_lLength );
+        char*          pOutputBuffer = new char[lOutputLen];
+
+        try {
+            pEncrypt->Encrypt( reinterpret_cast<const unsigned char*>(m_buffer.GetBuffer()), m_lLength,
+                               reinterpret_cast<unsigned char*>(pOutputBuffer), lOutputLen );
+            pDevice->Write( pOutputBuffer, lOutputLen );
+        } catch( PdfError & ) {
+            delete[] pOutputBuffer;
+            throw;
+        }
+
+        delete[] pOutputBuffer;
+    }
+    else
+    {
+        PdfDeviceOutputStream stream( pDevice );
+        PODOFO_UNIQUEU_PTR<PdfOutputStream> pEncryptStream( pEncrypt ? pEncrypt->CreateEncryptionOutputStream( &stream ) : NULL );
+        PdfOutputStream* pStream = pEncrypt ? pEncryptStream.get() : &stream;
+
+        if( m_bBuffered )
+            pStream->Write( m_buffer.GetBuffer(), m_lLength );
+        else
+            this->EncodeSource( pStream );
+
+        pStream->Close();
+
+        // RC4 does not change the length of the data
+        m_lLength = pDevice->Tell() - lStart;
+    }
+
+    m_pLength->SetNumber( static_cast<pdf_int64>(pDevice->Tell() - lStart) );
+    pDevice->Print( "\nendstream\n" );
+
+    // Do not keep the data of the source in memory
+    if( m_pSource && !bLengthOnly )
+    {
+        m_buffer    = PdfRefCountedBuffer();
+        m_bBuffered = false;
+    }
+}
+
+void PdfDeferredStream::GetCopy( char** pBuffer, pdf_long* lLen ) const
+{
+    if( !pBuffer || !lLen )
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
+    }
+
+    PdfRefCountedBuffer   buffer;
+    PdfBufferOutputStream stream( &buffer );
+    this->GetCopy( &stream );
+    stream.Close();
+
+    *lLen    = stream.GetLength();
+    *pBuffer = static_cast<char*>(podofo_calloc( *lLen, sizeof(char) ));
+    
+    if( !*pBuffer )
+    {
+        PODOFO_RAISE_ERROR( ePdfError_OutOfMemory );
+    }
+
+    if( *lLen )
+        memcpy( *pBuffer, buffer.GetBuffer(), *lLen );
+}
+
+void PdfDeferredStream::GetCopy( PdfOutputStream* pStream ) const
+{
+    if( !pStream )
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
+    }
+
+    if( m_bBuffered )
+        pStream->Write( m_buffer.GetBuffer(), m_lLength );
+    else
+        this->EncodeSource( pStream );
+}
+
+pdf_long PdfDeferredStream::GetLength() const
+{
+    if( m_lLength < 0 )
+        this->BufferSource();
+
+    return m_lLength;
+}
+
+const char* PdfDeferredStream::GetInternalBuffer() const
+{
+    this->BufferSource();
+    return m_buffer.GetBuffer();
+}
+
+pdf_long PdfDeferredStream::GetInternalBufferSize() const
+{
+    this->BufferSource();
+    return m_lLength;
+}
+
+void PdfDeferredStream::BeginAppendImpl( const TVecFilters & vecFilters )
+{
+    delete m_pSource;
+    m_pSource = NULL;
+    m_vecFilters.clear();
+
+    m_buffer    = PdfRefCountedBuffer();
+    m_lLength   = 0;
+    m_bBuffered = true;
+
+    m_pBufferStream = new PdfBufferOutputStream( &m_buffer );
+    if( vecFilters.size() )
+        m_pStream = PdfFilterFactory::CreateEncodeStream( vecFilters, m_pBufferStream, this->GetEncodeFlateSettings() );
+}
+
+void PdfDeferredStream::AppendImpl( const char* pszString, size_t lLen )
+{
+    if( m_pStream )
+        m_pStream->Write( pszString, lLen );
+    else
+        m_pBufferStream->Write( pszString, lLen );
+}
+
+void PdfDeferredStream::EndAppendImpl()
+{
+    if( m_pStream ) 
+    {
+        m_pStream->Close();
+        delete m_pStream;
+        m_pStream = NULL;
+    }
+
+    if( m_pBufferStream ) 
+    {
+        m_pBufferStream->Close();
+        m_lLength = m_pBufferStream->GetLength();
+        delete m_pBufferStream;
+        m_pBufferStream = NULL;
+    }
+}
+
+void PdfDeferredStream::EncodeSource( PdfOutputStream* pStream ) const
+{
+    PODOFO_UNIQUEU_PTR<PdfInputStream>  pInput( m_pSource->Open() );
+    PODOFO_UNIQUEU_PTR<PdfOutputStream> pEncodeStream;
+    if( m_vecFilters.size() )
+        pEncodeStream.reset( PdfFilterFactory::CreateEncodeStream( m_vecFilters, pStream, 
+                                                                   m_bFlateSettings ? &m_flateSettings : NULL ) );
+    PdfOutputStream* pOutput = m_vecFilters.size() ? pEncodeStream.get() : pStream;
+
+    std::vector<char> vecBuffer( PODOFO_DEFERRED_BLOCK_SIZE );
+    pdf_long          lTotal = 0;
+    pdf_long          lRead;
+    while( (lRead = pInput->Read( &vecBuffer[0], PODOFO_DEFERRED_BLOCK_SIZE )) > 0 )
+    {
+        pOutput->Write( &vecBuffer[0], lRead );
+        lTotal += lRead;
+    }
+
+    if( pEncodeStream.get() )
+        pEncodeStream->Close();
+
+    const pdf_long lExpected = m_pSource->GetLength();
+    if( lExpected >= 0 && lTotal != lExpected )
+    {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_UnexpectedEOF, "The stream source returned less or more data than expected" );
+    }
+}
+
+void PdfDeferredStream::BufferSource() const
+{
+    if( m_bBuffered )
+        return;
+
+    m_buffer = PdfRefCountedBuffer();
+
+    PdfBufferOutputStream stream( &m_buffer );
+    this->EncodeSource( &stream );
+    stream.Close();
+
+    m_lLength   = stream.GetLength();
+    m_bBuffered = true;
+}
+
+};
@@ -0,0 +1,327 @@
+/***************************************************************************
+ *   Copyright (C) 2007 by Dominik Seichter                                *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ *                                                                         *
+ *   In addition, as a special exception, the copyright holders give       *
+ *   permission to link the code of portions of this program with the      *
+ *   OpenSSL library under certain conditions as described in each         *
+ *   individual source file, and distribute linked combinations            *
+ *   including the two.                                                    *
+ *   You must obey the GNU General Public License in all respects          *
+ *   for all of the code used other than OpenSSL.  If you modify           *
+ *   file(s) with this exception, you may extend this exception to your    *
+ *   version of the file(s), but you are not obligated to do so.  If you   *
+ *   do not wish to do so, delete this exception statement from your       *
+ *   version.  If you delete this exception statement from all source      *
+ *   files in the program, then also delete it here.                       *
+ ***************************************************************************/
+
+
+#ifndef _PDF_DEFERRED_STREAM_H_
+#define _PDF_DEFERRED_STREAM_H_
+
+#include "PdfDefines.h"
+
+#include "PdfFilter.h"
+#include "PdfRefCountedBuffer.h"
+#include "PdfStream.h"
+
+#include <string>
+
+namespace PoDoFo {
+
+class PdfBufferOutputStream;
+class PdfInputStream;
+class PdfOutputStream;
+
+/** The source of the data of a PdfDeferredStream.
+ *
+ *  The source is opened each time the data of the stream
+ *  is needed, usually once when the document is written.
+ *  Derive from this class to generate stream data on demand.
+ *
+ *  \see PdfFileStreamSource
+ *  \see PdfInputStreamSource
+ */
+class PODOFO_API PdfStreamSource {
+ public:
+    virtual ~PdfStreamSource() { };
+
+    /** Open the source to read all of its data from the start.
+     *
+     *  \returns a new input stream, which has to be deleted by the caller
+     */
+    virtual PdfInputStream* Open() const = 0;
+
+    /** 
+     *  \returns the number of bytes read from an input stream 
+     *           returned by Open() or -1 if it is not known in advance
+     */
+    virtual pdf_long GetLength() const { return -1; }
+};
+
+/** A PdfStreamSource reading a file or a range of bytes in a file.
+ *
+ *  The file is opened only while the data is read,
+ *  so it has to exist until the document has been written.
+ */
+class PODOFO_API PdfFileStreamSource : public PdfStreamSource {
+ public:
+    /** Create a new source reading a file
+     *
+     *  \param pszFilename the file to read
+     *  \param lOffset the data starts at this offset in the file
+     *  \param lLength read this many bytes or the rest of the file if -1
+     */
+    PdfFileStreamSource( const char* pszFilename, pdf_long lOffset = 0, pdf_long lLength = -1 );
+
+    virtual PdfInputStream* Open() const;
+
+    virtual pdf_long GetLength() const;
+
+ private:
+    std::string m_sFilename;
+    pdf_long    m_lOffset;
+    pdf_long    m_lLength;
+};
+
+/** A PdfStreamSource reading a PdfInputStream.
+ *
+ *  An input stream can be read only once, so the data of the 
+ *  stream can only be written once and is not available afterwards.
+ *  Use a PdfFileStreamSource or an own PdfStreamSource if the 
+ *  document may be written more than once.
+ */
+class PODOFO_API PdfInputStreamSource : public PdfStreamSource {
+ public:
+    /** Create a new source reading an input stream
+     *
+     *  \param pStream read the data from this input stream,
+     *                 which is deleted along with the source
+     *  \param lLength the number of bytes pStream returns or -1 if it is not known
+     */
+    PdfInputStreamSource( PdfInputStream* pStream, pdf_long lLength = -1 );
+
+    virtual ~PdfInputStreamSource();
+
+    /** Can be called only once.
+     *  \returns an input stream reading the input stream of this source
+     */
+    virtual PdfInputStream* Open() const;
+
+    virtual pdf_long GetLength() const;
+
+ private:
+    /** copy constructor, not implemented
+     */
+    PdfInputStreamSource( const PdfInputStreamSource & rhs );
+    /** assignment operator, not implemented
+     */
+    PdfInputStreamSource & operator=( const PdfInputStreamSource & rhs );
+
+ private:
+    PdfInputStream* m_pStream;
+    pdf_long        m_lLength;
+    mutable bool    m_bOpened;
+};
+
+/** A PDF stream can be appended to any PdfObject
+ *  and can contain arbitrary data.
+ *
+ *  A PdfDeferredStream reads its data from a PdfStreamSource
+ *  and encodes it only while it is written, block by block.
+ *  This allows to write documents containing large files,
+ *  like images or fonts, without ever holding them in memory.
+ *
+ *  As the length of the encoded data is not known before, the /Length
+ *  key of the stream refers to an indirect object, which is updated
+ *  when the stream is written and written after the stream.
+ *
+ *  Reading the data of the stream, e.g. using GetFilteredCopy(),
+ *  reads the source into memory until the stream is written.
+ *  Writing the stream to a PdfOutputDevice which only counts the length,
+ *  like the first pass of a linearized PdfWriter does, keeps the encoded
+ *  data in memory, too, until the stream is written to a real device.
+ *  So the source is read and encoded only once, even when linearizing.
+ *  Data appended to the stream replaces the source and is kept
+ *  in memory like in a PdfMemStream.
+ *
+ *  Use PdfObject::CreateDeferredStream() to create a PdfDeferredStream.
+ *
+ *  \see PdfStreamSource
+ *  \see PdfMemStream
+ *  \see PdfFileStream
+ */
+class PODOFO_API PdfDeferredStream : public PdfStream {
+    friend class PdfObject;
+
+ public:
+    virtual ~PdfDeferredStream();
+
+    /** Set the source of the data of this stream, 
+     *  which is encoded with vecFilters when the stream is written.
+     *
+     *  The /Filter and /DecodeParms keys are set like BeginAppend() does.
+     *
+     *  \param pSource the source of the data, which is 
+     *                 deleted along with the stream (or if an error occurs)
+     *  \param vecFilters a list of filters to encode the data with
+     */
+    void SetSource( PdfStreamSource* pSource, const TVecFilters & vecFilters );
+
+    /** Set the source of the data of this stream,
+     *  which is written as it is.
+     *
+     *  Like SetRawData(), this does not modify the filters of 
+     *  the object and the data is expected to be encoded as stated 
+     *  by its /Filter key, e.g. a JPEG file for a DCTDecode image.
+     *
+     *  \param pSource the source of the data, which is 
+     *                 deleted along with the stream (or if an error occurs)
+     */
+    void SetRawSource( PdfStreamSource* pSource );
+
+    /**
+     *  \returns true if the data of this stream is read from a PdfStreamSource
+     */
+    inline bool HasSource() const;
+
+    /** Write the stream to an output device
+     *
+     *  The data of the source is read and encoded while it is written,
+     *  unless the stream is encrypted using AES, which requires 
+     *  all of the data in memory, or pDevice only counts the length.
+     *  In the latter case the encoded data is kept in memory
+     *  for the next write.
+     *
+     *  \param pDevice write to this outputdevice.
+     *  \param pEncrypt encrypt stream data using this object
+     */
+    virtual void Write( PdfOutputDevice* pDevice, PdfEncrypt* pEncrypt = NULL );
+
+    /** Get a malloced buffer of the current stream.
+     *  No filters will be applied to the buffer, so
+     *  if the stream is Flate compressed the compressed copy
+     *  will be returned.
+     *
+     *  The caller has to podofo_free() the buffer.
+     *
+     *  \param pBuffer pointer to the buffer address (output parameter)
+     *  \param lLen    pointer to the buffer length  (output parameter)
+     */
+    virtual void GetCopy( char** pBuffer, pdf_long* lLen ) const;
+
+    /** Get a copy of a the stream and write it to a PdfOutputStream
+     *
+     *  \param pStream data is written to this stream.
+     */
+    virtual void GetCopy( PdfOutputStream* pStream ) const;
+
+    /** Get the streams length with all filters applied (eg the compressed
+     *  length of a Flate compressed stream).
+     *
+     *  If the length is not known yet, the source is read into memory
+     *  to determine it.
+     *
+     *  \returns the length of the stream with all filters applied
+     */
+    virtual pdf_long GetLength() const;
+
+ protected:
+    /** Required for the GetFilteredCopy implementation
+     *
+     *  The data of the source is read into memory
+     *  and kept there until the stream is written.
+     *
+     *  \returns a handle to the internal buffer
+     */
+    virtual const char* GetInternalBuffer() const;
+
+    /** Required for the GetFilteredCopy implementation
+     *  \returns the size of the internal buffer
+     */
+    virtual pdf_long GetInternalBufferSize() const;
+
+    /** Begin appending data to this stream.
+     *  Clears the current stream contents and removes the source.
+     *
+     *  \param vecFilters use this filters to encode any data written to the stream.
+     */
+    virtual void BeginAppendImpl( const TVecFilters & vecFilters );
+
+    /** Append a binary buffer to the current stream contents.
+     *
+     *  \param pszString a buffer
+     *  \param lLen length of the buffer
+     *
+     *  \see BeginAppend
+     *  \see Append
+     *  \see EndAppend
+     */
+    virtual void AppendImpl( const char* pszString, size_t lLen ); 
+
+    /** Finish appending data to the stream
+     */
+    virtual void EndAppendImpl();
+
+ private:
+    /** Create a new PdfDeferredStream object which has a parent PdfObject.
+     *  Use PdfObject::CreateDeferredStream to create a stream.
+     *
+     *  \param pParent parent object, which has to be owned by a PdfVecObjects
+     *  \param pLength the length object of a PdfDeferredStream which is replaced 
+     *                 by this one or NULL to create a new length object
+     */
+    PdfDeferredStream( PdfObject* pParent, PdfObject* pLength = NULL );
+
+    /** Read the source and write its encoded data to pStream.
+     *  pStream is not closed.
+     */
+    void EncodeSource( PdfOutputStream* pStream ) const;
+
+    /** Read the encoded data of the source into m_buffer
+     */
+    void BufferSource() const;
+
+ private:
+    PdfStreamSource*            m_pSource;
+    TVecFilters                 m_vecFilters;     ///< filters to encode the source with
+    TFlateSettings              m_flateSettings;
+    bool                        m_bFlateSettings; ///< m_flateSettings are used to encode the source
+
+    PdfObject*                  m_pLength;
+
+    PdfOutputStream*            m_pStream;
+    PdfBufferOutputStream*      m_pBufferStream;
+
+    mutable PdfRefCountedBuffer m_buffer;
+    mutable pdf_long            m_lLength;        ///< length of the encoded data or -1 if not known yet
+    mutable bool                m_bBuffered;      ///< m_buffer contains the encoded data
+};
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+bool PdfDeferredStream::HasSource() const
+{
+    return m_pSource != NULL;
+}
+
+};
+
+#endif // _PDF_DEFERRED_STREAM_H_
@@ -186,6 +186,14 @@ enum EPdfWriteMode {
 
 const EPdfWriteMode ePdfWriteMode_Default = ePdfWriteMode_Compact;
 
+/**
+ * Specify how a PdfInputDevice accesses the file or buffer it reads from.
+ */
+enum EPdfInputMode {
+    ePdfInputMode_Default  = 0x00, ///< Read files through stdio and copy memory buffers (Default)
+    ePdfInputMode_ZeroCopy = 0x01  ///< Map files into memory and use memory buffers in place without copying them
+};
+
 /**
  * Every PDF datatype that can occur in a PDF file
  * is referenced by an own enum (e.g. Bool or String).
@@ -37,12 +37,9 @@
 #include "PdfLocale.h"
 #include "util/PdfMutexWrapper.h"
 #include "PdfDefinesPrivate.h"
-#include "base/PdfStream.h"
-#include "base/PdfContentsTokenizer.h"
 
 #include "doc/PdfFont.h"
 
-#include <stack>
 #include <stdlib.h>
 #include <string.h>
 #include <limits>
@@ -70,51 +67,15 @@ PdfEncoding::~PdfEncoding()
     
 PdfString PdfEncoding::ConvertToUnicode(const PdfString & rEncodedString, const PdfFont*) const
 {
-    
-    if(!m_toUnicode.empty())
-    {
-        
-        const pdf_utf16be* pStr = reinterpret_cast<const pdf_utf16be*>(rEncodedString.GetString());
-        const size_t lLen = rEncodedString.GetLength()/2;
-        pdf_utf16be lCID, lUnicodeValue;
-        
-        pdf_utf16be* pszUtf16 = static_cast<pdf_utf16be*>(podofo_calloc(lLen, sizeof(pdf_utf16be)));
-        if( !pszUtf16 )
-        {
-            PODOFO_RAISE_ERROR( ePdfError_OutOfMemory );
-        }
-        
-        for(size_t i = 0 ; i<lLen ; i++)
-        {
-            
-#ifdef PODOFO_IS_LITTLE_ENDIAN
-            lCID = (pStr[i] << 8) | (pStr[i] >> 8 );
-#else
-            lCID = pStr[i];
-#endif // PODOFO_IS_LITTLE_ENDIAN
-            
-            lUnicodeValue = this->GetUnicodeValue(lCID);
-            
-#ifdef PODOFO_IS_LITTLE_ENDIAN
-            pszUtf16[i] = (lUnicodeValue << 8) | (lUnicodeValue >> 8 );
-#else
-            pszUtf16[i] = lUnicodeValue;
-#endif // PODOFO_IS_LITTLE_ENDIAN
-        }
-        
-        PdfString ret( pszUtf16, lLen );
-        podofo_free( pszUtf16 );
-        
-        return ret;
-        
-    }
+    if(m_toUnicode.HasUnicodeMappings())
+        return m_toUnicode.DecodeToUnicode(rEncodedString);
     else
         return(PdfString("\0"));
 }
 
 PdfRefCountedBuffer PdfEncoding::ConvertToEncoding( const PdfString & rString, const PdfFont* pFont ) const
 {
-    if(!m_toUnicode.empty())
+    if(m_toUnicode.HasUnicodeMappings())
     {
         // Get the string in UTF-16be format
         PdfString sStr = rString.ToUnicode();
@@ -160,200 +121,22 @@ void PdfEncoding::ParseToUnicode()
 {
     if (m_pToUnicode && m_pToUnicode->HasStream())
     {
-        std::stack<std::string> stkToken;
-        pdf_uint16 loop = 0;
-        char *streamBuffer;
-        const char *streamToken = NULL;
-        EPdfTokenType *streamTokenType = NULL;
-        pdf_long streamBufferLen;
-        bool in_beginbfrange = 0;
-        bool in_beginbfchar = 0;
-        pdf_uint16 range_entries = 0;
-        pdf_uint16 char_entries = 0;
-        pdf_uint16 inside_hex_string = 0;
-        pdf_uint16 inside_array = 0;
-        pdf_uint16 range_start = 0;
-        pdf_uint16 range_end = 0;
-        pdf_uint16 i = 0;
-        pdf_utf16be firstvalue = 0;
-        const PdfStream *CIDStreamdata = m_pToUnicode->GetStream ();
-        CIDStreamdata->GetFilteredCopy (&streamBuffer, &streamBufferLen);
-        
-        PdfContentsTokenizer streamTokenizer (streamBuffer, streamBufferLen);
-        while (streamTokenizer.GetNextToken (streamToken, streamTokenType))
-        {
-            stkToken.push (streamToken);
-            
-            if (strcmp (streamToken, ">") == 0)
-            {
-                if (inside_hex_string == 0)
-                    PODOFO_RAISE_ERROR_INFO(ePdfError_InvalidStream, "CMap Error, got > before <")
-                    else
-                        inside_hex_string = 0;
-                
-                if (inside_array == 0)
-                {
-                    i++;
-                }
-            }
-            
-            if (strcmp (streamToken, "]") == 0)
-            {
-                if (inside_array == 0)
-                    PODOFO_RAISE_ERROR_INFO(ePdfError_InvalidStream, "CMap Error, got ] before [")
-                else
-                    inside_array = 0;
-                
-                i++;
-                loop++;
-            }
-            
-            if (in_beginbfrange == 1)
-            {
-                if (loop < range_entries)
-                {
-                    if (inside_hex_string == 1)
-                    {
-                        pdf_utf16be num_value;
-                        std::stringstream ss;
-                        ss << std::hex << streamToken;
-                        ss >> num_value;
-                        if (i % 3 == 0)
-                            range_start = num_value;
-                        if (i % 3 == 1)
-                        {
-                            range_end = num_value;
-                        }
-                        if (i % 3 == 2)
-                        {
-                            if (inside_array == 0)
-                            {
-                                for (int k = range_start; k <= range_end; k++)
-                                {
-                                    m_toUnicode[k] = num_value;
-                                    num_value++;
-                                }
-							
-                                loop++;
-                            }
-                            else
-                            {
-                                m_toUnicode[range_start] = num_value;
-                            }
-
-                            range_start++;
-                        }
-                    }
-                }
-            }
-            
-            if (in_beginbfchar == 1)
-            {
-                if (loop < char_entries)
-                {
-                    if (inside_hex_string == 1)
-                    {
-                        pdf_utf16be num_value;
-                        std::stringstream ss;
-                        ss << std::hex << streamToken;
-                        ss >> num_value;
-                        if (i % 2 == 0)
-                        {
-                            firstvalue = num_value;
-                        }
-                        if (i % 2 == 1)
-                        {
-                            m_toUnicode[firstvalue] = num_value;
-                        }
-                    }
-                }
-            }
-            
-            
-            if (strcmp (streamToken, "<") == 0)
-            {
-                inside_hex_string = 1;
-            }
-            
-            
-            
-            if (strcmp (streamToken, "[") == 0)
-            {
-                inside_array = 1;
-            }
-            
-            
-            if (strcmp (streamToken, "beginbfrange") == 0)
-            {
-                // need 2 entries - one to pop() and one for top()
-                if ( stkToken.size() < 2 )
-                {
-                    PODOFO_RAISE_ERROR_INFO(ePdfError_InvalidStream, "CMap missing object number before beginbfrange");
-                }
-                
-                i = loop = 0;
-                in_beginbfrange = 1;
-                stkToken.pop ();
-                std::stringstream ss;
-                ss << std::hex << stkToken.top ();
-                ss >> range_entries;
-            }
-            
-            if (strcmp (streamToken, "endbfrange") == 0)
-            {
-                in_beginbfrange = 0;
-                i = 0;
-            }
-            
-            if (strcmp (streamToken, "beginbfchar") == 0)
-            {
-                // need 2 entries - one to pop() and one for top()
-                if ( stkToken.size() < 2 )
-                {
-                    PODOFO_RAISE_ERROR_INFO(ePdfError_InvalidStream, "CMap missing object number before beginbfchar");
-                }
-                
-                i = loop = 0;
-                in_beginbfchar = 1;
-                stkToken.pop ();
-                std::stringstream ss;
-                ss << std::hex << stkToken.top ();
-                ss >> char_entries;
-            }
-            
-            if (strcmp (streamToken, "endbfchar") == 0)
-            {
-                in_beginbfchar = 0;
-                i = 0;
-            }
-        }
-        
-        podofo_free(streamBuffer);
-        
+        // Fonts using the same /ToUnicode CMap share the compiled CMap
+        m_toUnicode = PdfCMapCache::GetCMap( m_pToUnicode );
         m_bToUnicodeIsLoaded = true;
     }
 }
 
 pdf_utf16be PdfEncoding::GetUnicodeValue( pdf_utf16be  value ) const
 {
-    if(!m_toUnicode.empty())
-    {
-        const std::map<pdf_utf16be, pdf_utf16be>::const_iterator found = m_toUnicode.find(value);
-        return (found == m_toUnicode.end() ? 0 : found->second);
-    }
-    
-    return 0;
+    return m_toUnicode.GetUnicodeValue( value );
 }
 
 pdf_utf16be PdfEncoding::GetCIDValue( pdf_utf16be lUnicodeValue ) const
 {
-    if(!m_toUnicode.empty())
-    {
-        // TODO: optimize
-        for(std::map<pdf_utf16be, pdf_utf16be>::const_iterator it = m_toUnicode.begin(); it != m_toUnicode.end(); ++it)
-            if(it->second == lUnicodeValue)
-                return it->first;
-    }
+    pdf_uint32 nCode;
+    if( m_toUnicode.GetCode( lUnicodeValue, &nCode ) )
+        return static_cast<pdf_utf16be>(nCode);
     
     return 0;
 }
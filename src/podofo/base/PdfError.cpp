@@ -363,6 +363,9 @@ const char* PdfError::ErrorName( EPdfError eCode )
         case ePdfError_NotLoadedForUpdate:
             pszMsg = "ePdfError_NotLoadedForUpdate"; 
             break;
+        case ePdfError_ThreadError:
+            pszMsg = "ePdfError_ThreadError";
+            break;
         case ePdfError_CannotEncryptedForUpdate:
             pszMsg = "ePdfError_CannotEncryptedForUpdate"; 
             break;
@@ -514,6 +517,9 @@ const char* PdfError::ErrorMessage( EPdfError eCode )
         case ePdfError_CannotEncryptedForUpdate:
             pszMsg = "Cannot load encrypted documents for update.";
             break;
+        case ePdfError_ThreadError:
+            pszMsg = "Error while starting or joining a thread.";
+            break;
         case ePdfError_Unknown:
             pszMsg = "Error code unknown.";
             break;
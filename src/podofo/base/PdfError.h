@@ -129,6 +129,8 @@ enum EPdfError {
     ePdfError_NotLoadedForUpdate,       /**< The document had not been loaded for update. */
     ePdfError_CannotEncryptedForUpdate, /**< Cannot load encrypted documents for update. */
 
+    ePdfError_ThreadError,              /**< Error while starting or joining a thread */
+
     ePdfError_Unknown = 0xffff          /**< Unknown error */
 };
 
@@ -65,14 +65,16 @@ void PdfFileStream::BeginAppendImpl( const TVecFilters & vecFilters )
 
     if( vecFilters.size() )
     {
+        const TFlateSettings* pFlateSettings = this->GetEncodeFlateSettings();
+
         m_pDeviceStream = new PdfDeviceOutputStream( m_pDevice );
         if( m_pCurEncrypt ) 
         {
             m_pEncryptStream = m_pCurEncrypt->CreateEncryptionOutputStream( m_pDeviceStream );
-            m_pStream        = PdfFilterFactory::CreateEncodeStream( vecFilters, m_pEncryptStream );
+            m_pStream        = PdfFilterFactory::CreateEncodeStream( vecFilters, m_pEncryptStream, pFlateSettings );
         }
         else
-            m_pStream        = PdfFilterFactory::CreateEncodeStream( vecFilters, m_pDeviceStream );
+            m_pStream        = PdfFilterFactory::CreateEncodeStream( vecFilters, m_pDeviceStream, pFlateSettings );
     }
     else 
     {
@@ -90,8 +90,10 @@ class PdfFilteredEncodeStream : public PdfOutputStream{
      *  \param pOutputStream write all data to this output stream after encoding the data.
      *  \param eFilter use this filter for encoding.
      *  \param bOwnStream if true pOutputStream will be deleted along with this filter
+     *  \param pFlateSettings settings for a FlateDecode filter or NULL for the defaults
      */
-    PdfFilteredEncodeStream( PdfOutputStream* pOutputStream, const EPdfFilter eFilter, bool bOwnStream )
+    PdfFilteredEncodeStream( PdfOutputStream* pOutputStream, const EPdfFilter eFilter, bool bOwnStream,
+                             const TFlateSettings* pFlateSettings = NULL )
         : m_pOutputStream( pOutputStream ), m_pFilter( NULL )
     {
         m_pFilter = PdfFilterFactory::Create( eFilter );
@@ -101,6 +103,9 @@ class PdfFilteredEncodeStream : public PdfOutputStream{
             PODOFO_RAISE_ERROR( ePdfError_UnsupportedFilter );
         }
 
+        if( pFlateSettings && eFilter == ePdfFilter_FlateDecode )
+            static_cast<PdfFlateFilter*>(m_pFilter)->SetSettings( *pFlateSettings );
+
         m_pFilter->BeginEncode( pOutputStream );
 
         if( !bOwnStream )
@@ -271,14 +276,200 @@ void PdfFilter::Decode( const char* pInBuffer, pdf_long lInLen, char** ppOutBuff
     *plOutLen    = stream.GetLength();
 }
 
+// -----------------------------------------------------
+// PdfFilteredInputStream code
+// -----------------------------------------------------
+
+/** Size of the blocks of encoded data which PdfFilteredInputStream decodes at once
+ */
+#define PODOFO_FILTERED_INPUT_BLOCK_SIZE 4096
+
+/** Collects the decoded data of one block for PdfFilteredInputStream.
+ *  The buffer keeps its capacity when it is cleared.
+ */
+class PdfFilteredInputStreamSink : public PdfOutputStream {
+ public:
+    virtual pdf_long Write( const char* pBuffer, pdf_long lLen )
+    {
+        m_vecData.insert( m_vecData.end(), pBuffer, pBuffer + lLen );
+        return lLen;
+    }
+
+    virtual void Close() 
+    {
+    }
+
+    inline void Clear() 
+    {
+        m_vecData.clear();
+    }
+
+    inline const char* GetBuffer() const
+    {
+        return m_vecData.size() ? &m_vecData[0] : NULL;
+    }
+
+    inline pdf_long GetLength() const
+    {
+        return static_cast<pdf_long>(m_vecData.size());
+    }
+
+ private:
+    std::vector<char> m_vecData;
+};
+
+PdfFilteredInputStream::PdfFilteredInputStream( const char* pBuffer, pdf_long lLen, const TVecFilters & filters,
+                                                const PdfDictionary* pDictionary )
+    : m_pInput( pBuffer ), m_lInputLen( lLen ), m_lInputPos( 0 ), 
+      m_pDecodeStream( NULL ), m_pSink( new PdfFilteredInputStreamSink() ), m_lSinkPos( 0 )
+{
+    if( filters.size() )
+    {
+        try {
+            m_pDecodeStream = PdfFilterFactory::CreateDecodeStream( filters, m_pSink, pDictionary );
+        } catch( PdfError & e ) {
+            delete m_pSink;
+            throw e;
+        }
+    }
+}
+
+PdfFilteredInputStream::~PdfFilteredInputStream()
+{
+    if( m_pDecodeStream )
+    {
+        // Not all data was read, finish the filters anyways
+        try {
+            m_pDecodeStream->Close();
+        } catch( PdfError & ) {
+        }
+
+        delete m_pDecodeStream;
+    }
+
+    delete m_pSink;
+}
+
+bool PdfFilteredInputStream::DecodeNextBlock()
+{
+    m_pSink->Clear();
+    m_lSinkPos = 0;
+
+    // Some blocks, e.g. the beginning of a flate stream,
+    // give no output, so continue until something was decoded
+    while( !m_pSink->GetLength() )
+    {
+        if( m_lInputPos >= m_lInputLen )
+        {
+            if( !m_pDecodeStream )
+                return false;
+
+            // Flush all data buffered in the filters
+            PdfOutputStream* pDecodeStream = m_pDecodeStream;
+            m_pDecodeStream = NULL;
+            try {
+                pDecodeStream->Close();
+            } catch( PdfError & e ) {
+                delete pDecodeStream;
+                throw e;
+            }
+            delete pDecodeStream;
+
+            return m_pSink->GetLength() != 0;
+        }
+
+        const pdf_long lBlock = PDF_MIN( m_lInputLen - m_lInputPos, static_cast<pdf_long>(PODOFO_FILTERED_INPUT_BLOCK_SIZE) );
+        if( m_pDecodeStream )
+            m_pDecodeStream->Write( m_pInput + m_lInputPos, lBlock );
+        else
+            m_pSink->Write( m_pInput + m_lInputPos, lBlock );
+
+        m_lInputPos += lBlock;
+    }
+
+    return true;
+}
+
+bool PdfFilteredInputStream::ReadChunk( const char** ppBuffer, pdf_long* plLen )
+{
+    if( m_lSinkPos >= m_pSink->GetLength() )
+    {
+        if( !m_pDecodeStream && m_lInputPos < m_lInputLen )
+        {
+            // Unfiltered data is handed out as it is
+            m_pSink->Clear();
+            m_lSinkPos = 0;
+
+            *ppBuffer    = m_pInput + m_lInputPos;
+            *plLen       = m_lInputLen - m_lInputPos;
+            m_lInputPos  = m_lInputLen;
+            return true;
+        }
+
+        if( !this->DecodeNextBlock() )
+        {
+            *ppBuffer = NULL;
+            *plLen    = 0;
+            return false;
+        }
+    }
+
+    *ppBuffer  = m_pSink->GetBuffer() + m_lSinkPos;
+    *plLen     = m_pSink->GetLength() - m_lSinkPos;
+    m_lSinkPos = m_pSink->GetLength();
+    return true;
+}
+
+pdf_long PdfFilteredInputStream::Read( char* pBuffer, pdf_long lLen, pdf_long* )
+{
+    pdf_long lRead = 0;
+    while( lRead < lLen )
+    {
+        if( m_lSinkPos >= m_pSink->GetLength() && !this->DecodeNextBlock() )
+            break;
+
+        const pdf_long lCopy = PDF_MIN( lLen - lRead, m_pSink->GetLength() - m_lSinkPos );
+        memcpy( pBuffer + lRead, m_pSink->GetBuffer() + m_lSinkPos, lCopy );
+        m_lSinkPos += lCopy;
+        lRead      += lCopy;
+    }
+
+    return lRead;
+}
+
 // -----------------------------------------------------
 // PdfFilterFactory code
 // -----------------------------------------------------
 
+TFlateSettings         PdfFilterFactory::s_flateSettings;
+const PdfFlateEncoder* PdfFilterFactory::s_pFlateEncoder = NULL;
+
+static const PdfZlibFlateEncoder s_zlibFlateEncoder;
+
 PdfFilterFactory::PdfFilterFactory()
 {
 }
 
+void PdfFilterFactory::SetFlateSettings( const TFlateSettings & rSettings )
+{
+    s_flateSettings = rSettings;
+}
+
+const TFlateSettings & PdfFilterFactory::GetFlateSettings()
+{
+    return s_flateSettings;
+}
+
+void PdfFilterFactory::SetFlateEncoder( const PdfFlateEncoder* pEncoder )
+{
+    s_pFlateEncoder = pEncoder;
+}
+
+const PdfFlateEncoder* PdfFilterFactory::GetFlateEncoder()
+{
+    return s_pFlateEncoder ? s_pFlateEncoder : &s_zlibFlateEncoder;
+}
+
 PdfFilter* PdfFilterFactory::Create( const EPdfFilter eFilter ) 
 {
     PdfFilter* pFilter = NULL;
@@ -335,17 +526,23 @@ PdfFilter* PdfFilterFactory::Create( const EPdfFilter eFilter )
 }
 
 PdfOutputStream* PdfFilterFactory::CreateEncodeStream( const TVecFilters & filters, PdfOutputStream* pStream ) 
+{
+    return PdfFilterFactory::CreateEncodeStream( filters, pStream, NULL );
+}
+
+PdfOutputStream* PdfFilterFactory::CreateEncodeStream( const TVecFilters & filters, PdfOutputStream* pStream,
+                                                       const TFlateSettings* pFlateSettings ) 
 {
     TVecFilters::const_iterator it = filters.begin();
 
     PODOFO_RAISE_LOGIC_IF( !filters.size(), "Cannot create an EncodeStream from an empty list of filters" );
 
-    PdfFilteredEncodeStream* pFilter = new PdfFilteredEncodeStream( pStream, *it, false );
+    PdfFilteredEncodeStream* pFilter = new PdfFilteredEncodeStream( pStream, *it, false, pFlateSettings );
     ++it;
 
     while( it != filters.end() ) 
     {
-        pFilter = new PdfFilteredEncodeStream( pFilter, *it, true );
+        pFilter = new PdfFilteredEncodeStream( pFilter, *it, true, pFlateSettings );
         ++it;
     }
 
@@ -359,17 +556,34 @@ PdfOutputStream* PdfFilterFactory::CreateDecodeStream( const TVecFilters & filte
 
     PODOFO_RAISE_LOGIC_IF( !filters.size(), "Cannot create an DecodeStream from an empty list of filters" );
 
-    // TODO: support arrays and indirect objects here and the short name /DP
-    if( pDictionary && pDictionary->HasKey( "DecodeParms" ) && pDictionary->GetKey( "DecodeParms" )->IsDictionary() )
-        pDictionary = &(pDictionary->GetKey( "DecodeParms" )->GetDictionary());
-
-    PdfFilteredDecodeStream* pFilterStream = new PdfFilteredDecodeStream( pStream, *it, false, pDictionary );
-    ++it;
+    // TODO: support indirect objects here and the short name /DP
+    const PdfArray* pDecodeParmsArray = NULL;
+    if( pDictionary && pDictionary->HasKey( "DecodeParms" ) )
+    {
+        const PdfObject* pDecodeParms = pDictionary->GetKey( "DecodeParms" );
+        if( pDecodeParms->IsDictionary() )
+            pDictionary = &(pDecodeParms->GetDictionary());
+        else if( pDecodeParms->IsArray() )
+            pDecodeParmsArray = &(pDecodeParms->GetArray());
+    }
 
+    size_t                   nIndex        = filters.size() - 1;
+    PdfFilteredDecodeStream* pFilterStream = NULL;
     while( it != filters.rend() ) 
     {
-        pFilterStream = new PdfFilteredDecodeStream( pFilterStream, *it, true, pDictionary );
+        // An array holds the parameters of each filter, or null
+        const PdfDictionary* pDecodeParms = pDictionary;
+        if( pDecodeParmsArray )
+            pDecodeParms = nIndex < pDecodeParmsArray->size() && (*pDecodeParmsArray)[nIndex].IsDictionary() ?
+                &((*pDecodeParmsArray)[nIndex].GetDictionary()) : NULL;
+
+        if( pFilterStream )
+            pFilterStream = new PdfFilteredDecodeStream( pFilterStream, *it, true, pDecodeParms );
+        else
+            pFilterStream = new PdfFilteredDecodeStream( pStream, *it, false, pDecodeParms );
+
         ++it;
+        --nIndex;
     }
 
     return pFilterStream;
@@ -407,6 +621,12 @@ const char* PdfFilterFactory::FilterTypeToName( EPdfFilter eFilter )
     return aszFilters[static_cast<int>(eFilter)];
 }
 
+bool PdfFilterFactory::IsImageCodec( EPdfFilter eFilter )
+{
+    return eFilter == ePdfFilter_DCTDecode || eFilter == ePdfFilter_JPXDecode || 
+           eFilter == ePdfFilter_JBIG2Decode || eFilter == ePdfFilter_CCITTFaxDecode;
+}
+
 TVecFilters PdfFilterFactory::CreateFilterList( const PdfObject* pObject )
 {
     TVecFilters filters;
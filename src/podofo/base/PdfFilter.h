@@ -53,6 +53,79 @@ typedef std::vector<EPdfFilter>            TVecFilters;
 typedef TVecFilters::iterator              TIVecFilters;
 typedef TVecFilters::const_iterator        TCIVecFilters;
 
+/** The compression strategies of the FlateDecode encoder.
+ *  They correspond to the strategy parameter of zlib's deflateInit2.
+ */
+enum EPdfFlateStrategy {
+    ePdfFlateStrategy_Default = 0,     ///< Normal data
+    ePdfFlateStrategy_Filtered,        ///< Data produced by a predictor, i.e. small values with random distribution
+    ePdfFlateStrategy_HuffmanOnly,     ///< Huffman encoding only, no string matching
+    ePdfFlateStrategy_RLE,             ///< Limit match distances to one, fast for image data
+    ePdfFlateStrategy_Fixed            ///< Do not use dynamic Huffman codes
+};
+
+/** Parameters of the FlateDecode encoder.
+ *
+ *  Besides the compression level and strategy, the settings can name a
+ *  predictor which is applied to the data before it is compressed.
+ *  A predictor is meant for single streams with a known row layout
+ *  (images, XRef streams), see PdfStream::SetFlateSettings. PdfStream
+ *  writes the matching /DecodeParms dictionary.
+ *
+ *  \see PdfFilterFactory::SetFlateSettings
+ *  \see PdfVecObjects::SetFlateSettings
+ */
+struct TFlateSettings {
+    /** Create settings
+     *  \param level the compression level from 0 (store only) to 9 (best compression)
+     *               or -1 for the default level of the encoder
+     *  \param strategy the compression strategy
+     */
+    TFlateSettings( int level = -1, EPdfFlateStrategy strategy = ePdfFlateStrategy_Default )
+        : nLevel( level ), eStrategy( strategy ),
+          nPredictor( 1 ), nColors( 1 ), nBitsPerComponent( 8 ), nColumns( 1 )
+    {
+    }
+
+    int               nLevel;    ///< The compression level, -1 to 9
+    EPdfFlateStrategy eStrategy; ///< The compression strategy
+
+    int               nPredictor;        ///< 1 for none, 2 for TIFF, 10 to 14 for a PNG predictor or 15 for the best PNG predictor of each row
+    int               nColors;           ///< Color components per sample, only used with a predictor
+    int               nBitsPerComponent; ///< Bits per color component (1, 2, 4, 8 or 16), only used with a predictor
+    int               nColumns;          ///< Samples per row, only used with a predictor
+};
+
+/** An encoder which compresses a whole buffer into the zlib format
+ *  (RFC 1950) expected by the FlateDecode filter.
+ *
+ *  PoDoFo uses an encoder whenever all data of a stream is available at once,
+ *  e.g. when a PdfMemStream is compressed. Incremental encoding through
+ *  PdfFilter::BeginEncode and data with a predictor always use zlib.
+ *
+ *  Implement this interface to plug in a faster deflate implementation
+ *  and register it using PdfFilterFactory::SetFlateEncoder.
+ */
+class PODOFO_API PdfFlateEncoder {
+ public:
+    virtual ~PdfFlateEncoder() {}
+
+    /** Compress a buffer.
+     *
+     *  Implementations have to be thread safe, as PdfWriter
+     *  may compress several streams concurrently.
+     *
+     *  \param pInBuffer the data to compress
+     *  \param lInLen length of the data to compress
+     *  \param ppOutBuffer receives the compressed data, allocated using podofo_malloc().
+     *                     The caller has to podofo_free() it.
+     *  \param plOutLen receives the length of the compressed data
+     *  \param rSettings compression level and strategy to use
+     */
+    virtual void Encode( const char* pInBuffer, pdf_long lInLen, char** ppOutBuffer, pdf_long* plOutLen,
+                         const TFlateSettings & rSettings ) const = 0;
+};
+
 /** Every filter in PoDoFo has to implement this interface.
  * 
  *  The two methods Encode() and Decode() have to be implemented 
@@ -454,6 +527,69 @@ PdfFilter::~PdfFilter()
 }
 
 
+class PdfFilteredInputStreamSink;
+
+/** An input stream which decodes data with a list of filters while it is read.
+ *
+ *  The encoded data is passed through the filters in small blocks,
+ *  so only the decoded data of one block is held in memory at any time,
+ *  however large the stream is. The buffer for the decoded data is reused
+ *  for all blocks.
+ *
+ *  \see PdfStream::CreateFilteredInputStream
+ */
+class PODOFO_API PdfFilteredInputStream : public PdfInputStream {
+ public:
+    /** Create a filtered input stream.
+     *
+     *  \param pBuffer the encoded data, which has to live as long as this stream
+     *  \param lLen length of the encoded data
+     *  \param filters decode the data using these filters, may be empty
+     *  \param pDictionary the stream dictionary, which might contain a 
+     *         DecodeParms key with parameters for the filters
+     */
+    PdfFilteredInputStream( const char* pBuffer, pdf_long lLen, const TVecFilters & filters,
+                            const PdfDictionary* pDictionary = NULL );
+
+    virtual ~PdfFilteredInputStream();
+
+    /** Read decoded data from the stream
+     *  
+     *  \param pBuffer    the data will be stored into this buffer
+     *  \param lLen       the size of the buffer and number of bytes
+     *                    that will be read
+     *  \param pTotalLeft unused
+     *
+     *  \returns the number of bytes read or zero if all data has been read
+     */
+    virtual pdf_long Read( char* pBuffer, pdf_long lLen, pdf_long* pTotalLeft = 0 );
+
+    /** Hand out the next block of decoded data without copying it.
+     *
+     *  \param ppBuffer receives a pointer to the decoded data, which is valid
+     *                  until Read() or ReadChunk() is called again
+     *  \param plLen receives the length of the decoded data
+     *
+     *  \returns false if all data has been read
+     */
+    bool ReadChunk( const char** ppBuffer, pdf_long* plLen );
+
+ private:
+    /** Decode the next block of encoded data
+     *  \returns false if all data has been decoded
+     */
+    bool DecodeNextBlock();
+
+ private:
+    const char*                  m_pInput;
+    pdf_long                     m_lInputLen;
+    pdf_long                     m_lInputPos;
+
+    PdfOutputStream*             m_pDecodeStream; ///< Decodes into m_pSink, NULL for unfiltered data
+    PdfFilteredInputStreamSink*  m_pSink;
+    pdf_long                     m_lSinkPos;      ///< Bytes of m_pSink which have been read
+};
+
 /** A factory to create a filter object for a filter type (as GetType() gives)
  *  from the EPdfFilter enum. 
  *  All filters should be created using this factory.
@@ -484,6 +620,19 @@ class PODOFO_API PdfFilterFactory {
      */
     static PdfOutputStream* CreateEncodeStream( const TVecFilters & filters, PdfOutputStream* pStream );
 
+    /** Create a PdfOutputStream that applies a list of filters 
+     *  on all data written to it.
+     *
+     *  \param filters a list of filters
+     *  \param pStream write all data to this PdfOutputStream after it has been
+     *         encoded
+     *  \param pFlateSettings settings for a FlateDecode filter in the list
+     *         or NULL to use the settings returned by GetFlateSettings()
+     *  \returns a new PdfOutputStream that has to be deleted by the caller.
+     */
+    static PdfOutputStream* CreateEncodeStream( const TVecFilters & filters, PdfOutputStream* pStream,
+                                                const TFlateSettings* pFlateSettings );
+
     /** Create a PdfOutputStream that applies a list of filters 
      *  on all data written to it.
      *
@@ -494,7 +643,8 @@ class PODOFO_API PdfFilterFactory {
      *         contain additional parameters for stream decoding.
      *         This method will look for a key named DecodeParms
      *         in this dictionary and pass the information found
-     *         in that dictionary to the filters.
+     *         in that dictionary to the filters. If DecodeParms is
+     *         an array, each filter gets the entry at its own index.
      *  \returns a new PdfOutputStream that has to be deleted by the caller.
      *
      *  \see PdfFilterFactory::CreateFilterList
@@ -518,6 +668,16 @@ class PODOFO_API PdfFilterFactory {
      */
     static const char* FilterTypeToName( EPdfFilter eFilter );
 
+    /** Check whether a filter is an image codec, i.e. DCTDecode,
+     *  JPXDecode, JBIG2Decode or CCITTFaxDecode. The data encoded
+     *  with these filters is the compressed image itself and can
+     *  be passed on without decoding it, see PdfStream::GetEncodedImageCopy.
+     *
+     *  \param eFilter a filter type
+     *  \returns true if eFilter is an image codec
+     */
+    static bool IsImageCodec( EPdfFilter eFilter );
+
     /** The passed PdfObject has to be a dictionary with a Filters key,
      *  a (possibly empty) array of filter names or a filter name.
      *
@@ -528,9 +688,41 @@ class PODOFO_API PdfFilterFactory {
      */
     static TVecFilters CreateFilterList( const PdfObject* pObject );
 
+    /** Set the settings used by all FlateDecode filters which
+     *  are not created for a document with its own settings.
+     *
+     *  \param rSettings the new default compression level and strategy
+     *
+     *  \see PdfVecObjects::SetFlateSettings
+     */
+    static void SetFlateSettings( const TFlateSettings & rSettings );
+
+    /** 
+     *  \returns the default settings of FlateDecode filters
+     */
+    static const TFlateSettings & GetFlateSettings();
+
+    /** Set the encoder used to compress whole buffers with the FlateDecode filter.
+     *
+     *  The encoder is not owned by PoDoFo and has to live
+     *  until it is replaced by another encoder.
+     *
+     *  \param pEncoder an encoder or NULL to reset to the built-in zlib encoder
+     */
+    static void SetFlateEncoder( const PdfFlateEncoder* pEncoder );
+
+    /** 
+     *  \returns the encoder used to compress whole buffers with the FlateDecode filter,
+     *           never NULL
+     */
+    static const PdfFlateEncoder* GetFlateEncoder();
+
  private:
     // prohibit instantiation of all-methods-static factory from outside
     PdfFilterFactory();
+
+    static TFlateSettings         s_flateSettings;
+    static const PdfFlateEncoder* s_pFlateEncoder;
 };
 
 
@@ -46,6 +46,8 @@ extern "C" {
 }
 #endif // PODOFO_HAVE_JPEG_LIB
 
+#include <algorithm>
+#include <climits>
 #include <stdlib.h>
 #include <string.h>
 
@@ -64,36 +66,68 @@ extern "C" {
 
 #define LZW_TABLE_SIZE      4096
 
-namespace {
+namespace PoDoFo {
 
-// Private data for PdfAscii85Filter. This will be optimised
-// by the compiler through compile-time constant expression
-// evaluation.
-const unsigned long sPowers85[] = {
-    85*85*85*85, 85*85*85, 85*85, 85, 1
-};
+/** Reads a sample of nBits (1 to 16) bits starting
+ *  at bit nBit of a row (most significant bit first).
+ */
+static inline unsigned int PredictorReadSample( const unsigned char* pRow, pdf_long nBit, int nBits )
+{
+    unsigned int nValue = 0;
+    for( int i = 0; i < nBits; i++, nBit++ )
+        nValue = (nValue << 1) | ((pRow[nBit >> 3] >> (7 - (nBit & 7))) & 1);
 
-} // end anonymous namespace
+    return nValue;
+}
 
+/** Writes a sample of nBits (1 to 16) bits starting
+ *  at bit nBit of a row (most significant bit first).
+ */
+static inline void PredictorWriteSample( unsigned char* pRow, pdf_long nBit, int nBits, unsigned int nValue )
+{
+    for( int i = nBits - 1; i >= 0; i--, nBit++ )
+    {
+        const unsigned char cMask = static_cast<unsigned char>(0x80 >> (nBit & 7));
+        if( (nValue >> i) & 1 )
+            pRow[nBit >> 3] |= cMask;
+        else
+            pRow[nBit >> 3] &= ~cMask;
+    }
+}
 
-namespace PoDoFo {
+/** The PNG Paeth predictor function.
+ *
+ *  Sub, Average and Paeth depend on the byte decoded just before,
+ *  so only the Up predictor runs as a flat loop over the row.
+ */
+static inline unsigned char PredictorPaeth( int a, int b, int c )
+{
+    int pa = b - c;
+    int pb = a - c;
+    int pc = pa + pb;
+
+    pa = pa < 0 ? -pa : pa;
+    pb = pb < 0 ? -pb : pb;
+    pc = pc < 0 ? -pc : pc;
+
+    return static_cast<unsigned char>( (pa <= pb && pa <= pc) ? a : (pb <= pc ? b : c) );
+}
 
 /** 
  * This structur contains all necessary values
  * for a FlateDecode and LZWDecode Predictor.
  * These values are normally stored in the /DecodeParams
  * key of a PDF dictionary.
+ *
+ * The predictors work on whole rows: PdfPredictorDecoder and
+ * PdfPredictorEncoder collect the data of one row and process it at once.
  */
-class PdfPredictorDecoder {
-
-public:
-    PdfPredictorDecoder( const PdfDictionary* pDecodeParms ) {
-        m_nPredictor   = static_cast<int>(pDecodeParms->GetKeyAsLong( "Predictor", 1L ));
-        m_nColors      = static_cast<int>(pDecodeParms->GetKeyAsLong( "Colors", 1L ));
-        m_nBPC         = static_cast<int>(pDecodeParms->GetKeyAsLong( "BitsPerComponent", 8L ));
-        m_nColumns     = static_cast<int>(pDecodeParms->GetKeyAsLong( "Columns", 1L ));
-        m_nEarlyChange = static_cast<int>(pDecodeParms->GetKeyAsLong( "EarlyChange", 1L ));
-        
+class PdfPredictor {
+protected:
+    PdfPredictor( int nPredictor, int nColors, int nBPC, int nColumns )
+        : m_nPredictor( nPredictor ), m_nColors( nColors ), m_nBPC( nBPC ), m_nColumns( nColumns ),
+          m_nBpp( 0 ), m_nRowLen( 0 ), m_nFill( 0 ), m_pRow( NULL ), m_pPrev( NULL )
+    {
         // check that input values are in range (CVE-2018-20797)
         // ISO 32000-2008 specifies these values as all 1 or greater
         // negative values for m_nColumns / m_nColors / m_nBPC result in huge podofo_calloc
@@ -102,54 +136,99 @@ public:
             PODOFO_RAISE_ERROR( ePdfError_ValueOutOfRange );
         }
 
-        if( m_nPredictor >= 10)
+        if( m_nPredictor == 1 )
+            return;
+
+        if( m_nPredictor != 2 && (m_nPredictor < 10 || m_nPredictor > 15) )
         {
-          m_bNextByteIsPredictor = true;
-          m_nCurPredictor = -1;
+            PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidPredictor, "Unknown predictor" );
         }
-        else
+
+        if( m_nBPC != 1 && m_nBPC != 2 && m_nBPC != 4 && m_nBPC != 8 && m_nBPC != 16 )
         {
-          m_bNextByteIsPredictor = false;
-          m_nCurPredictor = m_nPredictor;
+            PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidPredictor, "BitsPerComponent must be 1, 2, 4, 8 or 16" );
         }
 
-        m_nCurRowIndex  = 0;
-        m_nBpp  = (m_nBPC * m_nColors) >> 3;
-        m_nRows = (m_nColumns * m_nColors * m_nBPC) >> 3;
-
         // check for multiplication overflow on buffer sizes (e.g. if m_nBPC=2 and m_nColors=SIZE_MAX/2+1)
-        if ( podofo_multiplication_overflow( m_nBPC, m_nColors ) || podofo_multiplication_overflow( m_nColumns, m_nBPC * m_nColors ) )
+        if ( podofo_multiplication_overflow( m_nBPC, m_nColors ) || podofo_multiplication_overflow( m_nColumns, m_nBPC * m_nColors )
+             || m_nColumns * m_nBPC * m_nColors > INT_MAX - 8 )
         {
             PODOFO_RAISE_ERROR( ePdfError_ValueOutOfRange );
         }
 
-        // check that computed allocation sizes are > 0 (CVE-2018-20797)
-        if ( m_nRows < 1 || m_nBpp < 1 )
-        {
-            PODOFO_RAISE_ERROR( ePdfError_ValueOutOfRange );
-        }
+        // PNG uses at least one byte as distance to the left pixel
+        m_nBpp    = (m_nBPC * m_nColors + 7) >> 3;
+        m_nRowLen = (m_nColumns * m_nColors * m_nBPC + 7) >> 3;
 
-        m_pPrev = static_cast<char*>(podofo_calloc( m_nRows, sizeof(char) ));
-        if( !m_pPrev )
+        // PNG rows are prefixed with the predictor of the row,
+        // the row buffers store it at index 0
+        m_pRow  = static_cast<unsigned char*>(podofo_calloc( m_nRowLen + 1, sizeof(unsigned char) ));
+        m_pPrev = static_cast<unsigned char*>(podofo_calloc( m_nRowLen + 1, sizeof(unsigned char) ));
+        if( !m_pRow || !m_pPrev )
         {
+            podofo_free( m_pRow );
+            podofo_free( m_pPrev );
             PODOFO_RAISE_ERROR( ePdfError_OutOfMemory );
         }
+    }
 
-        memset( m_pPrev, 0, sizeof(char) * m_nRows );
+    ~PdfPredictor()
+    {
+        podofo_free( m_pRow );
+        podofo_free( m_pPrev );
+    }
 
-        m_pUpperLeftPixelComponents = static_cast<char*>(podofo_calloc( m_nBpp, sizeof(char) ));
-        if( !m_pUpperLeftPixelComponents )
-        {
-            PODOFO_RAISE_ERROR( ePdfError_OutOfMemory );
-        }
+    /** 
+     *  \returns the number of bytes of an encoded row, including the PNG predictor byte
+     */
+    inline int GetEncodedRowLength() const
+    {
+        return m_nPredictor >= 10 ? m_nRowLen + 1 : m_nRowLen;
+    }
 
-        memset( m_pUpperLeftPixelComponents, 0, sizeof(char) * m_nBpp );
-    };
+    /** 
+     *  \returns a pointer to the data of a row buffer, after the PNG predictor byte
+     */
+    inline static unsigned char* RowData( unsigned char* pRow )
+    {
+        return pRow + 1;
+    }
 
-    ~PdfPredictorDecoder()
+    /** Exchange the current and the previous row.
+     */
+    inline void NextRow()
+    {
+        unsigned char* pTmp = m_pPrev;
+        m_pPrev = m_pRow;
+        m_pRow  = pTmp;
+        m_nFill = 0;
+    }
+
+protected:
+    int m_nPredictor;
+    int m_nColors;
+    int m_nBPC; //< Bits per component
+    int m_nColumns;
+    int m_nBpp; ///< Bytes per pixel, at least 1
+    int m_nRowLen; ///< Bytes per row without the PNG predictor byte
+
+    int m_nFill; ///< Bytes of the current row which have been collected
+
+    unsigned char* m_pRow;  ///< The current row
+    unsigned char* m_pPrev; ///< The previous row, all zero before the first row
+};
+
+/** Reverses a FlateDecode or LZWDecode predictor.
+ */
+class PdfPredictorDecoder : public PdfPredictor {
+
+public:
+    PdfPredictorDecoder( const PdfDictionary* pDecodeParms )
+        : PdfPredictor( static_cast<int>(pDecodeParms->GetKeyAsLong( "Predictor", 1L )),
+                        static_cast<int>(pDecodeParms->GetKeyAsLong( "Colors", 1L )),
+                        static_cast<int>(pDecodeParms->GetKeyAsLong( "BitsPerComponent", 8L )),
+                        static_cast<int>(pDecodeParms->GetKeyAsLong( "Columns", 1L )) )
     {
-        podofo_free( m_pPrev );
-        podofo_free( m_pUpperLeftPixelComponents );
     }
 
     void Decode( const char* pBuffer, pdf_long lLen, PdfOutputStream* pStream ) 
@@ -160,200 +239,470 @@ public:
             return;
         }
 
-
-        while( lLen-- ) 
+        // TIFF rows have no predictor byte, they are stored after index 0 as well
+        const int nRowLen = this->GetEncodedRowLength();
+        const int nStart  = m_nPredictor >= 10 ? 0 : 1;
+        while( lLen > 0 ) 
         {
-            if( m_bNextByteIsPredictor )
-            {
-                m_nCurPredictor = *pBuffer + 10;
-                m_bNextByteIsPredictor = false;
+            const int nCopy = static_cast<int>( std::min( lLen, static_cast<pdf_long>(nRowLen - m_nFill) ) );
+            memcpy( m_pRow + nStart + m_nFill, pBuffer, nCopy );
+            m_nFill += nCopy;
+            pBuffer += nCopy;
+            lLen    -= nCopy;
+
+            if( m_nFill == nRowLen ) 
+            {   // One line finished
+                if( m_nPredictor == 2 )
+                    this->DecodeTiffRow();
+                else
+                    this->DecodePngRow();
+
+                pStream->Write( reinterpret_cast<char*>(RowData( m_pRow )), m_nRowLen );
+                this->NextRow();
             }
-            else
+        }
+    }
+
+private:
+    void DecodePngRow()
+    {
+        unsigned char*       pRow  = RowData( m_pRow );
+        const unsigned char* pPrev = RowData( m_pPrev );
+        const int            nBpp  = m_nBpp;
+        const int            nLen  = m_nRowLen;
+        int                  i;
+
+        switch( m_pRow[0] )
+        {
+            case 0: // png none
+                break;
+            case 1: // png sub
+                for( i = nBpp; i < nLen; i++ )
+                    pRow[i] = static_cast<unsigned char>( pRow[i] + pRow[i - nBpp] );
+                break;
+            case 2: // png up
+                for( i = 0; i < nLen; i++ )
+                    pRow[i] = static_cast<unsigned char>( pRow[i] + pPrev[i] );
+                break;
+            case 3: // png average
+                for( i = 0; i < nBpp && i < nLen; i++ )
+                    pRow[i] = static_cast<unsigned char>( pRow[i] + (pPrev[i] >> 1) );
+                for( ; i < nLen; i++ )
+                    pRow[i] = static_cast<unsigned char>( pRow[i] + ((pRow[i - nBpp] + pPrev[i]) >> 1) );
+                break;
+            case 4: // png paeth
+                for( i = 0; i < nBpp && i < nLen; i++ )
+                    pRow[i] = static_cast<unsigned char>( pRow[i] + pPrev[i] );
+                for( ; i < nLen; i++ )
+                    pRow[i] = static_cast<unsigned char>( pRow[i] + PredictorPaeth( pRow[i - nBpp], pPrev[i], pPrev[i - nBpp] ) );
+                break;
+            default:
+                PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidPredictor, "Invalid png predictor in row" );
+                break;
+        }
+    }
+
+    void DecodeTiffRow()
+    {
+        unsigned char* pRow = RowData( m_pRow );
+        int            i;
+
+        switch( m_nBPC )
+        {
+            case 8:
+                for( i = m_nColors; i < m_nRowLen; i++ )
+                    pRow[i] = static_cast<unsigned char>( pRow[i] + pRow[i - m_nColors] );
+                break;
+            case 16:
+                for( i = 2 * m_nColors; i + 1 < m_nRowLen; i += 2 )
+                {
+                    const int nLeft  = 2 * m_nColors;
+                    unsigned int nValue = ((pRow[i] << 8) | pRow[i + 1]) + ((pRow[i - nLeft] << 8) | pRow[i - nLeft + 1]);
+                    pRow[i]     = static_cast<unsigned char>( (nValue >> 8) & 0xff );
+                    pRow[i + 1] = static_cast<unsigned char>( nValue & 0xff );
+                }
+                break;
+            default:
             {
-                switch( m_nCurPredictor )
+                const unsigned int nMask    = (1u << m_nBPC) - 1;
+                const pdf_long     nSamples = static_cast<pdf_long>(m_nColumns) * m_nColors;
+                for( pdf_long s = m_nColors; s < nSamples; s++ )
                 {
-                    case 2: // Tiff Predictor
-                    {
-                        if(m_nBPC == 8)
-                        {   // Same as png sub
-                            int prev = (m_nCurRowIndex - m_nBpp < 0
-                                        ? 0 : m_pPrev[m_nCurRowIndex - m_nBpp]);
-                            m_pPrev[m_nCurRowIndex] = *pBuffer + prev;
-                            break;
-                        }
-
-                        // TODO: implement tiff predictor for other than 8 BPC
-                        PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidPredictor, "tiff predictors other than 8 BPC are not implemented" );
-                        break;
-                    }
-                    case 10: // png none
-                    {
-                        m_pPrev[m_nCurRowIndex] = *pBuffer;
-                        break;
-                    }
-                    case 11: // png sub
-                    {
-                        int prev = (m_nCurRowIndex - m_nBpp < 0 
-                                    ? 0 : m_pPrev[m_nCurRowIndex - m_nBpp]);
-                        m_pPrev[m_nCurRowIndex] = *pBuffer + prev;
-                        break;
-                    }
-                    case 12: // png up
-                    {
-                        m_pPrev[m_nCurRowIndex] += *pBuffer;
-                        break;
-                    }
-                    case 13: // png average
-                    {
-                        int prev = (m_nCurRowIndex - m_nBpp < 0 
-                                    ? 0 : m_pPrev[m_nCurRowIndex - m_nBpp]);
-                        m_pPrev[m_nCurRowIndex] = ((prev + m_pPrev[m_nCurRowIndex]) >> 1) + *pBuffer;
-                        break;
-                    }
-                    case 14: // png paeth
-                    {
-                        int nLeftByteIndex = m_nCurRowIndex - m_nBpp;
+                    unsigned int nValue = PredictorReadSample( pRow, s * m_nBPC, m_nBPC )
+                        + PredictorReadSample( pRow, (s - m_nColors) * m_nBPC, m_nBPC );
+                    PredictorWriteSample( pRow, s * m_nBPC, m_nBPC, nValue & nMask );
+                }
+                break;
+            }
+        }
+    }
+};
 
-                        int a = nLeftByteIndex < 0 ? 0 : static_cast<unsigned char>( m_pPrev[nLeftByteIndex] );
-                        int b = static_cast<unsigned char>( m_pPrev[m_nCurRowIndex] );
+/** Applies a FlateDecode predictor to data before it is compressed.
+ *
+ *  Encoded rows are collected in an internal buffer,
+ *  which is available after every call to Encode.
+ */
+class PdfPredictorEncoder : public PdfPredictor {
 
-                        int nCurrComponentIndex = m_nCurRowIndex % m_nBpp;
-                        int c = nLeftByteIndex < 0 ? 0 : static_cast<unsigned char>( m_pUpperLeftPixelComponents[nCurrComponentIndex] );
+public:
+    PdfPredictorEncoder( const TFlateSettings & rSettings )
+        : PdfPredictor( rSettings.nPredictor, rSettings.nColors, rSettings.nBitsPerComponent, rSettings.nColumns )
+    {
+        if( m_nPredictor == 15 )
+        {
+            m_vecCandidate.resize( m_nRowLen + 1 );
+            m_vecBest.resize( m_nRowLen + 1 );
+        }
+    }
 
-                        int p = a + b - c;
+    /** Encode a block of data. Only complete rows are encoded,
+     *  the remaining bytes are kept for the next call.
+     *
+     *  \param pBuffer the data
+     *  \param lLen length of the data
+     */
+    void Encode( const char* pBuffer, pdf_long lLen )
+    {
+        m_vecOutput.clear();
+        if( m_nPredictor == 1 )
+        {
+            m_vecOutput.insert( m_vecOutput.end(), pBuffer, pBuffer + lLen );
+            return;
+        }
 
-                        int pa = p - a;
-                        if( pa < 0 ) pa = -pa;
+        const int nRowLen = this->GetEncodedRowLength();
+        m_vecOutput.reserve( static_cast<size_t>( (m_nFill + lLen) / m_nRowLen ) * nRowLen );
+        while( lLen > 0 ) 
+        {
+            const int nCopy = static_cast<int>( std::min( lLen, static_cast<pdf_long>(m_nRowLen - m_nFill) ) );
+            memcpy( RowData( m_pRow ) + m_nFill, pBuffer, nCopy );
+            m_nFill += nCopy;
+            pBuffer += nCopy;
+            lLen    -= nCopy;
 
-                        int pb = p - b;
-                        if( pb < 0 ) pb = -pb;
+            if( m_nFill == m_nRowLen ) 
+            {
+                const size_t nPos = m_vecOutput.size();
+                m_vecOutput.resize( nPos + nRowLen );
+                unsigned char* pOut = reinterpret_cast<unsigned char*>(&m_vecOutput[nPos]);
+                if( m_nPredictor == 2 )
+                    this->EncodeTiffRow( pOut );
+                else if( m_nPredictor == 15 )
+                    this->EncodeOptimumRow( pOut );
+                else
+                    this->EncodePngRow( m_nPredictor - 10, pOut );
 
-                        int pc = p - c;
-                        if( pc < 0 ) pc = -pc;
+                this->NextRow();
+            }
+        }
+    }
 
-                        char closestByte;
-                        if( pa <= pb && pa <= pc )
-                            closestByte = a;
-                        else if( pb <= pc )
-                            closestByte = b;
-                        else
-                            closestByte = c;
+    /** Finish encoding
+     *
+     *  \throws ePdfError_InvalidPredictor if the data did not end with a complete row
+     */
+    void EndEncode()
+    {
+        if( m_nFill )
+        {
+            PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidPredictor, "The data does not end with a complete row" );
+        }
+    }
 
-                        // Save the byte we're about to clobber for the next pixel's prediction
-                        m_pUpperLeftPixelComponents[nCurrComponentIndex] = m_pPrev[m_nCurRowIndex];
+    /** 
+     *  \returns the rows encoded by the last call to Encode
+     */
+    inline const char* GetBuffer() const
+    {
+        return m_vecOutput.size() ? &m_vecOutput[0] : NULL;
+    }
 
-                        m_pPrev[m_nCurRowIndex] = *pBuffer + closestByte;
-                        break;
-                    }
-                    case 15: // png optimum
-                        PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidPredictor, "png optimum predictor is not implemented" );
-                        break;
-                        
-                    default:
-                    {
-                        //PODOFO_RAISE_ERROR( ePdfError_InvalidPredictor );
-                        break;
-                    }
-                }
+    /** 
+     *  \returns the length of the buffer returned by GetBuffer()
+     */
+    inline pdf_long GetLength() const
+    {
+        return static_cast<pdf_long>(m_vecOutput.size());
+    }
 
-                ++m_nCurRowIndex;
-            }
+private:
+    /** Encode the current row with a png predictor
+     *  \param nType the png predictor from 0 (none) to 4 (paeth)
+     *  \param pOut receives the predictor byte and the encoded row
+     */
+    void EncodePngRow( int nType, unsigned char* pOut ) const
+    {
+        const unsigned char* pRow  = RowData( m_pRow );
+        const unsigned char* pPrev = RowData( m_pPrev );
+        const int            nBpp  = m_nBpp;
+        const int            nLen  = m_nRowLen;
+        int                  i;
+
+        *pOut++ = static_cast<unsigned char>( nType );
+        switch( nType )
+        {
+            case 0: // png none
+                memcpy( pOut, pRow, nLen );
+                break;
+            case 1: // png sub
+                for( i = 0; i < nBpp && i < nLen; i++ )
+                    pOut[i] = pRow[i];
+                for( ; i < nLen; i++ )
+                    pOut[i] = static_cast<unsigned char>( pRow[i] - pRow[i - nBpp] );
+                break;
+            case 2: // png up
+                for( i = 0; i < nLen; i++ )
+                    pOut[i] = static_cast<unsigned char>( pRow[i] - pPrev[i] );
+                break;
+            case 3: // png average
+                for( i = 0; i < nBpp && i < nLen; i++ )
+                    pOut[i] = static_cast<unsigned char>( pRow[i] - (pPrev[i] >> 1) );
+                for( ; i < nLen; i++ )
+                    pOut[i] = static_cast<unsigned char>( pRow[i] - ((pRow[i - nBpp] + pPrev[i]) >> 1) );
+                break;
+            case 4: // png paeth
+                for( i = 0; i < nBpp && i < nLen; i++ )
+                    pOut[i] = static_cast<unsigned char>( pRow[i] - pPrev[i] );
+                for( ; i < nLen; i++ )
+                    pOut[i] = static_cast<unsigned char>( pRow[i] - PredictorPaeth( pRow[i - nBpp], pPrev[i], pPrev[i - nBpp] ) );
+                break;
+        }
+    }
 
-            ++pBuffer;
+    /** Encode the current row with the png predictor which gives 
+     *  the smallest sum of absolute differences, as libpng does.
+     */
+    void EncodeOptimumRow( unsigned char* pOut )
+    {
+        pdf_uint64 nBestSum = 0;
+        for( int nType = 0; nType <= 4; nType++ )
+        {
+            unsigned char* pCandidate = reinterpret_cast<unsigned char*>(&m_vecCandidate[0]);
+            this->EncodePngRow( nType, pCandidate );
 
-            if( m_nCurRowIndex >= m_nRows ) 
-            {   // One line finished
-                m_nCurRowIndex  = 0;
-                m_bNextByteIsPredictor = (m_nCurPredictor >= 10);
-                pStream->Write( m_pPrev, m_nRows );
+            pdf_uint64 nSum = 0;
+            for( int i = 1; i <= m_nRowLen; i++ )
+                nSum += pCandidate[i] < 128 ? pCandidate[i] : 256 - pCandidate[i];
+
+            if( nType == 0 || nSum < nBestSum )
+            {
+                nBestSum = nSum;
+                m_vecBest.swap( m_vecCandidate );
             }
         }
+
+        memcpy( pOut, &m_vecBest[0], m_nRowLen + 1 );
     }
 
+    void EncodeTiffRow( unsigned char* pOut ) const
+    {
+        const unsigned char* pRow = RowData( m_pRow );
+        int                  i;
+
+        switch( m_nBPC )
+        {
+            case 8:
+                for( i = 0; i < m_nColors && i < m_nRowLen; i++ )
+                    pOut[i] = pRow[i];
+                for( ; i < m_nRowLen; i++ )
+                    pOut[i] = static_cast<unsigned char>( pRow[i] - pRow[i - m_nColors] );
+                break;
+            case 16:
+            {
+                const int nLeft = 2 * m_nColors;
+                for( i = 0; i < nLeft && i < m_nRowLen; i++ )
+                    pOut[i] = pRow[i];
+                for( ; i + 1 < m_nRowLen; i += 2 )
+                {
+                    unsigned int nValue = ((pRow[i] << 8) | pRow[i + 1]) - ((pRow[i - nLeft] << 8) | pRow[i - nLeft + 1]);
+                    pOut[i]     = static_cast<unsigned char>( (nValue >> 8) & 0xff );
+                    pOut[i + 1] = static_cast<unsigned char>( nValue & 0xff );
+                }
+                for( ; i < m_nRowLen; i++ )
+                    pOut[i] = pRow[i];
+                break;
+            }
+            default:
+            {
+                const unsigned int nMask    = (1u << m_nBPC) - 1;
+                const pdf_long     nSamples = static_cast<pdf_long>(m_nColumns) * m_nColors;
+                memcpy( pOut, pRow, m_nRowLen );
+                for( pdf_long s = m_nColors; s < nSamples; s++ )
+                {
+                    unsigned int nValue = PredictorReadSample( pRow, s * m_nBPC, m_nBPC )
+                        - PredictorReadSample( pRow, (s - m_nColors) * m_nBPC, m_nBPC );
+                    PredictorWriteSample( pOut, s * m_nBPC, m_nBPC, nValue & nMask );
+                }
+                break;
+            }
+        }
+    }
 
 private:
-    int m_nPredictor;
-    int m_nColors;
-    int m_nBPC; //< Bytes per component
-    int m_nColumns;
-    int m_nEarlyChange;
-    int m_nBpp; ///< Bytes per pixel
+    std::vector<char> m_vecOutput;    ///< Rows encoded by the last call to Encode
+    std::vector<char> m_vecCandidate; ///< A candidate row for the png optimum predictor
+    std::vector<char> m_vecBest;      ///< The best row for the png optimum predictor
+};
+
+
+/** Collects the output of a filter and writes it to the output
+ *  stream of the filter in large chunks instead of byte by byte.
+ *
+ *  Call Flush() before the end of each *BlockImpl and End*Impl call,
+ *  the buffer is not written when it is destroyed.
+ */
+class PdfFilterOutputBuffer {
+ public:
+    PdfFilterOutputBuffer( PdfOutputStream* pStream )
+        : m_pStream( pStream ), m_lLen( 0 )
+    {
+    }
 
-    int m_nCurPredictor;
-    int m_nCurRowIndex;
-    int m_nRows;
+    /** Reserve space for lLen bytes, which have to
+     *  be written to the returned pointer.
+     *
+     *  \param lLen at most PODOFO_FILTER_INTERNAL_BUFFER_SIZE bytes
+     */
+    inline char* Reserve( pdf_long lLen )
+    {
+        if( m_lLen + lLen > PODOFO_FILTER_INTERNAL_BUFFER_SIZE )
+            this->Flush();
 
-    bool m_bNextByteIsPredictor;
+        char* pReserved = m_buffer + m_lLen;
+        m_lLen += lLen;
+        return pReserved;
+    }
 
-    char* m_pPrev;
+    inline void Put( char c )
+    {
+        if( m_lLen == PODOFO_FILTER_INTERNAL_BUFFER_SIZE )
+            this->Flush();
 
-    // The PNG Paeth predictor uses the values of the pixel above and to the left
-    // of the current pixel. But we overwrite the row above as we go, so we'll
-    // have to store the bytes of the upper-left pixel separately.
-    char* m_pUpperLeftPixelComponents;
-};
+        m_buffer[m_lLen++] = c;
+    }
+
+    /** Fill lLen bytes with the value c.
+     */
+    void Fill( char c, pdf_long lLen )
+    {
+        while( lLen )
+        {
+            const pdf_long lFill = PDF_MIN( lLen, static_cast<pdf_long>(PODOFO_FILTER_INTERNAL_BUFFER_SIZE) );
+            memset( this->Reserve( lFill ), c, lFill );
+            lLen -= lFill;
+        }
+    }
+
+    /** Append a block of data. Large blocks are written
+     *  directly to the stream without being copied.
+     */
+    void Write( const char* pBuffer, pdf_long lLen )
+    {
+        if( m_lLen + lLen > PODOFO_FILTER_INTERNAL_BUFFER_SIZE )
+        {
+            this->Flush();
+            if( lLen > PODOFO_FILTER_INTERNAL_BUFFER_SIZE / 2 )
+            {
+                m_pStream->Write( pBuffer, lLen );
+                return;
+            }
+        }
+
+        memcpy( m_buffer + m_lLen, pBuffer, lLen );
+        m_lLen += lLen;
+    }
 
+    void Flush()
+    {
+        if( m_lLen )
+        {
+            m_pStream->Write( m_buffer, m_lLen );
+            m_lLen = 0;
+        }
+    }
+
+ private:
+    PdfOutputStream* m_pStream;
+    char             m_buffer[PODOFO_FILTER_INTERNAL_BUFFER_SIZE];
+    pdf_long         m_lLen;
+};
 
 // -------------------------------------------------------
 // Hex
 // -------------------------------------------------------
 
 PdfHexFilter::PdfHexFilter()
-    : m_cDecodedByte( 0 ), m_bLow( true )
+    : m_cDecodedByte( 0 ), m_bLow( true ), m_bEod( false )
 {
 }
 
 void PdfHexFilter::EncodeBlockImpl( const char* pBuffer, pdf_long lLen )
 {
-    char data[2];
-    while( lLen-- )
-    {
-        data[0]  = (*pBuffer & 0xF0) >> 4;
-        data[0] += (data[0] > 9 ? 'A' - 10 : '0');
+    static const char s_hexDigits[] = "0123456789ABCDEF";
 
-        data[1]  = (*pBuffer & 0x0F);
-        data[1] += (data[1] > 9 ? 'A' - 10 : '0');
-
-        GetStream()->Write( data, 2 );
+    const unsigned char*  pData = reinterpret_cast<const unsigned char*>(pBuffer);
+    PdfFilterOutputBuffer output( GetStream() );
+    while( lLen )
+    {
+        const pdf_long lBlock = PDF_MIN( lLen, static_cast<pdf_long>(PODOFO_FILTER_INTERNAL_BUFFER_SIZE / 2) );
+        char*          pOut   = output.Reserve( lBlock * 2 );
+        for( pdf_long i = 0; i < lBlock; i++ )
+        {
+            *pOut++ = s_hexDigits[pData[i] >> 4];
+            *pOut++ = s_hexDigits[pData[i] & 0x0F];
+        }
 
-        ++pBuffer;
+        pData += lBlock;
+        lLen  -= lBlock;
     }
+
+    output.Flush();
 }
 
 void PdfHexFilter::BeginDecodeImpl( const PdfDictionary* )
 { 
     m_cDecodedByte = 0;
     m_bLow         = true;
+    m_bEod         = false;
 }
 
 void PdfHexFilter::DecodeBlockImpl( const char* pBuffer, pdf_long lLen )
 {
-    char val;
+    const unsigned char*  pData = reinterpret_cast<const unsigned char*>(pBuffer);
+    const unsigned char*  pEnd  = pData + lLen;
+    PdfFilterOutputBuffer output( GetStream() );
 
-    while( lLen-- ) 
+    while( pData < pEnd && !m_bEod ) 
     {
-        if( PdfTokenizer::IsWhitespace( *pBuffer ) )
+        const int val = PdfTokenizer::GetHexValue( *pData );
+        if( val != static_cast<int>(PdfTokenizer::HEX_NOT_FOUND) )
         {
-            ++pBuffer;
-            continue;
+            if( m_bLow ) 
+            {
+                m_cDecodedByte = static_cast<char>(val);
+                m_bLow         = false;
+            }
+            else
+            {
+                output.Put( static_cast<char>((m_cDecodedByte << 4) | val) );
+                m_bLow = true;
+            }
         }
-
-        val  = PdfTokenizer::GetHexValue( *pBuffer );
-        if( m_bLow ) 
+        else if( *pData == '>' )
         {
-            m_cDecodedByte = (val & 0x0F);
-            m_bLow         = false;
+            m_bEod = true;
         }
-        else
+        else if( !PdfTokenizer::IsWhitespace( *pData ) )
         {
-            m_cDecodedByte = ((m_cDecodedByte << 4) | val);
-            m_bLow         = true;
-
-            GetStream()->Write( &m_cDecodedByte, 1 );
+            output.Flush();
+            PODOFO_RAISE_ERROR_INFO( ePdfError_ValueOutOfRange, "Invalid character in ASCIIHex data" );
         }
 
-        ++pBuffer;
+        ++pData;
     }
+
+    output.Flush();
 }
 
 void PdfHexFilter::EndDecodeImpl()
@@ -362,7 +711,9 @@ void PdfHexFilter::EndDecodeImpl()
     {
         // an odd number of bytes was read,
         // so the last byte is 0
-        GetStream()->Write( &m_cDecodedByte, 1 );
+        const char cLast = static_cast<char>(m_cDecodedByte << 4);
+        GetStream()->Write( &cLast, 1 );
+        m_bLow = true;
     }
 }
 
@@ -374,34 +725,26 @@ void PdfHexFilter::EndDecodeImpl()
 // Paul Haahr - http://www.webcom.com/~haahr/
 // -------------------------------------------------------
 
-PdfAscii85Filter::PdfAscii85Filter()
-    : m_count( 0 ), m_tuple( 0 )
-{
-}
-
-void PdfAscii85Filter::EncodeTuple( unsigned long tuple, int count )
+/** Encode the first nBytes + 1 digits of a tuple to ASCII85.
+ *
+ *  \returns the number of characters written to pOut
+ */
+static inline int Ascii85EncodeTuple( unsigned long tuple, int nBytes, char* pOut )
 {
-    int      i      = 5;
-    int      z      = 0;
-    char     buf[5];
-    char     out[5];
-    char*    start  = buf;;
-
-    do 
+    char digits[5];
+    for( int i = 4; i >= 0; i-- )
     {
-        *start++ = static_cast<char>(tuple % 85);
+        digits[i] = static_cast<char>(tuple % 85) + '!';
         tuple /= 85;
-    } 
-    while (--i > 0);
+    }
 
-    i = count;
-    do 
-    {
-        out[z++] = static_cast<unsigned char>(*--start) + '!';
-    } 
-    while (i-- > 0);
+    memcpy( pOut, digits, nBytes + 1 );
+    return nBytes + 1;
+}
 
-    GetStream()->Write( out, z );
+PdfAscii85Filter::PdfAscii85Filter()
+    : m_count( 0 ), m_tuple( 0 ), m_bEod( false )
+{
 }
 
 void PdfAscii85Filter::BeginEncodeImpl()
@@ -412,40 +755,57 @@ void PdfAscii85Filter::BeginEncodeImpl()
 
 void PdfAscii85Filter::EncodeBlockImpl( const char* pBuffer, pdf_long lLen )
 {
-    unsigned int  c;
-    const char*   z = "z";
+    const unsigned char*  pData = reinterpret_cast<const unsigned char*>(pBuffer);
+    const unsigned char*  pEnd  = pData + lLen;
+    PdfFilterOutputBuffer output( GetStream() );
 
-    while( lLen ) 
+    // complete a tuple started in a previous block
+    while( m_count && pData < pEnd )
     {
-        c = *pBuffer & 0xff;
-        switch (m_count++) {
-            case 0: m_tuple |= ( c << 24); break;
-            case 1: m_tuple |= ( c << 16); break;
-            case 2: m_tuple |= ( c <<  8); break;
-            case 3:
-                m_tuple |= c;
-                if( 0 == m_tuple ) 
-                {
-                    GetStream()->Write( z, 1 );
-                }
-                else
-                {
-                    this->EncodeTuple( m_tuple, m_count ); 
-                }
+        m_tuple |= static_cast<unsigned long>(*pData++) << (24 - 8 * m_count);
+        if( ++m_count == 4 )
+        {
+            if( m_tuple )
+                Ascii85EncodeTuple( m_tuple, 4, output.Reserve( 5 ) );
+            else
+                output.Put( 'z' );
 
-                m_tuple = 0;
-                m_count = 0;
-                break;
+            m_tuple = 0;
+            m_count = 0;
         }
-        --lLen;
-        ++pBuffer;
     }
+
+    // encode all complete tuples directly from the buffer
+    while( pEnd - pData >= 4 )
+    {
+        const unsigned long tuple = (static_cast<unsigned long>(pData[0]) << 24) |
+                                    (static_cast<unsigned long>(pData[1]) << 16) |
+                                    (static_cast<unsigned long>(pData[2]) <<  8) |
+                                     static_cast<unsigned long>(pData[3]);
+        if( tuple )
+            Ascii85EncodeTuple( tuple, 4, output.Reserve( 5 ) );
+        else
+            output.Put( 'z' );
+
+        pData += 4;
+    }
+
+    // keep the remaining bytes for the next block
+    while( pData < pEnd )
+        m_tuple |= static_cast<unsigned long>(*pData++) << (24 - 8 * m_count++);
+
+    output.Flush();
 }
 
 void PdfAscii85Filter::EndEncodeImpl()
 {
     if( m_count > 0 )
-        this->EncodeTuple( m_tuple, m_count );
+    {
+        char out[5];
+        GetStream()->Write( out, Ascii85EncodeTuple( m_tuple, m_count, out ) );
+        m_tuple = 0;
+        m_count = 0;
+    }
     //GetStream()->Write( "~>", 2 );
 }
 
@@ -453,101 +813,165 @@ void PdfAscii85Filter::BeginDecodeImpl( const PdfDictionary* )
 { 
     m_count = 0;
     m_tuple = 0;
+    m_bEod  = false;
 }
 
 void PdfAscii85Filter::DecodeBlockImpl( const char* pBuffer, pdf_long lLen )
 {
-    bool foundEndMarker = false;
+    const unsigned char*  pData = reinterpret_cast<const unsigned char*>(pBuffer);
+    const unsigned char*  pEnd  = pData + lLen;
+    PdfFilterOutputBuffer output( GetStream() );
 
-    while( lLen && !foundEndMarker ) 
+    while( pData < pEnd && !m_bEod ) 
     {
-        switch ( *pBuffer ) 
+        const unsigned char c = *pData++;
+        if( c >= '!' && c <= 'u' )
         {
-            default:
-                if ( *pBuffer < '!' || *pBuffer > 'u') 
-                {
-                    PODOFO_RAISE_ERROR( ePdfError_ValueOutOfRange );
-                }
-
-                m_tuple += ( *pBuffer - '!') * sPowers85[m_count++];
-                if( m_count == 5 ) 
-                {
-                    WidePut( m_tuple, 4 );
-                    m_count = 0;
-                    m_tuple = 0;
-                }
-                break;
-            case 'z':
-                if (m_count != 0 ) 
-                {
-                    PODOFO_RAISE_ERROR( ePdfError_ValueOutOfRange );
-                }
+            m_tuple = m_tuple * 85 + (c - '!');
+            if( ++m_count == 5 ) 
+            {
+                char* pOut = output.Reserve( 4 );
+                pOut[0] = static_cast<char>(m_tuple >> 24);
+                pOut[1] = static_cast<char>(m_tuple >> 16);
+                pOut[2] = static_cast<char>(m_tuple >>  8);
+                pOut[3] = static_cast<char>(m_tuple);
 
-                this->WidePut( 0, 4 );
-                break;
-            case '~':
-                ++pBuffer; 
-                --lLen;
-                if( lLen && *pBuffer != '>' ) 
-                {
-                    PODOFO_RAISE_ERROR( ePdfError_ValueOutOfRange );
-                }
-                foundEndMarker = true;
-                break;
-            case '\n': case '\r': case '\t': case ' ':
-            case '\0': case '\f': case '\b': case 0177:
-                break;
+                m_count = 0;
+                m_tuple = 0;
+            }
         }
+        else if( c == 'z' && !m_count )
+        {
+            memset( output.Reserve( 4 ), 0, 4 );
+        }
+        else if( c == '~' )
+        {
+            // the end of data marker is "~>", the '>'
+            // might only be part of the next block
+            if( pData < pEnd && *pData != '>' ) 
+            {
+                output.Flush();
+                PODOFO_RAISE_ERROR( ePdfError_ValueOutOfRange );
+            }
 
-        --lLen;
-        ++pBuffer;
+            m_bEod = true;
+        }
+        else if( !PdfTokenizer::IsWhitespace( c ) && c != '\b' && c != 0177 )
+        {
+            output.Flush();
+            PODOFO_RAISE_ERROR( ePdfError_ValueOutOfRange );
+        }
     }
+
+    output.Flush();
 }
 
 void PdfAscii85Filter::EndDecodeImpl()
 { 
     if( m_count > 0 ) 
     {
-        m_count--;
-        m_tuple += sPowers85[m_count];
-        WidePut( m_tuple, m_count );
+        // a final partial tuple of n digits decodes to n - 1 bytes,
+        // the missing digits are taken as 'u'
+        const int nBytes = m_count - 1;
+        while( m_count < 5 )
+        {
+            m_tuple = m_tuple * 85 + 84;
+            ++m_count;
+        }
+
+        const char data[4] = { static_cast<char>(m_tuple >> 24), static_cast<char>(m_tuple >> 16),
+                               static_cast<char>(m_tuple >>  8), static_cast<char>(m_tuple) };
+        GetStream()->Write( data, nBytes );
+
+        m_count = 0;
+        m_tuple = 0;
     }
 }
 
-void PdfAscii85Filter::WidePut( unsigned long tuple, int bytes ) const
+// -------------------------------------------------------
+// Flate
+// -------------------------------------------------------
+
+/** Convert a compression strategy to the corresponding zlib constant.
+ */
+static int FlateStrategyToZlib( EPdfFlateStrategy eStrategy )
+{
+    switch( eStrategy )
+    {
+        case ePdfFlateStrategy_Filtered:
+            return Z_FILTERED;
+        case ePdfFlateStrategy_HuffmanOnly:
+            return Z_HUFFMAN_ONLY;
+        case ePdfFlateStrategy_RLE:
+            return Z_RLE;
+        case ePdfFlateStrategy_Fixed:
+            return Z_FIXED;
+        case ePdfFlateStrategy_Default:
+        default:
+            return Z_DEFAULT_STRATEGY;
+    }
+}
+
+/** Initialize a z_stream for compression with the passed settings.
+ */
+static int FlateInit( z_stream* pStream, const TFlateSettings & rSettings )
+{
+    int nLevel = rSettings.nLevel;
+    if( nLevel < Z_DEFAULT_COMPRESSION || nLevel > Z_BEST_COMPRESSION )
+        nLevel = Z_DEFAULT_COMPRESSION;
+
+    pStream->zalloc   = Z_NULL;
+    pStream->zfree    = Z_NULL;
+    pStream->opaque   = Z_NULL;
+
+    return deflateInit2( pStream, nLevel, Z_DEFLATED, MAX_WBITS, 8, FlateStrategyToZlib( rSettings.eStrategy ) );
+}
+
+void PdfZlibFlateEncoder::Encode( const char* pInBuffer, pdf_long lInLen, char** ppOutBuffer, pdf_long* plOutLen,
+                                  const TFlateSettings & rSettings ) const
 {
-    char data[4];
+    if( lInLen < 0 || static_cast<pdf_uint64>(lInLen) > static_cast<pdf_uint64>(UINT_MAX) )
+    {
+        PODOFO_RAISE_ERROR( ePdfError_ValueOutOfRange );
+    }
 
-    switch( bytes ) 
+    z_stream stream;
+    memset( &stream, 0, sizeof(stream) );
+
+    if( FlateInit( &stream, rSettings ) != Z_OK )
+    {
+        PODOFO_RAISE_ERROR( ePdfError_Flate );
+    }
+
+    // deflateBound gives an upper limit for the compressed size,
+    // so that all data can be compressed with a single call to deflate
+    uLong lBound = deflateBound( &stream, static_cast<uLong>(lInLen) );
+    char* pBuffer = static_cast<char*>(podofo_malloc( lBound ? lBound : 1 ));
+    if( !pBuffer )
     {
-	case 4:
-            data[0] = static_cast<char>(tuple >> 24);
-            data[1] = static_cast<char>(tuple >> 16);
-            data[2] = static_cast<char>(tuple >>  8);
-            data[3] = static_cast<char>(tuple);
-            break;
-	case 3:
-            data[0] = static_cast<char>(tuple >> 24);
-            data[1] = static_cast<char>(tuple >> 16);
-            data[2] = static_cast<char>(tuple >>  8);
-            break;
-	case 2:
-            data[0] = static_cast<char>(tuple >> 24);
-            data[1] = static_cast<char>(tuple >> 16);
-            break;
-	case 1:
-            data[0] = static_cast<char>(tuple >> 24);
-            break;
+        deflateEnd( &stream );
+        PODOFO_RAISE_ERROR( ePdfError_OutOfMemory );
     }
 
-    GetStream()->Write( data, bytes );
+    stream.avail_in  = static_cast<uInt>(lInLen);
+    stream.next_in   = reinterpret_cast<Bytef*>(const_cast<char*>(pInBuffer));
+    stream.avail_out = static_cast<uInt>(lBound);
+    stream.next_out  = reinterpret_cast<Bytef*>(pBuffer);
+
+    if( deflate( &stream, Z_FINISH ) != Z_STREAM_END )
+    {
+        deflateEnd( &stream );
+        podofo_free( pBuffer );
+        PODOFO_RAISE_ERROR( ePdfError_Flate );
+    }
+
+    *plOutLen    = static_cast<pdf_long>(stream.total_out);
+    *ppOutBuffer = pBuffer;
+    deflateEnd( &stream );
 }
 
-// -------------------------------------------------------
-// Flate
-// -------------------------------------------------------
 PdfFlateFilter::PdfFlateFilter()
-    : m_pPredictor( 0 )
+    : m_settings( PdfFilterFactory::GetFlateSettings() ), m_pPredictor( 0 ), m_pPredictorEncoder( 0 )
 {
     memset( m_buffer, 0, sizeof(m_buffer) );
     memset( &m_stream, 0, sizeof(m_stream) );
@@ -556,15 +980,15 @@ PdfFlateFilter::PdfFlateFilter()
 PdfFlateFilter::~PdfFlateFilter()
 {
     delete m_pPredictor;
+    delete m_pPredictorEncoder;
 }
 
 void PdfFlateFilter::BeginEncodeImpl()
 {
-    m_stream.zalloc   = Z_NULL;
-    m_stream.zfree    = Z_NULL;
-    m_stream.opaque   = Z_NULL;
+    delete m_pPredictorEncoder;
+    m_pPredictorEncoder = m_settings.nPredictor != 1 ? new PdfPredictorEncoder( m_settings ) : NULL;
 
-    if( deflateInit( &m_stream, Z_DEFAULT_COMPRESSION ) )
+    if( FlateInit( &m_stream, m_settings ) != Z_OK )
     {
         PODOFO_RAISE_ERROR( ePdfError_Flate );
     }
@@ -572,7 +996,14 @@ void PdfFlateFilter::BeginEncodeImpl()
 
 void PdfFlateFilter::EncodeBlockImpl( const char* pBuffer, pdf_long lLen )
 {
-    this->EncodeBlockInternal( pBuffer, lLen, Z_NO_FLUSH );
+    if( m_pPredictorEncoder )
+    {
+        m_pPredictorEncoder->Encode( pBuffer, lLen );
+        if( m_pPredictorEncoder->GetLength() )
+            this->EncodeBlockInternal( m_pPredictorEncoder->GetBuffer(), m_pPredictorEncoder->GetLength(), Z_NO_FLUSH );
+    }
+    else
+        this->EncodeBlockInternal( pBuffer, lLen, Z_NO_FLUSH );
 }
 
 void PdfFlateFilter::EncodeBlockInternal( const char* pBuffer, pdf_long lLen, int nMode )
@@ -610,6 +1041,20 @@ void PdfFlateFilter::EncodeBlockInternal( const char* pBuffer, pdf_long lLen, in
 
 void PdfFlateFilter::EndEncodeImpl()
 {
+    if( m_pPredictorEncoder )
+    {
+        try {
+            m_pPredictorEncoder->EndEncode();
+        } catch( PdfError & e ) {
+            deflateEnd( &m_stream );
+            e.AddToCallstack( __FILE__, __LINE__ );
+            throw e;
+        }
+
+        delete m_pPredictorEncoder;
+        m_pPredictorEncoder = NULL;
+    }
+
     this->EncodeBlockInternal( NULL, 0, Z_FINISH );
     deflateEnd( &m_stream );
 }
@@ -685,54 +1130,134 @@ void PdfFlateFilter::EndDecodeImpl()
 // -------------------------------------------------------
 
 PdfRLEFilter::PdfRLEFilter()
-    : m_nCodeLen( 0 )
+    : m_nCodeLen( 0 ), m_bEod( false ), m_nLiteral( 0 ), m_cRun( 0 ), m_nRun( 0 )
 {
 }
 
 void PdfRLEFilter::BeginEncodeImpl()
 {
-    PODOFO_RAISE_ERROR( ePdfError_UnsupportedFilter );
+    m_nLiteral = 0;
+    m_nRun     = 0;
 }
 
-void PdfRLEFilter::EncodeBlockImpl( const char*, pdf_long )
+void PdfRLEFilter::FlushLiteral( PdfFilterOutputBuffer & rOutput )
 {
-    PODOFO_RAISE_ERROR( ePdfError_UnsupportedFilter );
+    if( m_nLiteral )
+    {
+        rOutput.Put( static_cast<char>(m_nLiteral - 1) );
+        rOutput.Write( reinterpret_cast<const char*>(m_literal), m_nLiteral );
+        m_nLiteral = 0;
+    }
+}
+
+void PdfRLEFilter::FlushRun( PdfFilterOutputBuffer & rOutput )
+{
+    // A run of two bytes is not shorter than the same bytes in a literal,
+    // so it only interrupts a literal if it starts a new one anyway
+    if( m_nRun > 2 || (m_nRun == 2 && !m_nLiteral) )
+    {
+        this->FlushLiteral( rOutput );
+
+        char* pOut = rOutput.Reserve( 2 );
+        pOut[0] = static_cast<char>(257 - m_nRun);
+        pOut[1] = static_cast<char>(m_cRun);
+    }
+    else
+    {
+        for( int i = 0; i < m_nRun; i++ )
+        {
+            if( m_nLiteral == static_cast<int>(sizeof(m_literal)) )
+                this->FlushLiteral( rOutput );
+
+            m_literal[m_nLiteral++] = m_cRun;
+        }
+    }
+
+    m_nRun = 0;
+}
+
+void PdfRLEFilter::EncodeBlockImpl( const char* pBuffer, pdf_long lLen )
+{
+    const unsigned char*  pData = reinterpret_cast<const unsigned char*>(pBuffer);
+    const unsigned char*  pEnd  = pData + lLen;
+    PdfFilterOutputBuffer output( GetStream() );
+
+    while( pData < pEnd )
+    {
+        if( m_nRun && *pData == m_cRun )
+        {
+            // extend the pending run as far as possible at once
+            const unsigned char* pRunEnd = pData + PDF_MIN( static_cast<pdf_long>(128 - m_nRun), 
+                                                            static_cast<pdf_long>(pEnd - pData) );
+            while( pData < pRunEnd && *pData == m_cRun )
+            {
+                ++pData;
+                ++m_nRun;
+            }
+
+            if( m_nRun == 128 )
+                this->FlushRun( output );
+        }
+        else
+        {
+            this->FlushRun( output );
+            m_cRun = *pData++;
+            m_nRun = 1;
+        }
+    }
+
+    output.Flush();
 }
 
 void PdfRLEFilter::EndEncodeImpl()
 {
-    PODOFO_RAISE_ERROR( ePdfError_UnsupportedFilter );
+    PdfFilterOutputBuffer output( GetStream() );
+    this->FlushRun( output );
+    this->FlushLiteral( output );
+    output.Put( static_cast<char>(128) ); // end of data
+    output.Flush();
 }
 
 void PdfRLEFilter::BeginDecodeImpl( const PdfDictionary* )
 { 
     m_nCodeLen = 0;
+    m_bEod     = false;
 }
 
 void PdfRLEFilter::DecodeBlockImpl( const char* pBuffer, pdf_long lLen )
 {
-    while( lLen-- )
+    const unsigned char*  pData = reinterpret_cast<const unsigned char*>(pBuffer);
+    const unsigned char*  pEnd  = pData + lLen;
+    PdfFilterOutputBuffer output( GetStream() );
+
+    while( pData < pEnd && !m_bEod )
     {
-        if( !m_nCodeLen )
+        if( m_nCodeLen > 0 )
         {
-            m_nCodeLen = static_cast<int>(*pBuffer);
-        } else if( m_nCodeLen == 128 )
-            break;
-        else if( m_nCodeLen <= 127 )
+            // copy as much of the literal run as this block contains
+            const pdf_long lCopy = PDF_MIN( static_cast<pdf_long>(m_nCodeLen), static_cast<pdf_long>(pEnd - pData) );
+            output.Write( reinterpret_cast<const char*>(pData), lCopy );
+            pData      += lCopy;
+            m_nCodeLen -= static_cast<int>(lCopy);
+        }
+        else if( m_nCodeLen < 0 )
         {
-            GetStream()->Write( pBuffer, 1 );
-            m_nCodeLen--;
+            output.Fill( static_cast<char>(*pData++), -m_nCodeLen );
+            m_nCodeLen = 0;
         }
-        else if( m_nCodeLen >= 129 )
+        else
         {
-            m_nCodeLen = 257 - m_nCodeLen;
-
-            while( m_nCodeLen-- ) 
-                GetStream()->Write( pBuffer, 1 );
+            const int nCode = *pData++;
+            if( nCode < 128 )
+                m_nCodeLen = nCode + 1;
+            else if( nCode > 128 )
+                m_nCodeLen = nCode - 257;
+            else
+                m_bEod = true;
         }
-
-        ++pBuffer;
     }
+
+    output.Flush();
 }
 
 // -------------------------------------------------------
@@ -988,10 +1513,12 @@ void PdfDCTFilter::DecodeBlockImpl( const char* pBuffer, pdf_long lLen )
 
 void PdfDCTFilter::EndDecodeImpl()
 {
+    // the buffer may be larger than the data written to it
+    const size_t lLen = m_pDevice->GetLength();
     delete m_pDevice;
     m_pDevice = NULL;
 
-    jpeg_memory_src ( &m_cinfo, reinterpret_cast<JOCTET*>(m_buffer.GetBuffer()), m_buffer.GetSize() );
+    jpeg_memory_src ( &m_cinfo, reinterpret_cast<JOCTET*>(m_buffer.GetBuffer()), lLen );
 
     if( jpeg_read_header(&m_cinfo, TRUE) <= 0 )
     {
@@ -1002,55 +1529,34 @@ void PdfDCTFilter::EndDecodeImpl()
 
     jpeg_start_decompress(&m_cinfo);
 
+    const int iComponents = m_cinfo.output_components;
+    if( iComponents != 1 && iComponents != 3 && iComponents != 4 )
+    {
+        (void) jpeg_destroy_decompress( &m_cinfo );
+        PODOFO_RAISE_ERROR_INFO( ePdfError_InternalLogic, "DCTDecode unknown components" );
+    }
 
-    char*      pOutBuffer;
-    JSAMPARRAY pBuffer;	
-    long       lRowBytes   = m_cinfo.output_width * m_cinfo.output_components;
-    const int  iComponents = m_cinfo.output_components;
-
-    // pBuffer will be deleted by jpeg_destroy_decompress
-    pBuffer    = (*m_cinfo.mem->alloc_sarray)( reinterpret_cast<j_common_ptr>( &m_cinfo ), JPOOL_IMAGE, lRowBytes, 1);
-    pOutBuffer = static_cast<char*>(podofo_calloc( lRowBytes, sizeof(char)) );
-	if (!pOutBuffer)
-	{
-		PODOFO_RAISE_ERROR(ePdfError_OutOfMemory);
-	}
+    // The scanlines are laid out as PDF expects them (interleaved components,
+    // one byte each), so write them as they are. Decode as many scanlines
+    // at once as libjpeg produces in one step.
+    const JDIMENSION lRowBytes = m_cinfo.output_width * iComponents;
+    const JDIMENSION lRows     = m_cinfo.rec_outbuf_height > 0 ? m_cinfo.rec_outbuf_height : 1;
 
-    while( m_cinfo.output_scanline < m_cinfo.output_height ) 
-    {
-        jpeg_read_scanlines(&m_cinfo, pBuffer, 1);
-        if( iComponents == 4 ) 
-        {
-            for( unsigned int i=0, c=0; i < m_cinfo.output_width; i++, c+=4 ) 
-            {
-                pOutBuffer[c]   = pBuffer[0][i*4];
-                pOutBuffer[c+1] = pBuffer[0][i*4+1];
-                pOutBuffer[c+2] = pBuffer[0][i*4+2];
-                pOutBuffer[c+3] = pBuffer[0][i*4+3];
-            }
-        }
-        else if( iComponents == 3 ) 
-        {
-            for( unsigned int i=0, c=0; i < m_cinfo.output_width; i++, c+=3 ) 
-            {
-                pOutBuffer[c]   = pBuffer[0][i*3];
-                pOutBuffer[c+1] = pBuffer[0][i*3+1];
-                pOutBuffer[c+2] = pBuffer[0][i*3+2];
-            }
-        }
-        else if( iComponents == 1 ) 
-        {
-            memcpy( pOutBuffer, pBuffer[0], m_cinfo.output_width );
-        }
-        else
+    // pRows will be deleted by jpeg_destroy_decompress
+    JSAMPARRAY pRows = (*m_cinfo.mem->alloc_sarray)( reinterpret_cast<j_common_ptr>( &m_cinfo ), JPOOL_IMAGE, lRowBytes, lRows );
+    try {
+        while( m_cinfo.output_scanline < m_cinfo.output_height ) 
         {
-            PODOFO_RAISE_ERROR_INFO( ePdfError_InternalLogic, "DCTDecode unknown components" );
+            const JDIMENSION lRead = jpeg_read_scanlines( &m_cinfo, pRows, lRows );
+            for( JDIMENSION i = 0; i < lRead; i++ )
+                GetStream()->Write( reinterpret_cast<const char*>(pRows[i]), lRowBytes );
         }
-        
-        GetStream()->Write( reinterpret_cast<char*>(pOutBuffer), lRowBytes );
+    } catch( PdfError & e ) {
+        // does nothing if a libjpeg error has destroyed it already
+        (void) jpeg_destroy_decompress( &m_cinfo );
+        throw e;
     }
 
-    podofo_free( pOutBuffer );
     (void) jpeg_destroy_decompress( &m_cinfo );
 }
 
@@ -87,6 +87,8 @@ namespace PoDoFo {
 #define PODOFO_FILTER_INTERNAL_BUFFER_SIZE 4096
 
 class PdfPredictorDecoder;
+class PdfPredictorEncoder;
+class PdfFilterOutputBuffer;
 class PdfOutputDevice;
 
 /** The ascii hex filter.
@@ -172,6 +174,7 @@ class PdfHexFilter : public PdfFilter {
  private:
     char m_cDecodedByte;
     bool m_bLow;
+    bool m_bEod;         ///< the end of data marker has been read
 };
 
 // -----------------------------------------------------
@@ -293,13 +296,10 @@ class PdfAscii85Filter : public PdfFilter {
      */
     inline virtual EPdfFilter GetType() const;
 
- private:
-    void EncodeTuple ( unsigned long tuple, int bytes );
-    void WidePut( unsigned long tuple, int bytes ) const;
-
  private:
     int           m_count;
     unsigned long m_tuple;
+    bool          m_bEod;  ///< the end of data marker has been read
 };
 
 // -----------------------------------------------------
@@ -424,14 +424,23 @@ class PdfFlateFilter : public PdfFilter {
      */
     inline virtual EPdfFilter GetType() const;
 
+    /** Set the compression level and strategy used by
+     *  the next call to BeginEncode.
+     *
+     *  \param rSettings the new settings
+     */
+    inline void SetSettings( const TFlateSettings & rSettings );
+
  private:
     void EncodeBlockInternal( const char* pBuffer, pdf_long lLen, int nMode );
 
  private:
     unsigned char        m_buffer[PODOFO_FILTER_INTERNAL_BUFFER_SIZE];
+    TFlateSettings       m_settings;
 
     z_stream             m_stream;
     PdfPredictorDecoder* m_pPredictor;
+    PdfPredictorEncoder* m_pPredictorEncoder;
 };
 
 // -----------------------------------------------------
@@ -458,6 +467,23 @@ EPdfFilter PdfFlateFilter::GetType() const
     return ePdfFilter_FlateDecode;
 }
 
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+void PdfFlateFilter::SetSettings( const TFlateSettings & rSettings )
+{
+    m_settings = rSettings;
+}
+
+/** The built-in encoder for whole buffers, which
+ *  compresses the data with a single call to zlib.
+ */
+class PdfZlibFlateEncoder : public PdfFlateEncoder {
+ public:
+    virtual void Encode( const char* pInBuffer, pdf_long lInLen, char** ppOutBuffer, pdf_long* plOutLen,
+                         const TFlateSettings & rSettings ) const;
+};
+
 
 /** The RLE filter.
  */
@@ -538,7 +564,23 @@ class PdfRLEFilter : public PdfFilter {
     inline virtual EPdfFilter GetType() const;
 
  private:
-    int m_nCodeLen;
+    /** Write the pending literal bytes as one literal run.
+     */
+    void FlushLiteral( PdfFilterOutputBuffer & rOutput );
+
+    /** Write the pending run of equal bytes, either as
+     *  a repeat run or as part of the pending literal.
+     */
+    void FlushRun( PdfFilterOutputBuffer & rOutput );
+
+ private:
+    int           m_nCodeLen;      ///< decoding: number of literal bytes left or minus the repeat count of the next byte
+    bool          m_bEod;          ///< decoding: the end of data marker has been read
+
+    unsigned char m_literal[128];  ///< encoding: pending literal bytes
+    int           m_nLiteral;
+    unsigned char m_cRun;          ///< encoding: byte of the pending run
+    int           m_nRun;          ///< encoding: length of the pending run
 };
 
 // -----------------------------------------------------
@@ -546,7 +588,7 @@ class PdfRLEFilter : public PdfFilter {
 // -----------------------------------------------------
 bool PdfRLEFilter::CanEncode() const
 {
-    return false;
+    return true;
 }
 
 // -----------------------------------------------------
@@ -36,6 +36,7 @@
 #include "PdfFileStream.h"
 #include "PdfMemStream.h"
 #include "PdfObject.h"
+#include "PdfSpoolStream.h"
 #include "PdfXRef.h"
 #include "PdfXRefStream.h"
 #include "PdfDefinesPrivate.h"
@@ -46,7 +47,7 @@ PdfImmediateWriter::PdfImmediateWriter( PdfOutputDevice* pDevice, PdfVecObjects*
                                         const PdfObject* pTrailer, EPdfVersion eVersion, 
                                         PdfEncrypt* pEncrypt, EPdfWriteMode eWriteMode )
     : PdfWriter( pVecObjects ), m_pParent( pVecObjects ), 
-      m_pDevice( pDevice ), m_pLast( NULL ), m_bOpenStream( false )
+      m_pDevice( pDevice ), m_pLast( NULL ), m_bOpenStream( false ), m_pSpoolFactory( NULL )
 {
     if( m_pTrailer )
         delete m_pTrailer;
@@ -57,21 +58,30 @@ PdfImmediateWriter::PdfImmediateWriter( PdfOutputDevice* pDevice, PdfVecObjects*
     // register as stream factory for PdfVecObjects
     m_pParent->SetStreamFactory( this );
 
-    this->CreateFileIdentifier( m_identifier, m_pTrailer );
-    // setup encryption
-    if( pEncrypt )
-    {
-        this->SetEncrypted( *pEncrypt );
-        m_pEncrypt->GenerateEncryptionKey( m_identifier );
-    }
-
-    // start with writing the header
-    this->SetPdfVersion( eVersion );
-    this->SetWriteMode( eWriteMode );
-    this->WritePdfHeader( m_pDevice );
-
-    m_pXRef = m_bXRefStream ? new PdfXRefStream( m_vecObjects, this ) : new PdfXRef();
+    try {
+        this->CreateFileIdentifier( m_identifier, m_pTrailer );
+        // setup encryption
+        if( pEncrypt )
+        {
+            this->SetEncrypted( *pEncrypt );
+            m_pEncrypt->GenerateEncryptionKey( m_identifier );
+        }
+
+        // start with writing the header
+        this->SetPdfVersion( eVersion );
+        this->SetWriteMode( eWriteMode );
+        this->WritePdfHeader( m_pDevice );
+
+        m_pXRef = m_bXRefStream ? new PdfXRefStream( m_vecObjects, this ) : new PdfXRef();
+    } catch( PdfError & e ) {
+        // The destructor is not called, so PdfVecObjects
+        // must not keep a pointer to this writer
+        m_pParent->SetStreamFactory( NULL );
+        m_pParent->Detach( this );
 
+        e.AddToCallstack( __FILE__, __LINE__ );
+        throw e;
+    }
 }
 
 PdfImmediateWriter::~PdfImmediateWriter()
@@ -80,6 +90,16 @@ PdfImmediateWriter::~PdfImmediateWriter()
         m_pParent->Detach( this );
     
     delete m_pXRef;
+    delete m_pSpoolFactory;
+}
+
+void PdfImmediateWriter::SetStreamMemoryBudget( pdf_long lMemoryBudget )
+{
+    delete m_pSpoolFactory;
+    m_pSpoolFactory = NULL;
+
+    if( lMemoryBudget >= 0 )
+        m_pSpoolFactory = new PdfSpoolStreamFactory( lMemoryBudget );
 }
 
 void PdfImmediateWriter::WriteObject( const PdfObject* pObject )
@@ -148,9 +168,12 @@ void PdfImmediateWriter::Finish()
 
 PdfStream* PdfImmediateWriter::CreateStream( PdfObject* pParent )
 {
-    return m_bOpenStream ? 
-        static_cast<PdfStream*>(new PdfMemStream( pParent )) :
-        static_cast<PdfStream*>(new PdfFileStream( pParent, m_pDevice ));
+    if( !m_bOpenStream )
+        return new PdfFileStream( pParent, m_pDevice );
+
+    return m_pSpoolFactory ? 
+        m_pSpoolFactory->CreateStream( pParent ) :
+        static_cast<PdfStream*>(new PdfMemStream( pParent ));
 }
 
 void PdfImmediateWriter::FinishLastObject()
@@ -42,6 +42,7 @@ namespace PoDoFo {
 
 class PdfEncrypt;
 class PdfOutputDevice;
+class PdfSpoolStreamFactory;
 class PdfXRef;
 
 /** A kind of PdfWriter that writes objects with streams immediately to
@@ -88,6 +89,21 @@ class PODOFO_API PdfImmediateWriter : private PdfWriter,
      */
     inline EPdfVersion GetPdfVersion() const;
 
+    /** Limit the memory used by streams which cannot be written
+     *  immediately, because another stream is written at the same time.
+     *
+     *  By default these streams are kept in memory until the document
+     *  is finished. With a memory budget, streams which would exceed it
+     *  are moved to a temporary file and copied from there when the
+     *  document is finished. Only streams created afterwards are affected.
+     *
+     *  \param lMemoryBudget number of bytes these streams may keep in
+     *                       memory together or -1 for no limit (the default)
+     *
+     *  \see PdfSpoolStreamFactory
+     */
+    void SetStreamMemoryBudget( pdf_long lMemoryBudget );
+
  private:
     void WriteObject( const PdfObject* pObject );
 
@@ -134,6 +150,8 @@ class PODOFO_API PdfImmediateWriter : private PdfWriter,
     PdfObject*       m_pLast;
 
     bool             m_bOpenStream;
+
+    PdfSpoolStreamFactory* m_pSpoolFactory; ///< creates the streams while m_bOpenStream is set, if not NULL
 };
 
 // -----------------------------------------------------
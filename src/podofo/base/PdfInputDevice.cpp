@@ -33,11 +33,21 @@
 
 #include "PdfInputDevice.h"
 
+#include "PdfInputStream.h"
+
 #include <cstdarg>
+#include <cstring>
 #include <fstream>
 #include <sstream>
 #include "PdfDefinesPrivate.h"
 
+#ifdef PODOFO_HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif // PODOFO_HAVE_SYS_MMAN_H
+
 namespace PoDoFo {
 
 PdfInputDevice::PdfInputDevice()
@@ -45,7 +55,7 @@ PdfInputDevice::PdfInputDevice()
     this->Init();
 }
 
-PdfInputDevice::PdfInputDevice( const char* pszFilename )
+PdfInputDevice::PdfInputDevice( const char* pszFilename, EPdfInputMode eMode )
 {
     this->Init();
 
@@ -54,6 +64,9 @@ PdfInputDevice::PdfInputDevice( const char* pszFilename )
         PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
     }
 
+    if( eMode == ePdfInputMode_ZeroCopy && this->MapFile( pszFilename ) )
+        return;
+
     try {
         m_pFile = fopen(pszFilename, "rb");
         //m_pStream = new std::ifstream( pszFilename, std::ios::binary );
@@ -100,7 +113,7 @@ PdfInputDevice::PdfInputDevice( const wchar_t* pszFilename )
 }
 #endif // _WIN32
 
-PdfInputDevice::PdfInputDevice( const char* pBuffer, size_t lLen )
+PdfInputDevice::PdfInputDevice( const char* pBuffer, size_t lLen, EPdfInputMode eMode )
 {
     this->Init();
 
@@ -109,20 +122,24 @@ PdfInputDevice::PdfInputDevice( const char* pBuffer, size_t lLen )
         PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
     }
 
-    try {
-        m_pStream = static_cast< std::istream* >( 
-            new std::istringstream( std::string( pBuffer, lLen ), std::ios::binary ) );
-        if( !m_pStream || !m_pStream->good() )
+    if( eMode == ePdfInputMode_ZeroCopy || !lLen )
+    {
+        m_pBuffer = pBuffer;
+    }
+    else
+    {
+        char* pCopy = static_cast<char*>( podofo_malloc( lLen ) );
+        if( !pCopy )
         {
-            PODOFO_RAISE_ERROR( ePdfError_FileNotFound );
+            PODOFO_RAISE_ERROR( ePdfError_OutOfMemory );
         }
-        m_StreamOwned = true;
-    }
-    catch(...) {
-        // should probably check the exact error, but for now it's a good error
-        PODOFO_RAISE_ERROR( ePdfError_FileNotFound );
+
+        memcpy( pCopy, pBuffer, lLen );
+        m_pBuffer      = pCopy;
+        m_bBufferOwned = true;
     }
-    PdfLocaleImbue(*m_pStream);
+
+    m_lBufferLen = lLen;
 }
 
 PdfInputDevice::PdfInputDevice( const std::istream* pInStream )
@@ -154,6 +171,17 @@ PdfInputDevice::~PdfInputDevice()
             fclose(m_pFile);
         }
     }
+
+    if( m_bBufferOwned )
+    {
+        podofo_free( const_cast<char*>(m_pBuffer) );
+    }
+#ifdef PODOFO_HAVE_SYS_MMAN_H
+    else if( m_bBufferMapped )
+    {
+        munmap( const_cast<char*>(m_pBuffer), m_lBufferLen );
+    }
+#endif // PODOFO_HAVE_SYS_MMAN_H
 }
 
 void PdfInputDevice::Init()
@@ -162,6 +190,51 @@ void PdfInputDevice::Init()
     m_pFile = 0;
     m_StreamOwned = false;
     m_bIsSeekable = true;
+
+    m_pBuffer       = NULL;
+    m_lBufferLen    = 0;
+    m_lBufferPos    = 0;
+    m_bBufferOwned  = false;
+    m_bBufferMapped = false;
+    m_bBufferEof    = false;
+}
+
+bool PdfInputDevice::MapFile( const char* pszFilename )
+{
+#ifdef PODOFO_HAVE_SYS_MMAN_H
+    int fd = open( pszFilename, O_RDONLY );
+    if( fd == -1 )
+        return false;
+
+    struct stat st;
+    if( fstat( fd, &st ) == -1 || !S_ISREG( st.st_mode ) )
+    {
+        close( fd );
+        return false;
+    }
+
+    if( !st.st_size )
+    {
+        // mmap cannot map empty files, an empty buffer behaves the same
+        close( fd );
+        m_pBuffer = "";
+        return true;
+    }
+
+    void* pMapping = mmap( NULL, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0 );
+    // The mapping stays valid after the descriptor has been closed
+    close( fd );
+    if( pMapping == MAP_FAILED )
+        return false;
+
+    m_pBuffer       = static_cast<const char*>(pMapping);
+    m_lBufferLen    = static_cast<size_t>(st.st_size);
+    m_bBufferMapped = true;
+    return true;
+#else
+    (void)pszFilename;
+    return false;
+#endif // PODOFO_HAVE_SYS_MMAN_H
 }
 
 void PdfInputDevice::Close()
@@ -171,6 +244,17 @@ void PdfInputDevice::Close()
 
 int PdfInputDevice::GetChar() const
 {
+    if (m_pBuffer)
+    {
+        if( m_lBufferPos >= m_lBufferLen )
+        {
+            m_bBufferEof = true;
+            return EOF;
+        }
+
+        return static_cast<unsigned char>( m_pBuffer[m_lBufferPos++] );
+    }
+
 	if (m_pStream)
     {
         return m_pStream->get();
@@ -186,6 +270,17 @@ int PdfInputDevice::GetChar() const
 
 int PdfInputDevice::Look() const 
 {
+    if (m_pBuffer)
+    {
+        if( m_lBufferPos >= m_lBufferLen )
+        {
+            m_bBufferEof = true;
+            return EOF;
+        }
+
+        return static_cast<unsigned char>( m_pBuffer[m_lBufferPos] );
+    }
+
     if (m_pStream)
     {
         return m_pStream->peek();
@@ -215,6 +310,11 @@ int PdfInputDevice::Look() const
 
 std::streamoff PdfInputDevice::Tell() const
 {
+    if (m_pBuffer)
+    {
+        return static_cast<std::streamoff>(m_lBufferPos);
+    }
+
 	if (m_pStream)
     {
         return m_pStream->tellg();
@@ -241,6 +341,26 @@ void PdfInputDevice::Seek( std::streamoff off, std::ios_base::seekdir dir )
 {
     if (m_bIsSeekable)
     {
+        if (m_pBuffer)
+        {
+            std::streamoff base;
+
+            if( dir == std::ios_base::beg )
+                base = 0;
+            else if( dir == std::ios_base::cur )
+                base = static_cast<std::streamoff>(m_lBufferPos);
+            else // if( dir == std::ios_base::end )
+                base = static_cast<std::streamoff>(m_lBufferLen);
+
+            if( base + off < 0 || base + off > static_cast<std::streamoff>(m_lBufferLen) )
+            {
+                PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDeviceOperation, "Failed to seek to given position in the buffer" );
+            }
+
+            m_lBufferPos = static_cast<size_t>(base + off);
+            m_bBufferEof = false;
+        }
+
         if (m_pStream)
         {
             m_pStream->seekg( off, dir );
@@ -272,6 +392,21 @@ void PdfInputDevice::Seek( std::streamoff off, std::ios_base::seekdir dir )
 
 std::streamoff PdfInputDevice::Read( char* pBuffer, std::streamsize lLen )
 {
+    if (m_pBuffer)
+    {
+        size_t lAvail = m_lBufferLen - m_lBufferPos;
+        size_t lRead  = lLen < 0 ? 0 : static_cast<size_t>(lLen);
+        if( lRead > lAvail )
+        {
+            lRead        = lAvail;
+            m_bBufferEof = true;
+        }
+
+        memcpy( pBuffer, m_pBuffer + m_lBufferPos, lRead );
+        m_lBufferPos += lRead;
+        return static_cast<std::streamoff>(lRead);
+    }
+
 	if (m_pStream) {
         m_pStream->read( pBuffer, lLen );
         return m_pStream->gcount();
@@ -282,4 +417,161 @@ std::streamoff PdfInputDevice::Read( char* pBuffer, std::streamsize lLen )
 	}
 }
 
+// -----------------------------------------------------
+// PdfStreamInputDevice
+// -----------------------------------------------------
+
+/** Number of bytes PdfStreamInputDevice reads from its input stream at once
+ */
+#define PODOFO_STREAM_DEVICE_BLOCK_SIZE 4096
+
+/** Number of bytes PdfStreamInputDevice keeps in memory for seeking back
+ */
+#define PODOFO_STREAM_DEVICE_HISTORY 64
+
+PdfStreamInputDevice::PdfStreamInputDevice( PdfInputStream* pInStream, bool bTakeOwnership )
+    : PdfInputDevice(), m_pInStream( pInStream ), m_bOwned( bTakeOwnership ),
+      m_pWindow( NULL ), m_lWindowLen( 0 ), m_lWindowPos( 0 ), m_lWindowOffset( 0 ),
+      m_bInputEof( false ), m_bEof( false )
+{
+    if( !pInStream )
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
+    }
+
+    m_pWindow = static_cast<char*>( podofo_malloc( PODOFO_STREAM_DEVICE_HISTORY + PODOFO_STREAM_DEVICE_BLOCK_SIZE ) );
+    if( !m_pWindow )
+    {
+        PODOFO_RAISE_ERROR( ePdfError_OutOfMemory );
+    }
+}
+
+PdfStreamInputDevice::~PdfStreamInputDevice()
+{
+    if( m_bOwned )
+        delete m_pInStream;
+
+    podofo_free( m_pWindow );
+}
+
+void PdfStreamInputDevice::Close()
+{
+    // nothing to do here, the input stream is closed when it is deleted
+}
+
+bool PdfStreamInputDevice::FillWindow() const
+{
+    if( m_bInputEof )
+        return false;
+
+    const size_t lKeep = PDF_MIN( m_lWindowLen, static_cast<size_t>(PODOFO_STREAM_DEVICE_HISTORY) );
+    memmove( m_pWindow, m_pWindow + m_lWindowLen - lKeep, lKeep );
+    m_lWindowOffset += static_cast<std::streamoff>(m_lWindowLen - lKeep);
+    m_lWindowPos     = lKeep;
+    m_lWindowLen     = lKeep;
+
+    const pdf_long lRead = m_pInStream->Read( m_pWindow + lKeep, PODOFO_STREAM_DEVICE_BLOCK_SIZE );
+    if( lRead < 0 )
+    {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDeviceOperation, "Failed to read from the input stream" );
+    }
+    else if( !lRead )
+    {
+        m_bInputEof = true;
+        return false;
+    }
+
+    m_lWindowLen += static_cast<size_t>(lRead);
+    return true;
+}
+
+std::streamoff PdfStreamInputDevice::Tell() const
+{
+    return m_lWindowOffset + static_cast<std::streamoff>(m_lWindowPos);
+}
+
+int PdfStreamInputDevice::GetChar() const
+{
+    if( m_lWindowPos >= m_lWindowLen && !this->FillWindow() )
+    {
+        m_bEof = true;
+        return EOF;
+    }
+
+    return static_cast<unsigned char>( m_pWindow[m_lWindowPos++] );
+}
+
+int PdfStreamInputDevice::Look() const
+{
+    if( m_lWindowPos >= m_lWindowLen && !this->FillWindow() )
+    {
+        m_bEof = true;
+        return EOF;
+    }
+
+    return static_cast<unsigned char>( m_pWindow[m_lWindowPos] );
+}
+
+void PdfStreamInputDevice::Seek( std::streamoff off, std::ios_base::seekdir dir )
+{
+    if( dir == std::ios_base::end )
+    {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDeviceOperation, "Cannot seek relative to the end of an input stream" );
+    }
+
+    const std::streamoff lTarget = (dir == std::ios_base::cur ? this->Tell() + off : off);
+    if( lTarget < m_lWindowOffset )
+    {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDeviceOperation, "Cannot seek back before the data held in memory" );
+    }
+
+    // skip forward until the target position is in the window
+    while( lTarget > m_lWindowOffset + static_cast<std::streamoff>(m_lWindowLen) )
+    {
+        m_lWindowPos = m_lWindowLen;
+        if( !this->FillWindow() )
+        {
+            PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDeviceOperation, "Failed to seek to given position in the input stream" );
+        }
+    }
+
+    m_lWindowPos = static_cast<size_t>(lTarget - m_lWindowOffset);
+    m_bEof       = false;
+}
+
+std::streamoff PdfStreamInputDevice::Read( char* pBuffer, std::streamsize lLen )
+{
+    std::streamsize lRead = 0;
+    while( lRead < lLen )
+    {
+        if( m_lWindowPos >= m_lWindowLen && !this->FillWindow() )
+        {
+            m_bEof = true;
+            break;
+        }
+
+        const size_t lCopy = PDF_MIN( static_cast<size_t>(lLen - lRead), m_lWindowLen - m_lWindowPos );
+        memcpy( pBuffer + lRead, m_pWindow + m_lWindowPos, lCopy );
+        m_lWindowPos += lCopy;
+        lRead        += static_cast<std::streamsize>(lCopy);
+    }
+
+    return static_cast<std::streamoff>(lRead);
+}
+
+bool PdfStreamInputDevice::Eof() const
+{
+    return m_bEof;
+}
+
+bool PdfStreamInputDevice::Bad() const
+{
+    return false;
+}
+
+void PdfStreamInputDevice::Clear( std::ios_base::iostate state ) const
+{
+    m_bEof = (state & std::ios_base::eofbit) != 0;
+}
+
 }; // namespace PoDoFo
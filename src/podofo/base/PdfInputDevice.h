@@ -43,6 +43,8 @@
 
 namespace PoDoFo {
 
+class PdfInputStream;
+
 /** This class provides an Input device which operates 
  *  either on a file, a buffer in memory or any arbitrary std::istream
  *
@@ -57,8 +59,13 @@ class PODOFO_API PdfInputDevice {
      *
      *  \param pszFilename path to a file that will be opened and all data
      *                     is read from this file.
+     *  \param eMode if ePdfInputMode_ZeroCopy the whole file is mapped
+     *               into memory and all reads are served directly from
+     *               the mapping. On platforms without memory mapping
+     *               the file is read through stdio as usual.
+     *               The file must not be truncated while it is mapped.
      */
-    PdfInputDevice( const char* pszFilename );
+    PdfInputDevice( const char* pszFilename, EPdfInputMode eMode = ePdfInputMode_Default );
 
 #ifdef _WIN32
     /** Construct a new PdfInputDevice that reads all data from a file.
@@ -74,12 +81,15 @@ class PODOFO_API PdfInputDevice {
 #endif // _WIN32
 
     /** Construct a new PdfInputDevice that reads all data from a memory buffer.
-     *  The buffer will not be owned by this object - it is COPIED.
+     *  The buffer will not be owned by this object.
      *
      *  \param pBuffer a buffer in memory
      *  \param lLen the length of the buffer in memory
+     *  \param eMode by default the buffer is COPIED. If ePdfInputMode_ZeroCopy
+     *               is passed the buffer is read in place and has to stay
+     *               valid and unmodified as long as this device is used.
      */
-    PdfInputDevice( const char* pBuffer, size_t lLen );
+    PdfInputDevice( const char* pBuffer, size_t lLen, EPdfInputMode eMode = ePdfInputMode_Default );
 
     /** Construct a new PdfInputDevice that reads all data from a std::istream.
      *
@@ -152,6 +162,23 @@ class PODOFO_API PdfInputDevice {
      * this value with SetIsSeekable(bool) .
      */
     PODOFO_NOTHROW inline bool IsSeekable() const;
+
+    /**
+     * Get direct access to the data of this device if it is held
+     * contiguously in memory, i.e. for memory buffers and mapped files.
+     *
+     * \returns a pointer to the first byte of the data or NULL
+     *          if the device reads from a file or stream.
+     *
+     * \see GetBufferLength
+     */
+    PODOFO_NOTHROW inline const char* GetBuffer() const;
+
+    /**
+     * \returns the length of the buffer returned by GetBuffer()
+     *          or 0 if the device is not held in memory.
+     */
+    PODOFO_NOTHROW inline size_t GetBufferLength() const;
  protected:
     /**
      * Control whether or or not this stream is flagged
@@ -169,11 +196,25 @@ class PODOFO_API PdfInputDevice {
      */
     void Init();
 
+    /** Map a file into memory and read from the mapping.
+     *
+     *  \returns false if the file could not be mapped
+     *           and has to be read through stdio instead
+     */
+    bool MapFile( const char* pszFilename );
+
  private:
     std::istream* m_pStream;
 	  FILE *				m_pFile;
     bool          m_StreamOwned;
     bool          m_bIsSeekable;
+
+    const char*    m_pBuffer;       ///< contiguous data for memory and mapped devices
+    size_t         m_lBufferLen;
+    mutable size_t m_lBufferPos;
+    bool           m_bBufferOwned;  ///< m_pBuffer was allocated using podofo_malloc
+    bool           m_bBufferMapped; ///< m_pBuffer is a memory mapping of a file
+    mutable bool   m_bBufferEof;
 };
 
 bool PdfInputDevice::IsSeekable() const
@@ -188,6 +229,8 @@ void PdfInputDevice::SetSeekable(bool bIsSeekable)
 
 bool PdfInputDevice::Bad() const
 {
+    if (m_pBuffer)
+        return false;
     if (m_pStream)
         return m_pStream->bad();
     return m_pFile != NULL;
@@ -195,6 +238,8 @@ bool PdfInputDevice::Bad() const
 
 bool PdfInputDevice::Eof() const
 {
+    if (m_pBuffer)
+        return m_bBufferEof;
     if (m_pStream)
         return m_pStream->eof();
     if (m_pFile)
@@ -204,10 +249,91 @@ bool PdfInputDevice::Eof() const
 
 void PdfInputDevice::Clear(std::ios_base::iostate state) const
 {
+    if (m_pBuffer)
+        m_bBufferEof = (state & std::ios_base::eofbit) != 0;
     if (m_pStream)
         m_pStream->clear(state);
 }
 
+const char* PdfInputDevice::GetBuffer() const
+{
+    return m_pBuffer;
+}
+
+size_t PdfInputDevice::GetBufferLength() const
+{
+    return m_pBuffer ? m_lBufferLen : 0;
+}
+
+/** An input device which reads sequentially from a PdfInputStream,
+ *  e.g. from a PdfFilteredInputStream which decodes a stream while
+ *  it is read.
+ *
+ *  Only a small window of the data is held in memory, independent
+ *  of the length of the stream. Therefore the device can seek back
+ *  only a few bytes behind the furthest position read so far,
+ *  seeking forward skips data and seeking relative to the end is
+ *  not supported.
+ */
+class PODOFO_API PdfStreamInputDevice : public PdfInputDevice {
+ public:
+    /** Construct a new PdfStreamInputDevice that reads from a PdfInputStream.
+     *
+     *  \param pInStream read all data from this stream
+     *  \param bTakeOwnership if true pInStream is deleted
+     *                        together with this device
+     */
+    PdfStreamInputDevice( PdfInputStream* pInStream, bool bTakeOwnership = false );
+
+    virtual ~PdfStreamInputDevice();
+
+    virtual void Close();
+
+    virtual std::streamoff Tell() const;
+
+    virtual int GetChar() const;
+
+    virtual int Look() const;
+
+    /** Seek the device to the position offset from the beginning
+     *  or from the current position.
+     *
+     *  Positions before the window held in memory and seeking
+     *  relative to the end raise an InvalidDeviceOperation.
+     */
+    virtual void Seek( std::streamoff off, std::ios_base::seekdir dir = std::ios_base::beg );
+
+    virtual std::streamoff Read( char* pBuffer, std::streamsize lLen );
+
+    PODOFO_NOTHROW virtual bool Eof() const;
+
+    PODOFO_NOTHROW virtual bool Bad() const;
+
+    PODOFO_NOTHROW virtual void Clear( std::ios_base::iostate state = std::ios_base::goodbit ) const;
+
+ private:
+    /** Read the next block from the input stream into the window,
+     *  keeping the last few bytes of the window for seeking back.
+     *
+     *  \returns false if there is no more data to read
+     */
+    bool FillWindow() const;
+
+    PdfStreamInputDevice( const PdfStreamInputDevice & rhs );
+    const PdfStreamInputDevice & operator=( const PdfStreamInputDevice & rhs );
+
+ private:
+    PdfInputStream*        m_pInStream;
+    bool                   m_bOwned;
+
+    char*                  m_pWindow;
+    mutable size_t         m_lWindowLen;
+    mutable size_t         m_lWindowPos;
+    mutable std::streamoff m_lWindowOffset; ///< position of the first byte of the window in the stream
+    mutable bool           m_bInputEof;     ///< the input stream has no more data
+    mutable bool           m_bEof;
+};
+
 };
 
 #endif // _PDF_INPUT_DEVICE_H_
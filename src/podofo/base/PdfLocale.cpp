@@ -36,6 +36,8 @@
 #include "PdfError.h"
 #include "PdfDefinesPrivate.h"
 
+#include <cmath>
+#include <cstring>
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
@@ -62,4 +64,177 @@ void PdfLocaleImbue(std::ios_base& s)
 #endif
 }
 
+/** Exactly representable powers of ten for the fast path of PdfLocaleParseReal
+ */
+static const double s_dPowersOfTen[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static const int s_nMaxExactPowerOfTen = 22;
+
+/** Maximum number of significant digits which fit into a pdf_uint64
+ */
+static const int s_nMaxMantissaDigits = 19;
+
+size_t PdfLocaleParseReal( const char* pszBuffer, size_t lLen, double & rdValue )
+{
+    size_t     i          = 0;
+    bool       bNegative  = false;
+    bool       bDigits    = false;
+    bool       bInexact   = false;
+    int        nSignificant = 0;
+    int        nExponent  = 0;
+    pdf_uint64 nMantissa  = 0;
+
+    if( i < lLen && (pszBuffer[i] == '-' || pszBuffer[i] == '+') )
+        bNegative = (pszBuffer[i++] == '-');
+
+    // integer part
+    for( ; i < lLen && pszBuffer[i] >= '0' && pszBuffer[i] <= '9'; ++i )
+    {
+        bDigits = true;
+        if( nSignificant < s_nMaxMantissaDigits )
+        {
+            nMantissa = nMantissa * 10 + (pszBuffer[i] - '0');
+            if( nMantissa )
+                ++nSignificant;
+        }
+        else
+        {
+            ++nExponent;
+            bInexact = true;
+        }
+    }
+
+    // fractional part
+    if( i < lLen && pszBuffer[i] == '.' )
+    {
+        for( ++i; i < lLen && pszBuffer[i] >= '0' && pszBuffer[i] <= '9'; ++i )
+        {
+            bDigits = true;
+            if( nSignificant < s_nMaxMantissaDigits )
+            {
+                nMantissa = nMantissa * 10 + (pszBuffer[i] - '0');
+                --nExponent;
+                if( nMantissa )
+                    ++nSignificant;
+            }
+            else if( pszBuffer[i] != '0' )
+                bInexact = true;
+        }
+    }
+
+    if( !bDigits )
+        return 0;
+
+    if( !bInexact && nMantissa <= (PODOFO_ULL_LITERAL(1) << 53) 
+        && nExponent <= 0 && -nExponent <= s_nMaxExactPowerOfTen )
+    {
+        // Both operands are exact, so IEEE division rounds correctly
+        rdValue = static_cast<double>(nMantissa) / s_dPowersOfTen[-nExponent];
+    }
+    else
+    {
+        // Rare case of very long or very large numbers
+        std::istringstream parser( std::string( pszBuffer, i ) );
+        PdfLocaleImbue( parser );
+        if( !(parser >> rdValue) )
+            return 0;
+
+        return i;
+    }
+
+    if( bNegative )
+        rdValue = -rdValue;
+
+    return i;
+}
+
+/** Strip trailing zeros and a trailing decimal point
+ */
+static size_t PdfLocaleCompactReal( const char* pszBuffer, size_t lLen )
+{
+    if( !memchr( pszBuffer, '.', lLen ) )
+        return lLen;
+
+    while( lLen && pszBuffer[lLen - 1] == '0' )
+        --lLen;
+    if( lLen && pszBuffer[lLen - 1] == '.' )
+        --lLen;
+
+    return lLen;
+}
+
+size_t PdfLocaleFormatReal( double dValue, char* pszBuffer, size_t lBufferLen, bool bCompact, int nPrecision )
+{
+    static const double dMaxScaled = 4503599627370496.0; // 2^52, fractions are exact below
+    static const int    nMaxFractionDigits = 15;
+
+    if( !lBufferLen )
+        return 0;
+
+    const int    nFractionDigits = nPrecision;
+    const bool   bFastPath       = nPrecision >= 0 && nPrecision <= nMaxFractionDigits;
+    const double dScaled         = bFastPath ? std::fabs( dValue ) * s_dPowersOfTen[nPrecision] : 0.0;
+    size_t       lLen            = 0;
+
+    if( bFastPath && dScaled < dMaxScaled )
+    {
+        double dInteger  = std::floor( dScaled );
+        double dFraction = dScaled - dInteger;
+        // The multiplication may be off by half an ulp, so values close
+        // to a rounding tie cannot be decided here
+        double dUncertainty = dScaled * 2.3e-16 + 1e-300;
+
+        if( std::fabs( dFraction - 0.5 ) > dUncertainty )
+        {
+            pdf_uint64 nScaled = static_cast<pdf_uint64>(dInteger) + (dFraction > 0.5 ? 1 : 0);
+            char       digits[32];
+            int        nDigits = 0;
+
+            do {
+                digits[nDigits++] = static_cast<char>('0' + nScaled % 10);
+                nScaled /= 10;
+            } while( nScaled || nDigits <= nFractionDigits );
+
+            char   buffer[40];
+            size_t lPos = 0;
+            if( std::signbit( dValue ) )
+                buffer[lPos++] = '-';
+
+            while( nDigits > nFractionDigits )
+                buffer[lPos++] = digits[--nDigits];
+
+            if( nDigits )
+            {
+                buffer[lPos++] = '.';
+                while( nDigits )
+                    buffer[lPos++] = digits[--nDigits];
+            }
+
+            if( bCompact )
+                lPos = PdfLocaleCompactReal( buffer, lPos );
+
+            lLen = PDF_MIN( lPos, lBufferLen - 1 );
+            memcpy( pszBuffer, buffer, lLen );
+            pszBuffer[lLen] = '\0';
+            return lLen;
+        }
+    }
+
+    // Huge, non finite or ambiguous values are formatted by the stream library
+    std::ostringstream oss;
+    PdfLocaleImbue( oss );
+    oss.precision( nPrecision );
+    oss << std::fixed << dValue;
+
+    const std::string & sValue = oss.str();
+    lLen = bCompact ? PdfLocaleCompactReal( sValue.c_str(), sValue.length() ) : sValue.length();
+    lLen = PDF_MIN( lLen, lBufferLen - 1 );
+    memcpy( pszBuffer, sValue.c_str(), lLen );
+    pszBuffer[lLen] = '\0';
+    return lLen;
+}
+
 };
@@ -35,6 +35,7 @@
 #define PODOFO_PDFLOCALE_H
 
 #include <ios>
+#include <cstddef>
 
 namespace PoDoFo {
 
@@ -64,6 +65,51 @@ static const char PdfIOLocale[] = "C";
  */
 void PODOFO_API PdfLocaleImbue(std::ios_base&);
 
+/**
+ * Buffer size which is large enough to hold any finite double
+ * formatted by PdfLocaleFormatReal including the terminating zero.
+ */
+#define PDF_REAL_BUFFER_LEN 320
+
+/**
+ * Parse a PDF real number without depending on the current locale
+ * and without allocating memory.
+ *
+ * Accepts an optional sign followed by digits with an optional
+ * decimal point, e.g. "3.14", "-.5" or "+12.". The result is
+ * correctly rounded.
+ *
+ * \param pszBuffer the characters to parse, need not be zero terminated
+ * \param lLen number of characters in pszBuffer
+ * \param rdValue the parsed value is stored here
+ *
+ * \returns the number of characters that have been parsed or 0
+ *          if pszBuffer does not start with a real number
+ */
+size_t PODOFO_API PdfLocaleParseReal( const char* pszBuffer, size_t lLen, double & rdValue );
+
+/**
+ * Format a real number for a PDF file without depending on the
+ * current locale and without allocating memory.
+ *
+ * The number is written with nPrecision fractional digits, exactly like
+ * std::fixed formatting of a stream imbued with PdfLocaleImbue().
+ *
+ * \param dValue the number to format
+ * \param pszBuffer destination buffer, should have room for at least
+ *                  PDF_REAL_BUFFER_LEN characters. Longer output is truncated.
+ * \param lBufferLen size of pszBuffer
+ * \param bCompact if true, trailing zeros and a trailing decimal point
+ *                 are removed, which gives the shortest representation
+ *                 at this precision
+ * \param nPrecision number of fractional digits, six by default 
+ *                   like std::fixed
+ *
+ * \returns the number of characters written to pszBuffer (which is
+ *          always zero terminated)
+ */
+size_t PODOFO_API PdfLocaleFormatReal( double dValue, char* pszBuffer, size_t lBufferLen, bool bCompact, int nPrecision = 6 );
+
 };
 
 #endif
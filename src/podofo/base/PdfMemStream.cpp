@@ -40,6 +40,7 @@
 #include "PdfOutputDevice.h"
 #include "PdfOutputStream.h"
 #include "PdfVariant.h"
+#include "PdfVecObjects.h"
 #include "PdfDefinesPrivate.h"
 
 #include <stdlib.h>
@@ -47,12 +48,12 @@
 namespace PoDoFo {
 
 PdfMemStream::PdfMemStream( PdfObject* pParent )
-    : PdfStream( pParent ), m_pStream( NULL ), m_pBufferStream( NULL ), m_lLength( 0 )
+    : PdfStream( pParent ), m_pStream( NULL ), m_pBufferStream( NULL ), m_lLength( 0 ), m_bFlateEncode( false )
 {
 }
 
 PdfMemStream::PdfMemStream( const PdfMemStream & rhs )
-    : PdfStream( NULL ), m_pStream( NULL ), m_pBufferStream( NULL ), m_lLength( 0 )
+    : PdfStream( NULL ), m_pStream( NULL ), m_pBufferStream( NULL ), m_lLength( 0 ), m_bFlateEncode( false )
 {
     operator=(rhs);
 }
@@ -66,10 +67,19 @@ void PdfMemStream::BeginAppendImpl( const TVecFilters & vecFilters )
     m_buffer  = PdfRefCountedBuffer();
 	m_lLength = 0;
 
-    if( vecFilters.size() )
+    const TFlateSettings* pFlateSettings = this->GetEncodeFlateSettings();
+    if( vecFilters.size() == 1 && vecFilters.front() == ePdfFilter_FlateDecode 
+        && (!pFlateSettings || pFlateSettings->nPredictor == 1) )
+    {
+        // The data is kept in memory anyways, so collect it
+        // and compress all of it at once in EndAppendImpl
+        m_bFlateEncode = true;
+        m_pStream      = new PdfBufferOutputStream( &m_buffer );
+    }
+    else if( vecFilters.size() )
     {
         m_pBufferStream = new PdfBufferOutputStream( &m_buffer );
-        m_pStream       = PdfFilterFactory::CreateEncodeStream( vecFilters, m_pBufferStream );
+        m_pStream       = PdfFilterFactory::CreateEncodeStream( vecFilters, m_pBufferStream, pFlateSettings );
     }
     else 
         m_pStream = new PdfBufferOutputStream( &m_buffer );
@@ -106,6 +116,12 @@ void PdfMemStream::EndAppendImpl()
         m_pBufferStream = NULL;
     }
 
+    if( m_bFlateEncode )
+    {
+        m_bFlateEncode = false;
+        this->FlateEncodeBuffer();
+    }
+
     if( m_pParent )
         m_pParent->GetDictionary().AddKey( PdfName::KeyLength, PdfVariant(static_cast<pdf_int64>(m_lLength) ) );
 }
@@ -238,23 +254,29 @@ void PdfMemStream::Uncompress()
 }
 
 void PdfMemStream::FlateCompressStreamData()
+{
+    if( !m_lLength )
+        return;
+
+    this->FlateEncodeBuffer();
+}
+
+void PdfMemStream::FlateEncodeBuffer()
 {
     char*            pBuffer;
     pdf_long             lLen;
 
-    if( !m_lLength )
-        return;
+    const TFlateSettings* pSettings = this->GetEncodeFlateSettings();
+    PdfFilterFactory::GetFlateEncoder()->Encode( m_buffer.GetBuffer(), m_lLength, &pBuffer, &lLen,
+                                                 pSettings ? *pSettings : PdfFilterFactory::GetFlateSettings() );
 
-    PODOFO_UNIQUEU_PTR<PdfFilter> pFilter( PdfFilterFactory::Create( ePdfFilter_FlateDecode ) );
-    if( pFilter.get() )
-    {
-        pFilter->Encode( m_buffer.GetBuffer(), m_buffer.GetSize(), &pBuffer, &lLen );
-        this->Set( pBuffer, lLen );
-    }
-    else
-    {
-        PODOFO_RAISE_ERROR( ePdfError_UnsupportedFilter );
-    }
+    // Take the encoded data as it is. Set() would encode
+    // it again using the default filter.
+    m_buffer  = PdfRefCountedBuffer( pBuffer, lLen );
+    m_lLength = lLen;
+
+    if( m_pParent )
+        m_pParent->GetDictionary().AddKey( PdfName::KeyLength, PdfVariant( static_cast<pdf_int64>(m_lLength) ) );
 }
 
 const PdfStream & PdfMemStream::operator=( const PdfStream & rhs )
@@ -182,6 +182,11 @@ class PODOFO_API PdfMemStream : public PdfStream {
      */
     void FlateCompressStreamData();
 
+    /** Replace the current data with its FlateDecode (zlib) compressed form,
+     *  using the encoder returned by PdfFilterFactory::GetFlateEncoder.
+     *  A predictor in the settings of the stream is not applied.
+     */
+    void FlateEncodeBuffer();
 
  private:
     PdfRefCountedBuffer    m_buffer;
@@ -189,6 +194,7 @@ class PODOFO_API PdfMemStream : public PdfStream {
     PdfBufferOutputStream* m_pBufferStream;
 
     pdf_long               m_lLength;
+    bool                   m_bFlateEncode;   ///< Compress the collected data in EndAppendImpl
 };
 
 // -----------------------------------------------------
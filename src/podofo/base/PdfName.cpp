@@ -188,11 +188,25 @@ PdfName PdfName::FromEscaped( const char * pszName, pdf_long ilen )
 void PdfName::Write( PdfOutputDevice* pDevice, EPdfWriteMode, const PdfEncrypt* ) const
 {
     // Allow empty names, which are legal according to the PDF specification
-    pDevice->Print( "/" );
-    if( m_Data.length() )
+    const char* pszData = m_Data.c_str();
+    size_t      lLen    = m_Data.length();
+    size_t      i;
+
+    // Most names contain only regular characters and can be written as they are
+    for( i = 0; i < lLen; i++ ) 
+    {
+        if( !PdfTokenizer::IsRegular( pszData[i] ) || 
+            !PdfTokenizer::IsPrintable( pszData[i] ) || 
+            pszData[i] == '#' )
+            break;
+    }
+
+    if( i == lLen )
+        pDevice->WriteName( pszData, lLen );
+    else
     {
         std::string escaped( EscapeName(m_Data.begin(), m_Data.length()) );
-        pDevice->Write( escaped.c_str(), escaped.length() );
+        pDevice->WriteName( escaped.c_str(), escaped.length() );
     }
 }
 
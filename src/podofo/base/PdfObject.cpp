@@ -34,6 +34,7 @@
 #include "PdfObject.h"
 
 #include "PdfArray.h"
+#include "PdfDeferredStream.h"
 #include "PdfDictionary.h"
 #include "PdfEncrypt.h"
 #include "PdfFileStream.h"
@@ -217,13 +218,17 @@ void PdfObject::WriteObject( PdfOutputDevice* pDevice, EPdfWriteMode eWriteMode,
 
     if( m_reference.IsIndirect() )
     {
+        pDevice->WriteUInt( m_reference.ObjectNumber() );
+        pDevice->Write( " ", 1 );
+        pDevice->WriteUInt( m_reference.GenerationNumber() );
+
         if( (eWriteMode & ePdfWriteMode_Clean) == ePdfWriteMode_Clean ) 
         {
-            pDevice->Print( "%i %i obj\n", m_reference.ObjectNumber(), m_reference.GenerationNumber() );
+            pDevice->Write( " obj\n", 5 );
         }
         else 
         {
-            pDevice->Print( "%i %i obj", m_reference.ObjectNumber(), m_reference.GenerationNumber() );
+            pDevice->Write( " obj", 4 );
         }
     }
 
@@ -235,10 +240,12 @@ void PdfObject::WriteObject( PdfOutputDevice* pDevice, EPdfWriteMode eWriteMode,
     if( pEncrypt && m_pStream )
     {
         // Set length if it is a key
-        PdfFileStream* pFileStream = dynamic_cast<PdfFileStream*>(m_pStream);
-        if( !pFileStream )
+        PdfFileStream*     pFileStream     = dynamic_cast<PdfFileStream*>(m_pStream);
+        PdfDeferredStream* pDeferredStream = dynamic_cast<PdfDeferredStream*>(m_pStream);
+        if( !pFileStream && !pDeferredStream )
         {
-            // PdfFileStream handles encryption internally
+            // PdfFileStream handles encryption internally,
+            // PdfDeferredStream sets its length while it is written
             pdf_long lLength = pEncrypt->CalculateStreamLength(m_pStream->GetLength());
             PdfVariant varLength = static_cast<pdf_int64>(lLength);
             *(const_cast<PdfObject*>(this)->GetIndirectKey( PdfName::KeyLength )) = varLength;
@@ -337,18 +344,7 @@ PdfStream* PdfObject::GetStream_NoDL()
 {
     if( !m_pStream )
     {
-        if ( GetDataType() != ePdfDataType_Dictionary )
-        {
-            PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDataType, "Tried to get stream of non-dictionary object");
-	    }
-        if ( !m_reference.IsIndirect() )
-		{
-            PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDataType, "Tried to get stream of non-indirect PdfObject");
-		}
-        if( !m_pOwner ) 
-        {
-            PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidHandle, "Tried to create stream on PdfObject lacking owning document/PdfVecObjects" );
-        }
+        CheckStreamParent();
 
         m_pStream = m_pOwner->CreateStream( this );
     }
@@ -357,6 +353,40 @@ PdfStream* PdfObject::GetStream_NoDL()
     return m_pStream;
 }
 
+PdfDeferredStream* PdfObject::CreateDeferredStream()
+{
+    // Load an existing stream now, so that it
+    // does not replace the new one later
+    DelayedStreamLoad();
+    CheckStreamParent();
+
+    // A replaced PdfDeferredStream passes on its length object,
+    // so that it is not left behind in the owner
+    PdfDeferredStream* pOld    = dynamic_cast<PdfDeferredStream*>(m_pStream);
+    PdfDeferredStream* pStream = new PdfDeferredStream( this, pOld ? pOld->m_pLength : NULL );
+    delete m_pStream;
+    m_pStream = pStream;
+
+    SetDirty( true );
+    return pStream;
+}
+
+void PdfObject::CheckStreamParent() const
+{
+    if ( GetDataType() != ePdfDataType_Dictionary )
+    {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDataType, "Tried to get stream of non-dictionary object");
+    }
+    if ( !m_reference.IsIndirect() )
+    {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDataType, "Tried to get stream of non-indirect PdfObject");
+    }
+    if( !m_pOwner ) 
+    {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidHandle, "Tried to create stream on PdfObject lacking owning document/PdfVecObjects" );
+    }
+}
+
 const PdfStream* PdfObject::GetStream() const
 {
     DelayedStreamLoad();
@@ -50,6 +50,7 @@ class PdfStream;
 class PdfVecObjects;
 class PdfDictionary;
 class PdfArray;
+class PdfDeferredStream;
 class PdfDocument;
 
 /**
@@ -230,6 +231,16 @@ class PODOFO_API PdfObject : public PdfVariant {
      */
     const PdfStream* GetStream() const;
 
+    /** Replace the stream of this object by a new PdfDeferredStream,
+     *  whose data is read from a PdfStreamSource only when the
+     *  object is written.
+     *
+     *  This will set the dirty flag of this object.
+     *  \returns the new stream, which is owned by this object
+     *  \see PdfDeferredStream::SetSource
+     */
+    PdfDeferredStream* CreateDeferredStream();
+
     /** Check if this object has a PdfStream object
      *  appended.
      * 
@@ -325,6 +336,10 @@ class PODOFO_API PdfObject : public PdfVariant {
      */
     PdfStream* GetStream_NoDL();
 
+    /** Raises an error if this object cannot have a stream
+     */
+    void CheckStreamParent() const;
+
     virtual void AfterDelayedLoad( EPdfDataType eDataType );
 
     /** Set the owner of this object variant
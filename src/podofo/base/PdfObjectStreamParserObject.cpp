@@ -56,10 +56,18 @@ PdfObjectStreamParserObject::PdfObjectStreamParserObject(PdfParserObject* pParse
 
 PdfObjectStreamParserObject::~PdfObjectStreamParserObject()
 {
-
+    // Delete objects which were decoded but never added
+    for( size_t i = 0; i < m_vecDecoded.size(); i++ )
+        delete m_vecDecoded[i];
 }
 
 void PdfObjectStreamParserObject::Parse(ObjectIdList const & list)
+{
+    this->Decode( list );
+    this->AddObjects();
+}
+
+void PdfObjectStreamParserObject::Decode(ObjectIdList const & list)
 {
     pdf_int64 lNum   = m_pParser->GetIndirectKeyAsLong( "N", 0 );
     pdf_int64 lFirst = m_pParser->GetIndirectKeyAsLong( "First", 0 );
@@ -70,11 +78,6 @@ void PdfObjectStreamParserObject::Parse(ObjectIdList const & list)
 
     try {
         this->ReadObjectsFromStream( pBuffer, lBufferLen, lNum, lFirst, list );
-
-        // the object stream is not needed anymore in the final PDF
-        delete m_vecObjects->RemoveObject( m_pParser->Reference() );
-        m_pParser = NULL;
-
     } catch( PdfError & rError ) {
         podofo_free( pBuffer );
         throw rError;
@@ -83,9 +86,32 @@ void PdfObjectStreamParserObject::Parse(ObjectIdList const & list)
     podofo_free( pBuffer );
 }
 
+void PdfObjectStreamParserObject::AddObjects()
+{
+    for( size_t i = 0; i < m_vecDecoded.size(); i++ )
+    {
+        PdfObject* pObject = m_vecDecoded[i];
+        m_vecDecoded[i]    = NULL;
+
+        if( m_vecObjects->GetObject( pObject->Reference() ) ) 
+        {
+            PdfError::LogMessage( eLogSeverity_Warning, "Object: %" PDF_FORMAT_INT64 " 0 R will be deleted and loaded again.\n", 
+                                  static_cast<pdf_int64>(pObject->Reference().ObjectNumber()) );
+            delete m_vecObjects->RemoveObject( pObject->Reference(), false );
+        }
+        m_vecObjects->insert_sorted( pObject );
+    }
+
+    m_vecDecoded.clear();
+
+    // the object stream is not needed anymore in the final PDF
+    delete m_vecObjects->RemoveObject( m_pParser->Reference() );
+    m_pParser = NULL;
+}
+
 void PdfObjectStreamParserObject::ReadObjectsFromStream( char* pBuffer, pdf_long lBufferLen, pdf_int64 lNum, pdf_int64 lFirst, ObjectIdList const & list)
 {
-    PdfRefCountedInputDevice device( pBuffer, lBufferLen );
+    PdfRefCountedInputDevice device( pBuffer, lBufferLen, ePdfInputMode_ZeroCopy );
     PdfTokenizer             tokenizer( device, m_buffer );
     PdfVariant               var;
     int                      i = 0;
@@ -108,7 +134,7 @@ void PdfObjectStreamParserObject::ReadObjectsFromStream( char* pBuffer, pdf_long
 		// use a second tokenizer here so that anything that gets dequeued isn't left in the tokenizer that reads the offsets and lengths
 	    PdfTokenizer variantTokenizer( device, m_buffer );
         variantTokenizer.GetNextVariant( var, 0 ); // Stream is already decrypted
-		bool should_read = std::find(list.begin(), list.end(), lObj) != list.end();
+		bool should_read = std::binary_search(list.begin(), list.end(), lObj);
 #if defined(PODOFO_VERBOSE_DEBUG)
         std::cerr << "ReadObjectsFromStream STREAM=" << m_pParser->Reference().ToString() <<
 			", OBJ=" << lObj <<
@@ -116,12 +142,7 @@ void PdfObjectStreamParserObject::ReadObjectsFromStream( char* pBuffer, pdf_long
 #endif
 		if (should_read)
         {
-			if(m_vecObjects->GetObject(PdfReference( static_cast<int>(lObj), PODOFO_LL_LITERAL(0) ))) 
-            {
-                PdfError::LogMessage( eLogSeverity_Warning, "Object: %" PDF_FORMAT_INT64 " 0 R will be deleted and loaded again.\n", lObj );
-                delete m_vecObjects->RemoveObject(PdfReference( static_cast<int>(lObj), PODOFO_LL_LITERAL(0) ),false);
-            }
-            m_vecObjects->insert_sorted( new PdfObject( PdfReference( static_cast<int>(lObj), PODOFO_LL_LITERAL(0) ), var ) );
+            m_vecDecoded.push_back( new PdfObject( PdfReference( static_cast<int>(lObj), PODOFO_LL_LITERAL(0) ), var ) );
 		}
 
         // move back to the position inside of the table of contents
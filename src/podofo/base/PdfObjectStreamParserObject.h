@@ -40,6 +40,7 @@
 
 namespace PoDoFo {
 
+class PdfObject;
 class PdfParserObject;
 class PdfVecObjects;
 
@@ -65,7 +66,35 @@ public:
 
     ~PdfObjectStreamParserObject();
 
-    void Parse(ObjectIdList const &);
+    /**
+     * Read all objects listed in list from the object stream, 
+     * add them to the vector of objects and remove the object stream.
+     * This is the same as calling Decode and AddObjects.
+     *
+     * \param list object numbers of the objects to read, sorted ascending
+     */
+    void Parse(ObjectIdList const & list);
+
+    /**
+     * Decompress the object stream and read all objects listed in list
+     * without adding them to the vector of objects.
+     *
+     * Neither the vector of objects nor the object stream are modified,
+     * so Decode can be called concurrently for different object streams
+     * as long as their streams and all objects they refer to
+     * have been loaded and no objects are added in the meantime.
+     *
+     * \param list object numbers of the objects to read, sorted ascending
+     *
+     * \see AddObjects
+     */
+    void Decode(ObjectIdList const & list);
+
+    /**
+     * Add all objects read by Decode to the vector of objects
+     * and remove the object stream from it.
+     */
+    void AddObjects();
 
 private:
     void ReadObjectsFromStream( char* pBuffer, pdf_long lBufferLen, pdf_int64 lNum, pdf_int64 lFirst, ObjectIdList const &);
@@ -74,6 +103,8 @@ private:
     PdfParserObject* m_pParser;
     PdfVecObjects* m_vecObjects;
     PdfRefCountedBuffer m_buffer;
+
+    std::vector<PdfObject*> m_vecDecoded;
 };
 
 };
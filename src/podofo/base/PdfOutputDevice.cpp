@@ -38,6 +38,14 @@
 #include <fstream>
 #include <sstream>
 
+/** Size of the buffer which combines small writes to files
+ */
+#define PDF_WRITE_BUFFER_LEN 65536
+
+/** Size of the stack buffer used by Print before
+ *  falling back to a heap allocated buffer
+ */
+#define PDF_PRINT_BUFFER_LEN 256
 
 namespace PoDoFo {
 
@@ -60,10 +68,15 @@ PdfOutputDevice::PdfOutputDevice( const char* pszFilename, bool bTruncate )
     if( bTruncate )
         openmode |= std::ios_base::trunc;
 
+    // Allocate the buffer before opening the file, so that the file
+    // is not leaked if this fails
+    this->InitWriteBuffer();
+
     std::fstream *pStream = new std::fstream( pszFilename, openmode );
     if( pStream->fail() )
     {
         delete pStream;
+        podofo_free( m_pWriteBuffer );
         PODOFO_RAISE_ERROR_INFO( ePdfError_FileNotFound, pszFilename );
     }
 
@@ -90,9 +103,15 @@ PdfOutputDevice::PdfOutputDevice( const wchar_t* pszFilename, bool bTruncate )
         PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
     }
 
+    // Allocate the buffer before opening the file, so that the file
+    // is not leaked if this fails
+    this->InitWriteBuffer();
+
     m_hFile = _wfopen( pszFilename, bTruncate ? L"w+b" : L"r+b" );
     if( !m_hFile )
     {
+        podofo_free( m_pWriteBuffer );
+
         PdfError e( ePdfError_FileNotFound, __FILE__, __LINE__ );
         e.SetErrorInformation( pszFilename );
         throw e;
@@ -102,6 +121,8 @@ PdfOutputDevice::PdfOutputDevice( const wchar_t* pszFilename, bool bTruncate )
     {
         if( fseeko( m_hFile, 0, SEEK_END ) == -1 )
         {
+            fclose( m_hFile );
+            podofo_free( m_pWriteBuffer );
             PODOFO_RAISE_ERROR_INFO( ePdfError_ValueOutOfRange, "Failed to seek to the end of the file" );
         }
 
@@ -160,6 +181,18 @@ PdfOutputDevice::PdfOutputDevice( std::iostream* pStream )
 
 PdfOutputDevice::~PdfOutputDevice()
 {
+    if( m_pWriteBuffer )
+    {
+        // Like the destructor of std::fstream, ignore errors 
+        // when writing the remaining data
+        try {
+            this->FlushWriteBuffer();
+        } catch( const PdfError & ) {
+        }
+
+        podofo_free( m_pWriteBuffer );
+    }
+
     if( m_pStreamOwned ) 
         // remember, deleting a null pointer is safe
         delete m_pStream; // will call close
@@ -185,58 +218,99 @@ void PdfOutputDevice::Init()
     m_lBufferLen        = 0;
     m_ulPosition        = 0;
     m_pStreamOwned      = true;
+    m_pWriteBuffer      = NULL;
+    m_lWriteBufferUsed  = 0;
 }
 
-void PdfOutputDevice::Print( const char* pszFormat, ... )
+void PdfOutputDevice::InitWriteBuffer()
 {
-    va_list args;
-    long lBytes;
+    m_pWriteBuffer = static_cast<char*>(podofo_malloc( PDF_WRITE_BUFFER_LEN ));
+    if( !m_pWriteBuffer )
+    {
+        PODOFO_RAISE_ERROR( ePdfError_OutOfMemory );
+    }
+}
 
-	va_start( args, pszFormat );
-	lBytes = PrintVLen(pszFormat, args);
-	va_end( args );
+void PdfOutputDevice::FlushWriteBuffer()
+{
+    if( m_lWriteBufferUsed )
+    {
+        // Reset first, so that a failed write is not repeated
+        size_t lLen = m_lWriteBufferUsed;
+        m_lWriteBufferUsed = 0;
 
-	va_start( args, pszFormat );
-	PrintV(pszFormat, lBytes, args);
-	va_end( args );
+        this->WriteDirect( m_pWriteBuffer, lLen );
+    }
 }
 
-long PdfOutputDevice::PrintVLen( const char* pszFormat, va_list args )
+void PdfOutputDevice::Print( const char* pszFormat, ... )
 {
+    va_list args;
     long    lBytes;
+    char    buffer[PDF_PRINT_BUFFER_LEN];
 
     if( !pszFormat )
     {
         PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
     }
 
-    if( m_hFile )
+    if( !strchr( pszFormat, '%' ) )
     {
-        if( (lBytes = vfprintf( m_hFile, pszFormat, args )) < 0 )
-        {
-            perror( NULL );
-            PODOFO_RAISE_ERROR( ePdfError_UnexpectedEOF );
-        }
+        this->Write( pszFormat, strlen( pszFormat ) );
+        return;
     }
-    else
+
+    // Format into a buffer on the stack first, most 
+    // strings written to a PDF file are short
+    va_start( args, pszFormat );
+    lBytes = vsnprintf( buffer, PDF_PRINT_BUFFER_LEN, pszFormat, args );
+    va_end( args );
+
+    if( lBytes >= 0 && lBytes < PDF_PRINT_BUFFER_LEN )
+    {
+        this->Write( buffer, static_cast<size_t>(lBytes) );
+        return;
+    }
+
+    va_start( args, pszFormat );
+    lBytes = PrintVLen( pszFormat, args );
+    va_end( args );
+
+    va_start( args, pszFormat );
+    PrintV( pszFormat, lBytes, args );
+    va_end( args );
+}
+
+long PdfOutputDevice::PrintVLen( const char* pszFormat, va_list args )
+{
+    long    lBytes;
+
+    if( !pszFormat )
     {
-        // OC 17.08.2010: Use new function _vscprintf to get the number of characters:
-        // visual c++  8.0 == 1400 (Visual Studio 2005)
-        // i am not shure if 1300 is ok here, but who cares this cruel compiler version
+        PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
+    }
+
+    // OC 17.08.2010: Use new function _vscprintf to get the number of characters:
+    // visual c++  8.0 == 1400 (Visual Studio 2005)
+    // i am not shure if 1300 is ok here, but who cares this cruel compiler version
 #if (defined _MSC_VER && _MSC_VER >= 1400 )
-        lBytes = _vscprintf( pszFormat, args );
+    lBytes = _vscprintf( pszFormat, args );
 #elif (defined _MSC_VER || defined __hpux)  // vsnprintf without buffer does not work with MS-VC or HPUX
-        int len = 1024;
-        do
-        {
-            char * temp = new char[len+1]; // OC 17.08.2010 BugFix: +1 avoids corrupted heap
-            lBytes = vsnprintf( temp, len+1, pszFormat, args );
-            delete[] temp;
-            len *= 2;
-        } while (lBytes < 0 );
+    int len = 1024;
+    do
+    {
+        char * temp = new char[len+1]; // OC 17.08.2010 BugFix: +1 avoids corrupted heap
+        lBytes = vsnprintf( temp, len+1, pszFormat, args );
+        delete[] temp;
+        len *= 2;
+    } while (lBytes < 0 );
 #else
-        lBytes = vsnprintf( NULL, 0, pszFormat, args );
+    lBytes = vsnprintf( NULL, 0, pszFormat, args );
 #endif
+
+    if( lBytes < 0 )
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InvalidDeviceOperation );
     }
 
     return lBytes;
@@ -249,59 +323,104 @@ void PdfOutputDevice::PrintV( const char* pszFormat, long lBytes, va_list args )
         PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
     }
 
-    if( m_pBuffer )
+    m_printBuffer.Resize( lBytes + 1 );
+    char* data = m_printBuffer.GetBuffer();
+    if( !data )
     {
-        if( m_ulPosition + lBytes <= m_lBufferLen )
-        {
-            vsnprintf( m_pBuffer + m_ulPosition, m_lBufferLen - m_ulPosition, pszFormat, args );
-        }
-        else
-        {
-            PODOFO_RAISE_ERROR( ePdfError_OutOfMemory );
-        }
+        PODOFO_RAISE_ERROR( ePdfError_OutOfMemory );
     }
-    else if( m_pStream || m_pRefCountedBuffer )
+
+    vsnprintf( data, lBytes + 1, pszFormat, args );
+    this->Write( data, static_cast<size_t>(lBytes) );
+}
+
+void PdfOutputDevice::WriteInt( pdf_int64 nValue )
+{
+    if( nValue < 0 ) 
     {
-        ++lBytes;
-        m_printBuffer.Resize( lBytes );
-        char* data = m_printBuffer.GetBuffer();
-        if( !data )
-        {
-            PODOFO_RAISE_ERROR( ePdfError_OutOfMemory );
-        }
+        char minus = '-';
+        this->Write( &minus, 1 );
+        // Negate in unsigned arithmetic, which works for the smallest value, too
+        this->WriteUInt( static_cast<pdf_uint64>(0) - static_cast<pdf_uint64>(nValue) );
+    }
+    else
+        this->WriteUInt( static_cast<pdf_uint64>(nValue) );
+}
 
-        vsnprintf( data, lBytes, pszFormat, args );
-        if( lBytes )
-            --lBytes;
+void PdfOutputDevice::WriteUInt( pdf_uint64 nValue, int nMinDigits )
+{
+    char buffer[32];
+    int  nPos = sizeof(buffer);
 
-        if( m_pStream ) 
-        {
-            std::string str;
-            str.assign( data, lBytes );
-            *m_pStream << str;
-        }
-        else // if( m_pRefCountedBuffer ) 
-        {
-            if( m_ulPosition + lBytes > static_cast<unsigned long>(m_pRefCountedBuffer->GetSize()) )
-            {
-                m_pRefCountedBuffer->Resize( m_ulPosition + lBytes );
-            }
+    nMinDigits = PODOFO_MIN( nMinDigits, static_cast<int>(sizeof(buffer)) );
+    do {
+        buffer[--nPos] = static_cast<char>('0' + nValue % 10);
+        nValue /= 10;
+    } while( nValue );
 
-            memcpy( m_pRefCountedBuffer->GetBuffer() + m_ulPosition, data, lBytes );
-        }
+    while( static_cast<int>(sizeof(buffer)) - nPos < nMinDigits )
+        buffer[--nPos] = '0';
+
+    this->Write( buffer + nPos, sizeof(buffer) - nPos );
+}
 
+void PdfOutputDevice::WriteReal( double dValue, bool bCompact, int nPrecision )
+{
+    char   buffer[PDF_REAL_BUFFER_LEN];
+    size_t lLen = PdfLocaleFormatReal( dValue, buffer, PDF_REAL_BUFFER_LEN, bCompact, nPrecision );
+    if( !lLen ) 
+    {
+        buffer[0] = '0';
+        lLen      = 1;
     }
 
-    m_ulPosition += static_cast<size_t>(lBytes);
-    if(m_ulPosition>m_ulLength) 
+    this->Write( buffer, lLen );
+}
+
+void PdfOutputDevice::WriteName( const char* pszName, size_t lLen )
+{
+    char buffer[PDF_PRINT_BUFFER_LEN];
+
+    if( lLen < PDF_PRINT_BUFFER_LEN )
     {
-        m_ulLength = m_ulPosition;
+        buffer[0] = '/';
+        memcpy( buffer + 1, pszName, lLen );
+        this->Write( buffer, lLen + 1 );
     }
+    else
+    {
+        this->Write( "/", 1 );
+        this->Write( pszName, lLen );
+    }
+}
+
+void PdfOutputDevice::WriteReference( pdf_objnum nObjectNo, pdf_gennum nGenerationNo )
+{
+    char buffer[32];
+    int  nPos = sizeof(buffer);
+
+    // Written from right to left
+    buffer[--nPos] = 'R';
+    buffer[--nPos] = ' ';
+    do {
+        buffer[--nPos] = static_cast<char>('0' + nGenerationNo % 10);
+        nGenerationNo /= 10;
+    } while( nGenerationNo );
+
+    buffer[--nPos] = ' ';
+    do {
+        buffer[--nPos] = static_cast<char>('0' + nObjectNo % 10);
+        nObjectNo /= 10;
+    } while( nObjectNo );
+
+    this->Write( buffer + nPos, sizeof(buffer) - nPos );
 }
 
 size_t PdfOutputDevice::Read( char* pBuffer, size_t lLen )
 {
 	size_t numRead = 0;
+
+    this->FlushWriteBuffer();
     if( m_hFile )
     {
 		numRead = fread( pBuffer, sizeof(char), lLen, m_hFile );
@@ -342,6 +461,29 @@ size_t PdfOutputDevice::Read( char* pBuffer, size_t lLen )
 }
 
 void PdfOutputDevice::Write( const char* pBuffer, size_t lLen )
+{
+    if( m_pWriteBuffer )
+    {
+        // Combine small writes to the file into larger blocks
+        if( m_lWriteBufferUsed + lLen > PDF_WRITE_BUFFER_LEN )
+            this->FlushWriteBuffer();
+
+        if( lLen < PDF_WRITE_BUFFER_LEN )
+        {
+            memcpy( m_pWriteBuffer + m_lWriteBufferUsed, pBuffer, lLen );
+            m_lWriteBufferUsed += lLen;
+        }
+        else
+            this->WriteDirect( pBuffer, lLen );
+    }
+    else
+        this->WriteDirect( pBuffer, lLen );
+
+    m_ulPosition += static_cast<size_t>(lLen);
+	if(m_ulPosition>m_ulLength) m_ulLength = m_ulPosition;
+}
+
+void PdfOutputDevice::WriteDirect( const char* pBuffer, size_t lLen )
 {
     if( m_hFile )
     {
@@ -372,13 +514,12 @@ void PdfOutputDevice::Write( const char* pBuffer, size_t lLen )
 
         memcpy( m_pRefCountedBuffer->GetBuffer() + m_ulPosition, pBuffer, lLen );
     }
-
-    m_ulPosition += static_cast<size_t>(lLen);
-	if(m_ulPosition>m_ulLength) m_ulLength = m_ulPosition;
 }
 
 void PdfOutputDevice::Seek( size_t offset )
 {
+    this->FlushWriteBuffer();
+
     if( m_hFile )
     {
         if( fseeko( m_hFile, offset, SEEK_SET ) == -1 )
@@ -409,6 +550,8 @@ void PdfOutputDevice::Seek( size_t offset )
 
 void PdfOutputDevice::Flush()
 {
+    this->FlushWriteBuffer();
+
     if( m_hFile )
     {
         if( fflush( m_hFile ) )
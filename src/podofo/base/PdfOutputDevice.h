@@ -40,6 +40,7 @@
 
 #include "PdfDefines.h"
 #include "PdfLocale.h"
+#include "PdfReference.h"
 #include "PdfRefCountedBuffer.h"
 
 namespace PoDoFo {
@@ -142,11 +143,22 @@ class PODOFO_API PdfOutputDevice {
      */
     virtual inline size_t GetLength() const;
 
+    /** 
+     *  \returns true if this device does not write any data and only counts 
+     *           its length, i.e. it was created using the default constructor
+     */
+    inline bool IsLengthOnly() const;
+
     /** Write to the PdfOutputDevice. Usage is as the usage of printf.
      * 
      *  WARNING: Do not use this for doubles or floating point values
      *           as the output might depend on the current locale.
      *
+     *  The string is formatted only once. Format strings without
+     *  any conversion specification are written directly.
+     *  Prefer the typed methods like WriteInt or WriteReal
+     *  for frequently written tokens.
+     *
      *  \param pszFormat a format string as you would use it with printf
      *
      *  \see Write
@@ -188,6 +200,51 @@ class PODOFO_API PdfOutputDevice {
      */
     virtual void Write( const char* pBuffer, size_t lLen );
 
+    /** Write a signed integer in decimal notation.
+     *
+     *  \param nValue the integer to write
+     *
+     *  \see Write
+     */
+    void WriteInt( pdf_int64 nValue );
+
+    /** Write an unsigned integer in decimal notation.
+     *
+     *  \param nValue the integer to write
+     *  \param nMinDigits the number is padded with leading
+     *                    zeros to at least this many digits
+     *
+     *  \see Write
+     */
+    void WriteUInt( pdf_uint64 nValue, int nMinDigits = 0 );
+
+    /** Write a real number independent of the current locale.
+     *
+     *  \param dValue the number to write
+     *  \param bCompact remove trailing zeros and a trailing decimal point
+     *  \param nPrecision number of fractional digits
+     *
+     *  \see PdfLocaleFormatReal
+     */
+    void WriteReal( double dValue, bool bCompact = false, int nPrecision = 6 );
+
+    /** Write a PDF name, i.e. a slash followed by the name.
+     *
+     *  \param pszName the name, already escaped according to
+     *                 the PDF name escaping rules
+     *  \param lLen length of pszName
+     *
+     *  \see PdfName::GetEscapedName
+     */
+    void WriteName( const char* pszName, size_t lLen );
+
+    /** Write an indirect reference as "objectno generation R".
+     *
+     *  \param nObjectNo the object number
+     *  \param nGenerationNo the generation number
+     */
+    void WriteReference( pdf_objnum nObjectNo, pdf_gennum nGenerationNo );
+
     /** Read data from the device
      *  \param pBuffer a pointer to the data buffer
      *  \param lLen length of the output buffer
@@ -215,6 +272,21 @@ class PODOFO_API PdfOutputDevice {
      */
     void Init();
 
+    /** Allocate the buffer which combines small writes
+     *  to a file into larger blocks.
+     */
+    void InitWriteBuffer();
+
+    /** Write all data pending in the write buffer 
+     *  to the file.
+     */
+    void FlushWriteBuffer();
+
+    /** Write data directly to the underlying file, stream or buffer
+     *  without changing the current position.
+     */
+    void WriteDirect( const char* pBuffer, size_t lLen );
+
  protected:
     size_t        m_ulLength;
 
@@ -237,6 +309,9 @@ class PODOFO_API PdfOutputDevice {
     size_t               m_ulPosition;
 
     PdfRefCountedBuffer  m_printBuffer;
+
+    char*                m_pWriteBuffer;
+    size_t               m_lWriteBufferUsed;
 };
 
 // -----------------------------------------------------
@@ -247,6 +322,14 @@ size_t PdfOutputDevice::GetLength() const
     return m_ulLength;
 }
 
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+bool PdfOutputDevice::IsLengthOnly() const
+{
+    return !m_hFile && !m_pBuffer && !m_pStream && !m_pRefCountedBuffer;
+}
+
 // -----------------------------------------------------
 // 
 // -----------------------------------------------------
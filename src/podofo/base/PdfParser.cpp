@@ -45,6 +45,8 @@
 #include "PdfStream.h"
 #include "PdfVariant.h"
 #include "PdfXRefStreamParserObject.h"
+#include "util/PdfMutexWrapper.h"
+#include "util/PdfThread.h"
 
 #include <cstring>
 #include <cstdlib>
@@ -60,6 +62,7 @@ using std::flush;
 #define PDF_MAGIC_LEN       8
 #define PDF_XREF_ENTRY_SIZE 20
 #define PDF_XREF_BUF        512
+#define PDF_PARSE_CHUNK     64
 
 #if defined( PTRDIFF_MAX )
 #define PDF_LONG_MAX PTRDIFF_MAX
@@ -75,16 +78,194 @@ namespace PoDoFo {
 bool PdfParser::s_bIgnoreBrokenObjects = true;
 const long nMaxNumIndirectObjects = (1L << 23) - 1L;
 long PdfParser::s_nMaxObjects = nMaxNumIndirectObjects;
+int  PdfParser::s_nThreadCount = 1;
+
+/** State shared by all worker threads of PdfParser::ReadObjectsParallel
+ */
+struct TParseObjectsJob {
+    const PdfParser::TVecOffsets* pOffsets;
+    PdfVecObjects*                pVecObjects;
+    PdfArena*                     pArena;
+    const char*                   pBuffer;
+    size_t                        lBufferLen;
+    size_t                        lTokenBufferLen;
+    long                          nNumObjects;
+
+    Util::PdfMutex                mutex;
+    long                          nNextObject; ///< guarded by mutex
+
+    PdfParserObject**             ppObjects;
+    PdfError**                    ppErrors;
+};
+
+/** Deletes objects and errors, which were parsed 
+ *  concurrently but not consumed by ReadObjectsInternal
+ *  because of an exception.
+ */
+class PdfParsedObjectsGuard {
+  public:
+    ~PdfParsedObjectsGuard()
+    {
+        for( size_t i = 0; i < vecObjects.size(); i++ )
+            delete vecObjects[i];
+
+        for( size_t i = 0; i < vecErrors.size(); i++ )
+            delete vecErrors[i];
+    }
+
+    std::vector<PdfParserObject*> vecObjects;
+    std::vector<PdfError*>        vecErrors;
+};
+
+/** State shared by all worker threads of PdfParser::ReadObjectStreamsParallel
+ */
+struct TDecodeObjectStreamsJob {
+    ~TDecodeObjectStreamsJob()
+    {
+        for( size_t i = 0; i < vecDecoded.size(); i++ )
+            delete vecDecoded[i];
+
+        for( size_t i = 0; i < vecErrors.size(); i++ )
+            delete vecErrors[i];
+    }
+
+    PdfVecObjects*                                              pVecObjects;
+    PdfArena*                                                   pArena;
+    size_t                                                      lTokenBufferLen;
+    std::vector<PdfParserObject*>                               vecStreams;
+    std::vector<const PdfObjectStreamParserObject::ObjectIdList*> vecLists;
+
+    Util::PdfMutex                                              mutex;
+    size_t                                                      nNextStream; ///< guarded by mutex
+
+    std::vector<PdfObjectStreamParserObject*>                   vecDecoded;
+    std::vector<PdfError*>                                      vecErrors;
+};
+
+/** Entry point of the worker threads of PdfParser::ReadObjectStreamsParallel.
+ *
+ *  The worker decodes one object stream after another until all 
+ *  streams are decoded. Streams, which could not be decoded for
+ *  any other reason than a PdfError, are left NULL so that they are 
+ *  parsed again by the calling thread.
+ */
+static void DecodeObjectStreamsWorker( void* pData )
+{
+    TDecodeObjectStreamsJob* pJob = static_cast<TDecodeObjectStreamsJob*>(pData);
+
+    try {
+        PdfArenaScope       scope( pJob->pArena );
+        PdfRefCountedBuffer buffer( pJob->lTokenBufferLen );
+
+        for( ;; )
+        {
+            size_t nStream;
+            {
+                Util::PdfMutexWrapper wrapper( pJob->mutex );
+                nStream = pJob->nNextStream++;
+            }
+
+            if( nStream >= pJob->vecStreams.size() )
+                break;
+
+            PdfObjectStreamParserObject* pDecoded = NULL;
+            try {
+                pDecoded = new PdfObjectStreamParserObject( pJob->vecStreams[nStream], pJob->pVecObjects, buffer );
+                pDecoded->Decode( *pJob->vecLists[nStream] );
+            } catch( PdfError & rError ) {
+                delete pDecoded;
+                pDecoded = NULL;
+
+                try {
+                    pJob->vecErrors[nStream] = new PdfError( rError );
+                } catch( ... ) {
+                }
+            } catch( ... ) {
+                delete pDecoded;
+                pDecoded = NULL;
+            }
+
+            pJob->vecDecoded[nStream] = pDecoded;
+        }
+    } catch( ... ) {
+        // Streams not decoded by this worker are parsed by the calling thread
+    }
+}
+
+/** Entry point of the worker threads of PdfParser::ReadObjectsParallel.
+ *  
+ *  The worker parses chunks of objects until all objects are parsed.
+ *  Objects that could not be parsed because of a PdfError are stored 
+ *  together with the error. Objects, which could not be parsed for 
+ *  any other reason, are left NULL so that they are parsed again
+ *  by the calling thread.
+ */
+static void ParseObjectsWorker( void* pData )
+{
+    TParseObjectsJob* pJob = static_cast<TParseObjectsJob*>(pData);
+
+    try {
+        PdfArenaScope            scope( pJob->pArena );
+
+        // Each worker has its own cursor on the data of the parser's device
+        PdfRefCountedInputDevice device( pJob->pBuffer, pJob->lBufferLen, ePdfInputMode_ZeroCopy );
+        PdfRefCountedBuffer      buffer( pJob->lTokenBufferLen );
+
+        for( ;; )
+        {
+            long nFirst;
+            {
+                Util::PdfMutexWrapper wrapper( pJob->mutex );
+                nFirst             = pJob->nNextObject;
+                pJob->nNextObject += PDF_PARSE_CHUNK;
+            }
+
+            if( nFirst >= pJob->nNumObjects )
+                break;
+
+            long nLast = PODOFO_MIN( nFirst + PDF_PARSE_CHUNK, pJob->nNumObjects );
+            for( long i = nFirst; i < nLast; i++ )
+            {
+                const PdfParser::TXRefEntry & rEntry = (*pJob->pOffsets)[i];
+                if( !(rEntry.bParsed && rEntry.cUsed == 'n' && rEntry.lOffset > 0) )
+                    continue;
+
+                PdfParserObject* pObject = NULL;
+                try {
+                    pObject = new PdfParserObject( pJob->pVecObjects, device, buffer, rEntry.lOffset );
+                    pObject->SetLoadOnDemand( false );
+                    pObject->ParseFile( NULL );
+                } catch( PdfError & rError ) {
+                    try {
+                        pJob->ppErrors[i] = new PdfError( rError );
+                    } catch( ... ) {
+                        delete pObject;
+                        pObject = NULL;
+                    }
+                } catch( ... ) {
+                    delete pObject;
+                    pObject = NULL;
+                }
+
+                pJob->ppObjects[i] = pObject;
+            }
+        }
+    } catch( ... ) {
+        // Objects not parsed by this worker are parsed by the calling thread
+    }
+}
 
 PdfParser::PdfParser( PdfVecObjects* pVecObjects )
-    : PdfTokenizer(), m_vecObjects( pVecObjects ), m_bStrictParsing( false )
+    : PdfTokenizer(), m_vecObjects( pVecObjects ), m_bStrictParsing( false ),
+      m_pArena( NULL )
 
 {
     this->Init();
 }
 
 PdfParser::PdfParser( PdfVecObjects* pVecObjects, const char* pszFilename, bool bLoadOnDemand )
-    : PdfTokenizer(), m_vecObjects( pVecObjects ), m_bStrictParsing( false )
+    : PdfTokenizer(), m_vecObjects( pVecObjects ), m_bStrictParsing( false ),
+      m_pArena( NULL )
 {
     this->Init();
     this->ParseFile( pszFilename, bLoadOnDemand );
@@ -94,7 +275,8 @@ PdfParser::PdfParser( PdfVecObjects* pVecObjects, const char* pszFilename, bool
 #if defined(_MSC_VER)  &&  _MSC_VER <= 1200    // not for MS Visual Studio 6
 #else
 PdfParser::PdfParser( PdfVecObjects* pVecObjects, const wchar_t* pszFilename, bool bLoadOnDemand )
-    : PdfTokenizer(), m_vecObjects( pVecObjects ), m_bStrictParsing( false )
+    : PdfTokenizer(), m_vecObjects( pVecObjects ), m_bStrictParsing( false ),
+      m_pArena( NULL )
 {
     this->Init();
     this->ParseFile( pszFilename, bLoadOnDemand );
@@ -103,7 +285,8 @@ PdfParser::PdfParser( PdfVecObjects* pVecObjects, const wchar_t* pszFilename, bo
 #endif // _WIN32
 
 PdfParser::PdfParser( PdfVecObjects* pVecObjects, const char* pBuffer, long lLen, bool bLoadOnDemand )
-    : PdfTokenizer(), m_vecObjects( pVecObjects ), m_bStrictParsing( false )
+    : PdfTokenizer(), m_vecObjects( pVecObjects ), m_bStrictParsing( false ),
+      m_pArena( NULL )
 {
     this->Init();
     this->ParseFile( pBuffer, lLen, bLoadOnDemand );
@@ -111,7 +294,8 @@ PdfParser::PdfParser( PdfVecObjects* pVecObjects, const char* pBuffer, long lLen
 
 PdfParser::PdfParser( PdfVecObjects* pVecObjects, const PdfRefCountedInputDevice & rDevice, 
                       bool bLoadOnDemand )
-    : PdfTokenizer(), m_vecObjects( pVecObjects ), m_bStrictParsing( false )
+    : PdfTokenizer(), m_vecObjects( pVecObjects ), m_bStrictParsing( false ),
+      m_pArena( NULL )
 {
     this->Init();
 
@@ -150,14 +334,14 @@ void PdfParser::Init()
     m_nIncrementalUpdates = 0;
 }
 
-void PdfParser::ParseFile( const char* pszFilename, bool bLoadOnDemand )
+void PdfParser::ParseFile( const char* pszFilename, bool bLoadOnDemand, EPdfInputMode eMode )
 {
     if( !pszFilename || !pszFilename[0] )
     {
         PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
     }
 
-    PdfRefCountedInputDevice device( pszFilename, "rb" );
+    PdfRefCountedInputDevice device( pszFilename, "rb", eMode );
     if( !device.Device() )
     {
         PODOFO_RAISE_ERROR_INFO( ePdfError_FileNotFound, pszFilename );
@@ -186,14 +370,14 @@ void PdfParser::ParseFile( const wchar_t* pszFilename, bool bLoadOnDemand )
 }
 #endif // _WIN32
 
-void PdfParser::ParseFile( const char* pBuffer, long lLen, bool bLoadOnDemand )
+void PdfParser::ParseFile( const char* pBuffer, long lLen, bool bLoadOnDemand, EPdfInputMode eMode )
 {
     if( !pBuffer || !lLen )
     {
         PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
     }
 
-    PdfRefCountedInputDevice device( pBuffer, lLen );
+    PdfRefCountedInputDevice device( pBuffer, lLen, eMode );
     if( !device.Device() )
     {
         PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidHandle, "Cannot create PdfParser from buffer." );
@@ -211,6 +395,8 @@ void PdfParser::ParseFile( const PdfRefCountedInputDevice & rDevice, bool bLoadO
     m_bLoadOnDemand = bLoadOnDemand;
 
     try {
+        PdfArenaScope scope( m_pArena );
+
         if( !IsPdfFile() )
         {
             PODOFO_RAISE_ERROR( ePdfError_NoPdfFile );
@@ -1075,12 +1261,65 @@ void PdfParser::ReadObjects()
     ReadObjectsInternal();
 }
 
+void PdfParser::ReadObjectsParallel( int nThreads, std::vector<PdfParserObject*> & rvecObjects, 
+                                     std::vector<PdfError*> & rvecErrors )
+{
+    rvecObjects.resize( m_nNumObjects, NULL );
+    rvecErrors.resize( m_nNumObjects, NULL );
+
+    TParseObjectsJob job;
+    job.pOffsets        = &m_offsets;
+    job.pVecObjects     = m_vecObjects;
+    job.pArena          = m_pArena;
+    job.pBuffer         = m_device.Device()->GetBuffer();
+    job.lBufferLen      = m_device.Device()->GetBufferLength();
+    job.lTokenBufferLen = m_buffer.GetSize();
+    job.nNumObjects     = m_nNumObjects;
+    job.nNextObject     = 0;
+    job.ppObjects       = &rvecObjects[0];
+    job.ppErrors        = &rvecErrors[0];
+
+    // Never start more threads than there are chunks to parse
+    nThreads = static_cast<int>(PODOFO_MIN( static_cast<long>(nThreads), 
+                                            (m_nNumObjects + PDF_PARSE_CHUNK - 1) / PDF_PARSE_CHUNK ));
+
+    // The calling thread parses, too.
+    std::vector<Util::PdfThread*> vecThreads;
+    try {
+        for( int i = 1; i < nThreads; i++ )
+        {
+            Util::PdfThread* pThread = new Util::PdfThread();
+            vecThreads.push_back( pThread );
+            pThread->Start( &ParseObjectsWorker, &job );
+        }
+    } catch( ... ) {
+        // Continue with the threads that could be started
+    }
+
+    ParseObjectsWorker( &job );
+
+    // Deleting a thread waits for it to finish
+    for( size_t i = 0; i < vecThreads.size(); i++ )
+        delete vecThreads[i];
+}
+
 void PdfParser::ReadObjectsInternal() 
 {
     int              i            = 0;
     int              nLast        = 0;
     PdfParserObject* pObject      = NULL;
 
+    PdfParsedObjectsGuard parsed;
+    int nThreads = s_nThreadCount > 0 ? s_nThreadCount : Util::PdfThread::GetProcessorCount();
+
+    // Objects can only be parsed concurrently if each thread can read 
+    // the data in place and no shared encryption state is required
+    if( nThreads > 1 && m_nNumObjects > PDF_PARSE_CHUNK && 
+        !m_bLoadOnDemand && !m_pEncrypt && m_device.Device()->GetBuffer() )
+    {
+        ReadObjectsParallel( nThreads, parsed.vecObjects, parsed.vecErrors );
+    }
+
     // Read objects
     for( i=0; i < m_nNumObjects; i++ )
     {
@@ -1095,13 +1334,39 @@ void PdfParser::ReadObjectsInternal()
         {
             //printf("Reading object %i 0 R from %li\n", i, m_offsets[i].lOffset );
             
-            pObject = new PdfParserObject( m_vecObjects, m_device, m_buffer, m_offsets[i].lOffset );
-            if( !pObject )
-                PODOFO_RAISE_ERROR( ePdfError_OutOfMemory );
+            PdfError* pError  = NULL;
+            bool      bParsed = false;
+            if( parsed.vecObjects.size() && parsed.vecObjects[i] )
+            {
+                // Already parsed by ReadObjectsParallel
+                bParsed = true;
+                pObject = parsed.vecObjects[i];
+                pError  = parsed.vecErrors[i];
+                parsed.vecObjects[i] = NULL;
+                parsed.vecErrors[i]  = NULL;
+
+                pObject->SetDevice( m_device );
+            }
+            else
+            {
+                pObject = new PdfParserObject( m_vecObjects, m_device, m_buffer, m_offsets[i].lOffset );
+                if( !pObject )
+                    PODOFO_RAISE_ERROR( ePdfError_OutOfMemory );
+
+                pObject->SetLoadOnDemand( m_bLoadOnDemand );
+            }
 
-            pObject->SetLoadOnDemand( m_bLoadOnDemand );
             try {
-				pObject->ParseFile( m_pEncrypt );
+                if( pError )
+                {
+                    // Report the error of the worker thread like an error of ParseFile
+                    PdfError error( *pError );
+                    delete pError;
+                    throw error;
+                }
+                else if( !bParsed )
+                    pObject->ParseFile( m_pEncrypt );
+
 				if (m_pEncrypt && pObject->IsDictionary()) {
 					PdfObject* pObjType = pObject->GetDictionary().GetKey( PdfName::KeyType );
 					if( pObjType && pObjType->IsName() && pObjType->GetName() == "XRef" ) {
@@ -1195,16 +1460,28 @@ void PdfParser::ReadObjectsInternal()
     // Note that even if demand loading is enabled we still currently read all
     // objects from the stream into memory then free the stream.
     //
+    // Index the objects of all object streams with a single pass over m_offsets
+    TMapObjectStreams mapObjectStreams;
     for( i = 0; i < m_nNumObjects; i++ )
     {
         if( m_offsets[i].bParsed && m_offsets[i].cUsed == 's' ) // we have an object stream
-        {
+            mapObjectStreams[static_cast<int>(m_offsets[i].lGeneration)].push_back( static_cast<pdf_int64>(i) );
+    }
+
 #if defined(PODOFO_VERBOSE_DEBUG)
-            if (m_bLoadOnDemand) cerr << "Demand loading on, but can't demand-load from object stream." << endl;
+    if (m_bLoadOnDemand && mapObjectStreams.size()) cerr << "Demand loading on, but can't demand-load from object stream." << endl;
 #endif
-            ReadObjectFromStream( static_cast<int>(m_offsets[i].lGeneration), 
-                                  static_cast<int>(m_offsets[i].lOffset) );
-        }
+
+    // Streams are only decoded concurrently if all other objects
+    // are loaded already, as the worker threads must not load objects
+    if( nThreads > 1 && mapObjectStreams.size() > 1 && !m_bLoadOnDemand )
+    {
+        ReadObjectStreamsParallel( nThreads, mapObjectStreams );
+    }
+    else
+    {
+        for( TCIMapObjectStreams it = mapObjectStreams.begin(); it != mapObjectStreams.end(); ++it )
+            ReadObjectFromStream( it->first, it->second );
     }
 
     if( !m_bLoadOnDemand )
@@ -1248,10 +1525,11 @@ void PdfParser::SetPassword( const std::string & sPassword )
         PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidPassword, "Authentication with user specified password failed.");
     }
     
+    PdfArenaScope scope( m_pArena );
     ReadObjectsInternal();
 }
 
-void PdfParser::ReadObjectFromStream( int nObjNo, int )
+void PdfParser::ReadObjectFromStream( int nObjNo, const PdfObjectStreamParserObject::ObjectIdList & list )
 {
     // check if we already have read all objects
     // from this stream
@@ -1262,6 +1540,88 @@ void PdfParser::ReadObjectFromStream( int nObjNo, int )
     else
         m_setObjectStreams.insert( nObjNo );
 
+    PdfParserObject* pStream = GetObjectStream( nObjNo );
+    if( !pStream )
+        return;
+
+    PdfObjectStreamParserObject pParserObject( pStream, m_vecObjects, m_buffer );
+    pParserObject.Parse( list );
+}
+
+void PdfParser::ReadObjectStreamsParallel( int nThreads, const TMapObjectStreams & rmapObjectStreams )
+{
+    TDecodeObjectStreamsJob job;
+    job.pVecObjects     = m_vecObjects;
+    job.pArena          = m_pArena;
+    job.lTokenBufferLen = m_buffer.GetSize();
+    job.nNextStream     = 0;
+
+    // Load the encoded data of all object streams first, as this reads from
+    // the device and may resolve indirect /Length or /Filter keys
+    for( TCIMapObjectStreams it = rmapObjectStreams.begin(); it != rmapObjectStreams.end(); ++it )
+    {
+        if( m_setObjectStreams.find( it->first ) != m_setObjectStreams.end() )
+            continue;
+        else
+            m_setObjectStreams.insert( it->first );
+
+        PdfParserObject* pStream = GetObjectStream( it->first );
+        if( !pStream )
+            continue;
+
+        pStream->GetStream();
+        job.vecStreams.push_back( pStream );
+        job.vecLists.push_back( &(it->second) );
+    }
+
+    job.vecDecoded.resize( job.vecStreams.size(), NULL );
+    job.vecErrors.resize( job.vecStreams.size(), NULL );
+
+    // Never start more threads than there are streams
+    nThreads = static_cast<int>(PODOFO_MIN( static_cast<size_t>(nThreads), job.vecStreams.size() ));
+
+    // The calling thread decodes, too.
+    std::vector<Util::PdfThread*> vecThreads;
+    try {
+        for( int i = 1; i < nThreads; i++ )
+        {
+            Util::PdfThread* pThread = new Util::PdfThread();
+            vecThreads.push_back( pThread );
+            pThread->Start( &DecodeObjectStreamsWorker, &job );
+        }
+    } catch( ... ) {
+        // Continue with the threads that could be started
+    }
+
+    DecodeObjectStreamsWorker( &job );
+
+    // Deleting a thread waits for it to finish
+    for( size_t i = 0; i < vecThreads.size(); i++ )
+        delete vecThreads[i];
+
+    // Add the objects in the order of the streams
+    for( size_t i = 0; i < job.vecStreams.size(); i++ )
+    {
+        if( job.vecErrors[i] )
+        {
+            PdfError error( *job.vecErrors[i] );
+            throw error;
+        }
+        else if( job.vecDecoded[i] )
+        {
+            job.vecDecoded[i]->AddObjects();
+        }
+        else
+        {
+            // The worker failed for other reasons than a PdfError
+            PdfObjectStreamParserObject parserObject( job.vecStreams[i], m_vecObjects, m_buffer );
+            parserObject.Parse( *job.vecLists[i] );
+        }
+    }
+}
+
+PdfParserObject* PdfParser::GetObjectStream( int nObjNo )
+{
     // generation number of object streams is always 0
     PdfParserObject* pStream = dynamic_cast<PdfParserObject*>(m_vecObjects->GetObject( PdfReference( nObjNo, 0 ) ) );
     if( !pStream )
@@ -1272,27 +1632,15 @@ void PdfParser::ReadObjectFromStream( int nObjNo, int )
         if( s_bIgnoreBrokenObjects )
         {
             PdfError::LogMessage( eLogSeverity_Error, oss.str().c_str() );
-            return;
+            return NULL;
         }
         else
         {
             PODOFO_RAISE_ERROR_INFO( ePdfError_NoObject, oss.str().c_str() );
         }
     }
-    
 
-	PdfObjectStreamParserObject::ObjectIdList list;
-    for( int i = 0; i < m_nNumObjects; i++ ) 
-    {
-        if( m_offsets[i].bParsed && m_offsets[i].cUsed == 's' &&
-			m_offsets[i].lGeneration == nObjNo) 
-        {
-            list.push_back(static_cast<pdf_int64>(i));
-		}
-	}
-    
-    PdfObjectStreamParserObject pParserObject( pStream, m_vecObjects, m_buffer );
-    pParserObject.Parse( list );
+    return pStream;
 }
 
 const char* PdfParser::GetPdfVersionString() const
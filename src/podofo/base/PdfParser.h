@@ -35,6 +35,7 @@
 #define _PDF_PARSER_H_
 
 #include "PdfDefines.h"
+#include "PdfObjectStreamParserObject.h"
 #include "PdfTokenizer.h"
 #include "PdfVecObjects.h"
 
@@ -48,6 +49,7 @@ typedef TMapObjects::iterator       TIMapObjects;
 typedef TMapObjects::const_iterator TCIMapObjects;
 
 class PdfEncrypt;
+class PdfParserObject;
 class PdfString;
 
 /**
@@ -73,6 +75,12 @@ class PODOFO_API PdfParser : public PdfTokenizer {
     typedef TVecOffsets::iterator        TIVecOffsets;
     typedef TVecOffsets::const_iterator  TCIVecOffsets;
 
+    /** The object numbers of the objects in each object stream,
+     *  keyed by the object number of the object stream.
+     */
+    typedef std::map<int,PdfObjectStreamParserObject::ObjectIdList> TMapObjectStreams;
+    typedef TMapObjectStreams::const_iterator                        TCIMapObjectStreams;
+
     /** Create a new PdfParser object
      *  You have to open a PDF file using ParseFile later.
      *  \param pVecObjects vector to write the parsed PdfObjects to
@@ -180,6 +188,8 @@ class PODOFO_API PdfParser : public PdfTokenizer {
      *                       If false all objects will be read immediately.
      *                       This is faster if you do not need the complete PDF 
      *                       file in memory.
+     *  \param eMode If ePdfInputMode_ZeroCopy the file is mapped into memory
+     *               instead of being read through stdio.
      *
      *
      *  This might throw a PdfError( ePdfError_InvalidPassword ) exception
@@ -188,7 +198,8 @@ class PODOFO_API PdfParser : public PdfTokenizer {
      *  
      *  \see SetPassword
      */
-    void ParseFile( const char* pszFilename, bool bLoadOnDemand = true );
+    void ParseFile( const char* pszFilename, bool bLoadOnDemand = true, 
+                    EPdfInputMode eMode = ePdfInputMode_Default );
 
 #ifdef _WIN32
     /** Open a PDF file and parse it.
@@ -223,6 +234,9 @@ class PODOFO_API PdfParser : public PdfTokenizer {
      *                       If false all objects will be read immediately.
      *                       This is faster if you do not need the complete PDF 
      *                       file in memory.
+     *  \param eMode If ePdfInputMode_ZeroCopy the buffer is parsed in place
+     *               instead of being copied. It has to stay valid as long
+     *               as objects may still be loaded on demand from it.
      *
      *
      *  This might throw a PdfError( ePdfError_InvalidPassword ) exception
@@ -231,7 +245,8 @@ class PODOFO_API PdfParser : public PdfTokenizer {
      *  
      *  \see SetPassword
      */
-    void ParseFile( const char* pBuffer, long lLen, bool bLoadOnDemand = true );
+    void ParseFile( const char* pBuffer, long lLen, bool bLoadOnDemand = true, 
+                    EPdfInputMode eMode = ePdfInputMode_Default );
 
     /** Open a PDF file and parse it.
      *
@@ -363,6 +378,27 @@ class PODOFO_API PdfParser : public PdfTokenizer {
      */
     inline void SetStrictParsing( bool bStrict );
 
+    /**
+     * \return the arena parsed objects are allocated from or NULL
+     */
+    inline PdfArena* GetArena() const;
+
+    /**
+     * Allocate all objects parsed by this parser, including objects
+     * loaded on demand later, from an arena instead of the heap.
+     *
+     * The arena has to outlive all parsed objects, i.e. it may
+     * only be cleared after the PdfVecObjects passed to the parser
+     * and the parser itself have been deleted.
+     *
+     * By default, objects are allocated from the heap.
+     *
+     * \param pArena an arena or NULL to allocate from the heap
+     *
+     * \see PdfArena
+     */
+    inline void SetArena( PdfArena* pArena );
+
     /**
      * \return if broken objects are ignored while parsing
      */
@@ -401,6 +437,33 @@ class PODOFO_API PdfParser : public PdfTokenizer {
      */
     inline static void SetMaxObjectCount( long nMaxObjects );
 
+    /**
+     * \return number of threads used to parse objects
+     */
+    inline static int GetThreadCount();
+
+    /**
+     * Specify the number of threads the parser uses
+     * to parse the objects of a document, once the
+     * XRef table has been read.
+     *
+     * Objects are parsed concurrently only if loading
+     * on demand is disabled, the document is not encrypted
+     * and the whole document is available in memory,
+     * i.e. it was loaded from a buffer or from a file
+     * opened with ePdfInputMode_ZeroCopy.
+     * Object streams are decompressed and parsed concurrently 
+     * whenever loading on demand is disabled.
+     * The resulting objects are the same as with a single thread.
+     *
+     * By default, one thread is used. Pass 0 to use one
+     * thread per processor. Without PODOFO_MULTI_THREAD
+     * this setting has no effect.
+     *
+     * \param nThreads number of threads to use
+     */
+    inline static void SetThreadCount( int nThreads );
+
     inline pdf_long GetXRefOffset(void);
     
     bool HasXRefStream();
@@ -509,18 +572,46 @@ class PODOFO_API PdfParser : public PdfTokenizer {
      */
     void ReadObjectsInternal();
 
-    /** Read the object with index nIndex from the object stream nObjNo
-     *  and push it on the objects vector m_vecOffsets.
+    /** Parse all objects listed in m_offsets concurrently
+     *  on nThreads worker threads. Each thread reads
+     *  with its own cursor from the memory of m_device.
+     *
+     *  This method is called from ReadObjectsInternal.
+     *
+     *  \param nThreads number of worker threads
+     *  \param rvecObjects the parsed object for each index in m_offsets
+     *                     or NULL is stored here
+     *  \param rvecErrors an error for each index in m_offsets
+     *                    for which parsing failed or NULL is stored here
+     */
+    void ReadObjectsParallel( int nThreads, std::vector<PdfParserObject*> & rvecObjects, 
+                              std::vector<PdfError*> & rvecErrors );
+
+    /** Read the objects in list from the object stream nObjNo
+     *  and push them on the objects vector m_vecOffsets.
      *
      *  All objects are read from this stream and the stream object
      *  is free'd from memory. Further calls who try to read from the
      *  same stream simply do nothing.
      *
      *  \param nObjNo object number of the stream object
-     *  \param nIndex index of the object which should be parsed
+     *  \param list object numbers of the objects in this stream
+     *              which should be parsed, sorted ascending
+     *
+     */
+    void ReadObjectFromStream( int nObjNo, const PdfObjectStreamParserObject::ObjectIdList & list );
+
+    /** Read the objects from all object streams in rmapObjectStreams
+     *  like ReadObjectFromStream. The streams are decompressed and parsed 
+     *  concurrently on nThreads worker threads, the objects are
+     *  added to m_vecObjects in the same order as by ReadObjectFromStream.
+     *
+     *  This method is called from ReadObjectsInternal.
      *
+     *  \param nThreads number of worker threads
+     *  \param rmapObjectStreams the objects to read from each object stream
      */
-    void ReadObjectFromStream( int nObjNo, int nIndex );
+    void ReadObjectStreamsParallel( int nThreads, const TMapObjectStreams & rmapObjectStreams );
 
     /** Checks the magic number at the start of the pdf file
      *  and sets the m_ePdfVersion member to the correct version
@@ -567,6 +658,14 @@ class PODOFO_API PdfParser : public PdfTokenizer {
      */
     void         UpdateDocumentVersion();
 
+    /** Get the object stream with the object number nObjNo
+     *  from m_vecObjects.
+     *
+     *  \returns the object stream or NULL if it could not be loaded
+     *           and broken objects are ignored
+     */
+    PdfParserObject* GetObjectStream( int nObjNo );
+
 
     /** Resize the internal structure m_offsets in a safe manner.
      *  The limit for the maximum number of indirect objects in a PDF file is checked by this method.
@@ -601,11 +700,15 @@ class PODOFO_API PdfParser : public PdfTokenizer {
 
     bool          m_bStrictParsing;
 
+    PdfArena*     m_pArena;
+
     int           m_nIncrementalUpdates;
 
     static bool   s_bIgnoreBrokenObjects;
 
     static long   s_nMaxObjects;
+
+    static int    s_nThreadCount;
     
     std::set<pdf_long> m_visitedXRefOffsets;
 };
@@ -676,6 +779,22 @@ void PdfParser::SetStrictParsing( bool bStrict )
     m_bStrictParsing = bStrict;
 }
 
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+PdfArena* PdfParser::GetArena() const
+{
+    return m_pArena;
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+void PdfParser::SetArena( PdfArena* pArena )
+{
+    m_pArena = pArena;
+}
+
 // -----------------------------------------------------
 // 
 // -----------------------------------------------------
@@ -708,6 +827,22 @@ void PdfParser::SetMaxObjectCount( long nMaxObjects )
     PdfParser::s_nMaxObjects = nMaxObjects;
 }
 
+// -----------------------------------------------------
+//
+// -----------------------------------------------------
+int PdfParser::GetThreadCount()
+{
+    return PdfParser::s_nThreadCount;
+}
+
+// -----------------------------------------------------
+//
+// -----------------------------------------------------
+void PdfParser::SetThreadCount( int nThreads )
+{
+    PdfParser::s_nThreadCount = nThreads;
+}
+
 // -----------------------------------------------------
 //
 // -----------------------------------------------------
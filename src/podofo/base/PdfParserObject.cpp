@@ -96,6 +96,8 @@ void PdfParserObject::InitPdfParserObject()
 
     m_bStream           = false;
     m_lStreamOffset     = 0;
+
+    m_pArena            = PdfArena::GetCurrent();
 }
 
 void PdfParserObject::ReadObjectNumber()
@@ -381,6 +383,7 @@ void PdfParserObject::DelayedLoadImpl()
     PODOFO_ASSERT( DelayedLoadInProgress() );
 #endif
 
+    PdfArenaScope scope( m_pArena );
     ParseFileComplete( m_bIsTrailer );
 
     // If we complete without throwing DelayedLoadDone will be set
@@ -115,6 +115,16 @@ class PODOFO_API PdfParserObject : public PdfObject, public PdfTokenizer {
      */
     inline void SetObjectNumber( unsigned int nObjNo );
 
+    /** Set the device from which data of this object, 
+     *  which has not been loaded yet (e.g. its stream), is read.
+     *  It is only included for usage in the PdfParser, 
+     *  which parses objects on worker threads with their own devices.
+     *
+     *  \param rDevice a device providing the same data as the 
+     *                 device this object was parsed from
+     */
+    inline void SetDevice( const PdfRefCountedInputDevice & rDevice );
+
     /** Tries to free all memory allocated by this
      *  PdfObject (variables and streams) and reads
      *  it from disk again if it is requested another time.
@@ -191,6 +201,8 @@ class PODOFO_API PdfParserObject : public PdfObject, public PdfTokenizer {
 
     bool m_bStream;
     pdf_long m_lStreamOffset;
+
+    PdfArena* m_pArena; ///< Objects loaded on demand are allocated from this arena
 };
 
 // -----------------------------------------------------
@@ -201,6 +213,14 @@ void PdfParserObject::SetObjectNumber( unsigned int nObjNo )
     m_reference.SetObjectNumber( nObjNo );
 }
 
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+void PdfParserObject::SetDevice( const PdfRefCountedInputDevice & rDevice )
+{
+    m_device = rDevice;
+}
+
 // -----------------------------------------------------
 // 
 // -----------------------------------------------------
@@ -44,14 +44,14 @@ PdfRefCountedInputDevice::PdfRefCountedInputDevice()
 
 }
 
-PdfRefCountedInputDevice::PdfRefCountedInputDevice( const char* pszFilename, const char* )
+PdfRefCountedInputDevice::PdfRefCountedInputDevice( const char* pszFilename, const char*, EPdfInputMode eMode )
     : m_pDevice( NULL )
 {
     m_pDevice              = new TRefCountedInputDevice();
     m_pDevice->m_lRefCount = 1;
 
     try {
-        m_pDevice->m_pDevice = new PdfInputDevice( pszFilename );
+        m_pDevice->m_pDevice = new PdfInputDevice( pszFilename, eMode );
     } catch( PdfError & rError ) {
         delete m_pDevice;
         throw rError;
@@ -74,7 +74,7 @@ PdfRefCountedInputDevice::PdfRefCountedInputDevice( const wchar_t* pszFilename,
 }
 #endif // _WIN32
 
-PdfRefCountedInputDevice::PdfRefCountedInputDevice( const char* pBuffer, size_t lLen )
+PdfRefCountedInputDevice::PdfRefCountedInputDevice( const char* pBuffer, size_t lLen, EPdfInputMode eMode )
     : m_pDevice( NULL )
 {
     m_pDevice              = new TRefCountedInputDevice();
@@ -82,7 +82,7 @@ PdfRefCountedInputDevice::PdfRefCountedInputDevice( const char* pBuffer, size_t
 
 
     try {
-        m_pDevice->m_pDevice   = new PdfInputDevice( pBuffer, lLen );
+        m_pDevice->m_pDevice   = new PdfInputDevice( pBuffer, lLen, eMode );
     } catch( PdfError & rError ) {
         delete m_pDevice;
         throw rError;
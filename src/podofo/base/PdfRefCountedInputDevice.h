@@ -56,8 +56,12 @@ class PODOFO_API PdfRefCountedInputDevice {
      *  The file is opened using fopen()
      *  \param pszFilename a filename to be passed to fopen
      *  \param pszMode a mode string that can be passed to fopen
+     *  \param eMode pass ePdfInputMode_ZeroCopy to map the file into memory
+     *
+     *  \see PdfInputDevice
      */
-    PdfRefCountedInputDevice( const char* pszFilename, const char* pszMode );
+    PdfRefCountedInputDevice( const char* pszFilename, const char* pszMode, 
+                              EPdfInputMode eMode = ePdfInputMode_Default );
 
 
 #ifdef _WIN32
@@ -78,8 +82,14 @@ class PODOFO_API PdfRefCountedInputDevice {
      *  
      *  \param pBuffer pointer to the buffer
      *  \param lLen length of the buffer
+     *  \param eMode pass ePdfInputMode_ZeroCopy to read the buffer in place
+     *               instead of copying it. The buffer has to stay valid as
+     *               long as the device is referenced.
+     *
+     *  \see PdfInputDevice
      */
-    PdfRefCountedInputDevice( const char* pBuffer, size_t lLen );
+    PdfRefCountedInputDevice( const char* pBuffer, size_t lLen, 
+                              EPdfInputMode eMode = ePdfInputMode_Default );
 
     /** Create a new PdfRefCountedInputDevice from an PdfInputDevice
      *  
@@ -0,0 +1,461 @@
+/***************************************************************************
+ *   Copyright (C) 2007 by Dominik Seichter                                *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ *                                                                         *
+ *   In addition, as a special exception, the copyright holders give       *
+ *   permission to link the code of portions of this program with the      *
+ *   OpenSSL library under certain conditions as described in each         *
+ *   individual source file, and distribute linked combinations            *
+ *   including the two.                                                    *
+ *   You must obey the GNU General Public License in all respects          *
+ *   for all of the code used other than OpenSSL.  If you modify           *
+ *   file(s) with this exception, you may extend this exception to your    *
+ *   version of the file(s), but you are not obligated to do so.  If you   *
+ *   do not wish to do so, delete this exception statement from your       *
+ *   version.  If you delete this exception statement from all source      *
+ *   files in the program, then also delete it here.                       *
+ ***************************************************************************/
+
+#include "PdfSpoolStream.h"
+
+#include "PdfEncrypt.h"
+#include "PdfFilter.h"
+#include "PdfObject.h"
+#include "PdfOutputDevice.h"
+#include "PdfOutputStream.h"
+#include "PdfDefinesPrivate.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// Spooled data is read and written in blocks of this size
+#define PODOFO_SPOOL_BLOCK_SIZE 65536
+
+namespace PoDoFo {
+
+/** The memory budget and the temporary file shared by a 
+ *  PdfSpoolStreamFactory and all of its streams.
+ *
+ *  It is reference counted, as the streams may live longer 
+ *  than the factory which created them.
+ */
+class PdfStreamSpool {
+ public:
+    PdfStreamSpool( pdf_long lMemoryBudget )
+        : m_lMemoryBudget( lMemoryBudget ), m_lMemoryUsage( 0 ), m_hFile( NULL ), 
+          m_lFileLength( 0 ), m_bWriting( true ), m_nRefCount( 1 )
+    {
+    }
+
+    ~PdfStreamSpool()
+    {
+        if( m_hFile )
+            fclose( m_hFile );
+    }
+
+    void AddRef()
+    {
+        ++m_nRefCount;
+    }
+
+    void Release()
+    {
+        if( !--m_nRefCount )
+            delete this;
+    }
+
+    /** Reserve memory from the budget
+     *  \returns false if the budget does not allow it
+     */
+    bool Reserve( pdf_long lLen )
+    {
+        if( m_lMemoryUsage + lLen > m_lMemoryBudget )
+            return false;
+
+        m_lMemoryUsage += lLen;
+        return true;
+    }
+
+    /** Give memory reserved before back to the budget
+     */
+    void Free( pdf_long lLen )
+    {
+        m_lMemoryUsage -= lLen;
+    }
+
+    /** Append data to the temporary file
+     *  \returns the offset of the data in the file
+     */
+    pdf_long Write( const char* pBuffer, pdf_long lLen )
+    {
+        if( !m_hFile )
+        {
+            // tmpfile() deletes the file when it is closed
+            m_hFile = tmpfile();
+            if( !m_hFile )
+            {
+                PODOFO_RAISE_ERROR_INFO( ePdfError_FileNotFound, "Cannot create a temporary file for spooling streams" );
+            }
+        }
+
+        if( !m_bWriting )
+        {
+            if( fseeko( m_hFile, m_lFileLength, SEEK_SET ) == -1 )
+            {
+                PODOFO_RAISE_ERROR( ePdfError_InvalidDeviceOperation );
+            }
+
+            m_bWriting = true;
+        }
+
+        if( fwrite( pBuffer, sizeof(char), lLen, m_hFile ) != static_cast<size_t>(lLen) )
+        {
+            PODOFO_RAISE_ERROR( ePdfError_UnexpectedEOF );
+        }
+
+        const pdf_long lOffset = m_lFileLength;
+        m_lFileLength += lLen;
+        return lOffset;
+    }
+
+    /** Read data written before from the temporary file
+     */
+    void Read( pdf_long lOffset, char* pBuffer, pdf_long lLen )
+    {
+        // Seeking also flushes data written before
+        if( fseeko( m_hFile, lOffset, SEEK_SET ) == -1 )
+        {
+            PODOFO_RAISE_ERROR( ePdfError_InvalidDeviceOperation );
+        }
+
+        m_bWriting = false;
+        if( fread( pBuffer, sizeof(char), lLen, m_hFile ) != static_cast<size_t>(lLen) )
+        {
+            PODOFO_RAISE_ERROR( ePdfError_UnexpectedEOF );
+        }
+    }
+
+    inline pdf_long GetMemoryBudget() const { return m_lMemoryBudget; }
+    inline pdf_long GetMemoryUsage() const { return m_lMemoryUsage; }
+    inline pdf_long GetFileLength() const { return m_lFileLength; }
+
+ private:
+    pdf_long m_lMemoryBudget;
+    pdf_long m_lMemoryUsage;
+
+    FILE*    m_hFile;
+    pdf_long m_lFileLength;
+    bool     m_bWriting;     ///< the last operation on m_hFile was a write
+
+    int      m_nRefCount;
+};
+
+/** An output stream which stores all data in a PdfSpoolStream
+ */
+class PdfSpoolOutputStream : public PdfOutputStream {
+ public:
+    PdfSpoolOutputStream( PdfSpoolStream* pStream )
+        : m_pStream( pStream )
+    {
+    }
+
+    virtual pdf_long Write( const char* pBuffer, pdf_long lLen )
+    {
+        m_pStream->Store( pBuffer, lLen );
+        return lLen;
+    }
+
+    virtual void Close() 
+    {
+    }
+
+ private:
+    PdfSpoolStream* m_pStream;
+};
+
+PdfSpoolStreamFactory::PdfSpoolStreamFactory( pdf_long lMemoryBudget )
+    : m_pSpool( new PdfStreamSpool( lMemoryBudget ) )
+{
+}
+
+PdfSpoolStreamFactory::~PdfSpoolStreamFactory()
+{
+    m_pSpool->Release();
+}
+
+PdfStream* PdfSpoolStreamFactory::CreateStream( PdfObject* pParent )
+{
+    return new PdfSpoolStream( pParent, m_pSpool );
+}
+
+pdf_long PdfSpoolStreamFactory::GetMemoryBudget() const
+{
+    return m_pSpool->GetMemoryBudget();
+}
+
+pdf_long PdfSpoolStreamFactory::GetMemoryUsage() const
+{
+    return m_pSpool->GetMemoryUsage();
+}
+
+pdf_long PdfSpoolStreamFactory::GetSpooledLength() const
+{
+    return m_pSpool->GetFileLength();
+}
+
+PdfSpoolStream::PdfSpoolStream( PdfObject* pParent, PdfStreamSpool* pSpool )
+    : PdfStream( pParent ), m_pSpool( pSpool ), m_pStream( NULL ), m_pSpoolStream( NULL ),
+      m_pBuffer( NULL ), m_lBufferSize( 0 ), m_lLength( 0 ), m_bSpooled( false ), m_pCache( NULL )
+{
+    m_pSpool->AddRef();
+}
+
+PdfSpoolStream::~PdfSpoolStream()
+{
+    if( m_pStream != m_pSpoolStream )
+        delete m_pStream;
+    delete m_pSpoolStream;
+
+    this->FreeBuffers();
+    m_pSpool->Release();
+}
+
+void PdfSpoolStream::FreeBuffers()
+{
+    if( m_pBuffer )
+    {
+        podofo_free( m_pBuffer );
+        m_pBuffer = NULL;
+    }
+
+    m_pSpool->Free( m_lBufferSize );
+    m_lBufferSize = 0;
+
+    if( m_pCache )
+    {
+        podofo_free( m_pCache );
+        m_pCache = NULL;
+    }
+}
+
+void PdfSpoolStream::Write( PdfOutputDevice* pDevice, PdfEncrypt* pEncrypt )
+{
+    pDevice->Print( "stream\n" );
+    if( pEncrypt && (!m_bSpooled || 
+                     (pEncrypt->GetEncryptAlgorithm() != PdfEncrypt::ePdfEncryptAlgorithm_RC4V1 && 
+                      pEncrypt->GetEncryptAlgorithm() != PdfEncrypt::ePdfEncryptAlgorithm_RC4V2)) )
+    {
+        // Only RC4 can encrypt block by block, all other data 
+        // has to be encrypted at once
+        const pdf_long lOutputLen = pEncrypt->CalculateStreamLength( m_lLength );
+        char*          pOutputBuffer = new char[lOutputLen];
+
+        try {
+            pEncrypt->Encrypt( reinterpret_cast<const unsigned char*>(this->GetInternalBuffer()), m_lLength,
+                               reinterpret_cast<unsigned char*>(pOutputBuffer), lOutputLen );
+            pDevice->Write( pOutputBuffer, lOutputLen );
+        } catch( PdfError & ) {
+            delete[] pOutputBuffer;
+            throw;
+        }
+
+        delete[] pOutputBuffer;
+
+        // Do not keep a copy of spooled data in memory
+        if( m_pCache )
+        {
+            podofo_free( m_pCache );
+            m_pCache = NULL;
+        }
+    }
+    else
+    {
+        PdfDeviceOutputStream stream( pDevice );
+        if( pEncrypt ) 
+        {
+            PODOFO_UNIQUEU_PTR<PdfOutputStream> pEncryptStream( pEncrypt->CreateEncryptionOutputStream( &stream ) );
+            this->GetCopy( pEncryptStream.get() );
+            pEncryptStream->Close();
+        }
+        else
+            this->GetCopy( &stream );
+    }
+    pDevice->Print( "\nendstream\n" );
+}
+
+void PdfSpoolStream::GetCopy( char** pBuffer, pdf_long* lLen ) const
+{
+    if( !pBuffer || !lLen )
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
+    }
+
+    *pBuffer = static_cast<char*>(podofo_calloc( m_lLength, sizeof(char) ));
+    *lLen    = m_lLength;
+    
+    if( !*pBuffer )
+    {
+        PODOFO_RAISE_ERROR( ePdfError_OutOfMemory );
+    }
+
+    PdfMemoryOutputStream stream( *pBuffer, m_lLength );
+    this->GetCopy( &stream );
+}
+
+void PdfSpoolStream::GetCopy( PdfOutputStream* pStream ) const
+{
+    if( !pStream )
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
+    }
+
+    if( !m_bSpooled )
+    {
+        pStream->Write( m_pBuffer, m_lLength );
+        return;
+    }
+
+    // Copy block by block, so that spooled data is never held in memory at once
+    std::vector<char> vecBuffer( PODOFO_SPOOL_BLOCK_SIZE );
+    for( TVecExtents::const_iterator it = m_vecExtents.begin(); it != m_vecExtents.end(); ++it )
+    {
+        for( pdf_long lPos = 0; lPos < it->second; lPos += PODOFO_SPOOL_BLOCK_SIZE )
+        {
+            const pdf_long lBlock = PDF_MIN( static_cast<pdf_long>(PODOFO_SPOOL_BLOCK_SIZE), it->second - lPos );
+            m_pSpool->Read( it->first + lPos, &(vecBuffer[0]), lBlock );
+            pStream->Write( &(vecBuffer[0]), lBlock );
+        }
+    }
+}
+
+const char* PdfSpoolStream::GetInternalBuffer() const
+{
+    if( !m_bSpooled )
+        return m_pBuffer;
+
+    if( !m_pCache && m_lLength )
+    {
+        pdf_long lLen;
+        this->GetCopy( &m_pCache, &lLen );
+    }
+
+    return m_pCache;
+}
+
+void PdfSpoolStream::BeginAppendImpl( const TVecFilters & vecFilters )
+{
+    // Space in the temporary file is not reused
+    this->FreeBuffers();
+    m_vecExtents.clear();
+    m_bSpooled = false;
+    m_lLength  = 0;
+
+    m_pSpoolStream = new PdfSpoolOutputStream( this );
+    if( vecFilters.size() )
+    {
+        try {
+            m_pStream = PdfFilterFactory::CreateEncodeStream( vecFilters, m_pSpoolStream, this->GetEncodeFlateSettings() );
+        } catch( PdfError & ) {
+            delete m_pSpoolStream;
+            m_pSpoolStream = NULL;
+            throw;
+        }
+    }
+    else
+        m_pStream = m_pSpoolStream;
+}
+
+void PdfSpoolStream::AppendImpl( const char* pszString, size_t lLen )
+{
+    m_pStream->Write( pszString, lLen );
+}
+
+void PdfSpoolStream::EndAppendImpl()
+{
+    if( m_pStream ) 
+    {
+        m_pStream->Close();
+        if( m_pStream != m_pSpoolStream )
+            delete m_pStream;
+        m_pStream = NULL;
+    }
+
+    delete m_pSpoolStream;
+    m_pSpoolStream = NULL;
+
+    if( m_pParent )
+        m_pParent->GetDictionary().AddKey( PdfName::KeyLength, PdfVariant(static_cast<pdf_int64>(m_lLength) ) );
+}
+
+void PdfSpoolStream::Store( const char* pBuffer, pdf_long lLen )
+{
+    if( !m_bSpooled && m_lLength + lLen > m_lBufferSize )
+    {
+        // Grow the buffer exponentially if the budget allows,
+        // otherwise as much as needed
+        const pdf_long lNeeded = m_lLength + lLen;
+        pdf_long       lSize   = PDF_MAX( lNeeded, m_lBufferSize * 2 );
+        if( !m_pSpool->Reserve( lSize - m_lBufferSize ) )
+        {
+            lSize = lNeeded;
+            if( !m_pSpool->Reserve( lSize - m_lBufferSize ) )
+                lSize = 0;
+        }
+
+        if( lSize )
+        {
+            char* pNewBuffer = static_cast<char*>(podofo_realloc( m_pBuffer, lSize ));
+            if( !pNewBuffer )
+            {
+                m_pSpool->Free( lSize - m_lBufferSize );
+                PODOFO_RAISE_ERROR( ePdfError_OutOfMemory );
+            }
+
+            m_pBuffer     = pNewBuffer;
+            m_lBufferSize = lSize;
+        }
+        else
+            this->Spool();
+    }
+
+    if( !m_bSpooled )
+    {
+        memcpy( m_pBuffer + m_lLength, pBuffer, lLen );
+        m_lLength += lLen;
+        return;
+    }
+
+    const pdf_long lOffset = m_pSpool->Write( pBuffer, lLen );
+    if( m_vecExtents.size() && m_vecExtents.back().first + m_vecExtents.back().second == lOffset )
+        m_vecExtents.back().second += lLen;
+    else
+        m_vecExtents.push_back( std::pair<pdf_long,pdf_long>( lOffset, lLen ) );
+
+    m_lLength += lLen;
+}
+
+void PdfSpoolStream::Spool()
+{
+    if( m_lLength )
+        m_vecExtents.push_back( std::pair<pdf_long,pdf_long>( m_pSpool->Write( m_pBuffer, m_lLength ), m_lLength ) );
+
+    this->FreeBuffers();
+    m_bSpooled = true;
+}
+
+};
@@ -0,0 +1,266 @@
+/***************************************************************************
+ *   Copyright (C) 2007 by Dominik Seichter                                *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ *                                                                         *
+ *   In addition, as a special exception, the copyright holders give       *
+ *   permission to link the code of portions of this program with the      *
+ *   OpenSSL library under certain conditions as described in each         *
+ *   individual source file, and distribute linked combinations            *
+ *   including the two.                                                    *
+ *   You must obey the GNU General Public License in all respects          *
+ *   for all of the code used other than OpenSSL.  If you modify           *
+ *   file(s) with this exception, you may extend this exception to your    *
+ *   version of the file(s), but you are not obligated to do so.  If you   *
+ *   do not wish to do so, delete this exception statement from your       *
+ *   version.  If you delete this exception statement from all source      *
+ *   files in the program, then also delete it here.                       *
+ ***************************************************************************/
+
+#ifndef _PDF_SPOOL_STREAM_H_
+#define _PDF_SPOOL_STREAM_H_
+
+#include "PdfDefines.h"
+
+#include "PdfStream.h"
+#include "PdfVecObjects.h"
+
+#include <vector>
+
+namespace PoDoFo {
+
+class PdfOutputStream;
+class PdfStreamSpool;
+
+/** A stream factory which creates PdfSpoolStream objects.
+ *
+ *  All streams created by one factory share a memory budget.
+ *  A stream which would exceed the budget moves its data to a 
+ *  temporary file and writes any further data there, so the memory
+ *  used for stream data never grows beyond the budget.
+ *
+ *  All streams share one temporary file, which is deleted
+ *  after the factory and all of its streams have been deleted.
+ *  Space in the file is not reused when a stream is cleared.
+ *
+ *  \see PdfVecObjects::SetStreamFactory
+ *  \see PdfStreamedDocument::SetStreamMemoryBudget
+ */
+class PODOFO_API PdfSpoolStreamFactory : public PdfVecObjects::StreamFactory {
+ public:
+    /** Create a new stream factory
+     *
+     *  \param lMemoryBudget number of bytes of stream data all streams of
+     *                       this factory may keep in memory together
+     */
+    PdfSpoolStreamFactory( pdf_long lMemoryBudget );
+
+    virtual ~PdfSpoolStreamFactory();
+
+    /** Creates a PdfSpoolStream
+     *
+     *  \param pParent parent object
+     *
+     *  \returns a new stream object 
+     */
+    virtual PdfStream* CreateStream( PdfObject* pParent );
+
+    /**
+     *  \returns the number of bytes all streams may keep in memory
+     */
+    pdf_long GetMemoryBudget() const;
+
+    /**
+     *  \returns the number of bytes all streams keep in memory now
+     */
+    pdf_long GetMemoryUsage() const;
+
+    /**
+     *  \returns the number of bytes written to the temporary file so far
+     */
+    pdf_long GetSpooledLength() const;
+
+ private:
+    /** copy constructor, not implemented
+     */
+    PdfSpoolStreamFactory( const PdfSpoolStreamFactory & rhs );
+    /** assignment operator, not implemented
+     */
+    PdfSpoolStreamFactory & operator=( const PdfSpoolStreamFactory & rhs );
+
+ private:
+    PdfStreamSpool* m_pSpool;
+};
+
+/** A PDF stream can be appended to any PdfObject
+ *  and can contain arbitrary data.
+ *
+ *  A PdfSpoolStream keeps its data in memory as long as the memory
+ *  budget of its PdfSpoolStreamFactory allows and in a temporary
+ *  file otherwise. The data in the file is copied in small blocks
+ *  when the stream is written.
+ *
+ *  \see PdfSpoolStreamFactory
+ *  \see PdfMemStream
+ *  \see PdfFileStream
+ */
+class PODOFO_API PdfSpoolStream : public PdfStream {
+    friend class PdfSpoolStreamFactory;
+    friend class PdfSpoolOutputStream;
+
+ public:
+    virtual ~PdfSpoolStream();
+
+    /** Write the stream to an output device
+     *  \param pDevice write to this outputdevice.
+     *  \param pEncrypt encrypt stream data using this object
+     */
+    virtual void Write( PdfOutputDevice* pDevice, PdfEncrypt* pEncrypt = NULL );
+
+    /** Get a malloced buffer of the current stream.
+     *  No filters will be applied to the buffer, so
+     *  if the stream is Flate compressed the compressed copy
+     *  will be returned.
+     *
+     *  The caller has to podofo_free() the buffer.
+     *
+     *  \param pBuffer pointer to the buffer address (output parameter)
+     *  \param lLen    pointer to the buffer length  (output parameter)
+     */
+    virtual void GetCopy( char** pBuffer, pdf_long* lLen ) const;
+
+    /** Get a copy of a the stream and write it to a PdfOutputStream
+     *
+     *  \param pStream data is written to this stream.
+     */
+    virtual void GetCopy( PdfOutputStream* pStream ) const;
+
+    /** Get the streams length with all filters applied (eg the compressed
+     *  length of a Flate compressed stream).
+     *
+     *  \returns the length of the stream with all filters applied
+     */
+    inline virtual pdf_long GetLength() const;
+
+    /** 
+     *  \returns true if the data of this stream is in the temporary file
+     */
+    inline bool IsSpooled() const;
+
+ protected:
+    /** Required for the GetFilteredCopy implementation
+     *
+     *  The data of a spooled stream is read into memory
+     *  and kept there until the stream is changed.
+     *
+     *  \returns a handle to the internal buffer
+     */
+    virtual const char* GetInternalBuffer() const;
+
+    /** Required for the GetFilteredCopy implementation
+     *  \returns the size of the internal buffer
+     */
+    inline virtual pdf_long GetInternalBufferSize() const;
+
+    /** Begin appending data to this stream.
+     *  Clears the current stream contents.
+     *
+     *  \param vecFilters use this filters to encode any data written to the stream.
+     */
+    virtual void BeginAppendImpl( const TVecFilters & vecFilters );
+
+    /** Append a binary buffer to the current stream contents.
+     *
+     *  \param pszString a buffer
+     *  \param lLen length of the buffer
+     *
+     *  \see BeginAppend
+     *  \see Append
+     *  \see EndAppend
+     */
+    virtual void AppendImpl( const char* pszString, size_t lLen ); 
+
+    /** Finish appending data to the stream
+     */
+    virtual void EndAppendImpl();
+
+ private:
+    /** Create a new PdfSpoolStream object which has a parent PdfObject.
+     *  Use PdfSpoolStreamFactory::CreateStream to create a stream.
+     *
+     *  \param pParent parent object
+     *  \param pSpool the shared memory budget and temporary file
+     */
+    PdfSpoolStream( PdfObject* pParent, PdfStreamSpool* pSpool );
+
+    /** Add encoded data to the stream, in memory
+     *  if the budget allows or in the temporary file
+     */
+    void Store( const char* pBuffer, pdf_long lLen );
+
+    /** Move the data in memory to the temporary file
+     */
+    void Spool();
+
+    /** Free the memory buffer and the cached copy of spooled data
+     */
+    void FreeBuffers();
+
+ private:
+    typedef std::vector<std::pair<pdf_long,pdf_long> > TVecExtents; ///< offset and length in the temporary file
+
+    PdfStreamSpool*  m_pSpool;
+    PdfOutputStream* m_pStream;
+    PdfOutputStream* m_pSpoolStream;
+
+    char*            m_pBuffer;
+    pdf_long         m_lBufferSize;  ///< memory reserved from the budget
+    pdf_long         m_lLength;
+
+    bool             m_bSpooled;
+    TVecExtents      m_vecExtents;
+
+    mutable char*    m_pCache;       ///< copy of spooled data for GetInternalBuffer
+};
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+pdf_long PdfSpoolStream::GetLength() const
+{
+    return m_lLength;
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+bool PdfSpoolStream::IsSpooled() const
+{
+    return m_bSpooled;
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+pdf_long PdfSpoolStream::GetInternalBufferSize() const
+{
+    return m_lLength;
+}
+
+};
+
+#endif // _PDF_SPOOL_STREAM_H_
@@ -34,24 +34,39 @@
 #include "PdfStream.h"
 
 #include "PdfArray.h"
+#include "PdfDictionary.h"
 #include "PdfFilter.h" 
 #include "PdfInputStream.h"
 #include "PdfOutputStream.h"
 #include "PdfOutputDevice.h"
+#include "PdfVecObjects.h"
 #include "PdfDefinesPrivate.h"
 
+#include <algorithm>
 #include <iostream>
 
 #include <stdlib.h>
 
 using namespace std;
 
+/** The largest buffer preallocated for decoding a stream using its
+ *  /DL key, if the stream is not that large itself. Larger buffers
+ *  grow as the data is decoded, so a malformed /DL cannot force
+ *  a huge allocation.
+ */
+#define PODOFO_MAX_DECODED_LENGTH_HINT (4 * 1024 * 1024)
+
+/** The largest factor by which the /DL key of a stream may exceed
+ *  the encoded length before it is capped at PODOFO_MAX_DECODED_LENGTH_HINT
+ */
+#define PODOFO_MAX_DECODED_LENGTH_FACTOR 4
+
 namespace PoDoFo {
 
 enum EPdfFilter PdfStream::eDefaultFilter = ePdfFilter_FlateDecode;
 
 PdfStream::PdfStream( PdfObject* pParent )
-    : m_pParent( pParent ), m_bAppend( false )
+    : m_pParent( pParent ), m_bAppend( false ), m_pFlateSettings( NULL )
 {
 }
 
@@ -88,7 +103,7 @@ void PdfStream::GetFilteredCopy( PdfOutputStream* pStream ) const
 void PdfStream::GetFilteredCopy( char** ppBuffer, pdf_long* lLen ) const
 {
     TVecFilters            vecFilters    = PdfFilterFactory::CreateFilterList( m_pParent );
-    PdfMemoryOutputStream  stream;
+    PdfMemoryOutputStream  stream( this->GetDecodedLengthHint( vecFilters ) );
     if( vecFilters.size() )
     {
         // Use std::uniqueu_ptr so that pDecodeStream is deleted 
@@ -111,6 +126,74 @@ void PdfStream::GetFilteredCopy( char** ppBuffer, pdf_long* lLen ) const
     *ppBuffer = stream.TakeBuffer();
 }
 
+EPdfFilter PdfStream::GetEncodedImageCopy( PdfOutputStream* pStream ) const
+{
+    TVecFilters vecFilters = PdfFilterFactory::CreateFilterList( m_pParent );
+    if( !vecFilters.size() || !PdfFilterFactory::IsImageCodec( vecFilters.back() ) )
+    {
+        this->GetFilteredCopy( pStream );
+        return ePdfFilter_None;
+    }
+
+    const EPdfFilter eCodec = vecFilters.back();
+    vecFilters.pop_back();
+    if( vecFilters.size() )
+    {
+        // Only decode the filters applied on top of the image codec,
+        // e.g. an ASCII85 wrapped JPEG image
+        PdfOutputStream* pDecodeStream = PdfFilterFactory::CreateDecodeStream( vecFilters, pStream, 
+                                                                               m_pParent ? 
+                                                                               &(m_pParent->GetDictionary()) : NULL  );
+        try {
+            pDecodeStream->Write( this->GetInternalBuffer(), this->GetInternalBufferSize() );
+            pDecodeStream->Close();
+        }
+        catch( PdfError & e ) 
+        {
+            delete pDecodeStream;
+            throw e;
+        }
+        delete pDecodeStream;
+    }
+    else
+    {
+        pStream->Write( this->GetInternalBuffer(), this->GetInternalBufferSize() );
+    }
+
+    return eCodec;
+}
+
+PdfFilteredInputStream* PdfStream::CreateFilteredInputStream() const
+{
+    return new PdfFilteredInputStream( this->GetInternalBuffer(), this->GetInternalBufferSize(),
+                                       PdfFilterFactory::CreateFilterList( m_pParent ),
+                                       m_pParent ? &(m_pParent->GetDictionary()) : NULL );
+}
+
+pdf_long PdfStream::GetDecodedLengthHint( const TVecFilters & vecFilters ) const
+{
+    const pdf_long lLen = this->GetInternalBufferSize();
+    if( !vecFilters.size() )
+        return PDF_MAX( lLen, static_cast<pdf_long>(1) );
+
+    // The optional /DL key gives the decoded length. It is not trusted
+    // further than a few MiB or a small multiple of the encoded length,
+    // the buffer grows if the data is larger.
+    pdf_long lHint = lLen * 2;
+    if( m_pParent && m_pParent->IsDictionary() )
+    {
+        const PdfObject* pDL = m_pParent->GetDictionary().GetKey( "DL" );
+        if( pDL && pDL->IsNumber() && pDL->GetNumber() > 0 )
+        {
+            const pdf_int64 lMaxHint = PDF_MAX( static_cast<pdf_int64>(lLen) * PODOFO_MAX_DECODED_LENGTH_FACTOR, 
+                                                static_cast<pdf_int64>(PODOFO_MAX_DECODED_LENGTH_HINT) );
+            lHint = static_cast<pdf_long>(PDF_MIN( pDL->GetNumber(), lMaxHint ));
+        }
+    }
+
+    return PDF_MAX( lHint, static_cast<pdf_long>(INITIAL_SIZE) );
+}
+
 const PdfStream & PdfStream::operator=( const PdfStream & rhs )
 {
     PdfMemoryInputStream stream( rhs.GetInternalBuffer(), rhs.GetInternalBufferSize() );
@@ -209,6 +292,14 @@ void PdfStream::BeginAppend( const TVecFilters & vecFilters, bool bClearExisting
 
     PODOFO_RAISE_LOGIC_IF( m_bAppend, "BeginAppend() failed because EndAppend() was not yet called!" );
 
+    const TFlateSettings* pFlateSettings = this->GetEncodeFlateSettings();
+    const bool            bPredictor     = pFlateSettings && pFlateSettings->nPredictor != 1
+        && std::find( vecFilters.begin(), vecFilters.end(), ePdfFilter_FlateDecode ) != vecFilters.end();
+    if( bPredictor && vecFilters.size() != 1 )
+    {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidPredictor, "A predictor requires FlateDecode as the only filter" );
+    }
+
     if( m_pParent && m_pParent->GetOwner() )
         m_pParent->GetOwner()->BeginAppendStream( this );
 
@@ -237,6 +328,16 @@ void PdfStream::BeginAppend( const TVecFilters & vecFilters, bool bClearExisting
         m_pParent->GetDictionary().AddKey( PdfName::KeyFilter, filters );
     }
 
+    if( bPredictor && m_pParent )
+    {
+        PdfDictionary decodeParms;
+        decodeParms.AddKey( "Predictor", static_cast<pdf_int64>(pFlateSettings->nPredictor) );
+        decodeParms.AddKey( "Colors", static_cast<pdf_int64>(pFlateSettings->nColors) );
+        decodeParms.AddKey( "BitsPerComponent", static_cast<pdf_int64>(pFlateSettings->nBitsPerComponent) );
+        decodeParms.AddKey( "Columns", static_cast<pdf_int64>(pFlateSettings->nColumns) );
+        m_pParent->GetDictionary().AddKey( "DecodeParms", decodeParms );
+    }
+
     this->BeginAppendImpl( vecFilters );
     m_bAppend = true;
     if( pBuffer ) 
@@ -246,6 +347,14 @@ void PdfStream::BeginAppend( const TVecFilters & vecFilters, bool bClearExisting
     }
 }
 
+const TFlateSettings* PdfStream::GetEncodeFlateSettings() const
+{
+    if( m_pFlateSettings )
+        return m_pFlateSettings;
+
+    return m_pParent && m_pParent->GetOwner() ? m_pParent->GetOwner()->GetFlateSettings() : NULL;
+}
+
 void PdfStream::EndAppend()
 {
     PODOFO_RAISE_LOGIC_IF( !m_bAppend, "EndAppend() failed because BeginAppend() was not yet called!" );
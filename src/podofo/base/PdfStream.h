@@ -44,6 +44,7 @@
 
 namespace PoDoFo {
 
+class PdfFilteredInputStream;
 class PdfInputStream;
 class PdfName;
 class PdfObject;
@@ -226,6 +227,26 @@ class PODOFO_API PdfStream {
      */
     inline bool IsAppending() const;
 
+    /** Sets the FlateDecode settings used when data is appended to this stream.
+     *  They take precedence over the settings of the document.
+     *
+     *  If the settings name a predictor, FlateDecode has to be the only
+     *  filter passed to BeginAppend(), which applies the predictor to the data
+     *  and adds a matching /DecodeParms key to the stream dictionary.
+     *
+     *  The settings are not copied and have to live as long as they are used.
+     *
+     *  \param pSettings settings or NULL to use the settings of the document
+     *
+     *  \see PdfVecObjects::SetFlateSettings
+     */
+    inline void SetFlateSettings( const TFlateSettings* pSettings );
+
+    /**
+     *  \returns the FlateDecode settings of this stream or NULL
+     */
+    inline const TFlateSettings* GetFlateSettings() const;
+
     /** Get the stream's length with all filters applied (e.g. if the stream is
      * Flate-compressed, the length of the compressed data stream).
      *
@@ -268,6 +289,34 @@ class PODOFO_API PdfStream {
      *  \param pStream filtered data is written to this stream.
      */
     void GetFilteredCopy( PdfOutputStream* pStream ) const;
+
+    /** Create an input stream which decodes the stream with all filters
+     *  as specified in the dictionary's /Filter key while it is read.
+     *
+     *  Unlike GetFilteredCopy() this never holds all of the decoded
+     *  data in memory, see PdfFilteredInputStream.
+     *  The stream must not be modified while the returned stream is used.
+     *
+     *  \returns a new input stream, which has to be deleted by the caller
+     */
+    PdfFilteredInputStream* CreateFilteredInputStream() const;
+
+    /** Get a copy of the stream with all filters decoded except for
+     *  a final image codec like DCTDecode or JPXDecode, i.e. the image
+     *  as it can be stored in an image file of its format.
+     *
+     *  If the image codec is the only filter, the data of the stream is
+     *  passed on to pStream as it is, without decoding or copying it.
+     *  A stream without an image codec is decoded completely, 
+     *  like GetFilteredCopy() does.
+     *
+     *  \param pStream the encoded image is written to this stream
+     *  \returns the image codec the written data is encoded with or
+     *            ePdfFilter_None if all filters were decoded
+     *
+     *  \see PdfFilterFactory::IsImageCodec
+     */
+    EPdfFilter GetEncodedImageCopy( PdfOutputStream* pStream ) const;
     
     /** Create a copy of a PdfStream object
      *  \param rhs the object to clone
@@ -312,10 +361,26 @@ class PODOFO_API PdfStream {
      */
     virtual void EndAppendImpl() = 0;
 
+    /** 
+     *  \returns the FlateDecode settings for data appended to this stream,
+     *            i.e. the settings of the stream, of the document owning it
+     *            or NULL to use PdfFilterFactory::GetFlateSettings()
+     */
+    const TFlateSettings* GetEncodeFlateSettings() const;
+
+ private:
+    /** 
+     *  \param vecFilters the filters of this stream
+     *  \returns an estimate of the length of the decoded data, at least 1
+     */
+    pdf_long GetDecodedLengthHint( const TVecFilters & vecFilters ) const;
+
  protected:
     PdfObject*          m_pParent;
 
     bool                m_bAppend;
+
+    const TFlateSettings* m_pFlateSettings;
 };
 
 // -----------------------------------------------------
@@ -362,6 +427,22 @@ bool PdfStream::IsAppending() const
     return m_bAppend;
 }
 
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+void PdfStream::SetFlateSettings( const TFlateSettings* pSettings )
+{
+    m_pFlateSettings = pSettings;
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+const TFlateSettings* PdfStream::GetFlateSettings() const
+{
+    return m_pFlateSettings;
+}
+
 };
 
 #endif // _PDF_STREAM_H_
@@ -37,6 +37,7 @@
 #include "PdfDictionary.h"
 #include "PdfEncrypt.h"
 #include "PdfInputDevice.h"
+#include "PdfLocale.h"
 #include "PdfName.h"
 #include "PdfString.h"
 #include "PdfReference.h"
@@ -228,19 +229,16 @@ const char PdfTokenizer::s_octMap[]        = {
 PdfTokenizer::PdfTokenizer()
     : m_buffer( PDF_BUFFER )
 {
-    PdfLocaleImbue(m_doubleParser);
 }
 
 PdfTokenizer::PdfTokenizer( const char* pBuffer, size_t lLen )
     : m_device( pBuffer, lLen ), m_buffer( PDF_BUFFER )
 {
-    PdfLocaleImbue(m_doubleParser);
 }
 
 PdfTokenizer::PdfTokenizer( const PdfRefCountedInputDevice & rDevice, const PdfRefCountedBuffer & rBuffer )
     : m_device( rDevice ), m_buffer( rBuffer )
 {
-    PdfLocaleImbue(m_doubleParser);
 }
 
 PdfTokenizer::~PdfTokenizer()
@@ -278,6 +276,29 @@ bool PdfTokenizer::GetNextToken( const char*& pszToken , EPdfTokenType* peType )
         PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
     }
 
+    const char* pContiguous = m_device.Device()->GetBuffer();
+    if( pContiguous )
+    {
+        // Fast path: scan the token directly in memory and
+        // copy it once instead of reading it char by char
+        size_t lPos   = static_cast<size_t>(m_device.Device()->Tell());
+        size_t lStart = 0;
+        size_t lLen   = this->ScanToken( pContiguous, m_device.Device()->GetBufferLength(), lPos,
+                                         m_buffer.GetSize() - 1, lStart, peType );
+        m_device.Device()->Seek( static_cast<std::streamoff>(lPos) );
+
+        if( !lLen )
+        {
+            pszToken = 0;
+            return false;
+        }
+
+        memcpy( m_buffer.GetBuffer(), pContiguous + lStart, lLen );
+        m_buffer.GetBuffer()[lLen] = '\0';
+        pszToken = m_buffer.GetBuffer();
+        return true;
+    }
+
     if( peType )
         *peType = ePdfTokenType_Token;
 
@@ -373,6 +394,109 @@ bool PdfTokenizer::GetNextToken( const char*& pszToken , EPdfTokenType* peType )
     return true;
 }
 
+size_t PdfTokenizer::ScanToken( const char* pBuffer, size_t lLen, size_t & rlPos, size_t lMaxLen,
+                                size_t & rlStart, EPdfTokenType* peType ) const
+{
+    size_t lPos    = rlPos;
+    size_t counter = 0;
+
+    if( peType )
+        *peType = ePdfTokenType_Token;
+
+    while( lPos < lLen && counter < lMaxLen )
+    {
+        const unsigned char c = static_cast<unsigned char>(pBuffer[lPos]);
+
+        if( !counter && IsWhitespace( c ) )
+        {
+            // ignore leading whitespaces
+            ++lPos;
+        }
+        else if( c == '%' )
+        {
+            // Consume all characters before the next line break,
+            // accept 0x0D, 0x0A and 0x0D 0x0A as one EOL
+            while( lPos < lLen && pBuffer[lPos] != 0x0D && pBuffer[lPos] != 0x0A )
+                ++lPos;
+
+            if( lPos < lLen && pBuffer[lPos++] == 0x0D && lPos < lLen && pBuffer[lPos] == 0x0A )
+                ++lPos;
+
+            // comments are treated as token-delimiting whitespace
+            if( counter )
+                break;
+        }
+        else if( !counter && (c == '<' || c == '>' ) )
+        {
+            // special handling for << and >> tokens
+            if( peType )
+                *peType = ePdfTokenType_Delimiter;
+
+            rlStart = lPos++;
+            counter = 1;
+            if( lPos < lLen && counter < lMaxLen && static_cast<unsigned char>(pBuffer[lPos]) == c )
+            {
+                ++lPos;
+                ++counter;
+            }
+            break;
+        }
+        else if( counter && (IsWhitespace( c ) || IsDelimiter( c )) )
+        {
+            // Next character is a token-terminating char
+            break;
+        }
+        else
+        {
+            if( !counter )
+                rlStart = lPos;
+
+            ++lPos;
+            ++counter;
+
+            if( IsDelimiter( c ) )
+            {
+                // All delimeters except << and >> are one-character tokens
+                if( peType )
+                    *peType = ePdfTokenType_Delimiter;
+                break;
+            }
+        }
+    }
+
+    rlPos = lPos;
+    return counter;
+}
+
+bool PdfTokenizer::GetNextTokenInPlace( const char *& pszToken, size_t & rlLen, EPdfTokenType* peType )
+{
+    if( !m_device.Device() || !m_device.Device()->GetBuffer() || m_deqQueque.size() )
+    {
+        if( !this->GetNextToken( pszToken, peType ) )
+            return false;
+
+        rlLen = strlen( pszToken );
+        return true;
+    }
+
+    const char* pContiguous = m_device.Device()->GetBuffer();
+    size_t      lPos        = static_cast<size_t>(m_device.Device()->Tell());
+    size_t      lStart      = 0;
+
+    rlLen = this->ScanToken( pContiguous, m_device.Device()->GetBufferLength(), lPos,
+                             std::numeric_limits<size_t>::max(), lStart, peType );
+    m_device.Device()->Seek( static_cast<std::streamoff>(lPos) );
+
+    if( !rlLen )
+    {
+        pszToken = 0;
+        return false;
+    }
+
+    pszToken = pContiguous + lStart;
+    return true;
+}
+
 bool PdfTokenizer::IsNextToken( const char* pszToken )
 {
     if( !pszToken )
@@ -381,14 +505,15 @@ bool PdfTokenizer::IsNextToken( const char* pszToken )
     }
 
     const char* pszRead;
-    bool gotToken = this->GetNextToken( pszRead, NULL );
+    size_t      lLen;
+    bool gotToken = this->GetNextTokenInPlace( pszRead, lLen, NULL );
 
     if (!gotToken)
     {
         PODOFO_RAISE_ERROR( ePdfError_UnexpectedEOF );
     }
 
-    return (strcmp( pszToken, pszRead ) == 0);
+    return strlen( pszToken ) == lLen && memcmp( pszToken, pszRead, lLen ) == 0;
 }
 
 pdf_long PdfTokenizer::GetNextNumber()
@@ -496,11 +621,8 @@ EPdfDataType PdfTokenizer::DetermineDataType( const char* pszToken, EPdfTokenTyp
             //double dVal = strtod( pszToken, NULL );
             double dVal;
 
-            m_doubleParser.clear(); // clear error state
-            m_doubleParser.str( pszToken );
-            if( !(m_doubleParser >> dVal) )
+            if( !PdfLocaleParseReal( pszToken, pszStart - pszToken, dVal ) )
             {
-                m_doubleParser.clear(); // clear error state
                 PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDataType, pszToken );
             }
 
@@ -763,11 +885,31 @@ void PdfTokenizer::ReadString( PdfVariant& rVariant, PdfEncrypt* pEncrypt )
 
     m_vecBuffer.clear();
 
+    const char* pContiguous = m_device.Device()->GetBuffer();
+    const size_t lContiguousLen = m_device.Device()->GetBufferLength();
+
     while( (c = m_device.Device()->Look()) != EOF )
     {
         // end of stream reached
         if( !bEscape )
         {
+            if( pContiguous )
+            {
+                // Copy runs of characters which need no special handling at once
+                size_t lPos = static_cast<size_t>(m_device.Device()->Tell());
+                size_t lEnd = lPos;
+                while( lEnd < lContiguousLen && pContiguous[lEnd] != '\\' 
+                       && pContiguous[lEnd] != '(' && pContiguous[lEnd] != ')' )
+                    ++lEnd;
+
+                if( lEnd != lPos )
+                {
+                    m_vecBuffer.insert( m_vecBuffer.end(), pContiguous + lPos, pContiguous + lEnd );
+                    m_device.Device()->Seek( static_cast<std::streamoff>(lEnd) );
+                    continue;
+                }
+            }
+
             // Handle raw characters
             c = m_device.Device()->GetChar();
             if( !nBalanceCount && c == ')' )
@@ -877,17 +1019,45 @@ void PdfTokenizer::ReadHexString( std::vector<char>& rVecBuffer)
     rVecBuffer.clear();
     int        c;
 
-    while( (c = m_device.Device()->GetChar()) != EOF )
+    const char* pContiguous = m_device.Device()->GetBuffer();
+    if( pContiguous )
     {
-        // end of stream reached
-        if( c == '>' )
-            break;
+        // Scan the string in place up to the closing '>'
+        const size_t lLen = m_device.Device()->GetBufferLength();
+        size_t       lPos = static_cast<size_t>(m_device.Device()->Tell());
 
-        // only a hex digits
-        if( isdigit( c ) ||
-            ( c >= 'A' && c <= 'F') ||
-            ( c >= 'a' && c <= 'f'))
-            rVecBuffer.push_back( c );
+        for( ; lPos < lLen; ++lPos )
+        {
+            c = static_cast<unsigned char>(pContiguous[lPos]);
+            if( c == '>' )
+            {
+                ++lPos;
+                break;
+            }
+
+            // only a hex digits
+            if( isdigit( c ) ||
+                ( c >= 'A' && c <= 'F') ||
+                ( c >= 'a' && c <= 'f'))
+                rVecBuffer.push_back( c );
+        }
+
+        m_device.Device()->Seek( static_cast<std::streamoff>(lPos) );
+    }
+    else
+    {
+        while( (c = m_device.Device()->GetChar()) != EOF )
+        {
+            // end of stream reached
+            if( c == '>' )
+                break;
+
+            // only a hex digits
+            if( isdigit( c ) ||
+                ( c >= 'A' && c <= 'F') ||
+                ( c >= 'a' && c <= 'f'))
+                rVecBuffer.push_back( c );
+        }
     }
 
     // pad to an even length if necessary
@@ -131,6 +131,28 @@ class PODOFO_API PdfTokenizer {
      */
     virtual bool GetNextToken( const char *& pszToken, EPdfTokenType* peType = NULL);
 
+    /** Reads the next token from the current file position
+     *  ignoring all comments, without copying it if possible.
+     *
+     *  If the input device holds its data contiguously in memory
+     *  (see PdfInputDevice::GetBuffer) the returned token points
+     *  directly into the device buffer and is NOT NULL-terminated.
+     *  Otherwise the token is read using GetNextToken.
+     *
+     *  \param[out] pszToken On true return, set to the first character of the
+     *                     read token. The pointer is valid as long as the input
+     *                     device is alive or until the next call to GetNextToken(..).
+     *  \param[out] rlLen  On true return, the length of the token in bytes.
+     *  \param[out] peType On true return, if not NULL the type of the read token
+     *                     will be stored into this parameter.
+     *
+     *  \returns           True if a token was read, false if there are no
+     *                     more tokens to read.
+     *
+     *  \see GetNextToken
+     */
+    bool GetNextTokenInPlace( const char *& pszToken, size_t & rlLen, EPdfTokenType* peType = NULL );
+
     /** Reads the next token from the current file position
      *  ignoring all comments and compare the passed token
      *  to the read token.
@@ -291,6 +313,24 @@ class PODOFO_API PdfTokenizer {
      */
     void QuequeToken( const char* pszToken, EPdfTokenType eType );
 
+ private:
+    /** Scan the next token directly in a contiguous buffer.
+     *  This is the equivalent of the character based loop
+     *  in GetNextToken for memory and mapped input devices.
+     *
+     *  \param pBuffer the device buffer
+     *  \param lLen length of pBuffer
+     *  \param rlPos current read position, updated to the position
+     *               after the token on return
+     *  \param lMaxLen maximum length of the token
+     *  \param[out] rlStart offset of the token in pBuffer
+     *  \param[out] peType the type of the token if not NULL
+     *
+     *  \returns the length of the token, 0 if no token was found
+     */
+    size_t ScanToken( const char* pBuffer, size_t lLen, size_t & rlPos, size_t lMaxLen,
+                      size_t & rlStart, EPdfTokenType* peType ) const;
+
  protected:
     PdfRefCountedInputDevice m_device;
     PdfRefCountedBuffer      m_buffer;
@@ -314,11 +354,6 @@ class PODOFO_API PdfTokenizer {
     std::vector<char> m_vecBuffer; // we use a vector instead of a string
                                    // because we might read a Unicode
                                    // string which is allowed to contain 0 bytes.
-
-    /// An istringstream which is used
-    /// to read double values instead of strtod
-    /// which is locale depend.
-    std::istringstream m_doubleParser;
 };
 
 // -----------------------------------------------------
@@ -255,7 +255,7 @@ void PdfVariant::Write( PdfOutputDevice* pDevice, EPdfWriteMode eWriteMode, cons
                 pDevice->Write( " ", 1 ); // Write space before numbers
             }
 
-            pDevice->Print( "%" PDF_FORMAT_INT64, m_Data.nNumber );
+            pDevice->WriteInt( m_Data.nNumber );
             break;
         }
         case ePdfDataType_Real:
@@ -272,29 +272,8 @@ void PdfVariant::Write( PdfOutputDevice* pDevice, EPdfWriteMode eWriteMode, cons
                 pDevice->Write( " ", 1 ); // Write space before numbers
             }
 
-            // Use ostringstream, so that locale does not matter
-            std::ostringstream oss;
-            PdfLocaleImbue(oss);
-            oss << std::fixed << m_Data.dNumber;
-            std::string copy = oss.str();
-            size_t len = copy.size();
-
-            if( (eWriteMode & ePdfWriteMode_Compact) == ePdfWriteMode_Compact && 
-                copy.find('.') != string::npos )
-            {
-                const char *str = copy.c_str();
-                while( str[len - 1] == '0' )
-                    --len;
-                if( str[len - 1] == '.' )
-                    --len;
-                if( len == 0 )
-                {
-                    pDevice->Write( "0", 1 );
-                    break;
-                }
-            }
-
-            pDevice->Write( copy.c_str(), len );
+            // WriteReal does not depend on the locale
+            pDevice->WriteReal( m_Data.dNumber, (eWriteMode & ePdfWriteMode_Compact) == ePdfWriteMode_Compact );
             break;
         }
         case ePdfDataType_HexString:
@@ -315,7 +294,7 @@ void PdfVariant::Write( PdfOutputDevice* pDevice, EPdfWriteMode eWriteMode, cons
                 pDevice->Write( " ", 1 ); // Write space before null
             }
 
-            pDevice->Print( "null" );
+            pDevice->Write( "null", 4 );
             break;
         }
         case ePdfDataType_Unknown:
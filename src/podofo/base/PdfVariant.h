@@ -41,6 +41,7 @@
 #endif
 
 #include "PdfDefines.h"
+#include "PdfArena.h"
 #include "PdfRefCountedBuffer.h"
 #include "PdfString.h"
 
@@ -139,6 +140,13 @@ class PODOFO_API PdfVariant {
     PdfVariant( const PdfVariant & rhs );
 
     virtual ~PdfVariant();
+
+    /** Variants created with new are allocated from the
+     *  arena of the current PdfArenaScope, if any.
+     *  \see PdfArena
+     */
+    inline static void* operator new( size_t nSize ) { return PdfArena::Allocate( nSize ); }
+    inline static void operator delete( void* pMemory, size_t nSize ) { PdfArena::Free( pMemory, nSize ); }
     
     /** \returns true if this PdfVariant is empty.
      *           i.e. m_eDataType == ePdfDataType_Null
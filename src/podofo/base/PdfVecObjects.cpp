@@ -74,6 +74,13 @@ public:
     }
 };
 
+struct ObjectReferenceComparatorPredicate {
+public:
+    inline bool operator()( const PdfObject* const & pObj, const PdfReference & ref ) const { 
+        return pObj->Reference() < ref;
+    }
+};
+
 //RG: 1) Should this class not be moved to the header file
 class ObjectsComparator { 
 public:
@@ -105,7 +112,7 @@ private:
 size_t PdfVecObjects::m_nMaxReserveSize = static_cast<size_t>(8388607); // cf. Table C.1 in section C.2 of PDF32000_2008.pdf
 
 PdfVecObjects::PdfVecObjects()
-    : m_bAutoDelete( false ), m_bCanReuseObjectNumbers( true ), m_nObjectCount( 1 ), m_bSorted( true ), m_pDocument( NULL ), m_pStreamFactory( NULL )
+    : m_bAutoDelete( false ), m_bCanReuseObjectNumbers( true ), m_nObjectCount( 1 ), m_bSorted( true ), m_nIndexed( 0 ), m_nRenumberCount( 0 ), m_pDocument( NULL ), m_pStreamFactory( NULL ), m_pFlateSettings( NULL )
 {
 }
 
@@ -139,7 +146,10 @@ void PdfVecObjects::Clear()
     }
 
     m_vector.clear();
+    m_vecByNumber.clear();
 
+    m_nIndexed       = 0;
+    ++m_nRenumberCount;
     m_bAutoDelete    = false;
     m_nObjectCount   = 1;
     m_bSorted        = true; // an emtpy vector is sorted
@@ -149,17 +159,19 @@ void PdfVecObjects::Clear()
 
 PdfObject* PdfVecObjects::GetObject( const PdfReference & ref ) const
 {
-    if( !m_bSorted )
-        const_cast<PdfVecObjects*>(this)->Sort();
-
-    PdfObject refObj( ref, NULL );
-    TCIVecObjects it = std::lower_bound( m_vector.begin(), m_vector.end(), &refObj, ObjectComparatorPredicate() );
-    if( it != m_vector.end() && (refObj.Reference() == (*it)->Reference()) )
+    if( ref.ObjectNumber() < m_vecByNumber.size() )
     {
-        return *it;
+        PdfObject* pObj = m_vecByNumber[ref.ObjectNumber()];
+        if( pObj && pObj->Reference() == ref )
+            return pObj;
     }
 
-    return NULL;
+    // Every object is in the table, so there is no need to search
+    if( m_nIndexed == m_vector.size() )
+        return NULL;
+
+    TIVecObjects it = const_cast<PdfVecObjects*>(this)->FindObject( ref );
+    return it != m_vector.end() ? *it : NULL;
 }
 
 PdfObject* PdfVecObjects::MustGetObject( const PdfReference & ref ) const
@@ -172,39 +184,25 @@ PdfObject* PdfVecObjects::MustGetObject( const PdfReference & ref ) const
 
 size_t PdfVecObjects::GetIndex( const PdfReference & ref ) const
 {
-    if( !m_bSorted )
-        const_cast<PdfVecObjects*>(this)->Sort();
-
-    PdfObject refObj( ref, NULL );
-    std::pair<TCIVecObjects,TCIVecObjects> it = 
-        std::equal_range( m_vector.begin(), m_vector.end(), &refObj, ObjectComparatorPredicate() );
-
-    if( it.first == it.second )
+    TIVecObjects it = const_cast<PdfVecObjects*>(this)->FindObject( ref );
+    if( it == m_vector.end() )
     {
         PODOFO_RAISE_ERROR( ePdfError_NoObject );
     }
 
-    return (it.first - this->begin());
+    return (it - m_vector.begin());
 }
 
 PdfObject* PdfVecObjects::RemoveObject( const PdfReference & ref, bool bMarkAsFree )
 {
-    if( !m_bSorted )
-        this->Sort();
-
-
-    PdfObject*         pObj;
-    PdfObject refObj( ref, NULL );
-    std::pair<TIVecObjects,TIVecObjects> it = 
-        std::equal_range( m_vector.begin(), m_vector.end(), &refObj, ObjectComparatorPredicate() );
-
-    if( it.first != it.second )
+    TIVecObjects it = this->FindObject( ref );
+    if( it != m_vector.end() )
     {
-        pObj = *(it.first);
+        PdfObject* pObj = *it;
         if( bMarkAsFree )
             this->AddFreeObject( pObj->Reference() );
-        m_vector.erase( it.first );
-        return pObj;
+
+        return this->RemoveObject( it );
     }
     
     return NULL;
@@ -214,9 +212,64 @@ PdfObject* PdfVecObjects::RemoveObject( const TIVecObjects & it )
 {
     PdfObject* pObj = *it;
     m_vector.erase( it );
+    this->UnindexObject( pObj );
     return pObj;
 }
 
+TIVecObjects PdfVecObjects::FindObject( const PdfReference & ref )
+{
+    if( !m_bSorted )
+        this->Sort();
+
+    TIVecObjects it = std::lower_bound( m_vector.begin(), m_vector.end(), ref, ObjectReferenceComparatorPredicate() );
+    if( it != m_vector.end() && (*it)->Reference() == ref )
+        return it;
+
+    return m_vector.end();
+}
+
+void PdfVecObjects::IndexObject( PdfObject* pObj )
+{
+    pdf_objnum nObjNo = pObj->Reference().ObjectNumber();
+    if( nObjNo >= m_vecByNumber.size() )
+    {
+        // Do not let a few very large object numbers blow up the table
+        if( nObjNo > 2 * m_vector.size() + 1024 )
+            return;
+
+        m_vecByNumber.resize( nObjNo + 1, NULL );
+    }
+
+    if( !m_vecByNumber[nObjNo] )
+    {
+        m_vecByNumber[nObjNo] = pObj;
+        ++m_nIndexed;
+    }
+}
+
+void PdfVecObjects::UnindexObject( const PdfObject* pObj )
+{
+    pdf_objnum nObjNo = pObj->Reference().ObjectNumber();
+    if( nObjNo < m_vecByNumber.size() && m_vecByNumber[nObjNo] == pObj )
+    {
+        m_vecByNumber[nObjNo] = NULL;
+        --m_nIndexed;
+    }
+}
+
+void PdfVecObjects::RebuildIndex()
+{
+    m_vecByNumber.clear();
+    m_nIndexed = 0;
+
+    TCIVecObjects it = m_vector.begin();
+    while( it != m_vector.end() )
+    {
+        this->IndexObject( *it );
+        ++it;
+    }
+}
+
 void PdfVecObjects::CollectGarbage( PdfObject* pTrailer )
 {
     // We do not have any objects that have
@@ -262,6 +315,28 @@ PdfObject* PdfVecObjects::CreateObject( const PdfVariant & rVariant )
     return pObj;
 }
 
+PdfObject* PdfVecObjects::CreateUnlistedObject( const char* pszType )
+{
+    PdfReference ref( static_cast<pdf_objnum>(m_nObjectCount), 0 );
+    PdfObject*  pObj = new PdfObject( ref, pszType );
+    pObj->SetOwner( this );
+
+    this->SetObjectCount( ref );
+
+    return pObj;
+}
+
+void PdfVecObjects::DeleteUnlistedObject( PdfObject* pObject )
+{
+    if( !pObject )
+        return;
+
+    if( static_cast<size_t>(pObject->Reference().ObjectNumber()) + 1 == m_nObjectCount )
+        --m_nObjectCount;
+
+    delete pObject;
+}
+
 void PdfVecObjects::AddFreeObject( const PdfReference & rReference )
 {
     std::pair<TIPdfReferenceList,TIPdfReferenceList> it = 
@@ -303,6 +378,8 @@ void PdfVecObjects::insert_sorted( PdfObject* pObj )
     {
         m_vector.push_back( pObj );
     }
+
+    this->IndexObject( pObj );
 }
 
 void PdfVecObjects::RenumberObjects( PdfObject* pTrailer, TPdfReferenceSet* pNotDelete, bool bDoGarbageCollection )
@@ -345,7 +422,91 @@ void PdfVecObjects::RenumberObjects( PdfObject* pTrailer, TPdfReferenceSet* pNot
         ++it;
     }
 
-    
+    ++m_nRenumberCount;
+    this->RebuildIndex();
+}
+
+void PdfVecObjects::AssignObjectNumbers( const TPdfReferenceList & rNewReferences, PdfObject* pTrailer, TPdfReferenceList* pOldReferences )
+{
+    if( rNewReferences.size() != m_vector.size() )
+    {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_ValueOutOfRange, "Expected exactly one new reference per object." );
+    }
+
+    if( !m_bSorted )
+        this->Sort();
+
+    // Update the references while the vector is still
+    // sorted by the old object numbers
+    TCIVecObjects it = m_vector.begin();
+    while( it != m_vector.end() )
+    {
+        AssignReferences( *it, rNewReferences );
+        ++it;
+    }
+
+    if( pTrailer )
+        AssignReferences( pTrailer, rNewReferences );
+
+    std::vector<std::pair<PdfReference,PdfReference> > vecRenumbered;
+    vecRenumbered.reserve( m_vector.size() );
+    for( size_t i = 0; i < m_vector.size(); i++ )
+    {
+        vecRenumbered.push_back( std::make_pair( rNewReferences[i], m_vector[i]->m_reference ) );
+        m_vector[i]->m_reference = rNewReferences[i];
+    }
+
+    m_bSorted = false;
+    ++m_nRenumberCount;
+    this->Sort();
+    this->RebuildIndex();
+
+    if( pOldReferences )
+    {
+        // Sort() orders by reference, too
+        std::sort( vecRenumbered.begin(), vecRenumbered.end() );
+
+        pOldReferences->clear();
+        for( size_t i = 0; i < vecRenumbered.size(); i++ )
+            pOldReferences->push_back( vecRenumbered[i].second );
+    }
+}
+
+void PdfVecObjects::AssignReferences( const PdfObject* pObj, const TPdfReferenceList & rNewReferences )
+{
+    if( pObj->IsReference() )
+    {
+        TCIVecObjects itFound = std::lower_bound( m_vector.begin(), m_vector.end(), pObj->GetReference(), 
+                                                  ObjectReferenceComparatorPredicate() );
+        if( itFound != m_vector.end() && (*itFound)->Reference() == pObj->GetReference() )
+            *const_cast<PdfReference*>(&(pObj->GetReference())) = rNewReferences[itFound - m_vector.begin()];
+    }
+    else if( pObj->IsArray() )
+    {
+        PdfArray::const_iterator itArray = pObj->GetArray().begin(); 
+        while( itArray != pObj->GetArray().end() )
+        {
+            if( (*itArray).IsReference() ||
+                (*itArray).IsArray() ||
+                (*itArray).IsDictionary() )
+                AssignReferences( &(*itArray), rNewReferences );
+
+            ++itArray;
+        }
+    }
+    else if( pObj->IsDictionary() )
+    {
+        TCIKeyMap itKeys = pObj->GetDictionary().GetKeys().begin();
+        while( itKeys != pObj->GetDictionary().GetKeys().end() )
+        {
+            if( (*itKeys).second->IsReference() ||
+                (*itKeys).second->IsArray() ||
+                (*itKeys).second->IsDictionary() )
+                AssignReferences( (*itKeys).second, rNewReferences );
+            
+            ++itKeys;
+        }
+    }
 }
 
 void PdfVecObjects::InsertOneReferenceIntoVector( const PdfObject* pObj, TVecReferencePointerList* pList )  
@@ -502,7 +663,7 @@ void PdfVecObjects::GarbageCollection( TVecReferencePointerList* pList, PdfObjec
         bContains = pNotDelete ? ( pNotDelete->find( m_vector[pos]->Reference() ) != pNotDelete->end() ) : false;
         if( !(*it).size() && !bContains )
         {
-            m_vector.erase( this->begin() + pos );
+            this->RemoveObject( this->begin() + pos );
         }
         
         ++pos;
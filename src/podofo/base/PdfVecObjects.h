@@ -45,6 +45,7 @@ class PdfDocument;
 class PdfObject;
 class PdfStream;
 class PdfVariant;
+struct TFlateSettings;
 
 // Use deque as many insertions are here way faster than with using std::list
 // This is especially useful for PDFs like PDFReference17.pdf with
@@ -220,8 +221,22 @@ class PODOFO_API PdfVecObjects {
      */
     size_t GetObjectCount() const { return m_nObjectCount; }
 
+    /** 
+     *  \returns a number which changes whenever the objects
+     *            in the vector are renumbered or removed all at once,
+     *            so that indices by reference can detect that they are stale
+     *
+     *  \see RenumberObjects
+     *  \see AssignObjectNumbers
+     */
+    inline size_t GetRenumberCount() const;
+
     /** Finds the object with the given reference in m_vecOffsets 
      *  and returns a pointer to it if it is found.
+     *
+     *  Objects are looked up by their object number in constant time,
+     *  unless the object numbers in this vector are very sparse.
+     *
      *  \param ref the object to be found
      *  \returns the found object or NULL if no object was found.
      */
@@ -278,6 +293,26 @@ class PODOFO_API PdfVecObjects {
      */
     PdfObject* CreateObject( const PdfVariant & rVariant );
 
+    /** Creates a new object which is owned by this vector, but not inserted into it.
+     *  The object always gets a new object number with generation 0, i.e. free
+     *  object numbers are never reused. This is used for objects like object
+     *  streams and XRef streams, which are only created while writing.
+     *
+     *  \param pszType optional value of the /Type key of the object
+     *  \returns PdfObject pointer to the new PdfObject, which has to be deleted by the caller
+     */
+    PdfObject* CreateUnlistedObject( const char* pszType = NULL );
+
+    /** Deletes an object created by CreateUnlistedObject.
+     *  Its object number is given back if no other object number was
+     *  reserved since, so writing a document again does not increase
+     *  its object count. Delete several of these objects in the reverse
+     *  order of their creation to give back all of their numbers.
+     *
+     *  \param pObject the object to delete, may be NULL
+     */
+    void DeleteUnlistedObject( PdfObject* pObject );
+
     /** Mark a reference as unused so that it can be reused for new objects.
      *  \param rReference the reference to reuse
      *
@@ -303,7 +338,24 @@ class PODOFO_API PdfVecObjects {
      */
     void RenumberObjects( PdfObject* pTrailer, TPdfReferenceSet* pNotDelete = NULL, bool bDoGarbageCollection = false );
 
-    /** 
+    /**
+     *  Gives every object in the vector a new reference chosen by the caller
+     *  and updates all references to the objects, so that the renumbering
+     *  can be undone by a second call. References to objects which are not
+     *  part of this vector are not changed.
+     *
+     *  \param rNewReferences the new reference of each object, in the current
+     *         (sorted) order of the vector. Must not contain duplicates.
+     *  \param pTrailer the references of this trailer object are updated, too. May be NULL.
+     *  \param pOldReferences if not NULL, the previous reference of each object
+     *         is written to this list in the new order of the vector,
+     *         which restores the original numbers when passed to AssignObjectNumbers again.
+     *
+     *  \see RenumberObjects
+     */
+    void AssignObjectNumbers( const TPdfReferenceList & rNewReferences, PdfObject* pTrailer, TPdfReferenceList* pOldReferences = NULL );
+
+    /**
      * \see insert_sorted
      *
      * Simple forward to insert sorted, as PdfVecObjects is always sorted.
@@ -376,6 +428,21 @@ class PODOFO_API PdfVecObjects {
      */
     inline void SetStreamFactory( StreamFactory* pFactory );
 
+    /** Sets the compression level and strategy used for all
+     *  streams of this document which are compressed using the FlateDecode filter.
+     *
+     *  The settings are not copied and have to live as long as they are used.
+     *
+     *  \param pSettings settings or NULL to use PdfFilterFactory::GetFlateSettings()
+     */
+    inline void SetFlateSettings( const TFlateSettings* pSettings );
+
+    /**
+     *  \returns the FlateDecode settings of this document or NULL
+     *            if the defaults of PdfFilterFactory are used
+     */
+    inline const TFlateSettings* GetFlateSettings() const;
+
     /** Creates a stream object
      *  This method is a factory for PdfStream objects.
      *
@@ -484,6 +551,12 @@ class PODOFO_API PdfVecObjects {
      */
     void InsertOneReferenceIntoVector( const PdfObject* pObj, TVecReferencePointerList* pList );
 
+    /** Replace all references in pObj and its children by the
+     *  corresponding entry of rNewReferences.
+     *  Assumes that the PdfVecObjects is sorted.
+     */
+    void AssignReferences( const PdfObject* pObj, const TPdfReferenceList & rNewReferences );
+
     /** Delete all objects from the vector which do not have references to them selves
      *  \param pList must be a list created by BuildReferenceCountVector
      *  \param pTrailer must be the trailer object so that it is not deleted
@@ -492,13 +565,37 @@ class PODOFO_API PdfVecObjects {
      */
     void GarbageCollection( TVecReferencePointerList* pList, PdfObject* pTrailer, TPdfReferenceSet* pNotDelete = NULL );
 
+    /** Add pObj to the table of objects by object number used by GetObject.
+     *  Objects whose number would make the table too sparse and objects
+     *  sharing their number with an object already in the table are not added
+     *  and have to be searched in the sorted vector.
+     */
+    void IndexObject( PdfObject* pObj );
+
+    /** Remove pObj from the table of objects by object number.
+     */
+    void UnindexObject( const PdfObject* pObj );
+
+    /** Rebuild the table of objects by object number
+     *  after the references of objects were changed.
+     */
+    void RebuildIndex();
+
+    /** Find the position of the object with the reference ref
+     *  in the vector, which is sorted if necessary.
+     *  \returns the position or end() if no object was found
+     */
+    TIVecObjects FindObject( const PdfReference & ref );
+
  private:
     bool                m_bAutoDelete;
     bool                m_bCanReuseObjectNumbers;
     size_t              m_nObjectCount;
     bool                m_bSorted;
     TVecObjects         m_vector;
-
+    TVecObjects         m_vecByNumber;   ///< The objects of m_vector indexed by object number, NULL if not indexed
+    size_t              m_nIndexed;      ///< The number of objects in m_vecByNumber
+    size_t              m_nRenumberCount; ///< Incremented whenever the references of the objects change
 
     TVecObservers       m_vecObservers;
     TPdfReferenceList   m_lstFreeObjects;
@@ -506,6 +603,7 @@ class PODOFO_API PdfVecObjects {
     PdfDocument*        m_pDocument;
 
     StreamFactory*      m_pStreamFactory;
+    const TFlateSettings* m_pFlateSettings;
 
 	std::string			m_sSubsetPrefix;		 ///< Prefix for BaseFont and FontName of subsetted font
     static size_t       m_nMaxReserveSize;
@@ -544,6 +642,7 @@ inline void PdfVecObjects::Reserve( size_t size )
     if( size <= m_nMaxReserveSize ) // Fix CVE-2018-5783
     {
         m_vector.reserve( size );
+        m_vecByNumber.reserve( size + 1 );
     } 
     else
     {
@@ -601,6 +700,14 @@ inline const TPdfReferenceList & PdfVecObjects::GetFreeObjects() const
     return m_lstFreeObjects;
 }
 
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+size_t PdfVecObjects::GetRenumberCount() const
+{
+    return m_nRenumberCount;
+}
+
 // -----------------------------------------------------
 // 
 // -----------------------------------------------------
@@ -617,6 +724,22 @@ inline void PdfVecObjects::SetStreamFactory( StreamFactory* pFactory )
     m_pStreamFactory = pFactory;
 }
 
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+inline void PdfVecObjects::SetFlateSettings( const TFlateSettings* pSettings )
+{
+    m_pFlateSettings = pSettings;
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+inline const TFlateSettings* PdfVecObjects::GetFlateSettings() const
+{
+    return m_pFlateSettings;
+}
+
 // -----------------------------------------------------
 // 
 // -----------------------------------------------------
@@ -33,10 +33,11 @@
 
 #include "PdfWriter.h"
 
+#include "PdfArray.h"
 #include "PdfData.h"
 #include "PdfDate.h"
 #include "PdfDictionary.h"
-//#include "PdfHintStream.h"
+#include "PdfMemStream.h"
 #include "PdfObject.h"
 #include "PdfParser.h"
 #include "PdfParserObject.h"
@@ -45,26 +46,503 @@
 #include "PdfXRef.h"
 #include "PdfXRefStream.h"
 #include "PdfDefinesPrivate.h"
+#include "util/PdfMutexWrapper.h"
+#include "util/PdfThread.h"
+
+#include "doc/PdfHintStream.h"
 
 #define PDF_MAGIC           "\xe2\xe3\xcf\xd3\n"
-// 10 spaces
-#define LINEARIZATION_PADDING "          " 
+// Placeholder for offsets which are not known yet when writing
+// the linearization dictionary and the first page trailer.
+// It is as wide as the largest offset an XRef table entry can hold.
+#define LINEARIZATION_PLACEHOLDER PODOFO_LL_LITERAL(9999999999)
 
+#include <algorithm>
 #include <iostream>
 #include <stdlib.h>
 
 namespace PoDoFo {
 
+int PdfWriter::s_nThreadCount = 1;
+
+namespace NonPublic {
+
+/** The objects of a linearized PDF file in the order in which
+ *  they are written and their offsets (see Annex F of the PDF specification).
+ *
+ *  The linearization dictionary and the hint stream are not part
+ *  of vecObjects. All offsets are calculated as if the hint stream
+ *  was not present in the file.
+ */
+struct PdfLinearizedLayout {
+    PdfLinearizedLayout()
+        : nFirstPage( 0 ), nPages( 0 ), nShared( 0 ), nOther( 0 ), 
+          lBase( 0 ), lLinearizeEnd( 0 ), lFirstXRef( 0 ), lTrailerEnd( 0 ),
+          lHint( 0 ), lHintLength( 0 ), lMainXRef( 0 ), lFileEnd( 0 )
+    {
+    }
+
+    /** \returns the offset of the object at nIndex in the final file
+     */
+    pdf_uint64 GetOffset( size_t nIndex ) const
+    {
+        return vecOffsets[nIndex] + (nIndex >= nFirstPage ? lHintLength : 0);
+    }
+
+    TVecObjects             vecObjects;    ///< catalog and document level objects, first page,
+                                           ///< other pages, shared objects and all other objects
+    size_t                  nFirstPage;    ///< index of the first page object in vecObjects
+    size_t                  nPages;        ///< index of the first object of the other pages
+    size_t                  nShared;       ///< index of the first shared object
+    size_t                  nOther;        ///< index of the first object not belonging to any page
+    std::vector<size_t>     vecPageStart;  ///< index of the first object of each page
+    std::vector<std::vector<pdf_uint32> > vecPageShared; ///< shared object hint table entries used by each page
+
+    std::vector<pdf_uint64> vecOffsets;    ///< offset of each object in vecObjects and the end of the last one
+    pdf_uint64              lBase;         ///< offset at which the file starts on the output device
+    pdf_uint64              lLinearizeEnd;
+    pdf_uint64              lFirstXRef;
+    pdf_uint64              lTrailerEnd;
+    pdf_uint64              lHint;
+    pdf_uint64              lHintLength;   ///< 0 until the hint stream was created
+    pdf_uint64              lMainXRef;
+    pdf_uint64              lFileEnd;
+};
+
+};
+
+namespace {
+
+enum ELinearizedKind {
+    eLinearizedKind_Unknown,
+    eLinearizedKind_Page,
+    eLinearizedKind_PagesNode
+};
+
+/** Sorts all objects of a document into the parts of a linearized PDF file,
+ *  by following the references from the catalog and from each page.
+ */
+class PdfLinearizedObjectSorter {
+ public:
+    PdfLinearizedObjectSorter( PdfVecObjects* pObjects )
+        : m_pObjects( pObjects ), 
+          m_vecKind( pObjects->GetSize(), eLinearizedKind_Unknown ),
+          m_vecDocument( pObjects->GetSize(), false ),
+          m_vecUser( pObjects->GetSize(), -1 ),
+          m_vecVisit( pObjects->GetSize(), -1 ),
+          m_vecShared( pObjects->GetSize(), false )
+    {
+        m_pObjects->Sort();
+    }
+
+    void CollectPages( const PdfObject* pNode )
+    {
+        size_t nIndex = Find( pNode->Reference() );
+        if( nIndex == m_vecKind.size() || m_vecKind[nIndex] != eLinearizedKind_Unknown )
+            return; // not part of this document or already visited
+
+        const PdfObject* pKids = pNode->GetIndirectKey( "Kids" );
+        if( pKids && pKids->IsArray() ) 
+        {
+            m_vecKind[nIndex] = eLinearizedKind_PagesNode;
+
+            PdfArray::const_iterator it = pKids->GetArray().begin();
+            while( it != pKids->GetArray().end() )
+            {
+                const PdfObject* pKid = (*it).IsReference() ? m_pObjects->GetObject( (*it).GetReference() ) : NULL;
+                if( pKid && pKid->IsDictionary() ) 
+                    CollectPages( pKid );
+
+                ++it;
+            }
+        }
+        else
+        {
+            m_vecKind[nIndex] = eLinearizedKind_Page;
+            m_vecPages.push_back( nIndex );
+        }
+    }
+
+    /** Add an object to the catalog and document level objects section.
+     */
+    void AddDocumentObject( const PdfObject* pObj, bool bWithDependencies )
+    {
+        if( !pObj || !pObj->Reference().IsIndirect() )
+            return;
+
+        size_t nIndex = Find( pObj->Reference() );
+        if( nIndex == m_vecKind.size() || m_vecDocument[nIndex] || m_vecKind[nIndex] != eLinearizedKind_Unknown )
+            return;
+
+        m_vecDocument[nIndex] = true;
+        m_vecDocumentOrder.push_back( nIndex );
+
+        if( bWithDependencies )
+            VisitContents( pObj, -1, false );
+    }
+
+    /** Collect all objects required to display a page,
+     *  i.e. all objects reachable from the page object itself and from
+     *  inheritable attributes of its parents, except for other pages.
+     */
+    void AddPage( int nPage )
+    {
+        const PdfObject* pPage = (*m_pObjects)[m_vecPages[nPage]];
+
+        m_vecPageObjects.resize( nPage + 1 );
+        m_vecPageVisits.resize( nPage + 1 );
+
+        Visit( pPage->Reference(), nPage );
+
+        const PdfObject* pNode = pPage->GetIndirectKey( "Parent" );
+        size_t           nDepth = 0;
+        while( pNode && pNode->IsDictionary() && ++nDepth < m_vecKind.size() )
+        {
+            static const char* aInheritable[] = { "Resources", "MediaBox", "CropBox", "Rotate", NULL };
+            for( int i = 0; aInheritable[i]; i++ )
+            {
+                const PdfObject* pValue = pNode->GetDictionary().GetKey( aInheritable[i] );
+                if( pValue )
+                    VisitVariant( pValue, nPage );
+            }
+
+            if( !nPage ) 
+            {
+                // parents of the first page are written with the first page
+                size_t nIndex = Find( pNode->Reference() );
+                if( nIndex != m_vecKind.size() ) 
+                    m_vecFirstPageNodes.push_back( nIndex );
+            }
+
+            pNode = pNode->GetIndirectKey( "Parent" );
+        }
+    }
+
+    void CreateLayout( NonPublic::PdfLinearizedLayout & rLayout )
+    {
+        const size_t        nCount = m_vecKind.size();
+        std::vector<size_t> vecPosition( nCount, nCount );
+        size_t              i;
+        int                 nPage;
+        int                 nPageCount = static_cast<int>(m_vecPages.size());
+
+        for( i = 0; i < m_vecDocumentOrder.size(); i++ )
+            Place( m_vecDocumentOrder[i], rLayout, vecPosition );
+
+        rLayout.nFirstPage = rLayout.vecObjects.size();
+        rLayout.vecPageStart.push_back( rLayout.nFirstPage );
+        for( i = 0; i < m_vecPageObjects[0].size(); i++ )
+            Place( m_vecPageObjects[0][i], rLayout, vecPosition );
+        for( i = 0; i < m_vecFirstPageNodes.size(); i++ )
+            Place( m_vecFirstPageNodes[i], rLayout, vecPosition );
+
+        rLayout.nPages = rLayout.vecObjects.size();
+        for( nPage = 1; nPage < nPageCount; nPage++ )
+        {
+            rLayout.vecPageStart.push_back( rLayout.vecObjects.size() );
+            for( i = 0; i < m_vecPageObjects[nPage].size(); i++ )
+                if( !m_vecShared[m_vecPageObjects[nPage][i]] )
+                    Place( m_vecPageObjects[nPage][i], rLayout, vecPosition );
+        }
+
+        rLayout.nShared = rLayout.vecObjects.size();
+        for( nPage = 1; nPage < nPageCount; nPage++ )
+            for( i = 0; i < m_vecPageObjects[nPage].size(); i++ )
+                if( m_vecShared[m_vecPageObjects[nPage][i]] )
+                    Place( m_vecPageObjects[nPage][i], rLayout, vecPosition );
+
+        rLayout.nOther = rLayout.vecObjects.size();
+        for( i = 0; i < nCount; i++ )
+            Place( i, rLayout, vecPosition );
+
+        // The shared object hint table lists all objects of the first page
+        // followed by the objects of the shared objects section
+        rLayout.vecPageShared.resize( nPageCount );
+        for( nPage = 1; nPage < nPageCount; nPage++ )
+        {
+            for( i = 0; i < m_vecPageVisits[nPage].size(); i++ )
+            {
+                size_t nPos = vecPosition[m_vecPageVisits[nPage][i]];
+                if( nPos >= rLayout.nFirstPage && nPos < rLayout.nPages )
+                    rLayout.vecPageShared[nPage].push_back( static_cast<pdf_uint32>(nPos - rLayout.nFirstPage) );
+                else if( nPos >= rLayout.nShared && nPos < rLayout.nOther )
+                    rLayout.vecPageShared[nPage].push_back( static_cast<pdf_uint32>(nPos - rLayout.nShared + 
+                                                                                    rLayout.nPages - rLayout.nFirstPage) );
+            }
+        }
+    }
+
+    inline size_t GetPageCount() const
+    {
+        return m_vecPages.size();
+    }
+
+ private:
+    size_t Find( const PdfReference & rRef ) const
+    {
+        TCIVecObjects it = std::lower_bound( m_pObjects->begin(), m_pObjects->end(), rRef, ObjectReferenceLess );
+        if( it != m_pObjects->end() && (*it)->Reference() == rRef )
+            return it - m_pObjects->begin();
+
+        return m_vecKind.size();
+    }
+
+    static bool ObjectReferenceLess( const PdfObject* pObj, const PdfReference & rRef )
+    {
+        return pObj->Reference() < rRef;
+    }
+
+    void Place( size_t nIndex, NonPublic::PdfLinearizedLayout & rLayout, std::vector<size_t> & rPosition ) const
+    {
+        if( rPosition[nIndex] == rPosition.size() )
+        {
+            rPosition[nIndex] = rLayout.vecObjects.size();
+            rLayout.vecObjects.push_back( (*m_pObjects)[nIndex] );
+        }
+    }
+
+    /** Visit a referenced object.
+     *  \param nPage index of the page the object is used by
+     *         or -1 for document level objects
+     */
+    void Visit( const PdfReference & rRef, int nPage )
+    {
+        size_t nIndex = Find( rRef );
+        if( nIndex == m_vecKind.size() || m_vecDocument[nIndex] ||
+            m_vecKind[nIndex] == eLinearizedKind_PagesNode )
+            return;
+
+        if( m_vecKind[nIndex] == eLinearizedKind_Page && 
+            ( nPage < 0 || m_vecPages[nPage] != nIndex ) )
+            return; // pages are never part of another page
+
+        if( nPage < 0 ) 
+        {
+            m_vecDocument[nIndex] = true;
+            m_vecDocumentOrder.push_back( nIndex );
+        }
+        else
+        {
+            if( m_vecVisit[nIndex] == nPage )
+                return;
+
+            m_vecVisit[nIndex] = nPage;
+            m_vecPageVisits[nPage].push_back( nIndex );
+
+            if( m_vecUser[nIndex] == -1 ) 
+            {
+                m_vecUser[nIndex] = nPage;
+                m_vecPageObjects[nPage].push_back( nIndex );
+            }
+            else
+                m_vecShared[nIndex] = true;
+        }
+
+        VisitContents( (*m_pObjects)[nIndex], nPage, m_vecKind[nIndex] == eLinearizedKind_Page );
+    }
+
+    void VisitVariant( const PdfVariant* pVariant, int nPage )
+    {
+        if( pVariant->IsReference() )
+            Visit( pVariant->GetReference(), nPage );
+        else
+            VisitContents( pVariant, nPage, false );
+    }
+
+    void VisitContents( const PdfVariant* pVariant, int nPage, bool bSkipParent )
+    {
+        if( pVariant->IsArray() )
+        {
+            PdfArray::const_iterator it = pVariant->GetArray().begin();
+            while( it != pVariant->GetArray().end() )
+            {
+                if( (*it).IsReference() || (*it).IsArray() || (*it).IsDictionary() )
+                    VisitVariant( &(*it), nPage );
+
+                ++it;
+            }
+        }
+        else if( pVariant->IsDictionary() )
+        {
+            TCIKeyMap it = pVariant->GetDictionary().GetKeys().begin();
+            while( it != pVariant->GetDictionary().GetKeys().end() )
+            {
+                if( !(bSkipParent && (*it).first == "Parent") &&
+                    ( (*it).second->IsReference() || (*it).second->IsArray() || (*it).second->IsDictionary() ) )
+                    VisitVariant( (*it).second, nPage );
+
+                ++it;
+            }
+        }
+    }
+
+ private:
+    PdfVecObjects*      m_pObjects;
+    std::vector<int>    m_vecKind;
+    std::vector<bool>   m_vecDocument;
+    std::vector<int>    m_vecUser;   ///< first page using an object
+    std::vector<int>    m_vecVisit;  ///< last page visiting an object
+    std::vector<bool>   m_vecShared; ///< object is used by more than one page
+
+    std::vector<size_t> m_vecPages;
+    std::vector<size_t> m_vecDocumentOrder;
+    std::vector<size_t> m_vecFirstPageNodes;
+    std::vector<std::vector<size_t> > m_vecPageObjects; ///< objects first used by each page
+    std::vector<std::vector<size_t> > m_vecPageVisits;  ///< all objects used by each page
+};
+
+/** Fills the object streams created by PdfWriter::CreateObjectStreams
+ *  with the objects passed to Add, one object stream after the other.
+ */
+class PdfObjectStreamPacker {
+ public:
+    PdfObjectStreamPacker( const TVecObjects & rvecStreams, pdf_uint32 nSize, EPdfWriteMode eWriteMode )
+        : m_rvecStreams( rvecStreams ), m_nSize( nSize ), m_eWriteMode( eWriteMode ),
+          m_nStream( 0 ), m_nCount( 0 ), m_bFinished( rvecStreams.empty() ),
+          m_header( &m_headerBuffer ), m_data( &m_dataBuffer )
+    {
+    }
+
+    /** Write pObject to the current object stream and add it to pXRef.
+     */
+    void Add( const PdfObject* pObject, PdfXRef* pXRef )
+    {
+        if( m_bFinished || m_nStream >= m_rvecStreams.size() ) 
+        {
+            PODOFO_RAISE_ERROR_INFO( ePdfError_InternalLogic, "No object stream left to write an object to." );
+        }
+
+        PdfObject* pStream = m_rvecStreams[m_nStream];
+        pXRef->AddCompressedObject( pObject->Reference(), pStream->Reference().ObjectNumber(), m_nCount );
+
+        m_header.WriteUInt( pObject->Reference().ObjectNumber() );
+        m_header.Write( " ", 1 );
+        m_header.WriteUInt( static_cast<pdf_uint64>(m_data.Tell()) );
+        m_header.Write( " ", 1 );
+
+        // Objects in object streams are encrypted together with the object stream
+        pObject->Write( &m_data, m_eWriteMode, NULL );
+        m_data.Write( "\n", 1 );
+
+        if( ++m_nCount == m_nSize )
+            this->FinishStream();
+    }
+
+    /** Complete all object streams. No objects can be added afterwards.
+     */
+    void Finish()
+    {
+        while( !m_bFinished && m_nStream < m_rvecStreams.size() ) 
+            this->FinishStream();
+
+        m_bFinished = true;
+    }
+
+    bool IsFinished() const
+    {
+        return m_bFinished;
+    }
+
+ private:
+    void FinishStream()
+    {
+        PdfObject* pStream = m_rvecStreams[m_nStream++];
+        pdf_long   lFirst  = static_cast<pdf_long>(m_header.Tell());
+        pdf_long   lData   = static_cast<pdf_long>(m_data.Tell());
+
+        pStream->GetDictionary().AddKey( "N", static_cast<pdf_int64>(m_nCount) );
+        pStream->GetDictionary().AddKey( "First", static_cast<pdf_int64>(lFirst) );
+
+        pStream->GetStream()->BeginAppend();
+        pStream->GetStream()->Append( m_headerBuffer.GetBuffer(), lFirst );
+        pStream->GetStream()->Append( m_dataBuffer.GetBuffer(), lData );
+        pStream->GetStream()->EndAppend();
+
+        m_header.Seek( 0 );
+        m_data.Seek( 0 );
+        m_nCount = 0;
+    }
+
+ private:
+    const TVecObjects & m_rvecStreams;
+    pdf_uint32          m_nSize;
+    EPdfWriteMode       m_eWriteMode;
+
+    size_t              m_nStream; ///< index of the object stream currently filled
+    pdf_uint32          m_nCount;  ///< number of objects in the current object stream
+    bool                m_bFinished;
+
+    PdfRefCountedBuffer m_headerBuffer;
+    PdfRefCountedBuffer m_dataBuffer;
+    PdfOutputDevice     m_header;  ///< object numbers and offsets of the current object stream
+    PdfOutputDevice     m_data;    ///< objects of the current object stream
+};
+
+/** State shared by all worker threads of PdfWriter::CompressStreams
+ */
+struct TCompressStreamsJob {
+    ~TCompressStreamsJob()
+    {
+        for( size_t i = 0; i < vecErrors.size(); i++ )
+            delete vecErrors[i];
+    }
+
+    std::vector<PdfMemStream*> vecStreams;
+
+    Util::PdfMutex             mutex;
+    size_t                     nNextStream; ///< guarded by mutex
+
+    std::vector<char>          vecDone;     ///< one entry per stream, written by one worker each
+    std::vector<PdfError*>     vecErrors;
+};
+
+/** Entry point of the worker threads of PdfWriter::CompressStreams.
+ *
+ *  The worker compresses one stream after another until all 
+ *  streams are compressed. Streams, which could not be compressed
+ *  for any other reason than a PdfError, are not marked as done so
+ *  that they are compressed again by the calling thread.
+ */
+static void CompressStreamsWorker( void* pData )
+{
+    TCompressStreamsJob* pJob = static_cast<TCompressStreamsJob*>(pData);
+
+    for( ;; )
+    {
+        size_t nStream;
+        {
+            Util::PdfMutexWrapper wrapper( pJob->mutex );
+            nStream = pJob->nNextStream++;
+        }
+
+        if( nStream >= pJob->vecStreams.size() )
+            break;
+
+        try {
+            pJob->vecStreams[nStream]->FlateCompress();
+            pJob->vecDone[nStream] = 1;
+        } catch( PdfError & rError ) {
+            try {
+                pJob->vecErrors[nStream] = new PdfError( rError );
+                pJob->vecDone[nStream]   = 1;
+            } catch( ... ) {
+            }
+        } catch( ... ) {
+        }
+    }
+}
+
+};
+
+
 PdfWriter::PdfWriter( PdfParser* pParser )
-    : m_bXRefStream( false ), m_pEncrypt( NULL ), 
+    : m_bXRefStream( false ), m_nObjectStreamSize( 0 ), m_pEncrypt( NULL ), 
       m_pEncryptObj( NULL ), 
       m_eWriteMode( ePdfWriteMode_Compact ),
       m_lPrevXRefOffset( 0 ),
       m_bIncrementalUpdate( false ),
-      m_bLinearized( false ), m_lFirstInXRef( 0 ),
-      m_lLinearizedOffset(0),
-      m_lLinearizedLastOffset(0),
-      m_lTrailerOffset(0)
+      m_bLinearized( false ),
+      m_bCompressStreams( false )
 {
     if( !(pParser && pParser->GetTrailer()) )
     {
@@ -77,15 +555,13 @@ PdfWriter::PdfWriter( PdfParser* pParser )
 }
 
 PdfWriter::PdfWriter( PdfVecObjects* pVecObjects, const PdfObject* pTrailer )
-    : m_bXRefStream( false ), m_pEncrypt( NULL ), 
+    : m_bXRefStream( false ), m_nObjectStreamSize( 0 ), m_pEncrypt( NULL ), 
       m_pEncryptObj( NULL ), 
       m_eWriteMode( ePdfWriteMode_Compact ),
       m_lPrevXRefOffset( 0 ),
       m_bIncrementalUpdate( false ),
-      m_bLinearized( false ), m_lFirstInXRef( 0 ),
-      m_lLinearizedOffset(0),
-      m_lLinearizedLastOffset(0),
-      m_lTrailerOffset(0)
+      m_bLinearized( false ),
+      m_bCompressStreams( false )
 {
     if( !pVecObjects || !pTrailer )
     {
@@ -98,15 +574,13 @@ PdfWriter::PdfWriter( PdfVecObjects* pVecObjects, const PdfObject* pTrailer )
 }
 
 PdfWriter::PdfWriter( PdfVecObjects* pVecObjects )
-    : m_bXRefStream( false ), m_pEncrypt( NULL ), 
+    : m_bXRefStream( false ), m_nObjectStreamSize( 0 ), m_pEncrypt( NULL ), 
       m_pEncryptObj( NULL ), 
       m_eWriteMode( ePdfWriteMode_Compact ),
       m_lPrevXRefOffset( 0 ),
       m_bIncrementalUpdate( false ),
-      m_bLinearized( false ), m_lFirstInXRef( 0 ),
-      m_lLinearizedOffset(0),
-      m_lLinearizedLastOffset(0),
-      m_lTrailerOffset(0)
+      m_bLinearized( false ),
+      m_bCompressStreams( false )
 {
     m_eVersion     = ePdfVersion_Default;
     m_pTrailer     = new PdfObject();
@@ -162,6 +636,9 @@ void PdfWriter::Write( PdfOutputDevice* pDevice, bool bRewriteXRefTable )
         m_pEncrypt->CreateEncryptionDictionary( m_pEncryptObj->GetDictionary() );
     }
 
+    if( m_bCompressStreams )
+        this->CompressStreams();
+
     if( m_bLinearized ) 
     {
         if( m_bIncrementalUpdate )
@@ -171,9 +648,16 @@ void PdfWriter::Write( PdfOutputDevice* pDevice, bool bRewriteXRefTable )
     }
     else
     {
-        PdfXRef* pXRef = m_bXRefStream ? new PdfXRefStream( m_vecObjects, this ) : new PdfXRef();
+        PdfXRef* pXRef = NULL;
 
         try {
+            // The XRef stream is created last and deleted first,
+            // so that the object numbers of both are given back
+            if( m_bXRefStream && m_nObjectStreamSize && !m_bIncrementalUpdate )
+                this->CreateObjectStreams();
+
+            pXRef = m_bXRefStream ? new PdfXRefStream( m_vecObjects, this ) : new PdfXRef();
+
             if( !m_bIncrementalUpdate )
                 WritePdfHeader( pDevice );
 
@@ -198,9 +682,11 @@ void PdfWriter::Write( PdfOutputDevice* pDevice, bool bRewriteXRefTable )
             
             pDevice->Print( "startxref\n%" PDF_FORMAT_UINT64 "\n%%%%EOF\n", pXRef->GetOffset() );
             delete pXRef;
+            this->RemoveObjectStreams();
         } catch( PdfError & e ) {
             // Make sure pXRef is always deleted
             delete pXRef;
+            this->RemoveObjectStreams();
             
             // P.Zent: Delete Encryption dictionary (cannot be reused)
             if(m_pEncryptObj) {
@@ -271,83 +757,271 @@ void PdfWriter::WriteUpdate( PdfOutputDevice* pDevice, PdfInputDevice* pSourceIn
     this->Write (pDevice, bRewriteXRefTable );
 }
 
-void PdfWriter::WriteLinearized( PdfOutputDevice* /* pDevice */ )
+void PdfWriter::WriteLinearized( PdfOutputDevice* pDevice )
 {
-    PODOFO_RAISE_ERROR( ePdfError_NotImplemented );
+    NonPublic::PdfLinearizedLayout layout;
+    TPdfReferenceList              lstNew( m_vecObjects->GetSize() );
+    TPdfReferenceList              lstOld;
+    TPdfReferenceList              lstLinearized;
+
+    // Objects cannot be loaded from the source file anymore
+    // once they were renumbered, so load all of them now.
+    TCIVecObjects it = m_vecObjects->begin();
+    while( it != m_vecObjects->end() )
+    {
+        (*it)->DelayedStreamLoad();
+        ++it;
+    }
 
-    /*
-    PdfObject*      pLinearize  = NULL;
-    PdfPage*        pPage;
-    PdfObject*      pLast;
-    NonPublic::PdfHintStream*  pHint;
-    PdfOutputDevice length;
-    TVecXRefTable   vecXRef;
-    TVecXRefOffset  vecXRefOffset;
-    TIVecOffsets    it;
+    this->CreateLinearizedLayout( layout );
 
-    // prepare the document for linearization
-    this->FetchPagesTree();
-    pPage = m_pPagesTree->GetPage( 0 );
-    
-    pLinearize = CreateLinearizationDictionary();
-    pHint      = new NonPublic::PdfHintStream( m_vecObjects, m_pPagesTree );
-    
-    this->ReorderObjectsLinearized( pLinearize, pHint, pPage, &pLast );
+    // Objects of the first page section get the highest numbers, starting with
+    // the linearization dictionary, followed by the document level objects,
+    // the hint stream and the objects of the first page.
+    const size_t nMain = layout.vecObjects.size() - layout.nPages;
+    for( size_t i = 0; i < layout.vecObjects.size(); i++ )
+    {
+        size_t nNumber;
+        if( i >= layout.nPages )
+            nNumber = i - layout.nPages + 1;
+        else if( i < layout.nFirstPage )
+            nNumber = nMain + 2 + i;
+        else
+            nNumber = nMain + 3 + i;
 
-    // The file is prepared for linearization,
-    // so write it now.
-    WritePdfHeader( pDevice );
+        lstNew[m_vecObjects->GetIndex( layout.vecObjects[i]->Reference() )] = 
+            PdfReference( static_cast<pdf_objnum>(nNumber), 0 );
+    }
 
-    m_lLinearizedOffset = pDevice->GetLength();
-    pLinearize->WriteObject( pDevice );
+    PdfVecObjects              vecLinearized;
+    PdfObject*                 pLinearize = vecLinearized.CreateObject();
+    NonPublic::PdfHintStream   hint( &vecLinearized );
 
-    // fill the XRef table with the objects
+    lstLinearized.push_back( PdfReference( static_cast<pdf_objnum>(nMain + 1), 0 ) );
+    lstLinearized.push_back( PdfReference( static_cast<pdf_objnum>(nMain + 2 + layout.nFirstPage), 0 ) );
+    vecLinearized.AssignObjectNumbers( lstLinearized, NULL );
+
+    // The placeholders are overwritten with the real values
+    // before the file is written for the second time
+    PdfVariant placeholder( static_cast<pdf_int64>(LINEARIZATION_PLACEHOLDER) );
+    PdfArray   hints;
+    hints.push_back( placeholder );
+    hints.push_back( placeholder );
+
+    pLinearize->GetDictionary().AddKey( "Linearized", 1.0 );  // Version
+    pLinearize->GetDictionary().AddKey( "L", placeholder );   // File length
+    pLinearize->GetDictionary().AddKey( "H", hints );         // Hint stream offset and length
+    pLinearize->GetDictionary().AddKey( "O", placeholder );   // Object number of the first page
+    pLinearize->GetDictionary().AddKey( "E", placeholder );   // Offset of end of first page
+    pLinearize->GetDictionary().AddKey( "N",                  // Number of pages in the document 
+                                        static_cast<pdf_int64>(layout.vecPageStart.size()) );
+    pLinearize->GetDictionary().AddKey( "T", placeholder );   // Offset of first entry in main XRef table
+
+    m_vecObjects->AssignObjectNumbers( lstNew, m_pTrailer, &lstOld );
+
+    try {
+        // First pass: calculate all offsets as if there was no hint stream
+        PdfOutputDevice length;
+
+        layout.lBase = pDevice->Tell();
+        WriteLinearizedPass( &length, layout, pLinearize, hint.GetObject() );
+
+        NonPublic::TVecHintPages vecPages( layout.vecPageStart.size() );
+        for( size_t i = 0; i < vecPages.size(); i++ ) 
+        {
+            size_t nEnd = !i ? layout.nPages : 
+                ( i + 1 < vecPages.size() ? layout.vecPageStart[i+1] : layout.nShared );
+
+            vecPages[i].nObjects         = static_cast<pdf_uint32>(nEnd - layout.vecPageStart[i]);
+            vecPages[i].lLength          = layout.vecOffsets[nEnd] - layout.vecOffsets[layout.vecPageStart[i]];
+            vecPages[i].vecSharedObjects = layout.vecPageShared[i];
+        }
+
+        std::vector<pdf_uint64> vecShared;
+        for( size_t i = layout.nFirstPage; i < layout.nPages; i++ ) 
+            vecShared.push_back( layout.vecOffsets[i+1] - layout.vecOffsets[i] );
+        for( size_t i = layout.nShared; i < layout.nOther; i++ ) 
+            vecShared.push_back( layout.vecOffsets[i+1] - layout.vecOffsets[i] );
+
+        bool bShared = layout.nShared < layout.nOther;
+        hint.CreatePageHintTable( vecPages, layout.vecOffsets[layout.nFirstPage] );
+        hint.CreateSharedObjectHintTable( vecShared, static_cast<pdf_uint32>(layout.nPages - layout.nFirstPage), 
+                                          bShared ? layout.vecObjects[layout.nShared]->Reference().ObjectNumber() : 0,
+                                          bShared ? layout.vecOffsets[layout.nShared] : 0 );
+
+        PdfOutputDevice hintLength;
+        hint.GetObject()->WriteObject( &hintLength, m_eWriteMode, m_pEncrypt );
+        layout.lHintLength = hintLength.GetLength();
+
+        // Fill the linearization dictionary: The subsection header of the main XRef
+        // table is followed by the whitespace in front of its first entry.
+        char szSubSection[32];
+        snprintf( szSubSection, sizeof(szSubSection), "xref\n0 %u", static_cast<unsigned int>(nMain + 1) );
+
+        hints.clear();
+        hints.push_back( PdfVariant( static_cast<pdf_int64>(layout.lHint) ) );
+        hints.push_back( PdfVariant( static_cast<pdf_int64>(layout.lHintLength) ) );
+
+        pLinearize->GetDictionary().AddKey( "L", static_cast<pdf_int64>(layout.lFileEnd + layout.lHintLength) );
+        pLinearize->GetDictionary().AddKey( "H", hints );
+        pLinearize->GetDictionary().AddKey( "O", static_cast<pdf_int64>(
+                                                layout.vecObjects[layout.nFirstPage]->Reference().ObjectNumber()) );
+        pLinearize->GetDictionary().AddKey( "E", static_cast<pdf_int64>(layout.GetOffset( layout.nPages )) );
+        pLinearize->GetDictionary().AddKey( "T", static_cast<pdf_int64>(layout.lMainXRef + layout.lHintLength + 
+                                                                        strlen( szSubSection )) );
+
+        // Second pass: write the file
+        WriteLinearizedPass( pDevice, layout, pLinearize, hint.GetObject() );
+    } catch( PdfError & e ) {
+        m_vecObjects->AssignObjectNumbers( lstOld, m_pTrailer );
+
+        e.AddToCallstack( __FILE__, __LINE__ );
+        throw e;
+    }
+
+    m_vecObjects->AssignObjectNumbers( lstOld, m_pTrailer );
+}
+
+void PdfWriter::CreateLinearizedLayout( NonPublic::PdfLinearizedLayout & rLayout )
+{
+    const PdfObject* pRoot = m_pTrailer->GetDictionary().GetKey( "Root" );
+    if( !pRoot || !pRoot->IsReference() )
     {
-        // Use nested scope and stack local for PdfOutputDevice
-        // rather than using a temporary to stop gcc's whining.
-        PdfOutputDevice o;
-        WritePdfObjects(&o, m_vecLinearized, &vecXRef );
+        PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDataType, "The trailer has no reference to the catalog." );
     }
 
-    // prepend the linearization dictionary to the XRef table
-    TXRefEntry entry;
-    entry.lOffset     = m_lLinearizedOffset;
-    entry.lGeneration = pLinearize->Reference().GenerationNumber();
-    entry.cUsed       = 'n';
-    
-    vecXRef[0].nCount++;
-    vecXRef[0].nFirst--; 
-    vecXRef[0].vecOffsets.insert( vecXRef[0].vecOffsets.begin(), entry );
+    PdfObject* pCatalog = m_vecObjects->MustGetObject( pRoot->GetReference() );
+    PdfObject* pPages   = pCatalog->GetIndirectKey( "Pages" );
 
-    // Calculate the length of the xref table
-    WritePdfTableOfContents( &vecXRef, &length, &vecXRefOffset, true, false );
-    
-    it = vecXRef[0].vecOffsets.begin(); 
-    it++; // skip the linearization dictionary, as it was written before the XRef table
-          // and does already have a correct offset
-    while( it != vecXRef[0].vecOffsets.end() )
+    PdfLinearizedObjectSorter sorter( m_vecObjects );
+    if( pPages )
+        sorter.CollectPages( pPages );
+
+    if( !sorter.GetPageCount() ) 
     {
-        (*it).lOffset += pDevice->GetLength() + length.GetLength();
-        m_lLinearizedLastOffset = (*it).lOffset;
-        ++it;
+        PODOFO_RAISE_ERROR_INFO( ePdfError_PageNotFound, "A linearized PDF file requires at least one page." );
     }
-    
-    vecXRefOffset.clear();
-    WritePdfTableOfContents( &vecXRef, pDevice, &vecXRefOffset, true, false );
-    vecXRef.clear();
 
-    WritePdfObjects( pDevice, m_vecLinearized, &vecXRef );
-    vecXRef.clear();
+    // The catalog and the objects required to open the document
+    sorter.AddDocumentObject( pCatalog, false );
+    sorter.AddDocumentObject( pCatalog->GetIndirectKey( "ViewerPreferences" ), true );
+    sorter.AddDocumentObject( pCatalog->GetIndirectKey( "OpenAction" ), true );
+    sorter.AddDocumentObject( pCatalog->GetIndirectKey( "Threads" ), false );
+    sorter.AddDocumentObject( pCatalog->GetIndirectKey( "AcroForm" ), false );
+    if( pCatalog->GetIndirectKeyAsName( "PageMode" ) == PdfName( "UseOutlines" ) )
+        sorter.AddDocumentObject( pCatalog->GetIndirectKey( "Outlines" ), true );
+    sorter.AddDocumentObject( m_pEncryptObj, false );
+
+    for( size_t i = 0; i < sorter.GetPageCount(); i++ )
+        sorter.AddPage( static_cast<int>(i) );
+
+    sorter.CreateLayout( rLayout );
+}
+
+void PdfWriter::WriteLinearizedPass( PdfOutputDevice* pDevice, NonPublic::PdfLinearizedLayout & rLayout,
+                                     PdfObject* pLinearize, PdfObject* pHint )
+{
+    // The first pass writes to a device which starts at offset 0
+    // and calculates the offsets without the hint stream
+    const bool       bFirstPass = (rLayout.lHintLength == 0);
+    const pdf_uint64 lAdjust    = bFirstPass ? rLayout.lBase : 0;
+    const size_t     nObjects   = rLayout.vecObjects.size();
+    size_t           i;
+
+    if( bFirstPass )
+        rLayout.vecOffsets.resize( nObjects + 1 );
+    
+    WritePdfHeader( pDevice );
 
-    WritePdfObjects( pDevice, *m_vecObjects, &vecXRef );
+    const pdf_uint64 lLinearize = pDevice->Tell() + lAdjust;
+    pLinearize->WriteObject( pDevice, m_eWriteMode, NULL );
 
-    if( m_bXRefStream )
-        WriteXRefStream( &vecXRef, pDevice );
+    // The linearization dictionary and the first page trailer
+    // are padded to the size they have with placeholder values
+    if( bFirstPass )
+        rLayout.lLinearizeEnd = pDevice->Tell() + lAdjust;
+    else
+        while( pDevice->Tell() < rLayout.lLinearizeEnd )
+            pDevice->Write( " ", 1 );
+
+    // First page XRef table
+    PdfXRef xrefFirstPage;
+    xrefFirstPage.AddObject( pLinearize->Reference(), lLinearize, true );
+    xrefFirstPage.AddObject( pHint->Reference(), bFirstPass ? 0 : rLayout.lHint, true );
+    for( i = 0; i < rLayout.nPages; i++ ) 
+        xrefFirstPage.AddObject( rLayout.vecObjects[i]->Reference(), bFirstPass ? 0 : rLayout.GetOffset( i ), true );
+
+    rLayout.lFirstXRef = pDevice->Tell() + lAdjust;
+    xrefFirstPage.Write( pDevice );
+
+    PdfObject trailer;
+    FillTrailerObject( &trailer, xrefFirstPage.GetSize(), false );
+    trailer.GetDictionary().AddKey( "Prev", static_cast<pdf_int64>(bFirstPass ? LINEARIZATION_PLACEHOLDER : 
+                                                                   rLayout.lMainXRef + rLayout.lHintLength) );
+
+    pDevice->Print( "trailer\n" );
+    trailer.WriteObject( pDevice, m_eWriteMode, NULL ); // Do not encrypt the trailer dictionary!!!
+    pDevice->Print( "startxref\n0\n%%%%EOF\n" );
+
+    if( bFirstPass )
+        rLayout.lTrailerEnd = pDevice->Tell() + lAdjust;
     else
-        WritePdfTableOfContents( &vecXRef, pDevice, &vecXRefOffset, false, m_bLinearized );
+        while( pDevice->Tell() < rLayout.lTrailerEnd )
+            pDevice->Write( " ", 1 );
+
+    // Objects
+    PdfXRef xrefMain;
+    for( i = 0; i < nObjects; i++ ) 
+    {
+        PdfObject* pObject = rLayout.vecObjects[i];
+
+        if( i == rLayout.nFirstPage )
+        {
+            rLayout.lHint = pDevice->Tell() + lAdjust;
+            if( !bFirstPass )
+                pHint->WriteObject( pDevice, m_eWriteMode, m_pEncrypt );
+        }
+
+        if( bFirstPass )
+            rLayout.vecOffsets[i] = pDevice->Tell() + lAdjust;
+        else if( pDevice->Tell() != rLayout.GetOffset( i ) )
+        {
+            PODOFO_RAISE_ERROR_INFO( ePdfError_InternalLogic, "Object offsets differ between the passes of linearization." );
+        }
+
+        if( i >= rLayout.nPages )
+            xrefMain.AddObject( pObject->Reference(), pDevice->Tell() + lAdjust, true );
+
+        // Make sure that we do not encrypt the encryption dictionary!
+        pObject->WriteObject( pDevice, m_eWriteMode, 
+                              (pObject == m_pEncryptObj ? NULL : m_pEncrypt) );
+    }
+
+    if( bFirstPass )
+        rLayout.vecOffsets[nObjects] = pDevice->Tell() + lAdjust;
+
+    // Main XRef table
+    if( rLayout.nPages == nObjects )
+        xrefMain.SetFirstEmptyBlock();
+
+    if( bFirstPass )
+        rLayout.lMainXRef = pDevice->Tell() + lAdjust;
+    else if( pDevice->Tell() != rLayout.lMainXRef + rLayout.lHintLength )
+    {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_InternalLogic, "XRef offsets differ between the passes of linearization." );
+    }
+
+    xrefMain.Write( pDevice );
 
-    this->FillLinearizationDictionary( pLinearize, pDevice, pPage, pLast, pHint, &vecXRefOffset );
-    */
+    PdfObject trailerMain;
+    FillTrailerObject( &trailerMain, xrefMain.GetSize(), true );
+
+    pDevice->Print( "trailer\n" );
+    trailerMain.WriteObject( pDevice, m_eWriteMode, NULL );
+    pDevice->Print( "startxref\n%" PDF_FORMAT_UINT64 "\n%%%%EOF\n", rLayout.lFirstXRef );
+
+    if( bFirstPass )
+        rLayout.lFileEnd = pDevice->Tell() + lAdjust;
 }
 
 void PdfWriter::WritePdfHeader( PdfOutputDevice* pDevice )
@@ -358,6 +1032,7 @@ void PdfWriter::WritePdfHeader( PdfOutputDevice* pDevice )
 void PdfWriter::WritePdfObjects( PdfOutputDevice* pDevice, const PdfVecObjects& vecObjects, PdfXRef* pXref, bool bRewriteXRefTable )
 {
     TCIVecObjects itObjects, itObjectsEnd = vecObjects.end();
+    PdfObjectStreamPacker packer( m_vecObjectStreams, m_nObjectStreamSize, m_eWriteMode );
 
     for( itObjects = vecObjects.begin(); itObjects !=  itObjectsEnd; ++itObjects )
     {
@@ -388,6 +1063,12 @@ void PdfWriter::WritePdfObjects( PdfOutputDevice* pDevice, const PdfVecObjects&
             }
         }
 
+        if( !packer.IsFinished() && this->IsObjectStreamCandidate( pObject ) )
+        {
+            packer.Add( pObject, pXref );
+            continue;
+        }
+
         pXref->AddObject( pObject->Reference(), pDevice->Tell(), true );
 
         // Make sure that we do not encrypt the encryption dictionary!
@@ -395,6 +1076,14 @@ void PdfWriter::WritePdfObjects( PdfOutputDevice* pDevice, const PdfVecObjects&
                               (pObject == m_pEncryptObj ? NULL : m_pEncrypt) );
     }
 
+    // The object streams follow all objects packed into them
+    packer.Finish();
+    for( itObjects = m_vecObjectStreams.begin(); itObjects != m_vecObjectStreams.end(); ++itObjects )
+    {
+        pXref->AddObject( (*itObjects)->Reference(), pDevice->Tell(), true );
+        (*itObjects)->WriteObject( pDevice, m_eWriteMode, m_pEncrypt );
+    }
+
     TCIPdfReferenceList itFree, itFreeEnd = vecObjects.GetFreeObjects().end();
     for( itFree = vecObjects.GetFreeObjects().begin(); itFree != itFreeEnd; ++itFree )
     {
@@ -402,6 +1091,117 @@ void PdfWriter::WritePdfObjects( PdfOutputDevice* pDevice, const PdfVecObjects&
     }
 }
 
+void PdfWriter::CreateObjectStreams()
+{
+    size_t nCount = 0;
+    for( TCIVecObjects it = m_vecObjects->begin(); it != m_vecObjects->end(); ++it )
+    {
+        if( this->IsObjectStreamCandidate( *it ) )
+            ++nCount;
+    }
+
+    // The object streams are written by WritePdfObjects after all other
+    // objects, so they are not kept in m_vecObjects, which only reserves
+    // new object numbers with generation 0 for them
+    size_t nStreams = (nCount + m_nObjectStreamSize - 1) / m_nObjectStreamSize;
+    for( size_t i = 0; i < nStreams; i++ ) 
+    {
+        m_vecObjectStreams.push_back( m_vecObjects->CreateUnlistedObject( "ObjStm" ) );
+    }
+}
+
+void PdfWriter::RemoveObjectStreams()
+{
+    // Reverse order gives back all of the reserved object numbers
+    TVecObjects::const_reverse_iterator it;
+    for( it = m_vecObjectStreams.rbegin(); it != m_vecObjectStreams.rend(); ++it )
+        m_vecObjects->DeleteUnlistedObject( *it );
+
+    m_vecObjectStreams.clear();
+}
+
+bool PdfWriter::IsObjectStreamCandidate( const PdfObject* pObject ) const
+{
+    // Streams, objects with a generation number other than zero
+    // and the encryption dictionary cannot be stored in object
+    // streams (see section 7.5.7 of the PDF specification)
+    return pObject != m_pEncryptObj && pObject->Reference().GenerationNumber() == 0 && !pObject->HasStream();
+}
+
+void PdfWriter::CompressStreams()
+{
+    TCompressStreamsJob job;
+    job.nNextStream = 0;
+
+    // Select the streams on the calling thread, as objects and
+    // streams of a parsed document are loaded here on demand
+    for( TCIVecObjects it = m_vecObjects->begin(); it != m_vecObjects->end(); ++it )
+    {
+        if( IsCompressStreamCandidate( *it ) )
+            job.vecStreams.push_back( static_cast<PdfMemStream*>((*it)->GetStream()) );
+    }
+
+    job.vecDone.resize( job.vecStreams.size(), 0 );
+    job.vecErrors.resize( job.vecStreams.size(), NULL );
+
+    int nThreads = s_nThreadCount > 0 ? s_nThreadCount : Util::PdfThread::GetProcessorCount();
+
+    // Never start more threads than there are streams
+    nThreads = static_cast<int>(PODOFO_MIN( static_cast<size_t>(nThreads), job.vecStreams.size() ));
+
+    // The calling thread compresses, too.
+    std::vector<Util::PdfThread*> vecThreads;
+    try {
+        for( int i = 1; i < nThreads; i++ )
+        {
+            Util::PdfThread* pThread = new Util::PdfThread();
+            vecThreads.push_back( pThread );
+            pThread->Start( &CompressStreamsWorker, &job );
+        }
+    } catch( ... ) {
+        // Continue with the threads that could be started
+    }
+
+    CompressStreamsWorker( &job );
+
+    // Deleting a thread waits for it to finish
+    for( size_t i = 0; i < vecThreads.size(); i++ )
+        delete vecThreads[i];
+
+    for( size_t i = 0; i < job.vecStreams.size(); i++ )
+    {
+        if( job.vecErrors[i] )
+        {
+            PdfError error( *job.vecErrors[i] );
+            throw error;
+        }
+        else if( !job.vecDone[i] )
+        {
+            // The worker failed for other reasons than a PdfError
+            job.vecStreams[i]->FlateCompress();
+        }
+    }
+}
+
+bool PdfWriter::IsCompressStreamCandidate( PdfObject* pObject ) const
+{
+    if( !pObject->HasStream() || (m_bIncrementalUpdate && !pObject->IsDirty()) )
+        return false;
+
+    // Only streams in memory can be compressed in place
+    PdfMemStream* pStream = dynamic_cast<PdfMemStream*>(pObject->GetStream());
+    if( !pStream || !pStream->GetLength() )
+        return false;
+
+    const PdfDictionary & rDict = pObject->GetDictionary();
+    if( rDict.HasKey( PdfName::KeyFilter ) )
+        return false;
+
+    // XMP metadata has to stay readable by tools that do not know PDF
+    const PdfObject* pType = rDict.GetKey( PdfName::KeyType );
+    return !(pType && pType->IsName() && pType->GetName() == PdfName( "Metadata" ));
+}
+
 void PdfWriter::GetByteOffset( PdfObject* pObject, pdf_long* pulOffset )
 {
     TCIVecObjects   it     = m_vecObjects->begin();
@@ -448,123 +1248,17 @@ void PdfWriter::WriteToBuffer( char** ppBuffer, pdf_long* pulLen )
     this->Write( &memDevice );
 }
 
-/*
-PdfObject* PdfWriter::CreateLinearizationDictionary()
-{
-    PdfObject*       pLinearize        = m_vecObjects->CreateObject();
-
-    // This will be overwritten later with valid data!
-    PdfVariant place_holder( PdfData( LINEARIZATION_PADDING ) );
-
-    PdfArray array;
-    array.push_back( place_holder );
-    array.push_back( place_holder );
-
-    pLinearize->GetDictionary().AddKey( "Linearized", 1.0 );  // Version
-    pLinearize->GetDictionary().AddKey( "L", place_holder );  // File length
-    pLinearize->GetDictionary().AddKey( "H", array );         // Hint stream offset and length as PdfArray
-    pLinearize->GetDictionary().AddKey( "E", place_holder );  // Offset of end of first page
-    pLinearize->GetDictionary().AddKey( "N",                  // Number of pages in the document 
-                                        static_cast<pdf_int64>(m_pPagesTree->GetTotalNumberOfPages()) );             
-    pLinearize->GetDictionary().AddKey( "O", place_holder );  // Object number of the first page
-    pLinearize->GetDictionary().AddKey( "T", place_holder );  // Offset of first entry in main cross reference table
-
-    return pLinearize;
-    }*/
-
-/*
-void PdfWriter::ReorderObjectsLinearized( PdfObject* pLinearize, NonPublic::PdfHintStream* pHint, PdfPage* pPage, PdfObject** ppLast ) 
+void PdfWriter::SetObjectStreamSize( pdf_uint32 nObjects )
 {
-    TPdfReferenceList   lstLinearizedGroup;
-    TPdfReferenceSet    setLinearizedGroup;
-    TCIPdfReferenceList it;
-    TIVecObjects        itObjects;
-    PdfObject*          pRoot;
-    PdfObject*          pTmp = NULL;
-    size_t        index, i;
-
-    // get the dependend objects that are required to display
-    // the first page. I.e. get all objects that have to be written
-    // at the start of the file.
-    // Add all depencies to lstLinearizedGroup
-    m_vecObjects->GetObjectDependencies( pPage->GetObject(), &lstLinearizedGroup );
-
-    // get the root dictionary, it has to be written at the top of the file too.
-    pRoot = m_vecObjects->GetObject( m_pTrailer->GetDictionary().GetKey( "Root" )->GetReference() );
-    // add the root dictionary
-    lstLinearizedGroup.push_back( pRoot->Reference() );
-    // add the first page itself
-    lstLinearizedGroup.push_back( pPage->GetObject()->Reference() );
-
-    // add several dependencies of the root dictionary
-    this->FindCatalogDependencies( pRoot, "ViewerPreferences", &lstLinearizedGroup, true );
-    this->FindCatalogDependencies( pRoot, "PageMode", &lstLinearizedGroup, true );
-    this->FindCatalogDependencies( pRoot, "Threads", &lstLinearizedGroup, false );
-    this->FindCatalogDependencies( pRoot, "OpenAction", &lstLinearizedGroup, true );
-    this->FindCatalogDependencies( pRoot, "AcroForm", &lstLinearizedGroup, false );
-    this->FindCatalogDependencies( pRoot, "Encrypt", &lstLinearizedGroup, true );
-
-    // add the hint stream
-    lstLinearizedGroup.push_back( pHint->GetObject()->Reference() );
-    // add the linearization dictionary
-    lstLinearizedGroup.push_back( pLinearize->Reference() );
-
-
-    // move all objects which are required to display the first page
-    // at the front of the vector of objects.
-    // We only swap objects inside of the vector to avoid reallocations.
-    // This is a fast operation therefore
-    i  = m_vecObjects->GetSize()-1;
-    it = lstLinearizedGroup.begin();
-
-    while( it != lstLinearizedGroup.end() )
-    {
-        index = m_vecObjects->GetIndex( *it );
-
-        if( index < i ) 
-        {
-            pTmp                   = (*m_vecObjects)[index];
-            (*m_vecObjects)[index] = (*m_vecObjects)[i];
-            (*m_vecObjects)[i]     = pTmp;
-        }
-
-        i--;
-        ++it;
-    }
-
-    // Renumber all objects according to their position in the vector.
-    // This is the slowest (only slow) operation when creating a 
-    // linearized PDF file. Garbage collection goes along with this step.
-    std::copy( lstLinearizedGroup.begin(), lstLinearizedGroup.end(), std::inserter(setLinearizedGroup, setLinearizedGroup.begin()) );
-    m_vecObjects->RenumberObjects( m_pTrailer, &setLinearizedGroup );
-
-    // reorder the objects in the file
-    itObjects = m_vecObjects->begin();
-    itObjects += m_vecObjects->GetSize() - setLinearizedGroup.size();
-    m_vecObjects->RemoveObject( itObjects );
-
-    while( itObjects != m_vecObjects->end() )
+    if( nObjects > 0xffff )
     {
-        m_vecLinearized.push_back( *itObjects );
-        // reset the owner
-        (*itObjects)->SetOwner( m_vecObjects );
-        m_vecObjects->RemoveObject( itObjects ); 
+        PODOFO_RAISE_ERROR_INFO( ePdfError_ValueOutOfRange, "At most 65535 objects can be written to an object stream." );
     }
-    
-    *ppLast = m_vecLinearized.GetBack();
-    }*/
 
- /*
-void PdfWriter::FindCatalogDependencies( PdfObject* pCatalog, const PdfName & rName, TPdfReferenceList* pList, bool bWithDependencies )
-{
-    if( pCatalog->GetDictionary().HasKey( rName ) && pCatalog->GetDictionary().GetKey( rName )->IsReference() )
-    {
-        if( bWithDependencies )
-            m_vecObjects->GetObjectDependencies( pCatalog->GetIndirectKey( rName ), pList );
-        else
-            pList->push_back( pCatalog->GetIndirectKey( rName )->Reference() );
-    }
-    }*/
+    m_nObjectStreamSize = nObjects;
+    if( nObjects )
+        this->SetUseXRefStream( true );
+}
 
 void PdfWriter::FillTrailerObject( PdfObject* pTrailer, pdf_long lSize, bool bOnlySizeKey ) const
 {
@@ -611,71 +1305,6 @@ void PdfWriter::FillTrailerObject( PdfObject* pTrailer, pdf_long lSize, bool bOn
     }
 }
 
-/*
-void PdfWriter::FetchPagesTree() 
-{
-    if( !m_pPagesTree )
-    {
-        // try to find the pages tree
-        PdfObject* pRoot = m_pTrailer->GetDictionary().GetKey( "Root" );
-
-        if( !pRoot || !pRoot->IsReference() )
-        {
-            PODOFO_RAISE_ERROR( ePdfError_InvalidDataType );
-        }
-
-        //printf("Fetching: %lu\n", pRoot->GetReference().ObjectNumber() );
-        //printf("Size    : %i\n", static_cast<int>(m_vecObjects->GetSize()) );
-        pRoot            = m_vecObjects->GetObject( pRoot->GetReference() );
-        if( !pRoot ) 
-        {
-            PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
-        }
-
-        m_pPagesTree     = new PdfPagesTree( pRoot->GetIndirectKey( "Pages" ) );
-    }
-}
-*/
-
-/*
-void PdfWriter::FillLinearizationDictionary( PdfObject* pLinearize, PdfOutputDevice* pDevice, PdfPage* pPage, PdfObject* pLast, 
-NonPublic::PdfHintStream* pHint, TVecXRefOffset* pVecXRefOffset )
-{
-    long            lFileSize        = pDevice->GetLength();
-    PdfVariant      value( 0l );
-    PdfArray        hints;
-    PdfObject       trailer;
-
-    value.SetPaddingLength( LINEARIZATION_PADDING );
-
-    value.SetNumber( lFileSize );
-    pLinearize->GetDictionary().AddKey( "L", value );
-    value.SetNumber( pPage->GetObject()->Reference().ObjectNumber() );
-    pLinearize->GetDictionary().AddKey( "O", value );
-    value.SetNumber( m_lFirstInXRef );
-    pLinearize->GetDictionary().AddKey( "T", value );
-    value.SetNumber( m_lLinearizedLastOffset + pLast->GetObjectLength() );
-    pLinearize->GetDictionary().AddKey( "E", value );
-
-    value.SetNumber( m_lLinearizedOffset + pLinearize->GetObjectLength() );
-    hints.push_back( value );
-    value.SetNumber( pHint->GetObject()->GetObjectLength() );
-    hints.push_back( value );
-    pLinearize->GetDictionary().AddKey( "H", hints );
-
-    pDevice->Seek( m_lLinearizedOffset );
-    pLinearize->WriteObject( pDevice );
-    pDevice->Seek( lFileSize );
-
-    m_lPrevXRefOffset = pVecXRefOffset->back();
-    FillTrailerObject( &trailer, pLast->Reference().ObjectNumber()+1, false );
-
-    pDevice->Seek( m_lTrailerOffset );
-    trailer.WriteObject( pDevice );
-    pDevice->Seek( lFileSize );
-}
-*/
-
 void PdfWriter::CreateFileIdentifier( PdfString & identifier, const PdfObject* pTrailer, PdfString* pOriginalIdentifier ) const
 {
     PdfOutputDevice length;
@@ -52,7 +52,7 @@ class PdfParser;
 class PdfVecObjects;
 class PdfXRef;
 
-namespace NonPublic { class PdfHintStream; }
+namespace NonPublic { struct PdfLinearizedLayout; }
 
 /** The PdfWriter class writes a list of PdfObjects as PDF file.
  *  The XRef section (which is the required table of contents for any
@@ -145,6 +145,8 @@ class PODOFO_API PdfWriter {
 
     /** Enabled linearization for this document.
      *  I.e. optimize it for web usage. Default is false.
+     *  Linearized files are always written with XRef tables,
+     *  SetUseXRefStream is ignored for them.
      *  \param bLinearize if true create a web optimized PDF file
      */
     inline void SetLinearized( bool bLinearize );
@@ -166,6 +168,62 @@ class PODOFO_API PdfWriter {
      */
     inline bool GetUseXRefStream() const;
 
+    /** Pack all objects which are not streams into compressed
+     *  object streams (/Type /ObjStm) instead of writing each of 
+     *  them on its own. This makes files with many dictionaries 
+     *  considerably smaller. Object streams require an XRef stream,
+     *  which is enabled by this call, too. 
+     *  Object streams are not used for linearized files and 
+     *  incremental updates. Default is 0.
+     *  \param nObjects maximum number of objects per object stream
+     *                  (at most 65535) or 0 to disable object streams
+     *  \see SetUseXRefStream
+     */
+    void SetObjectStreamSize( pdf_uint32 nObjects );
+
+    /** 
+     *  \returns the maximum number of objects per object stream 
+     *            or 0 if object streams are not used
+     */
+    inline pdf_uint32 GetObjectStreamSize() const;
+
+    /** Compress all streams, which have no filter yet, with 
+     *  the FlateDecode filter before the document is written.
+     *  The streams of the document are modified, i.e. they are
+     *  still compressed after writing. 
+     *
+     *  Streams are compressed concurrently on GetThreadCount() 
+     *  threads. XMP metadata streams are never compressed and 
+     *  incremental updates only compress dirty streams. 
+     *  Default is false.
+     *
+     *  \param bCompress if true compress streams before writing
+     *  \see SetThreadCount
+     */
+    inline void SetCompressStreams( bool bCompress );
+
+    /** 
+     *  \returns true if streams are compressed before writing
+     */
+    inline bool GetCompressStreams() const;
+
+    /**
+     * \return number of threads used to compress streams
+     */
+    inline static int GetThreadCount();
+
+    /**
+     * Specify the number of threads used to compress
+     * streams if SetCompressStreams is enabled.
+     *
+     * By default, one thread is used. Pass 0 to use one
+     * thread per processor. Without PODOFO_MULTI_THREAD
+     * this setting has no effect.
+     *
+     * \param nThreads number of threads to use
+     */
+    inline static void SetThreadCount( int nThreads );
+
     /** Sets an offset to the previous XRef table. Set it to lower than
      *  or equal to 0, to not write a reference to the previous XRef table.
      *  The default is 0.
@@ -258,6 +316,32 @@ class PODOFO_API PdfWriter {
      */ 
     void WritePdfObjects( PdfOutputDevice* pDevice, const PdfVecObjects& vecObjects, PdfXRef* pXref, bool bRewriteXRefTable = false ) PODOFO_LOCAL;
 
+    /** Create the object streams into which WritePdfObjects packs
+     *  all objects accepted by IsObjectStreamCandidate.
+     */
+    void CreateObjectStreams() PODOFO_LOCAL;
+
+    /** Delete the object streams created by CreateObjectStreams.
+     */
+    void RemoveObjectStreams() PODOFO_LOCAL;
+
+    /** 
+     *  \param pObject an object of the written document
+     *  \returns true if pObject may be written to an object stream
+     */
+    bool IsObjectStreamCandidate( const PdfObject* pObject ) const PODOFO_LOCAL;
+
+    /** Flate compress all streams accepted by IsCompressStreamCandidate
+     *  concurrently on GetThreadCount() threads.
+     */
+    void CompressStreams() PODOFO_LOCAL;
+
+    /** 
+     *  \param pObject an object of the written document
+     *  \returns true if the stream of pObject is compressed by CompressStreams
+     */
+    bool IsCompressStreamCandidate( PdfObject* pObject ) const PODOFO_LOCAL;
+
     /** Creates a file identifier which is required in several
      *  PDF workflows. 
      *  All values from the files document information dictionary are
@@ -281,48 +365,31 @@ class PODOFO_API PdfWriter {
      */       
     void PODOFO_LOCAL WriteLinearized( PdfOutputDevice* pDevice );
 
-    /** Create a linearization dictionary for the current
-     *  document and return a pointer to it after inserting
-     *  it into the vector of PdfObjects
-     *
-     *  \returns a pointer to the linearization dictionary
-     */
-    PdfObject* CreateLinearizationDictionary() PODOFO_LOCAL;
-
-    /** Reorder and renumber all object as required for linearized PDF files.
-     *  This function is very slow.
-     *
-     *  \param pLinearize linearization dictionary
-     *  \param pHint primary hint stream dictionary
-     *  \param pPage first page to display in the document
-     *  \param ppLast the pointer will be initialized to the last object
-     *         belonging to the first page
-     */
-    //void ReorderObjectsLinearized( PdfObject* pLinearize, NonPublic::PdfHintStream* pHint, PdfPage* pPage, PdfObject** ppLast ) PODOFO_LOCAL;
-
-    /** Initialize m_pPagesTree with its correct value
-     *  Always call this function before accessing the pages tree.
+    /** Walk the page tree and sort all objects into the parts
+     *  of a linearized PDF file.
+     *  \param rLayout the object order is written to this layout
      */
-    //void FetchPagesTree();
+    void PODOFO_LOCAL CreateLinearizedLayout( NonPublic::PdfLinearizedLayout & rLayout );
 
-    /** Find dependencies required for creating a linearized PDF of the catalog dictionary.
-     */
-    //void FindCatalogDependencies( PdfObject* pCatalog, const PdfName & rName, TPdfReferenceList* pList, bool bWithDependencies ) PODOFO_LOCAL;
-
-    /** Fill all keys in the linearization dictionary with their values
-     *  \param pLinearize a linearization dictionary
-     *  \param pHint the hint stream
-     *  \param pPage the first page in the linearized PDF file
-     *  \param pLast pointer of the last object belonging to the first page
-     *  \param pVecXRefOffset xref table entries for previous entry
+    /** Write all objects of a linearized PDF file in the
+     *  order determined by CreateLinearizedLayout.
+     *  \param pDevice write to this output device
+     *  \param rLayout the object order; the object offsets are
+     *                 read from and written to this layout
+     *  \param pLinearize the linearization dictionary
+     *  \param pHint the hint stream or NULL to write the file 
+     *               as if there was no hint stream
      */
-    // void FillLinearizationDictionary( PdfObject* pLinearize, PdfOutputDevice* pDevice, PdfPage* pPage, PdfObject* pLast, NonPublic::PdfHintStream* pHint, TVecXRefOffset* pVecXRefOffset ) PODOFO_LOCAL;
+    void PODOFO_LOCAL WriteLinearizedPass( PdfOutputDevice* pDevice, NonPublic::PdfLinearizedLayout & rLayout,
+                                           PdfObject* pLinearize, PdfObject* pHint );
 
  protected:
     PdfVecObjects*  m_vecObjects;
     PdfObject*      m_pTrailer;
 
     bool            m_bXRefStream;
+    pdf_uint32      m_nObjectStreamSize;  ///< Maximum number of objects per object stream or 0
+    TVecObjects     m_vecObjectStreams;   ///< Object streams while the document is written
 
     PdfEncrypt*     m_pEncrypt;    ///< If not NULL encrypt all strings and streams and create an encryption dictionary in the trailer
     PdfObject*      m_pEncryptObj; ///< Used to temporarily store the encryption dictionary
@@ -337,21 +404,43 @@ class PODOFO_API PdfWriter {
     bool            m_bIncrementalUpdate;
 
     bool            m_bLinearized;
- 
-    /**
-     * This value is required when writing
-     * a linearized PDF file.
-     * It represents the offset of the whitespace
-     * character before the first line in the XRef
-     * section.
-     */
-    size_t            m_lFirstInXRef;
-    size_t            m_lLinearizedOffset;
-    size_t            m_lLinearizedLastOffset;
-    size_t            m_lTrailerOffset;
-    PdfVecObjects   m_vecLinearized;
+    bool            m_bCompressStreams;
+
+    static int      s_nThreadCount;
 };
 
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+void PdfWriter::SetCompressStreams( bool bCompress )
+{
+    m_bCompressStreams = bCompress;
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+bool PdfWriter::GetCompressStreams() const
+{
+    return m_bCompressStreams;
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+int PdfWriter::GetThreadCount()
+{
+    return PdfWriter::s_nThreadCount;
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+void PdfWriter::SetThreadCount( int nThreads )
+{
+    PdfWriter::s_nThreadCount = nThreads;
+}
+
 // -----------------------------------------------------
 // 
 // -----------------------------------------------------
@@ -386,6 +475,14 @@ bool PdfWriter::GetUseXRefStream() const
     return m_bXRefStream;
 }
 
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+pdf_uint32 PdfWriter::GetObjectStreamSize() const
+{
+    return m_nObjectStreamSize;
+}
+
 // -----------------------------------------------------
 // 
 // -----------------------------------------------------
@@ -104,9 +104,18 @@ PdfXRef::~PdfXRef()
 }
 
 void PdfXRef::AddObject( const PdfReference & rRef, pdf_uint64 offset, bool bUsed )
+{
+    this->AddItem( PdfXRef::TXRefItem( rRef, offset ), bUsed );
+}
+
+void PdfXRef::AddCompressedObject( const PdfReference & rRef, pdf_objnum nObjectStream, pdf_uint32 nIndex )
+{
+    this->AddItem( PdfXRef::TXRefItem( rRef, nObjectStream, nIndex ), true );
+}
+
+void PdfXRef::AddItem( const TXRefItem & item, bool bUsed )
 {
     TIVecXRefBlock     it = m_vecBlocks.begin();
-    PdfXRef::TXRefItem item( rRef, offset );
     bool               bInsertDone = false;
 
     while( it != m_vecBlocks.end() )
@@ -123,12 +132,12 @@ void PdfXRef::AddObject( const PdfReference & rRef, pdf_uint64 offset, bool bUse
     if( !bInsertDone ) 
     {
         PdfXRefBlock block;
-        block.m_nFirst = rRef.ObjectNumber();
+        block.m_nFirst = item.reference.ObjectNumber();
         block.m_nCount = 1;
         if( bUsed )
             block.items.push_back( item );
         else
-            block.freeItems.push_back( rRef );
+            block.freeItems.push_back( item.reference );
 
         m_vecBlocks.push_back( block );
         std::sort( m_vecBlocks.begin(), m_vecBlocks.end() );
@@ -137,7 +146,7 @@ void PdfXRef::AddObject( const PdfReference & rRef, pdf_uint64 offset, bool bUse
 
 void PdfXRef::Write( PdfOutputDevice* pDevice )
 {
-    PdfXRef::TCIVecXRefBlock  it         = m_vecBlocks.begin();
+    PdfXRef::TCIVecXRefBlock  it;
     PdfXRef::TCIVecXRefItems  itItems;
     PdfXRef::TCIVecReferences itFree;
     const PdfReference*       pNextFree  = NULL;
@@ -145,10 +154,13 @@ void PdfXRef::Write( PdfOutputDevice* pDevice )
     pdf_objnum nFirst = 0;
     pdf_uint32 nCount = 0;
 
-    MergeBlocks();
-
     m_offset = pDevice->Tell();
     this->BeginWrite( pDevice );
+
+    // BeginWrite may still add objects
+    MergeBlocks();
+
+    it = m_vecBlocks.begin();
     while( it != m_vecBlocks.end() )
     {
         nCount       = (*it).m_nCount;
@@ -187,8 +199,12 @@ void PdfXRef::Write( PdfOutputDevice* pDevice )
                 ++itFree;
             }
 
-            this->WriteXRefEntry( pDevice, (*itItems).offset, (*itItems).reference.GenerationNumber(), 'n', 
-                                  (*itItems).reference.ObjectNumber()  );
+            if( (*itItems).bCompressed )
+                this->WriteXRefEntry( pDevice, (*itItems).offset, static_cast<pdf_gennum>((*itItems).index), 'c', 
+                                      (*itItems).reference.ObjectNumber()  );
+            else
+                this->WriteXRefEntry( pDevice, (*itItems).offset, (*itItems).reference.GenerationNumber(), 'n', 
+                                      (*itItems).reference.ObjectNumber()  );
             ++itItems;
         }
 
@@ -337,13 +353,43 @@ void PdfXRef::WriteSubSection( PdfOutputDevice* pDevice, pdf_objnum nFirst, pdf_
 #ifdef DEBUG
     PdfError::DebugMessage("Writing XRef section: %u %u\n", nFirst, nCount );
 #endif // DEBUG
-    pDevice->Print( "%u %u\n", nFirst, nCount );
+    pDevice->WriteUInt( nFirst );
+    pDevice->Write( " ", 1 );
+    pDevice->WriteUInt( nCount );
+    pDevice->Write( "\n", 1 );
 }
 
 void PdfXRef::WriteXRefEntry( PdfOutputDevice* pDevice, pdf_uint64 offset, 
                               pdf_gennum generation, char cMode, pdf_objnum ) 
 {
-    pDevice->Print( "%0.10" PDF_FORMAT_UINT64 " %0.5hu %c \n", offset, generation, cMode );
+    if( cMode == 'c' )
+    {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_InternalLogic, "Objects in object streams require an XRef stream." );
+    }
+
+    // Each entry is exactly 20 bytes long (for offsets below 10^10):
+    // "nnnnnnnnnn ggggg n \n"
+    char buffer[32];
+    int  nPos = sizeof(buffer);
+
+    buffer[--nPos] = '\n';
+    buffer[--nPos] = ' ';
+    buffer[--nPos] = cMode;
+    buffer[--nPos] = ' ';
+    for( int i=0;i<5;i++ ) 
+    {
+        buffer[--nPos] = static_cast<char>('0' + generation % 10);
+        generation /= 10;
+    }
+
+    buffer[--nPos] = ' ';
+    for( int i=0;i<10 || offset;i++ ) 
+    {
+        buffer[--nPos] = static_cast<char>('0' + offset % 10);
+        offset /= 10;
+    }
+
+    pDevice->Write( buffer + nPos, sizeof(buffer) - nPos );
 }
 
 void PdfXRef::EndWrite( PdfOutputDevice* ) 
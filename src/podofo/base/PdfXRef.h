@@ -53,12 +53,19 @@ class PdfXRef {
  protected:
     struct TXRefItem{
         TXRefItem( const PdfReference & rRef, const pdf_uint64 & off ) 
-            : reference( rRef ), offset( off )
+            : reference( rRef ), offset( off ), index( 0 ), bCompressed( false )
+            {
+            }
+
+        TXRefItem( const PdfReference & rRef, pdf_objnum nObjectStream, pdf_uint32 nIndex ) 
+            : reference( rRef ), offset( nObjectStream ), index( nIndex ), bCompressed( true )
             {
             }
 
         PdfReference reference;
-        pdf_uint64   offset;
+        pdf_uint64   offset;      ///< offset in the file or object number of the object stream if bCompressed
+        pdf_uint32   index;       ///< index of the object in its object stream if bCompressed
+        bool         bCompressed; ///< true if the object is stored in an object stream
 
         bool operator<( const TXRefItem & rhs ) const
         {
@@ -136,6 +143,15 @@ class PdfXRef {
      */
     void AddObject( const PdfReference & rRef, pdf_uint64 offset, bool bUsed );
 
+    /** Add an object which is stored in an object stream to the XRef table.
+     *  Compressed objects can only be written by XRef streams.
+     *
+     *  \param rRef reference of this object
+     *  \param nObjectStream object number of the object stream containing this object
+     *  \param nIndex index of this object inside the object stream
+     */
+    void AddCompressedObject( const PdfReference & rRef, pdf_objnum nObjectStream, pdf_uint32 nIndex );
+
     /** Write the XRef table to an output device.
      * 
      *  \param pDevice an output device (usually a PDF file)
@@ -187,7 +203,9 @@ class PdfXRef {
      *                 should be written.
      *  @param offset the offset of the object
      *  @param generation the generation number
-     *  @param cMode the mode 'n' for object and 'f' for free objects
+     *  @param cMode the mode 'n' for object, 'f' for free objects and 'c' for objects
+     *               stored in an object stream. For 'c' offset is the object number of
+     *               the object stream and generation the index inside the object stream.
      *  @param objectNumber the object number of the currently written object if cMode = 'n' 
      *                       otherwise undefined
      */
@@ -214,6 +232,8 @@ class PdfXRef {
      */
     void MergeBlocks();
 
+    void AddItem( const TXRefItem & rItem, bool bUsed );
+
  private:
     pdf_uint64 m_offset;
 
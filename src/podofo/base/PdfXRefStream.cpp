@@ -35,6 +35,7 @@
 
 #include "PdfObject.h"
 #include "PdfStream.h"
+#include "PdfVecObjects.h"
 #include "PdfWriter.h"
 #include "PdfDefinesPrivate.h"
 
@@ -51,18 +52,55 @@ namespace PoDoFo {
 PdfXRefStream::PdfXRefStream( PdfVecObjects* pParent, PdfWriter* pWriter )
     : m_pParent( pParent ), m_pWriter( pWriter ), m_pObject( NULL )
 {
-    m_bufferLen = 2 + sizeof( pdf_uint32 );
+    m_indexLen  = 1;
+    m_bufferLen = 1 + sizeof( pdf_uint32 ) + m_indexLen;
 
-    m_pObject    = pParent->CreateObject( "XRef" );
+    // The XRef stream is written by EndWrite after all other objects,
+    // so it is not kept in pParent, which only reserves a new object number
+    m_pObject    = pParent->CreateUnlistedObject( "XRef" );
     m_offset    = 0;
 }
 
 PdfXRefStream::~PdfXRefStream()
 {
+    m_pParent->DeleteUnlistedObject( m_pObject );
 }
 
-void PdfXRefStream::BeginWrite( PdfOutputDevice* )
+void PdfXRefStream::BeginWrite( PdfOutputDevice* pDevice )
 {
+    // Nothing is written to pDevice before EndWrite writes the XRef stream
+    m_offset = pDevice->Tell();
+    this->AddObject( m_pObject->Reference(), m_offset, true );
+
+    // Objects in object streams may need more than one byte for their index
+    m_indexLen = 1;
+    for( TCIVecXRefBlock itBlock = m_vecBlocks.begin(); itBlock != m_vecBlocks.end() && m_indexLen == 1; ++itBlock ) 
+    {
+        for( TCIVecXRefItems itItem = (*itBlock).items.begin(); itItem != (*itBlock).items.end(); ++itItem ) 
+        {
+            if( (*itItem).bCompressed && (*itItem).index > 0xff )
+            {
+                m_indexLen = 2;
+                break;
+            }
+        }
+    }
+    m_bufferLen = 1 + sizeof( pdf_uint32 ) + m_indexLen;
+
+    // Consecutive entries differ in few bytes of their offsets only,
+    // so the PNG up predictor makes them compress a lot better
+    if( PdfStream::eDefaultFilter == ePdfFilter_FlateDecode )
+    {
+        const TFlateSettings* pSettings = m_pParent->GetFlateSettings();
+
+        m_flateSettings                   = pSettings ? *pSettings : PdfFilterFactory::GetFlateSettings();
+        m_flateSettings.nPredictor        = 12;
+        m_flateSettings.nColors           = 1;
+        m_flateSettings.nBitsPerComponent = 8;
+        m_flateSettings.nColumns          = static_cast<int>(m_bufferLen);
+        m_pObject->GetStream()->SetFlateSettings( &m_flateSettings );
+    }
+
     m_pObject->GetStream()->BeginAppend();
 }
 
@@ -75,7 +113,7 @@ void PdfXRefStream::WriteSubSection( PdfOutputDevice*, pdf_objnum first, pdf_uin
 }
 
 void PdfXRefStream::WriteXRefEntry( PdfOutputDevice*, pdf_uint64 offset, pdf_gennum generation, 
-                                    char cMode, pdf_objnum objectNumber ) 
+                                    char cMode, pdf_objnum ) 
 {
     std::vector<char>	bytes(m_bufferLen);
 #if (defined(_MSC_VER)  &&  _MSC_VER < 1700) || (defined(__BORLANDC__))	// MSC before VC11 has no data member, same as BorlandC
@@ -84,11 +122,13 @@ void PdfXRefStream::WriteXRefEntry( PdfOutputDevice*, pdf_uint64 offset, pdf_gen
     char * buffer = bytes.data();
 #endif
 
-    if( cMode == 'n' && objectNumber == m_pObject->Reference().ObjectNumber() )
-        m_offset = offset;
-    
-    buffer[0]             = static_cast<char>( cMode == 'n' ? 1 : 0 );
-    buffer[m_bufferLen-1] = static_cast<char>( cMode == 'n' ? 0 : generation );
+    if( cMode == 'n' )
+        generation = 0;
+
+    buffer[0]             = static_cast<char>( cMode == 'n' ? 1 : (cMode == 'c' ? 2 : 0) );
+    buffer[m_bufferLen-1] = static_cast<char>( generation & 0xff );
+    if( m_indexLen == 2 )
+        buffer[m_bufferLen-2] = static_cast<char>( (generation >> 8) & 0xff );
 
     const pdf_uint32 offset_be = ::PoDoFo::compat::podofo_htonl(static_cast<pdf_uint32>(offset));
     memcpy( &buffer[1], reinterpret_cast<const char*>(&offset_be), sizeof(pdf_uint32) );
@@ -102,10 +142,7 @@ void PdfXRefStream::EndWrite( PdfOutputDevice* pDevice )
 
     w.push_back( static_cast<pdf_int64>(1) );
     w.push_back( static_cast<pdf_int64>(sizeof(pdf_uint32)) );
-    w.push_back( static_cast<pdf_int64>(1) );
-
-    // Add our self to the XRef table
-    this->WriteXRefEntry( pDevice, pDevice->Tell(), 0, 'n' );
+    w.push_back( static_cast<pdf_int64>(m_indexLen) );
 
     m_pObject->GetStream()->EndAppend();
     m_pWriter->FillTrailerObject( m_pObject, this->GetSize(), false );
@@ -113,7 +150,6 @@ void PdfXRefStream::EndWrite( PdfOutputDevice* pDevice )
     m_pObject->GetDictionary().AddKey( "Index", m_indeces );
     m_pObject->GetDictionary().AddKey( "W", w );
 
-    pDevice->Seek( static_cast<size_t>(m_offset) );
     m_pObject->WriteObject( pDevice, m_pWriter->GetWriteMode(), NULL ); // DominikS: Requires encryption info??
     m_indeces.Clear();
 }
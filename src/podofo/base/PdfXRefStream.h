@@ -37,6 +37,7 @@
 #include "PdfDefines.h"
 
 #include "PdfArray.h"
+#include "PdfFilter.h"
 #include "PdfXRef.h"
 
 namespace PoDoFo {
@@ -99,7 +100,8 @@ class PdfXRefStream : public PdfXRef {
      *                 should be written.
      *  @param offset the offset of the object
      *  @param generation the generation number
-     *  @param cMode the mode 'n' for object and 'f' for free objects
+     *  @param cMode the mode 'n' for object, 'f' for free objects and 'c' for objects
+     *               stored in an object stream
      *  @param objectNumber the object number of the currently written object if cMode = 'n' 
      *                       otherwise undefined
      */
@@ -121,7 +123,10 @@ class PdfXRefStream : public PdfXRef {
     PdfArray       m_indeces;
 
     size_t         m_bufferLen; ///< The length of the internal buffer for one XRef entry
+    size_t         m_indexLen;  ///< The length of the third field of an XRef entry
     pdf_uint64     m_offset;    ///< Offset of the XRefStream object
+
+    TFlateSettings m_flateSettings; ///< Settings which apply the PNG up predictor to the entries
 };
 
 // -----------------------------------------------------
@@ -0,0 +1,86 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Dominik Seichter                                 *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ *                                                                         *
+ *   In addition, as a special exception, the copyright holders give       *
+ *   permission to link the code of portions of this program with the      *
+ *   OpenSSL library under certain conditions as described in each         *
+ *   individual source file, and distribute linked combinations            *
+ *   including the two.                                                    *
+ *   You must obey the GNU General Public License in all respects          *
+ *   for all of the code used other than OpenSSL.  If you modify           *
+ *   file(s) with this exception, you may extend this exception to your    *
+ *   version of the file(s), but you are not obligated to do so.  If you   *
+ *   do not wish to do so, delete this exception statement from your       *
+ *   version.  If you delete this exception statement from all source      *
+ *   files in the program, then also delete it here.                       *
+ ***************************************************************************/
+
+#ifndef PDF_PDFTHREAD_H
+#define PDF_PDFTHREAD_H
+
+#if defined(BUILDING_PODOFO)
+
+/* Import the platform-specific implementation of PdfThread */
+#if defined(PODOFO_MULTI_THREAD)
+#  if defined(_WIN32)
+#    include "PdfThreadImpl_win32.h"
+#  else
+#    include "PdfThreadImpl_pthread.h"
+#  endif
+#else
+#  include "PdfThreadImpl_noop.h"
+#endif
+
+namespace PoDoFo { namespace Util {
+
+/**
+ * A thread implemented by win32 threads or pthreads.
+ *
+ * If PODOFO_MULTI_THREAD is not set, Start() runs the thread function
+ * in the calling thread and GetProcessorCount() returns 1.
+ *
+ * A PdfThread is started at most once. The destructor waits for 
+ * the thread to finish, if Join() has not been called before.
+ */
+class PdfThread : public PdfThreadImpl
+{
+  // This wrapper/extension class is provided so we can add platform-independent
+  // functionality and helpers if desired.
+  public:
+    PdfThread() { }
+    ~PdfThread() { }
+
+  private:
+    /** copy constructor, not implemented
+     */
+    PdfThread( const PdfThread & rhs );
+    /** assignment operator, not implemented
+     */
+    PdfThread & operator=( const PdfThread & rhs );
+};
+
+};};
+
+#else // BUILDING_PODOFO
+// Only a forward-declaration is available for PdfThread for sources outside the
+// PoDoFo library build its self. PdfThread is not public API.
+namespace PoDoFo { namespace Util { class PdfThread; }; };
+#endif
+
+#endif
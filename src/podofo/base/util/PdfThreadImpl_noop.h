@@ -0,0 +1,84 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Dominik Seichter                                 *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ *                                                                         *
+ *   In addition, as a special exception, the copyright holders give       *
+ *   permission to link the code of portions of this program with the      *
+ *   OpenSSL library under certain conditions as described in each         *
+ *   individual source file, and distribute linked combinations            *
+ *   including the two.                                                    *
+ *   You must obey the GNU General Public License in all respects          *
+ *   for all of the code used other than OpenSSL.  If you modify           *
+ *   file(s) with this exception, you may extend this exception to your    *
+ *   version of the file(s), but you are not obligated to do so.  If you   *
+ *   do not wish to do so, delete this exception statement from your       *
+ *   version.  If you delete this exception statement from all source      *
+ *   files in the program, then also delete it here.                       *
+ ***************************************************************************/
+
+#ifndef PDFTHREADIMPL_NOOP_H
+#define PDFTHREADIMPL_NOOP_H
+
+#include "../PdfDefines.h"
+#include "../PdfDefinesPrivate.h"
+
+#if defined(PODOFO_MULTI_THREAD)
+#error "Multi-thread build, a real PdfThread implementation should be used instead"
+#endif
+
+namespace PoDoFo {
+namespace Util {
+
+/** The entry point of a PdfThread.
+ *  It must not throw any exceptions.
+ */
+typedef void (*PdfThreadFunc)( void* pData );
+
+/**
+ * A platform independent thread, no-op implementation.
+ * This version is used if PoDoFo is built without threading support.
+ * The thread function is run immediately by Start().
+ *  
+ * PdfThread is *NOT* part of PoDoFo's public API.
+ */
+class PdfThreadImpl {
+  public:
+    inline PdfThreadImpl() { }
+
+    inline ~PdfThreadImpl() { }
+
+    /**
+     * Run pFunc( pData ) in the calling thread.
+     */
+    inline void Start( PdfThreadFunc pFunc, void* pData ) { pFunc( pData ); }
+
+    /**
+     * Wait for the thread to finish
+     */
+    inline void Join() { }
+
+    /**
+     * \returns the number of processors which can run threads
+     */
+    inline static int GetProcessorCount() { return 1; }
+};
+
+}; // Util
+}; // PoDoFo
+
+#endif // PDFTHREADIMPL_NOOP_H
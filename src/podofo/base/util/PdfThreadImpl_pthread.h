@@ -0,0 +1,160 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Dominik Seichter                                 *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ *                                                                         *
+ *   In addition, as a special exception, the copyright holders give       *
+ *   permission to link the code of portions of this program with the      *
+ *   OpenSSL library under certain conditions as described in each         *
+ *   individual source file, and distribute linked combinations            *
+ *   including the two.                                                    *
+ *   You must obey the GNU General Public License in all respects          *
+ *   for all of the code used other than OpenSSL.  If you modify           *
+ *   file(s) with this exception, you may extend this exception to your    *
+ *   version of the file(s), but you are not obligated to do so.  If you   *
+ *   do not wish to do so, delete this exception statement from your       *
+ *   version.  If you delete this exception statement from all source      *
+ *   files in the program, then also delete it here.                       *
+ ***************************************************************************/
+
+#ifndef PDFTHREADIMPL_PTHREAD_H
+#define PDFTHREADIMPL_PTHREAD_H
+
+#include "../PdfDefines.h"
+#include "../PdfDefinesPrivate.h"
+
+#if ! defined(PODOFO_MULTI_THREAD)
+#error "Not a multi-thread build. PdfThreadImpl_noop.h should be used instead"
+#endif
+
+#if defined(_WIN32)
+#error "win32 build. PdfThreadImpl_win32.h should be used instead"
+#endif
+
+#include <pthread.h>
+#include <unistd.h>
+
+namespace PoDoFo {
+namespace Util {
+
+/** The entry point of a PdfThread.
+ *  It must not throw any exceptions.
+ */
+typedef void (*PdfThreadFunc)( void* pData );
+
+/**
+ * A platform independent thread, pthread implementation.
+ *  
+ * PdfThread is *NOT* part of PoDoFo's public API.
+ *
+ * This is the pthread implementation, which is
+ * entirely inline.
+ */
+class PdfThreadImpl {
+    pthread_t     m_thread;
+    bool          m_bRunning;
+    PdfThreadFunc m_pFunc;
+    void*         m_pData;
+
+  public:
+
+    inline PdfThreadImpl();
+
+    /** Joins the thread if it is still running
+     */
+    inline ~PdfThreadImpl();
+
+    /**
+     * Run pFunc( pData ) in a new thread
+     */
+    inline void Start( PdfThreadFunc pFunc, void* pData );
+
+    /**
+     * Wait for the thread to finish
+     */
+    inline void Join();
+
+    /**
+     * \returns the number of processors which can run threads
+     */
+    inline static int GetProcessorCount();
+
+  private:
+    inline static void* ThreadMain( void* pThis );
+};
+
+PdfThreadImpl::PdfThreadImpl()
+    : m_bRunning( false ), m_pFunc( NULL ), m_pData( NULL )
+{
+}
+
+PdfThreadImpl::~PdfThreadImpl()
+{
+    if( m_bRunning )
+        pthread_join( m_thread, NULL );
+}
+
+void PdfThreadImpl::Start( PdfThreadFunc pFunc, void* pData )
+{
+    if( m_bRunning )
+    {
+	    PODOFO_RAISE_ERROR( ePdfError_ThreadError );
+    }
+
+    m_pFunc = pFunc;
+    m_pData = pData;
+    if( pthread_create( &m_thread, NULL, &PdfThreadImpl::ThreadMain, this ) != 0 )
+    {
+	    PODOFO_RAISE_ERROR( ePdfError_ThreadError );
+    }
+
+    m_bRunning = true;
+}
+
+void PdfThreadImpl::Join()
+{
+    if( !m_bRunning )
+        return;
+
+    m_bRunning = false;
+    if( pthread_join( m_thread, NULL ) != 0 )
+    {
+	    PODOFO_RAISE_ERROR( ePdfError_ThreadError );
+    }
+}
+
+int PdfThreadImpl::GetProcessorCount()
+{
+#if defined(_SC_NPROCESSORS_ONLN)
+    long nCount = sysconf( _SC_NPROCESSORS_ONLN );
+    return nCount > 0 ? static_cast<int>(nCount) : 1;
+#else
+    return 1;
+#endif
+}
+
+void* PdfThreadImpl::ThreadMain( void* pThis )
+{
+    PdfThreadImpl* pThread = static_cast<PdfThreadImpl*>(pThis);
+    pThread->m_pFunc( pThread->m_pData );
+    return NULL;
+}
+
+}; // Util
+}; // PoDoFo
+
+#endif // PDFTHREADIMPL_PTHREAD_H
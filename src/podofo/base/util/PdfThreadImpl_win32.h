@@ -0,0 +1,152 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Dominik Seichter                                 *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ *                                                                         *
+ *   In addition, as a special exception, the copyright holders give       *
+ *   permission to link the code of portions of this program with the      *
+ *   OpenSSL library under certain conditions as described in each         *
+ *   individual source file, and distribute linked combinations            *
+ *   including the two.                                                    *
+ *   You must obey the GNU General Public License in all respects          *
+ *   for all of the code used other than OpenSSL.  If you modify           *
+ *   file(s) with this exception, you may extend this exception to your    *
+ *   version of the file(s), but you are not obligated to do so.  If you   *
+ *   do not wish to do so, delete this exception statement from your       *
+ *   version.  If you delete this exception statement from all source      *
+ *   files in the program, then also delete it here.                       *
+ ***************************************************************************/
+
+#ifndef PDFTHREADIMPL_WIN32_H
+#define PDFTHREADIMPL_WIN32_H
+
+#include "../PdfDefines.h"
+#include "../PdfDefinesPrivate.h"
+
+#if ! defined(PODOFO_MULTI_THREAD)
+#error "Not a multi-thread build. PdfThreadImpl_noop.h should be used instead"
+#endif
+
+#if !defined(_WIN32)
+#error "Wrong PdfThread implementation included!"
+#endif
+
+namespace PoDoFo {
+namespace Util {
+
+/** The entry point of a PdfThread.
+ *  It must not throw any exceptions.
+ */
+typedef void (*PdfThreadFunc)( void* pData );
+
+/** 
+ * A platform independent thread, win32 implementation.
+ */
+class PdfThreadImpl {
+  public:
+    inline PdfThreadImpl();
+
+    /** Joins the thread if it is still running
+     */
+    inline ~PdfThreadImpl();
+
+    /**
+     * Run pFunc( pData ) in a new thread
+     */
+    inline void Start( PdfThreadFunc pFunc, void* pData );
+
+    /**
+     * Wait for the thread to finish
+     */
+    inline void Join();
+
+    /**
+     * \returns the number of processors which can run threads
+     */
+    inline static int GetProcessorCount();
+
+  private:
+    inline static DWORD WINAPI ThreadMain( LPVOID pThis );
+
+    HANDLE        m_hThread;
+    PdfThreadFunc m_pFunc;
+    void*         m_pData;
+};
+
+PdfThreadImpl::PdfThreadImpl()
+    : m_hThread( NULL ), m_pFunc( NULL ), m_pData( NULL )
+{
+}
+
+PdfThreadImpl::~PdfThreadImpl()
+{
+    if( m_hThread )
+    {
+        WaitForSingleObject( m_hThread, INFINITE );
+        CloseHandle( m_hThread );
+    }
+}
+
+void PdfThreadImpl::Start( PdfThreadFunc pFunc, void* pData )
+{
+    if( m_hThread )
+    {
+        PODOFO_RAISE_ERROR( ePdfError_ThreadError );
+    }
+
+    m_pFunc   = pFunc;
+    m_pData   = pData;
+    m_hThread = CreateThread( NULL, 0, &PdfThreadImpl::ThreadMain, this, 0, NULL );
+    if( !m_hThread )
+    {
+        PODOFO_RAISE_ERROR( ePdfError_ThreadError );
+    }
+}
+
+void PdfThreadImpl::Join()
+{
+    if( !m_hThread )
+        return;
+
+    DWORD dwResult = WaitForSingleObject( m_hThread, INFINITE );
+    CloseHandle( m_hThread );
+    m_hThread = NULL;
+
+    if( dwResult != WAIT_OBJECT_0 )
+    {
+        PODOFO_RAISE_ERROR( ePdfError_ThreadError );
+    }
+}
+
+int PdfThreadImpl::GetProcessorCount()
+{
+    SYSTEM_INFO info;
+    GetSystemInfo( &info );
+    return info.dwNumberOfProcessors > 0 ? static_cast<int>(info.dwNumberOfProcessors) : 1;
+}
+
+DWORD WINAPI PdfThreadImpl::ThreadMain( LPVOID pThis )
+{
+    PdfThreadImpl* pThread = static_cast<PdfThreadImpl*>(pThis);
+    pThread->m_pFunc( pThread->m_pData );
+    return 0;
+}
+
+}; // Util
+}; // PoDoFo
+
+#endif // PDFTHREADIMPL_WIN32_H
@@ -39,13 +39,8 @@
 #include "base/PdfObject.h"
 #include "base/PdfVariant.h"
 #include "base/PdfLocale.h"
-#include "base/PdfStream.h"
-#include "base/PdfContentsTokenizer.h"
 
 
-#include <iostream>
-#include <stack>
-#include <iomanip>
 #include <string>
 
 using namespace std;
@@ -54,176 +49,20 @@ namespace PoDoFo
 {
 
 
-PdfCMapEncoding::PdfCMapEncoding (PdfObject * pObject, PdfObject * pToUnicode) : PdfEncoding(0x0000, 0xffff, pToUnicode), PdfElement(NULL, pObject), m_baseEncoding( eBaseEncoding_Font )
+PdfCMapEncoding::PdfCMapEncoding (PdfObject * pObject, PdfObject * pToUnicode) 
+    : PdfEncoding(0x0000, 0xffff, pToUnicode), 
+      PdfElement(pObject && pObject->IsName() ? ePdfDataType_Name : ePdfDataType_Dictionary, pObject), 
+      m_baseEncoding( eBaseEncoding_Font )
 {
-    if (pObject && pObject->HasStream())
+    if (pObject->IsName() || pObject->HasStream())
     {
-        std::stack<std::string> stkToken;
-        pdf_uint16 loop = 0;
-        char *streamBuffer;
-        const char *streamToken = NULL;
-        EPdfTokenType *streamTokenType = NULL;
-        pdf_long streamBufferLen;
-        bool in_begincidrange = 0;
-        bool in_begincidchar = 0;
-        pdf_uint16 range_entries = 0;
-        pdf_uint16 char_entries = 0;
-        pdf_uint16 inside_hex_string = 0;
-        pdf_uint16 inside_array = 0;
-        pdf_uint16 range_start = 0;
-        pdf_uint16 range_end = 0;
-        pdf_uint16 i = 0;
-        pdf_utf16be firstvalue = 0;
-        const PdfStream *CIDStreamdata = static_cast<const PdfObject*>(pObject)->GetStream ();
-        CIDStreamdata->GetFilteredCopy (&streamBuffer, &streamBufferLen);
-
-        PdfContentsTokenizer streamTokenizer (streamBuffer, streamBufferLen);
-        while (streamTokenizer.GetNextToken (streamToken, streamTokenType))
+        // Fonts using the same CMap share the compiled CMap
+        m_cMap = PdfCMapCache::GetCMap( pObject );
+        if( !m_cMap.IsValid() ) 
         {
-            stkToken.push (streamToken);
-
-            if (strcmp (streamToken, ">") == 0)
-            {
-                if (inside_hex_string == 0)
-                    PODOFO_RAISE_ERROR_INFO(ePdfError_InvalidStream, "CMap Error, got > before <")
-                    else
-                        inside_hex_string = 0;
-                
-                i++;
-
-            }
-
-            if (strcmp (streamToken, "]") == 0)
-            {
-                if (inside_array == 0)
-                    PODOFO_RAISE_ERROR_INFO(ePdfError_InvalidStream, "CMap Error, got ] before [")
-                    else
-                        inside_array = 0;
-                
-                i++;
-
-            }
-            
-            if (in_begincidrange == 1)
-            {
-                if (loop < range_entries)
-                {
-                    if (inside_hex_string == 1)
-                    {
-                        pdf_utf16be num_value;
-                        std::stringstream ss;
-                        ss << std::hex << streamToken;
-                        ss >> num_value;
-                        if (i % 3 == 0)
-                            range_start = num_value;
-                        if (i % 3 == 1)
-                        {
-                            range_end = num_value;
-                        }
-                        if (i % 3 == 2)
-                        {
-                            for (int k = range_start; k <= range_end; k++)
-                            {
-                                m_cMap[k] = num_value;
-                                num_value++;
-                            }
-
-                            loop++;
-
-                        }
-                    }
-                }
-
-            }
-
-
-
-            if (in_begincidchar == 1)
-            {
-                if (loop < char_entries)
-                {
-                    if (inside_hex_string == 1)
-                    {
-                        pdf_utf16be num_value;
-                        std::stringstream ss;
-                        ss << std::hex << streamToken;
-                        ss >> num_value;
-                        if (i % 2 == 0)
-                        {
-                            firstvalue = num_value;
-                        }
-                        if (i % 2 == 1)
-                        {
-                            m_cMap[firstvalue] = num_value;
-                        }
-
-                    }
-
-                }
-
-            }
-
-
-            if (strcmp (streamToken, "<") == 0)
-            {
-                inside_hex_string = 1;
-            }
-
-
-
-            if (strcmp (streamToken, "[") == 0)
-            {
-                inside_array = 1;
-            }
-
-
-
-
-
-            
-            
-            if (strcmp (streamToken, "begincidrange") == 0)
-            {
-                i = loop = 0;
-                in_begincidrange = 1;
-                stkToken.pop ();
-                std::stringstream ss;
-                ss << std::hex << stkToken.top ();
-                ss >> range_entries;
-
-            }
-            
-            if (strcmp (streamToken, "endcidrange") == 0)
-            {
-                in_begincidrange = 0;
-                i = 0;
-            }
-            
-            if (strcmp (streamToken, "begincidchar") == 0)
-            {
-                i = loop = 0;
-                in_begincidchar = 1;
-                stkToken.pop ();
-                std::stringstream ss;
-                ss << std::hex << stkToken.top ();
-                ss >> char_entries;
-
-            }
-            
-            if (strcmp (streamToken, "endcidchar") == 0)
-            {
-                in_begincidchar = 0;
-                i = 0;
-            }
-
-
-
+            PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidName, pObject->GetName().GetName().c_str() );
         }
-        
-        podofo_free(streamBuffer);
     }
-
-
 }
 
 void PdfCMapEncoding::AddToDictionary(PdfDictionary &) const
@@ -261,70 +100,36 @@ const PdfEncoding* PdfCMapEncoding::GetBaseEncoding() const
 
 PdfString PdfCMapEncoding::ConvertToUnicode(const PdfString & rEncodedString, const PdfFont* pFont) const
 {
-
-    if(m_bToUnicodeIsLoaded)
+    if(m_toUnicode.HasUnicodeMappings())
     {
-      if(!m_toUnicode.empty())
-      {
-        
-        const pdf_uint8* pStr = reinterpret_cast<const pdf_uint8*>(rEncodedString.GetString());
-        const size_t lLen = rEncodedString.GetLength();
-        
-        pdf_utf16be* pszUtf16 = static_cast<pdf_utf16be*>(podofo_calloc(lLen, sizeof(pdf_utf16be)));
-        if( !pszUtf16 )
-        {
-          PODOFO_RAISE_ERROR( ePdfError_OutOfMemory );
-        }
-        
-        size_t lDstLen = 0;
-        pdf_utf16be lCID, lUnicodeValue;
-        pdf_uint8* const pCID = reinterpret_cast<pdf_uint8*>(&lCID);
-        for(size_t iSrc = 0 ; iSrc<lLen ;)
-        {
-          lCID = 0;
-#ifdef PODOFO_IS_LITTLE_ENDIAN
-          pCID[0] = pStr[iSrc];
-#else
-          pCID[1] = pStr[iSrc];
-#endif // PODOFO_IS_LITTLE_ENDIAN
-
-          iSrc++;
-          
-          lUnicodeValue = this->GetUnicodeValue(lCID);
-
-          if (lUnicodeValue == 0)
-          {
-#ifdef PODOFO_IS_LITTLE_ENDIAN
-            pCID[1] = pStr[iSrc];
-#else
-            pCID[0] = pStr[iSrc];
-#endif // PODOFO_IS_LITTLE_ENDIAN
-          
-            iSrc++;
-            lUnicodeValue = this->GetUnicodeValue(lCID);
-          }
-          
-#ifdef PODOFO_IS_LITTLE_ENDIAN
-          pszUtf16[lDstLen] = (lUnicodeValue << 8) | (lUnicodeValue >> 8 );
-#else
-          pszUtf16[lDstLen] = lUnicodeValue;
-#endif // PODOFO_IS_LITTLE_ENDIAN
-          lDstLen++;
-        }
-        
-        PdfString ret( pszUtf16, lDstLen );
-        podofo_free( pszUtf16 );
-        
-        return ret;
-        
-      }
-      else
+        // The codes are read using the codespace ranges of the encoding CMap
+        // and mapped to unicode in one pass using the /ToUnicode CMap
+        return m_toUnicode.DecodeToUnicode(rEncodedString, m_cMap.IsValid() ? &m_cMap : NULL);
+    }
+    else if(m_bToUnicodeIsLoaded)
         return PdfEncoding::ConvertToUnicode(rEncodedString, pFont);
+    else if(m_cMap.HasUnicodeMappings())
+    {
+        // Predefined unicode CMaps like UniGB-UCS2-H map to unicode themselves
+        return m_cMap.DecodeToUnicode(rEncodedString);
     }
     else
         PODOFO_RAISE_ERROR( ePdfError_NotImplemented );
 }
 
+pdf_long PdfCMapEncoding::DecodeToUnicode( const PdfString & rEncodedString, pdf_utf16be* pBuffer, pdf_long lBufferLen ) const
+{
+    if( m_toUnicode.HasUnicodeMappings() )
+        return m_toUnicode.DecodeToUnicode( rEncodedString.GetString(), rEncodedString.GetLength(), 
+                                            pBuffer, lBufferLen, m_cMap.IsValid() ? &m_cMap : NULL );
+    else if( m_cMap.HasUnicodeMappings() )
+        return m_cMap.DecodeToUnicode( rEncodedString.GetString(), rEncodedString.GetLength(), pBuffer, lBufferLen );
+    else
+    {
+        PODOFO_RAISE_ERROR( ePdfError_NotImplemented );
+    }
+}
+
 PdfRefCountedBuffer PdfCMapEncoding::ConvertToEncoding( const PdfString & rString, const PdfFont* pFont ) const
 {
     if(m_bToUnicodeIsLoaded)
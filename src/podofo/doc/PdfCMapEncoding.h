@@ -62,10 +62,36 @@ public:
     virtual pdf_utf16be GetCharCode(int nIndex) const;
     virtual const PdfName & GetID() const;
     const PdfEncoding* GetBaseEncoding() const;
+
+    /** Convert an encoded string to unicode without allocating memory.
+     *  The codes are read using the codespace ranges of the CMap
+     *  of this encoding and mapped using the /ToUnicode CMap.
+     *
+     *  \param rEncodedString a string encoded by this encoding
+     *  \param pBuffer the big endian unicode string is written to this buffer
+     *  \param lBufferLen the size of pBuffer in units
+     *
+     *  \returns the length of the unicode string in units,
+     *            if it is larger than lBufferLen only
+     *            the first lBufferLen units are written
+     */
+    pdf_long DecodeToUnicode( const PdfString & rEncodedString, pdf_utf16be* pBuffer, pdf_long lBufferLen ) const;
+
+    /** 
+     *  \returns the CMap of this encoding
+     */
+    inline const PdfCMap & GetCMap() const { return m_cMap; }
+
+    /** 
+     *  \returns the /ToUnicode CMap of this encoding, 
+     *            which is invalid if there is none
+     */
+    inline const PdfCMap & GetToUnicodeCMap() const { return m_toUnicode; }
+
 private:
 
     EBaseEncoding m_baseEncoding;
-    std::map<pdf_utf16be, pdf_utf16be> m_cMap;
+    PdfCMap       m_cMap;         ///< The compiled CMap of the encoding
 };
 
 }; /*PoDoFo namespace end*/
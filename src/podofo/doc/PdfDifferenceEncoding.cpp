@@ -47,11 +47,14 @@
 
 namespace PoDoFo {
 
+// This table has to stay sorted by name (as compared by strcmp),
+// as it is searched using a binary search in FindUnicodeByName
 static struct {
     pdf_utf16be u; // in fact this might be little endian on LE systems
     const char *name;
 } nameToUnicodeTab[] = {
   {0x0021, "!"},
+  {0x0022, "\""},
   {0x0023, "#"},
   {0x0024, "$"},
   {0x0025, "%"},
@@ -376,7 +379,6 @@ static struct {
   {0x017b, "Zdotaccent"},
   {0x0396, "Zeta"},
   {0x005a, "Zsmall"},
-  {0x0022, "\""},
   {0x005c, "\\"},
   {0x005d, "]"},
   {0x005e, "^"},
@@ -797,15 +799,16 @@ static struct {
   {0x0021, "exclamsmall"},
   {0x2203, "existential"},
   {0x0066, "f"},
-  {0xfb00, "ff"},
-  {0xfb03, "ffi"},
-  {0xfb04, "ffl"},
-  {0xfb01, "fi"},
   {0xfb00, "f_f"},
   {0xfb03, "f_f_i"},
   {0xfb04, "f_f_l"},
   {0xfb01, "f_i"},
+  {0xfb02, "f_l"},
   {0x2640, "female"},
+  {0xfb00, "ff"},
+  {0xfb03, "ffi"},
+  {0xfb04, "ffl"},
+  {0xfb01, "fi"},
   {0x2012, "figuredash"},
   {0x25a0, "filledbox"},
   {0x25ac, "filledrect"},
@@ -815,7 +818,6 @@ static struct {
   {0x0035, "fiveoldstyle"},
   {0x2075, "fivesuperior"},
   {0xfb02, "fl"},
-  {0xfb02, "f_l"},
   {0x0192, "florin"},
   {0x0034, "four"},
   {0x2084, "fourinferior"},
@@ -1142,6 +1144,8 @@ static struct {
   { 0, NULL }
 };
 
+// This table has to stay sorted by unicode value,
+// as it is searched using a binary search in FindNameByUnicode
 static struct {
     pdf_utf16be u;
     const char *name;
@@ -2201,6 +2205,57 @@ static struct {
     {0xFFFF, NULL}
 };
 
+/** Find a glyph name in nameToUnicodeTab
+ *
+ *  \param pszName the glyph name to search for
+ *  \returns the index of the name in nameToUnicodeTab or -1 if it was not found
+ */
+static int FindUnicodeByName( const char* pszName )
+{
+    // the last entry of the table is the terminating NULL entry
+    int nLow  = 0;
+    int nHigh = static_cast<int>(sizeof(nameToUnicodeTab) / sizeof(nameToUnicodeTab[0])) - 2;
+
+    while( nLow <= nHigh ) 
+    {
+        int nMid = nLow + (nHigh - nLow) / 2;
+        int nCmp = strcmp( nameToUnicodeTab[nMid].name, pszName );
+        if( nCmp == 0 )
+            return nMid;
+        else if( nCmp < 0 )
+            nLow = nMid + 1;
+        else
+            nHigh = nMid - 1;
+    }
+
+    return -1;
+}
+
+/** Find a unicode value in UnicodeToNameTab
+ *
+ *  \param u the unicode value in host byte order to search for
+ *  \returns the index of the value in UnicodeToNameTab or -1 if it was not found
+ */
+static int FindNameByUnicode( pdf_utf16be u )
+{
+    // the last entry of the table is the terminating NULL entry
+    int nLow  = 0;
+    int nHigh = static_cast<int>(sizeof(UnicodeToNameTab) / sizeof(UnicodeToNameTab[0])) - 2;
+
+    while( nLow <= nHigh ) 
+    {
+        int nMid = nLow + (nHigh - nLow) / 2;
+        if( UnicodeToNameTab[nMid].u == u )
+            return nMid;
+        else if( UnicodeToNameTab[nMid].u < u )
+            nLow = nMid + 1;
+        else
+            nHigh = nMid - 1;
+    }
+
+    return -1;
+}
+
 PdfEncodingDifference::PdfEncodingDifference()
 {
 }
@@ -2299,7 +2354,6 @@ bool PdfEncodingDifference::Contains( int nCode, PdfName & rName, pdf_utf16be &
 
 bool PdfEncodingDifference::ContainsUnicodeValue( pdf_utf16be unicodeValue, char &rValue ) const
 {
-	printf ("%s:\n", __FUNCTION__);
 	TCIVecDifferences it, end = m_vecDifferences.end();
 	for (it = m_vecDifferences.begin(); it != end; it++) {
 		pdf_utf16be uv = it->unicodeValue;
@@ -2496,13 +2550,13 @@ pdf_utf16be PdfDifferenceEncoding::NameToUnicodeID( const PdfName & rName )
 {
     const char* pszName = rName.GetName().c_str();
 
-    for( int i = 0; nameToUnicodeTab[i].name; ++i) 
+    int         i       = FindUnicodeByName( pszName );
+    if( i != -1 ) 
     {
-        if ( strcmp( nameToUnicodeTab[i].name, pszName ) == 0 )
 #ifdef PODOFO_IS_LITTLE_ENDIAN
-            return ((nameToUnicodeTab[i].u & 0xff00) >> 8) | ((nameToUnicodeTab[i].u & 0xff) << 8);
+        return ((nameToUnicodeTab[i].u & 0xff00) >> 8) | ((nameToUnicodeTab[i].u & 0xff) << 8);
 #else
-            return nameToUnicodeTab[i].u;
+        return nameToUnicodeTab[i].u;
 #endif // PODOFO_IS_LITTLE_ENDIAN
     }
 
@@ -2532,19 +2586,11 @@ PdfName PdfDifferenceEncoding::UnicodeIDToName( pdf_utf16be inCodePoint )
     inCodePoint = ((inCodePoint & 0xff00) >> 8) | ((inCodePoint & 0xff) << 8);
 #endif // PODOFO_IS_LITTLE_ENDIAN
 
-    int i;
-	for( i = 0; UnicodeToNameTab[i].name; ++i) 
-    {
-        if ( UnicodeToNameTab[i].u == inCodePoint ) 
-            return PdfName( UnicodeToNameTab[i].name );
-    }
-
-    // if we can't find in the canonical list, look in the complete list
-    for ( i = 0; nameToUnicodeTab[i].name; ++i) 
-    {
-        if ( nameToUnicodeTab[i].u == inCodePoint )
-            return PdfName( UnicodeToNameTab[i].name );
-    }
+    // the canonical list contains all values of the complete list
+    // nameToUnicodeTab, so there is no need to search the latter
+    int i = FindNameByUnicode( inCodePoint );
+    if( i != -1 ) 
+        return PdfName( UnicodeToNameTab[i].name );
 
     // if we get here, then we are looking up an undefined codepoint
     // so we'll just give it SOME name..
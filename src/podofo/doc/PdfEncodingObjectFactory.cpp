@@ -78,6 +78,8 @@ const PdfEncoding *PdfEncodingObjectFactory::CreateEncoding (PdfObject *pObject,
             return PdfEncodingFactory::GlobalZapfDingbatsEncodingInstance ();
         else if (rName == PdfName ("Identity-H"))
             return new PdfIdentityEncoding (0, 0xffff, true, pToUnicode);
+        else if (PdfCMapCache::GetPredefinedCMap (rName).IsValid ())
+            return new PdfCMapEncoding (pObject, pToUnicode);
     }
   	else if (pObject->HasStream ())
     {
@@ -46,6 +46,7 @@
 #include "PdfFontMetricsBase14.h"
 #include "PdfFontTTFSubset.h"
 #include "PdfFontType1.h"
+#include "PdfSharedFontCache.h"
 
 #include <algorithm>
 
@@ -295,6 +296,8 @@ PdfFontCache::~PdfFontCache()
 
 void PdfFontCache::Init(void)
 {
+    m_nRenumberCount = m_pParent ? m_pParent->GetRenumberCount() : 0;
+
     m_sSubsetBasename[0] = 0;
     char *p = m_sSubsetBasename;
     int ii;
@@ -332,34 +335,18 @@ void PdfFontCache::EmptyCache()
 
     m_vecFonts.clear();
     m_vecFontSubsets.clear();
+    m_mapFontReferences.clear();
 }
 
 PdfFont* PdfFontCache::GetFont( PdfObject* pObject )
 {
-    TCISortedFontList it = m_vecFonts.begin();
-    const PdfReference & ref = pObject->Reference(); 
-
-    // Search if the object is a cached normal font
-    while( it != m_vecFonts.end() )
-    {
-        if( (*it).m_pFont->GetObject()->Reference() == ref ) 
-            return (*it).m_pFont;
-
-        ++it;
-    }
-
-    // Search if the object is a cached font subset
-    it = m_vecFontSubsets.begin();
-    while( it != m_vecFontSubsets.end() )
-    {
-        if( (*it).m_pFont->GetObject()->Reference() == ref ) 
-            return (*it).m_pFont;
-
-        ++it;
-    }
+    // Search if the object is a cached normal font or font subset
+    PdfFont* pFont = this->FindFont( pObject->Reference() );
+    if( pFont )
+        return pFont;
 
     // Create a new font
-    PdfFont* pFont = PdfFontFactory::CreateFont( &m_ftLibrary, pObject );
+    pFont = PdfFontFactory::CreateFont( &m_ftLibrary, pObject );
     if( pFont ) 
     {
         TFontCacheElement element;
@@ -369,15 +356,54 @@ PdfFont* PdfFontCache::GetFont( PdfObject* pObject )
         element.m_sFontName = pFont->GetFontMetrics()->GetFontname();
         element.m_pEncoding = NULL;
         element.m_bIsSymbolCharset = pFont->GetFontMetrics()->IsSymbol();
-        m_vecFonts.push_back( element );
-        
-        // Now sort the font list
-        std::sort( m_vecFonts.begin(), m_vecFonts.end() );
+
+        // Do a sorted insert, so no need to sort again
+        m_vecFonts.insert( std::upper_bound( m_vecFonts.begin(), m_vecFonts.end(), element ), element );
+        this->IndexFont( pFont );
     }
     
     return pFont;
 }
 
+PdfFont* PdfFontCache::FindFont( const PdfReference & rRef )
+{
+    // The objects have been renumbered since the index was built,
+    // so cached fonts may have references which are not indexed yet
+    if( m_pParent && m_pParent->GetRenumberCount() != m_nRenumberCount )
+        this->RebuildFontIndex();
+
+    TCIMapFontReferences it = m_mapFontReferences.find( rRef );
+    if( it != m_mapFontReferences.end() && (*it).second->GetObject()->Reference() != rRef )
+    {
+        // The font objects were renumbered without the cache noticing it
+        this->RebuildFontIndex();
+        it = m_mapFontReferences.find( rRef );
+    }
+
+    return it != m_mapFontReferences.end() ? (*it).second : NULL;
+}
+
+void PdfFontCache::RebuildFontIndex()
+{
+    m_mapFontReferences.clear();
+    m_nRenumberCount = m_pParent ? m_pParent->GetRenumberCount() : 0;
+
+    TCISortedFontList it = m_vecFontSubsets.begin();
+    while( it != m_vecFontSubsets.end() )
+    {
+        this->IndexFont( (*it).m_pFont );
+        ++it;
+    }
+
+    // Normal fonts take precedence over font subsets
+    it = m_vecFonts.begin();
+    while( it != m_vecFonts.end() )
+    {
+        this->IndexFont( (*it).m_pFont );
+        ++it;
+    }
+}
+
 PdfFont* PdfFontCache::GetFont( const char* pszFontName, bool bBold, bool bItalic, bool bSymbolCharset,
                                 bool bEmbedd, EFontCreationFlags eFontCreationFlags,
                                 const PdfEncoding * const pEncoding, 
@@ -428,6 +454,7 @@ PdfFont* PdfFontCache::GetFont( const char* pszFontName, bool bBold, bool bItali
                 // Do a sorted insert, so no need to sort again
                 //rvecContainer.insert( itSorted, element ); 
                 m_vecFonts.insert( it.first, element );
+                this->IndexFont( pFont );
                 
              }
 
@@ -450,7 +477,7 @@ PdfFont* PdfFontCache::GetFont( const char* pszFontName, bool bBold, bool bItali
             }
             else
             {
-                pMetrics = new PdfFontMetricsFreetype( &m_ftLibrary, sPath.c_str(), bSymbolCharset, bSubsetting ? genSubsetBasename() : NULL );
+                pMetrics = this->CreateFontMetrics( sPath.c_str(), bSymbolCharset, bSubsetting ? genSubsetBasename() : NULL );
                 pFont    = this->CreateFontObject( it.first, m_vecFonts, pMetrics, 
                            bEmbedd, bBold, bItalic, pszFontName, pEncoding, bSubsetting );
             }
@@ -604,7 +631,7 @@ PdfFont* PdfFontCache::GetDuplicateFontType1( PdfFont * pFont, const char* pszSu
 
     // Create a copy of the font
     PODOFO_ASSERT( pFont->GetFontMetrics()->GetFontType() == ePdfFontType_Type1Pfb );
-    PdfFontMetrics* pMetrics = new PdfFontMetricsFreetype( &m_ftLibrary, pFont->GetFontMetrics()->GetFilename(), pFont->GetFontMetrics()->IsSymbol() );
+    PdfFontMetrics* pMetrics = this->CreateFontMetrics( pFont->GetFontMetrics()->GetFilename(), pFont->GetFontMetrics()->IsSymbol() );
     PdfFont* newFont = new PdfFontType1( static_cast<PdfFontType1 *>(pFont), pMetrics, pszSuffix, m_pParent );
     if( newFont ) 
     {
@@ -617,10 +644,10 @@ PdfFont* PdfFontCache::GetDuplicateFontType1( PdfFont * pFont, const char* pszSu
         element.m_sFontName = name;
         element.m_pEncoding = newFont->GetEncoding();
           element.m_bIsSymbolCharset = pFont->GetFontMetrics()->IsSymbol();
-        m_vecFonts  .push_back( element );
-        
-        // Now sort the font list
-        std::sort( m_vecFonts.begin(), m_vecFonts.end() );
+
+        // Do a sorted insert, so no need to sort again
+        m_vecFonts.insert( std::upper_bound( m_vecFonts.begin(), m_vecFonts.end(), element ), element );
+        this->IndexFont( newFont );
     }
 
     return newFont;
@@ -860,16 +887,34 @@ std::string PdfFontCache::GetFontConfigFontPath( FcConfig* pConfig, const char*
 std::string PdfFontCache::GetFontPath( const char* pszFontName, bool bBold, bool bItalic )
 {
 #if defined(PODOFO_HAVE_FONTCONFIG)
-    Util::PdfMutexWrapper mutex(m_fontConfig.GetFontConfigMutex());
-    FcConfig* pFcConfig = static_cast<FcConfig*>(m_fontConfig.GetFontConfig());
-    std::string sPath   = this->GetFontConfigFontPath( pFcConfig,
-                                                       pszFontName, bBold, bItalic );
+    std::string sPath;
+    bool        bShared = PdfSharedFontCache::IsEnabled();
+    if( bShared && PdfSharedFontCache::GetFontPath( pszFontName, bBold, bItalic, sPath ) )
+        return sPath;
+
+    {
+        Util::PdfMutexWrapper mutex(m_fontConfig.GetFontConfigMutex());
+        FcConfig* pFcConfig = static_cast<FcConfig*>(m_fontConfig.GetFontConfig());
+        sPath = this->GetFontConfigFontPath( pFcConfig, pszFontName, bBold, bItalic );
+    }
+
+    if( bShared )
+        PdfSharedFontCache::AddFontPath( pszFontName, bBold, bItalic, sPath );
 #else
     std::string sPath = "";
 #endif
     return sPath;
 }
 
+PdfFontMetrics* PdfFontCache::CreateFontMetrics( const char* pszFilename, bool bSymbolCharset, const char* pszSubsetPrefix )
+{
+    if( PdfSharedFontCache::IsEnabled() )
+        return new PdfFontMetricsFreetype( &m_ftLibrary, PdfSharedFontCache::GetFontFile( pszFilename ), 
+                                           bSymbolCharset, pszSubsetPrefix );
+
+    return new PdfFontMetricsFreetype( &m_ftLibrary, pszFilename, bSymbolCharset, pszSubsetPrefix );
+}
+
 PdfFont* PdfFontCache::CreateFontObject( TISortedFontList itSorted, TSortedFontList & rvecContainer, 
                      PdfFontMetrics* pMetrics, bool bEmbedd, bool bBold, bool bItalic, 
                      const char* pszFontName, const PdfEncoding * const pEncoding, bool bSubsetting ) 
@@ -905,6 +950,7 @@ PdfFont* PdfFontCache::CreateFontObject( TISortedFontList itSorted, TSortedFontL
             
             // Do a sorted insert, so no need to sort again
             rvecContainer.insert( itSorted, element );
+            this->IndexFont( pFont );
         }
     } catch( PdfError & e ) {
         e.AddToCallstack( __FILE__, __LINE__ );
@@ -42,6 +42,8 @@
 #include "PdfFont.h"
 #include "PdfFontConfigWrapper.h"
 
+#include <map>
+
 #ifdef _WIN32
 
 // to have LOGFONTA/LOGFONTW available
@@ -171,6 +173,9 @@ class PODOFO_DOC_API PdfFontCache {
     typedef TSortedFontList::iterator       TISortedFontList;
     typedef TSortedFontList::const_iterator TCISortedFontList;
 
+    typedef std::map<PdfReference,PdfFont*> TMapFontReferences;
+    typedef TMapFontReferences::const_iterator TCIMapFontReferences;
+
  public:
 
     /**
@@ -361,6 +366,18 @@ class PODOFO_DOC_API PdfFontCache {
      */
     std::string GetFontPath( const char* pszFontName, bool bBold, bool bItalic );
 
+    /**
+     * Create the metrics for a font file, sharing
+     * the font file if the PdfSharedFontCache is enabled.
+     *
+     * \param pszFilename path to a font file
+     * \param bSymbolCharset whether to use a symbol charset, rather than unicode
+     * \param pszSubsetPrefix unique prefix for font subsets or NULL
+     *
+     * \returns new font metrics, which are owned by the caller
+     */
+    PdfFontMetrics* CreateFontMetrics( const char* pszFilename, bool bSymbolCharset, const char* pszSubsetPrefix = NULL );
+
     /** Create a font and put it into the fontcache
      *
      *  \param itSorted iterator pointing to a location in vecContainer
@@ -428,12 +445,34 @@ class PODOFO_DOC_API PdfFontCache {
 	// kind of ABCDEF+
 	const char *genSubsetBasename(void);
 
+    /** Find a cached font or font subset by the reference of its font object
+     *
+     *  \param rRef reference of a font object
+     *
+     *  \returns the font or NULL if it is not in the cache
+     */
+    PdfFont* FindFont( const PdfReference & rRef );
+
+    /** Add a font to the index of fonts by reference,
+     *  all fonts have to be added after they were cached.
+     *
+     *  \param pFont a font in m_vecFonts or m_vecFontSubsets
+     */
+    inline void IndexFont( PdfFont* pFont );
+
+    /** Build the index of fonts by reference again,
+     *  e.g. after the objects have been renumbered
+     */
+    void RebuildFontIndex();
+
  protected:
     void Init(void);
 	
  private:
     TSortedFontList m_vecFonts;              ///< Sorted list of all fonts, currently in the cache
     TSortedFontList m_vecFontSubsets;
+    TMapFontReferences m_mapFontReferences; ///< All fonts and font subsets by the reference of their font object
+    size_t          m_nRenumberCount;        ///< PdfVecObjects::GetRenumberCount() of m_pParent when m_mapFontReferences was built
     FT_Library      m_ftLibrary;             ///< Handle to the freetype library
 
     PdfVecObjects*  m_pParent;               ///< Handle to parent for creating new fonts and objects
@@ -460,6 +499,14 @@ inline void PdfFontCache::SetFontConfigWrapper(const PdfFontConfigWrapper & rFon
     m_fontConfig = rFontConfig;
 }
 
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+inline void PdfFontCache::IndexFont( PdfFont* pFont )
+{
+    m_mapFontReferences[pFont->GetObject()->Reference()] = pFont;
+}
+
 };
 
 #endif /* _PDF_FONT_CACHE_H_ */
@@ -951,8 +951,10 @@ double PdfFontMetrics::StringWidth( const char* pszText, pdf_long nLength ) cons
 
 double PdfFontMetrics::StringWidth( const pdf_utf16be* pszText, unsigned int nLength ) const
 {
-    double dWidth = 0.0;
-    unsigned short uChar;
+    const unsigned int CHUNK_SIZE = 256;
+    double             dWidths[CHUNK_SIZE];
+    double             dWidth = 0.0;
+    unsigned short     uChar;
 
     if( !pszText )
         return dWidth;
@@ -967,23 +969,59 @@ double PdfFontMetrics::StringWidth( const pdf_utf16be* pszText, unsigned int nLe
     }
     }
 
+    // Calculate the widths of a whole chunk of characters at once
     const pdf_utf16be* localText = pszText;
-    for ( unsigned int i=0; i<nLength; i++ )
+    while( nLength )
     {
+        unsigned int nChunk = PDF_MIN( nLength, CHUNK_SIZE );
+        if( nChunk < nLength )
+        {
+            // Do not split a surrogate pair between two chunks
 #ifdef PODOFO_IS_LITTLE_ENDIAN
-        uChar = static_cast<unsigned short>(((*localText & 0x00ff) << 8 | (*localText & 0xff00) >> 8));
+            uChar = static_cast<unsigned short>(((localText[nChunk-1] & 0x00ff) << 8 | (localText[nChunk-1] & 0xff00) >> 8));
 #else
-        uChar = static_cast<unsigned short>(*localText);
+            uChar = static_cast<unsigned short>(localText[nChunk-1]);
 #endif // PODOFO_IS_LITTLE_ENDIAN
-        dWidth += UnicodeCharWidth( uChar );
-        if ( uChar == 0x0020 )
-            dWidth += m_fWordSpace * this->GetFontScale() / 100.0;
-        localText++;
+            if( uChar >= 0xd800 && uChar <= 0xdbff )
+                --nChunk;
+        }
+
+        this->UnicodeCharWidths( localText, nChunk, dWidths );
+
+        for ( unsigned int i=0; i<nChunk; i++ )
+        {
+#ifdef PODOFO_IS_LITTLE_ENDIAN
+            uChar = static_cast<unsigned short>(((*localText & 0x00ff) << 8 | (*localText & 0xff00) >> 8));
+#else
+            uChar = static_cast<unsigned short>(*localText);
+#endif // PODOFO_IS_LITTLE_ENDIAN
+            dWidth += dWidths[i];
+            if ( uChar == 0x0020 )
+                dWidth += m_fWordSpace * this->GetFontScale() / 100.0;
+            localText++;
+        }
+
+        nLength -= nChunk;
     }
 
     return dWidth;
 }
 
+void PdfFontMetrics::UnicodeCharWidths( const pdf_utf16be* pszText, unsigned int nLength, double* pdWidths ) const
+{
+    unsigned short uChar;
+
+    for ( unsigned int i=0; i<nLength; i++ )
+    {
+#ifdef PODOFO_IS_LITTLE_ENDIAN
+        uChar = static_cast<unsigned short>(((pszText[i] & 0x00ff) << 8 | (pszText[i] & 0xff00) >> 8));
+#else
+        uChar = static_cast<unsigned short>(pszText[i]);
+#endif // PODOFO_IS_LITTLE_ENDIAN
+        pdWidths[i] = this->UnicodeCharWidth( uChar );
+    }
+}
+
 #ifndef _WCHAR_T_DEFINED
 #if defined(_MSC_VER)  &&  _MSC_VER <= 1200    // not for MS Visual Studio 6
 #else
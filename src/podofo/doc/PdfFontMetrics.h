@@ -166,6 +166,19 @@ class PODOFO_DOC_API PdfFontMetrics {
      */
     virtual double UnicodeCharWidth( unsigned short c ) const = 0;
 
+    /** Retrieve the widths of all characters of a text string in PDF units in the current font.
+     *  This gives the same widths as calling UnicodeCharWidth for every character,
+     *  but is faster as the whole string is handled at once.
+     *
+     *  \param pszText a UTF-16BE text string
+     *  \param nLength the number of UTF-16 code units in pszText
+     *  \param pdWidths the width of each code unit is written to this array, 
+     *                  which has to have room for nLength values.
+     *                  Fonts supporting characters beyond the BMP write the width
+     *                  of a surrogate pair to its first and 0.0 to its second code unit.
+     */
+    virtual void UnicodeCharWidths( const pdf_utf16be* pszText, unsigned int nLength, double* pdWidths ) const;
+
     /** Retrieve the width of the given character in 1/1000th mm in the current font
      *  \param c character
      *  \returns the width in 1/1000th mm
@@ -51,6 +51,8 @@
 
 #define PODOFO_FIRST_READABLE 31
 #define PODOFO_WIDTH_CACHE_SIZE 256
+#define PODOFO_WIDTH_PAGE_SIZE 256
+#define PODOFO_LAST_UNICODE 0x10ffff
 
 namespace PoDoFo {
 
@@ -146,6 +148,27 @@ PdfFontMetricsFreetype::PdfFontMetricsFreetype( FT_Library* pLibrary,
     InitFromBuffer(pIsSymbol);
 }
 
+PdfFontMetricsFreetype::PdfFontMetricsFreetype( FT_Library* pLibrary, 
+                                                const PdfSharedFontFile & rFile,
+                                                                bool pIsSymbol,
+                                                const char* pszSubsetPrefix ) 
+    : PdfFontMetrics( PdfFontMetrics::FontTypeFromFilename( rFile.GetFilename() ),
+                      rFile.GetFilename(), pszSubsetPrefix ),
+      m_pLibrary( pLibrary ),
+      m_pFace( NULL ),
+      m_bSymbol( pIsSymbol ),
+      m_sharedFontFile( rFile )
+{
+    if( !m_sharedFontFile.IsValid() ) 
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
+    }
+
+    // Unlike InitFromBuffer the font type is known from the filename
+    this->OpenFace( m_sharedFontFile.GetData(), m_sharedFontFile.GetLength() );
+    InitFromFace(pIsSymbol);
+}
+
 PdfFontMetricsFreetype::PdfFontMetricsFreetype( FT_Library* pLibrary, 
                                                 FT_Face face, 
                                                                 bool pIsSymbol,
@@ -168,6 +191,8 @@ PdfFontMetricsFreetype::PdfFontMetricsFreetype( FT_Library* pLibrary,
 
 PdfFontMetricsFreetype::~PdfFontMetricsFreetype()
 {
+    this->ClearWidthPages();
+
     if ( m_pFace )
     {
         FT_Done_Face( m_pFace );
@@ -175,25 +200,28 @@ PdfFontMetricsFreetype::~PdfFontMetricsFreetype()
 }
 
 void PdfFontMetricsFreetype::InitFromBuffer(bool pIsSymbol)
+{
+    this->OpenFace( m_bufFontData.GetBuffer(), m_bufFontData.GetSize() );
+
+    // asume true type
+    this->SetFontType( ePdfFontType_TrueType );
+
+    InitFromFace(pIsSymbol);
+}
+
+void PdfFontMetricsFreetype::OpenFace( const char* pBuffer, pdf_long lLen )
 {
     FT_Open_Args openArgs;
     memset(&openArgs, 0, sizeof(openArgs));
     openArgs.flags = FT_OPEN_MEMORY;
-    openArgs.memory_base = reinterpret_cast<FT_Byte*>(m_bufFontData.GetBuffer()), 
-    openArgs.memory_size = static_cast<FT_Long>(m_bufFontData.GetSize());
+    openArgs.memory_base = reinterpret_cast<const FT_Byte*>(pBuffer);
+    openArgs.memory_size = static_cast<FT_Long>(lLen);
     FT_Error error = FT_Open_Face( *m_pLibrary, &openArgs, 0, &m_pFace ); 
     if( error ) 
     {
         PdfError::LogMessage( eLogSeverity_Critical, "FreeType returned the error %i when calling FT_New_Face for a buffered font.", error );
         PODOFO_RAISE_ERROR( ePdfError_FreeType );
     }
-    else
-    {
-        // asume true type
-        this->SetFontType( ePdfFontType_TrueType );
-    }
-
-    InitFromFace(pIsSymbol);
 }
 
 void PdfFontMetricsFreetype::InitFromFace(bool pIsSymbol)
@@ -243,28 +271,36 @@ void PdfFontMetricsFreetype::InitFromFace(bool pIsSymbol)
         // we cache the 256 first width entries as they
         // are most likely needed quite often
         m_vecWidth.clear();
-        m_vecWidth.reserve( PODOFO_WIDTH_CACHE_SIZE );
-        for( unsigned int i=0; i < PODOFO_WIDTH_CACHE_SIZE; i++ )
+        this->ClearWidthPages();
+        // the widths might have been calculated already by another document
+        if( !m_sharedFontFile.GetWidths( m_bSymbol, m_vecWidth ) )
         {
-            if( i < PODOFO_FIRST_READABLE || !m_pFace )
-                m_vecWidth.push_back( 0.0  );
-            else
+            m_vecWidth.reserve( PODOFO_WIDTH_CACHE_SIZE );
+            for( unsigned int i=0; i < PODOFO_WIDTH_CACHE_SIZE; i++ )
             {
-                int index = i;
-                // Handle symbol fonts
-                if( m_bSymbol ) 
-                {
-                    index = index | 0xf000;
-                }
-
-                if( FT_Load_Char( m_pFace, index, FT_LOAD_NO_SCALE | FT_LOAD_NO_BITMAP) == 0 )  // | FT_LOAD_NO_RENDER
+                if( i < PODOFO_FIRST_READABLE || !m_pFace )
+                    m_vecWidth.push_back( 0.0  );
+                else
                 {
-                    m_vecWidth.push_back( static_cast<double>(m_pFace->glyph->metrics.horiAdvance) * 1000.0 / m_pFace->units_per_EM );
-                    continue;
-                }
+                    int index = i;
+                    // Handle symbol fonts
+                    if( m_bSymbol ) 
+                    {
+                        index = index | 0xf000;
+                    }
+
+                    if( FT_Load_Char( m_pFace, index, FT_LOAD_NO_SCALE | FT_LOAD_NO_BITMAP) == 0 )  // | FT_LOAD_NO_RENDER
+                    {
+                        m_vecWidth.push_back( static_cast<double>(m_pFace->glyph->metrics.horiAdvance) * 1000.0 / m_pFace->units_per_EM );
+                        continue;
+                    }
                 
-                m_vecWidth.push_back( 0.0  );
+                    m_vecWidth.push_back( 0.0  );
+                }
             }
+
+            if( m_sharedFontFile.IsValid() )
+                m_sharedFontFile.SetWidths( m_bSymbol, m_vecWidth );
         }
     }
 
@@ -331,14 +367,8 @@ void PdfFontMetricsFreetype::GetWidthArray( PdfVariant & var, unsigned int nFirs
                 list.push_back( PdfVariant( (pdf_int64)this->GetGlyphWidth(this->GetGlyphId(shCode)) ) );
                 continue;
             }
-            else if( FT_Load_Char( m_pFace, i, FT_LOAD_NO_SCALE | FT_LOAD_NO_BITMAP ) == 0 )  // | FT_LOAD_NO_RENDER
-            {
-                // zero return code is success!
-                list.push_back( PdfVariant( m_pFace->glyph->metrics.horiAdvance * 1000.0 / m_pFace->units_per_EM ) );
-                continue;
-            }
-            //PODOFO_RAISE_ERROR( ePdfError_FreeType );
-            list.push_back( PdfVariant( 0.0 ) );
+
+            list.push_back( PdfVariant( this->GetUnicodeWidth( i ) ) );
         }
     }
 
@@ -390,24 +420,98 @@ double PdfFontMetricsFreetype::CharWidth( unsigned char c ) const
 
 double PdfFontMetricsFreetype::UnicodeCharWidth( unsigned short c ) const
 {
-    FT_Error ftErr;
-    double   dWidth = 0.0;
+    double dWidth = this->GetUnicodeWidth( c );
+
+    return dWidth * static_cast<double>(this->GetFontSize() * this->GetFontScale() / 100.0) / 1000.0 +
+        static_cast<double>( this->GetFontSize() * this->GetFontScale() / 100.0 * this->GetFontCharSpace() / 100.0);
+}
+
+void PdfFontMetricsFreetype::UnicodeCharWidths( const pdf_utf16be* pszText, unsigned int nLength, double* pdWidths ) const
+{
+    // The scaling is the same for all characters
+    const double dScale     = static_cast<double>(this->GetFontSize() * this->GetFontScale() / 100.0) / 1000.0;
+    const double dCharSpace = static_cast<double>( this->GetFontSize() * this->GetFontScale() / 100.0 * this->GetFontCharSpace() / 100.0);
 
-    if( static_cast<int>(c) < PODOFO_WIDTH_CACHE_SIZE ) 
+    unsigned long lUnicode;
+    unsigned long lLow;
+    for( unsigned int i=0; i<nLength; i++ )
     {
-        dWidth = m_vecWidth[static_cast<unsigned int>(c)];
+#ifdef PODOFO_IS_LITTLE_ENDIAN
+        lUnicode = ((pszText[i] & 0x00ff) << 8 | (pszText[i] & 0xff00) >> 8);
+#else
+        lUnicode = pszText[i];
+#endif // PODOFO_IS_LITTLE_ENDIAN
+
+        if( lUnicode >= 0xd800 && lUnicode <= 0xdbff && i + 1 < nLength )
+        {
+#ifdef PODOFO_IS_LITTLE_ENDIAN
+            lLow = ((pszText[i+1] & 0x00ff) << 8 | (pszText[i+1] & 0xff00) >> 8);
+#else
+            lLow = pszText[i+1];
+#endif // PODOFO_IS_LITTLE_ENDIAN
+            if( lLow >= 0xdc00 && lLow <= 0xdfff )
+            {
+                // A surrogate pair gets the width of the whole character
+                lUnicode = 0x10000 + ((lUnicode - 0xd800) << 10) + (lLow - 0xdc00);
+                pdWidths[i]   = this->GetUnicodeWidth( lUnicode ) * dScale + dCharSpace;
+                pdWidths[++i] = 0.0;
+                continue;
+            }
+        }
+
+        pdWidths[i] = this->GetUnicodeWidth( lUnicode ) * dScale + dCharSpace;
     }
-    else
+}
+
+double PdfFontMetricsFreetype::GetUnicodeWidth( unsigned long lUnicode ) const
+{
+    if( lUnicode < PODOFO_WIDTH_CACHE_SIZE ) 
+        return m_vecWidth[lUnicode];
+
+    if( lUnicode > PODOFO_LAST_UNICODE )
+        return 0.0;
+
+    const unsigned long lPage = lUnicode / PODOFO_WIDTH_PAGE_SIZE;
+    if( lPage >= m_vecWidthPages.size() ) 
+        m_vecWidthPages.resize( lPage + 1, NULL );
+
+    double* pPage = m_vecWidthPages[lPage];
+    if( !pPage ) 
     {
-        ftErr = FT_Load_Char( m_pFace, static_cast<FT_UInt>(c), FT_LOAD_NO_SCALE | FT_LOAD_NO_BITMAP );
-        if( ftErr )
-            return dWidth;
+        pPage = static_cast<double*>(podofo_calloc( PODOFO_WIDTH_PAGE_SIZE, sizeof(double) ));
+        if( !pPage ) 
+        {
+            PODOFO_RAISE_ERROR( ePdfError_OutOfMemory );
+        }
 
-        dWidth = m_pFace->glyph->metrics.horiAdvance * 1000.0 / m_pFace->units_per_EM;
+        for( int i=0; i < PODOFO_WIDTH_PAGE_SIZE; i++ )
+            pPage[i] = -1.0;
+
+        m_vecWidthPages[lPage] = pPage;
     }
 
-    return dWidth * static_cast<double>(this->GetFontSize() * this->GetFontScale() / 100.0) / 1000.0 +
-        static_cast<double>( this->GetFontSize() * this->GetFontScale() / 100.0 * this->GetFontCharSpace() / 100.0);
+    double & rdWidth = pPage[lUnicode % PODOFO_WIDTH_PAGE_SIZE];
+    if( rdWidth < 0.0 ) 
+    {
+        if( FT_Load_Char( m_pFace, static_cast<FT_ULong>(lUnicode), FT_LOAD_NO_SCALE | FT_LOAD_NO_BITMAP ) == 0 )
+            rdWidth = m_pFace->glyph->metrics.horiAdvance * 1000.0 / m_pFace->units_per_EM;
+        else
+            rdWidth = 0.0;
+    }
+
+    return rdWidth;
+}
+
+void PdfFontMetricsFreetype::ClearWidthPages()
+{
+    std::vector<double*>::iterator it = m_vecWidthPages.begin();
+    while( it != m_vecWidthPages.end() )
+    {
+        podofo_free( *it );
+        ++it;
+    }
+
+    m_vecWidthPages.clear();
 }
 
 long PdfFontMetricsFreetype::GetGlyphId( long lUnicode ) const
@@ -479,6 +583,9 @@ double PdfFontMetricsFreetype::GetStrikeoutThickness() const
 // -----------------------------------------------------
 const char* PdfFontMetricsFreetype::GetFontData() const
 {
+    if( m_sharedFontFile.IsValid() )
+        return m_sharedFontFile.GetData();
+
     return m_bufFontData.GetBuffer();
 }
 
@@ -487,6 +594,9 @@ const char* PdfFontMetricsFreetype::GetFontData() const
 // -----------------------------------------------------
 pdf_long PdfFontMetricsFreetype::GetFontDataLen() const
 {
+    if( m_sharedFontFile.IsValid() )
+        return m_sharedFontFile.GetLength();
+
     return m_bufFontData.GetSize();
 }  
 
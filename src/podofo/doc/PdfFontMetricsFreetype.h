@@ -38,6 +38,7 @@
 #include "podofo/base/Pdf3rdPtyForwardDecl.h"
 #include "podofo/base/PdfString.h"
 #include "PdfFontMetrics.h"
+#include "PdfSharedFontCache.h"
 
 namespace PoDoFo {
 
@@ -75,6 +76,19 @@ class PODOFO_DOC_API PdfFontMetricsFreetype : public PdfFontMetrics {
     PdfFontMetricsFreetype( FT_Library* pLibrary, const PdfRefCountedBuffer & rBuffer,
 		    bool  pIsSymbol, const char* pszSubsetPrefix = NULL);
 
+    /** Create a font metrics object for a font file shared by all documents.
+     *  The font data is not copied and the widths are calculated only once per process.
+     *
+     *  \param pLibrary handle to an initialized FreeType2 library handle
+     *  \param rFile a valid font file from the PdfSharedFontCache
+	  *  \param pIsSymbol whether use a symbol encoding, rather than unicode
+     *  \param pszSubsetPrefix unique prefix for font subsets (see GetFontSubsetPrefix)
+     *
+     *  \see PdfSharedFontCache
+     */
+    PdfFontMetricsFreetype( FT_Library* pLibrary, const PdfSharedFontFile & rFile,
+		    bool  pIsSymbol, const char* pszSubsetPrefix = NULL);
+
     /** Create a font metrics object for a given freetype font.
      *  \param pLibrary handle to an initialized FreeType2 library handle
      *  \param face a valid freetype font face
@@ -144,6 +158,17 @@ class PODOFO_DOC_API PdfFontMetricsFreetype : public PdfFontMetrics {
      */
     virtual double UnicodeCharWidth( unsigned short c ) const;
 
+    /** Retrieve the widths of all characters of a text string in PDF units in the current font.
+     *  Surrogate pairs are decoded, so characters beyond the BMP are supported.
+     *
+     *  \param pszText a UTF-16BE text string
+     *  \param nLength the number of UTF-16 code units in pszText
+     *  \param pdWidths the width of each code unit is written to this array
+     *
+     *  \see PdfFontMetrics::UnicodeCharWidths
+     */
+    virtual void UnicodeCharWidths( const pdf_utf16be* pszText, unsigned int nLength, double* pdWidths ) const;
+
     /** Retrieve the line spacing for this font
      *  \returns the linespacing in PDF units
      */
@@ -267,6 +292,15 @@ class PODOFO_DOC_API PdfFontMetricsFreetype : public PdfFontMetrics {
      *  \returns the internal freetype handle
      */
     inline FT_Face GetFace();
+
+    /** Get the font file shared by all documents
+     *
+     *  \returns the shared font file or an invalid handle
+     *            if the font data is not shared
+     *
+     *  \see PdfSharedFontCache
+     */
+    inline const PdfSharedFontFile & GetSharedFontFile() const;
  
  private:
     
@@ -276,6 +310,12 @@ class PODOFO_DOC_API PdfFontMetricsFreetype : public PdfFontMetrics {
      */
     void InitFromBuffer(bool pIsSymbol);
 
+    /** Open the FreeType face from an in memory buffer
+     *  \param pBuffer font data which has to stay valid as long as the face
+     *  \param lLen length of the font data
+     */
+    void OpenFace( const char* pBuffer, pdf_long lLen );
+
     /** Load the metric data from the FTFace data
      *		Called internally by the constructors
 	  * \param pIsSymbol Whether use a symbol charset, rather than unicode
@@ -283,6 +323,18 @@ class PODOFO_DOC_API PdfFontMetricsFreetype : public PdfFontMetrics {
     void InitFromFace(bool pIsSymbol);
 
     void InitFontSizes();
+
+    /** Get the width of a unicode character in 1/1000th of the
+     *  font size from the width cache, loading it on first use.
+     *
+     *  \param lUnicode a unicode code point
+     *  \returns the unscaled width of the character or 0.0 if it is not in the font
+     */
+    double GetUnicodeWidth( unsigned long lUnicode ) const;
+
+    /** Free all pages of the width cache
+     */
+    void ClearWidthPages();
  protected:
     FT_Library*   m_pLibrary;
     FT_Face       m_pFace;
@@ -307,7 +359,14 @@ class PODOFO_DOC_API PdfFontMetricsFreetype : public PdfFontMetrics {
     double        m_dStrikeOutPosition;
 
     PdfRefCountedBuffer m_bufFontData;
+    PdfSharedFontFile   m_sharedFontFile;  ///< Font data shared by all documents, used instead of m_bufFontData
     std::vector<double> m_vecWidth;
+
+    /** Sparse cache of the widths of all characters beyond m_vecWidth,
+     *  indexed by the code point divided by 256. Each page holds 256 widths
+     *  which are negative until the width was loaded.
+     */
+    mutable std::vector<double*> m_vecWidthPages;
 };
 
 // -----------------------------------------------------
@@ -318,6 +377,14 @@ FT_Face PdfFontMetricsFreetype::GetFace()
     return m_pFace; 
 } 
 
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+const PdfSharedFontFile & PdfFontMetricsFreetype::GetSharedFontFile() const
+{
+    return m_sharedFontFile;
+}
+
  
 };
 
@@ -40,6 +40,8 @@
 #include "base/PdfName.h"
 #include "base/PdfStream.h"
 
+#include "PdfFontMetricsFreetype.h"
+
 namespace PoDoFo {
 
 PdfFontTrueType::PdfFontTrueType( PdfFontMetrics* pMetrics, const PdfEncoding* const pEncoding, 
@@ -66,9 +68,20 @@ void PdfFontTrueType::EmbedFontFile( PdfObject* pDescriptor )
     pContents = this->GetObject()->GetOwner()->CreateObject();
     pDescriptor->GetDictionary().AddKey( "FontFile2", pContents->Reference() );
 
+    // if the data is shared by all documents - use its cached encoding,
     // if the data was loaded from memory - use it from there
     // otherwise, load from disk
-    if ( m_pMetrics->GetFontDataLen() && m_pMetrics->GetFontData() ) 
+    const PdfFontMetricsFreetype* pFreetype = dynamic_cast<const PdfFontMetricsFreetype*>(m_pMetrics);
+    if( pFreetype && pFreetype->GetSharedFontFile().IsValid() ) 
+    {
+        lSize = pFreetype->GetSharedFontFile().GetLength();
+        // Set Length1 before creating the stream
+        // as PdfStreamedDocument does not allow 
+        // adding keys to an object after a stream was written
+        pContents->GetDictionary().AddKey( "Length1", PdfVariant( static_cast<pdf_int64>(lSize) ) );
+        pFreetype->GetSharedFontFile().SetStreamData( pContents );
+    }
+    else if ( m_pMetrics->GetFontDataLen() && m_pMetrics->GetFontData() ) 
     {
         // FIXME const_cast<char*> is dangerous if string literals may ever be passed
         char* pBuffer = const_cast<char*>( m_pMetrics->GetFontData() );
@@ -35,86 +35,15 @@
 
 #include "base/PdfDefinesPrivate.h"
 
-#include "base/PdfData.h"
 #include "base/PdfDictionary.h"
 #include "base/PdfStream.h"
 #include "base/PdfVariant.h"
 #include "base/PdfVecObjects.h"
 
-#include "PdfPage.h"
-#include "PdfPagesTree.h"
-
-// See PdfWriter.cpp
-#define LINEARIZATION_PADDING "1234567890"
-
 using namespace PoDoFo;
 
 namespace {
 
-struct TPageEntrySharedObjectInfo {
-    pdf_uint16 nIndex;
-    pdf_uint16 nNumerator;
-};
-
-typedef std::vector<TPageEntrySharedObjectInfo>       TVecPageEntrySharedObjectInfo;
-typedef TVecPageEntrySharedObjectInfo::iterator       TIVecPageEntrySharedObjectInfo;
-typedef TVecPageEntrySharedObjectInfo::const_iterator TCIVecPageEntrySharedObjectInfo;
-
-#if 0
-class PdfPageOffsetEntry {
-public:
-    PdfPageOffsetEntry()
-        : nObjectsPerPage( 0 ),
-          nPageLength( 0 ),
-          nSharedObjects( 0 ),
-
-          nContentsOffset( 0 ),
-          nContentsLength( 0 )
-    {
-        vecSharedObjects.resize( 0 );
-    }
-
-    pdf_uint16 nObjectsPerPage;
-    pdf_uint16 nPageLength;
-    pdf_uint16 nSharedObjects;
-
-    // item4 and item5:
-    TVecPageEntrySharedObjectInfo vecSharedObjects;
-
-    pdf_uint16 nContentsOffset;
-    pdf_uint16 nContentsLength;
-
-public:
-    void Write( PoDoFo::NonPublic::PdfHintStream* pHint );
-};
-
-void PdfPageOffsetEntry::Write( PoDoFo::NonPublic::PdfHintStream* pHint )
-{
-    TCIVecPageEntrySharedObjectInfo it;
-
-    pHint->WriteUInt16( nObjectsPerPage );
-    pHint->WriteUInt16( nPageLength );
-    pHint->WriteUInt16( nSharedObjects );
-
-    it = vecSharedObjects.begin();
-    while( it != vecSharedObjects.end() )
-    {
-        pHint->WriteUInt16( (*it).nIndex );
-        ++it;
-    }
-
-    it = vecSharedObjects.begin();
-    while( it != vecSharedObjects.end() )
-    {
-        pHint->WriteUInt16( (*it).nNumerator );
-        ++it;
-    }
-
-    pHint->WriteUInt16( nContentsOffset );
-    pHint->WriteUInt16( nContentsLength );
-}
-#endif
-
 class PdfPageOffsetHeader {
 public:
     PdfPageOffsetHeader()
@@ -138,10 +67,10 @@ public:
     // item1: The least number of objects in a page including the page itself
     pdf_uint32 nLeastNumberOfObjects;
     // item2: The location of the first pages page object
-    pdf_uint32 nFirstPageObject; // (*pXRef)[0].vecOffsets[ m_pPagesTree->GetPage( 0 )->Object()->Reference().ObjectNumber() ].lOffset;
+    pdf_uint32 nFirstPageObject;
     // item3: The number of bits needed to represent the difference between the 
     //        greatest and least number of objects in a page
-    pdf_uint16 nBitsPageObject; // (pdf_uint16)ceil( logb( (double)(max-least) ) );
+    pdf_uint16 nBitsPageObject;
     // item4: The least length of a page in bytes
     pdf_uint32 nLeastPageLength;
     // item5: The number of bits needed to represent the greatest difference 
@@ -231,12 +160,9 @@ namespace PoDoFo {
 
 namespace NonPublic {
 
-PdfHintStream::PdfHintStream( PdfVecObjects* pParent, PdfPagesTree* pPagesTree )
-    : PdfElement( NULL, pParent ), m_pPagesTree( pPagesTree )
+PdfHintStream::PdfHintStream( PdfVecObjects* pParent )
+    : PdfElement( NULL, pParent ), m_nBitBuffer( 0 ), m_nBitCount( 0 )
 {
-    // This is overwritten later with valid data!
-    PdfVariant place_holder( PdfData( LINEARIZATION_PADDING ) );
-    this->GetObject()->GetDictionary().AddKey( "S", place_holder ); // shared object hint table
 }
 
 PdfHintStream::~PdfHintStream()
@@ -244,130 +170,164 @@ PdfHintStream::~PdfHintStream()
 
 }
 
-/*
-void PdfHintStream::Create( TVecXRefTable* pXRef )
-{
-    this->CreatePageHintTable( pXRef );
-    this->CreateSharedObjectHintTable();
-}
-
-void PdfHintStream::CreatePageHintTable( TVecXRefTable* pXRef )
+void PdfHintStream::CreatePageHintTable( const TVecHintPages & rPages, pdf_uint64 lFirstPageOffset )
 {
-    TPdfReferenceList   lstPages;
-    TCIPdfReferenceList it;
-    int                 i;
-    int                 nPageCount = m_pPagesTree->GetTotalNumberOfPages();
-
     PdfPageOffsetHeader header;
-#if 1
-	// this will init/construct each of the objects in the vector
-	// AND it compiles on all platforms - where the below code
-	// isn't 100% valid for all C++ compilers
-	std::vector< PdfPageOffsetEntry >	vecPages( nPageCount );
-#else
-    // use an array instead of an vector,
-    // to make sure the constructors are called,
-    // which they are apparently not when using vector.resize
-    PdfPageOffsetEntry  vecPages[nPageCount];
-#endif
-
-    pdf_uint32        max;
-    pdf_uint32        least = 0;
-    pdf_uint32        maxNumberOfObjects = 0;
-    pdf_uint32        maxPageLength      = 0;
-    pdf_uint32        value;
-    PdfReference      maxRef;
-
-    for( i=0;i<nPageCount;i++ )
+    TCIVecHintPages     it;
+    pdf_uint32          maxNumberOfObjects = 0;
+    pdf_uint64          maxPageLength      = 0;
+    pdf_uint64          leastPageLength    = 0;
+    size_t              maxSharedObjects   = 0;
+    pdf_uint32          maxSharedObject    = 0;
+
+    if( rPages.empty() ) 
     {
-        lstPages.clear();
+        PODOFO_RAISE_ERROR( ePdfError_PageNotFound );
+    }
 
-        this->GetObject()->GetParent()->GetObjectDependencies( m_pPagesTree->GetPage( i )->GetObject(), &lstPages );
-        vecPages[i].nObjectsPerPage = lstPages.size();
+    for( it = rPages.begin(); it != rPages.end(); ++it )
+    {
+        if( it == rPages.begin() || header.nLeastNumberOfObjects > (*it).nObjects )
+            header.nLeastNumberOfObjects = (*it).nObjects;
 
-        if( !header.nLeastNumberOfObjects || header.nLeastNumberOfObjects > lstPages.size() )
-            header.nLeastNumberOfObjects = lstPages.size();
+        if( it == rPages.begin() || leastPageLength > (*it).lLength )
+            leastPageLength = (*it).lLength;
 
-        if( !maxNumberOfObjects || maxNumberOfObjects < lstPages.size() )
-            maxNumberOfObjects = lstPages.size();
+        maxNumberOfObjects = PDF_MAX( maxNumberOfObjects, (*it).nObjects );
+        maxPageLength      = PDF_MAX( maxPageLength, (*it).lLength );
+        maxSharedObjects   = PDF_MAX( maxSharedObjects, (*it).vecSharedObjects.size() );
 
-        it    = lstPages.begin();
-        least = 0;
-        max   = 0;
-        while( it != lstPages.end() ) 
-        {
-            value = (*pXRef)[0].vecOffsets[ (*it).ObjectNumber() ].lOffset;
+        for( size_t i = 0; i < (*it).vecSharedObjects.size(); i++ )
+            maxSharedObject = PDF_MAX( maxSharedObject, (*it).vecSharedObjects[i] );
+    }
 
-            if( !least || least > value )
-                least = value;
+    header.nFirstPageObject              = static_cast<pdf_uint32>(lFirstPageOffset);
+    header.nBitsPageObject               = GetBitCount( maxNumberOfObjects - header.nLeastNumberOfObjects );
+    header.nLeastPageLength              = static_cast<pdf_uint32>(leastPageLength);
+    header.nBitsPageLength               = GetBitCount( maxPageLength - leastPageLength );
+    header.nOffsetContentStream          = 0; // acrobat sets this to 0 and ignores it
+    header.nBitsContentStream            = 0; // acrobat sets this to 0 and ignores it
+    // acrobat expects the content stream length to span the whole page
+    header.nLeastContentStreamLength     = header.nLeastPageLength;
+    header.nBitsLeastContentStreamLength = header.nBitsPageLength;
+    header.nBitsNumSharedObjects         = GetBitCount( maxSharedObjects );
+    header.nBitsGreatestSharedObject     = maxSharedObjects ? GetBitCount( maxSharedObject ) : 0;
+    header.nItem12                       = 0; // no fractional positions of shared objects
+    header.nItem13                       = 0;
 
-            if( !max || max < value )
-            {
-                max    = value;
-                maxRef = *it;
-            }
+    header.Write( this );
 
-            ++it;
-        }
+    // The per page entries are written item by item,
+    // i.e. item 1 of all pages, then item 2 of all pages ...
+    for( it = rPages.begin(); it != rPages.end(); ++it )
+        WriteBits( (*it).nObjects - header.nLeastNumberOfObjects, header.nBitsPageObject );
+    FlushBits();
 
-        max += this->GetObject()->GetParent()->GetObject( maxRef )->GetObjectLength();
+    for( it = rPages.begin(); it != rPages.end(); ++it )
+        WriteBits( static_cast<pdf_uint32>((*it).lLength - leastPageLength), header.nBitsPageLength );
+    FlushBits();
 
-        vecPages[i].nPageLength     = max - least;
+    for( it = rPages.begin(); it != rPages.end(); ++it )
+        WriteBits( static_cast<pdf_uint32>((*it).vecSharedObjects.size()), header.nBitsNumSharedObjects );
+    FlushBits();
 
-        if( !header.nLeastPageLength || header.nLeastPageLength > vecPages[i].nPageLength )
-            header.nLeastPageLength = vecPages[i].nPageLength;
+    for( it = rPages.begin(); it != rPages.end(); ++it )
+        for( size_t i = 0; i < (*it).vecSharedObjects.size(); i++ )
+            WriteBits( (*it).vecSharedObjects[i], header.nBitsGreatestSharedObject );
+    FlushBits();
 
-        if( !maxPageLength || maxPageLength < max )
-            maxPageLength = max;
+    // item 5 (numerators) and item 6 (content stream offsets) use 0 bits
 
-        vecPages[i].nSharedObjects  = 0;
-        vecPages[i].nContentsOffset = 0;
-        vecPages[i].nContentsLength = 0;
-    }
+    for( it = rPages.begin(); it != rPages.end(); ++it )
+        WriteBits( static_cast<pdf_uint32>((*it).lLength - leastPageLength), header.nBitsLeastContentStreamLength );
+    FlushBits();
+}
 
-    header.nFirstPageObject              = (*pXRef)[0].vecOffsets[ m_pPagesTree->GetPage( 0 )->GetObject()->Reference().ObjectNumber() ].lOffset;
-    header.nBitsPageObject               = (pdf_uint16)ceil( logb( static_cast<double>(maxNumberOfObjects-header.nLeastNumberOfObjects) ) );
-    header.nBitsPageLength               = (pdf_uint16)ceil( logb( static_cast<double>(maxPageLength - header.nLeastPageLength) ) );
-    header.nOffsetContentStream          = 0; // acrobat sets this to 0 and ignores it
-    header.nBitsContentStream            = 0; // acrobat sets this to 0 and ignores it
-    header.nLeastContentStreamLength     = 0; // acrobat sets this to 0 and ignores it
-    header.nBitsLeastContentStreamLength = 0; // acrobat sets this to 0 and ignores it
-    header.nBitsNumSharedObjects         = 0;
-    header.nBitsGreatestSharedObject     = 0;
-    header.nItem12                       = 0;
-    header.nItem13                       = 0;
+void PdfHintStream::CreateSharedObjectHintTable( const std::vector<pdf_uint64> & rLengths, pdf_uint32 nFirstPage,
+                                                 pdf_objnum nFirstObject, pdf_uint64 lFirstOffset )
+{
+    PdfSharedObjectHeader header;
+    pdf_uint64            leastLength = 0;
+    pdf_uint64            maxLength   = 0;
+    size_t                i;
 
-    for( i=0;i<nPageCount;i++ )
+    for( i = 0; i < rLengths.size(); i++ ) 
     {
-        vecPages[i].nObjectsPerPage -= header.nLeastNumberOfObjects;
-        vecPages[i].nPageLength     -= header.nLeastPageLength;
-        vecPages[i].Write( this );
+        if( !i || leastLength > rLengths[i] )
+            leastLength = rLengths[i];
+
+        maxLength = PDF_MAX( maxLength, rLengths[i] );
     }
 
-    header.Write( this );
-}
+    // offset of the shared object hint table in the stream
+    PdfVariant offset( static_cast<pdf_int64>(m_buffer.length()) );
+    this->GetObject()->GetDictionary().AddKey( "S", offset ); 
 
-void PdfHintStream::CreateSharedObjectHintTable()
-{
-    PdfVariant offset( static_cast<long>(this->GetObject()->GetStream()->GetLength()) );
-    offset.SetPaddingLength( LINEARIZATION_PADDING );
+    header.nFirstObjectNumber         = nFirstObject;
+    header.nFirstObjectLocation       = static_cast<pdf_uint32>(lFirstOffset);
+    header.nNumSharedObjectsFirstPage = nFirstPage;
+    header.nNumSharedObjects          = static_cast<pdf_uint32>(rLengths.size());
+    header.nNumBits                   = 0; // each group consists of exactly one object
+    header.nLeastLength               = static_cast<pdf_uint32>(leastLength);
+    header.nNumBitsLengthDifference   = GetBitCount( maxLength - leastLength );
+
+    header.Write( this );
 
-    this->GetObject()->GetDictionary().AddKey( "S", offset ); // shared object hint table
+    for( i = 0; i < rLengths.size(); i++ ) 
+        WriteBits( static_cast<pdf_uint32>(rLengths[i] - leastLength), header.nNumBitsLengthDifference );
+    FlushBits();
 
+    // no MD5 signatures
+    for( i = 0; i < rLengths.size(); i++ ) 
+        WriteBits( 0, 1 );
+    FlushBits();
 
+    this->GetObject()->GetStream()->Set( m_buffer.data(), static_cast<pdf_long>(m_buffer.length()) );
 }
-*/
 
 void PdfHintStream::WriteUInt16( pdf_uint16 val )
 {
     val = ::PoDoFo::compat::podofo_htons(val);
-    this->GetObject()->GetStream()->Append( reinterpret_cast<char*>(&val), 2 );
+    m_buffer.append( reinterpret_cast<char*>(&val), 2 );
 }
 
 void PdfHintStream::WriteUInt32( pdf_uint32 val )
 {
     val = ::PoDoFo::compat::podofo_htonl(val);
-    this->GetObject()->GetStream()->Append( reinterpret_cast<char*>(&val), 4 );
+    m_buffer.append( reinterpret_cast<char*>(&val), 4 );
+}
+
+void PdfHintStream::WriteBits( pdf_uint32 val, int nBits )
+{
+    while( nBits > 0 ) 
+    {
+        --nBits;
+        m_nBitBuffer = (m_nBitBuffer << 1) | ((val >> nBits) & 1);
+        if( ++m_nBitCount == 8 ) 
+        {
+            m_buffer.push_back( static_cast<char>(m_nBitBuffer) );
+            m_nBitBuffer = 0;
+            m_nBitCount  = 0;
+        }
+    }
+}
+
+void PdfHintStream::FlushBits()
+{
+    if( m_nBitCount )
+        WriteBits( 0, 8 - m_nBitCount );
+}
+
+pdf_uint16 PdfHintStream::GetBitCount( pdf_uint64 val )
+{
+    pdf_uint16 nBits = 0;
+    while( val ) 
+    {
+        ++nBits;
+        val >>= 1;
+    }
+
+    return nBits;
 }
 
 }; // end namespace PoDoFo::NonPublic
@@ -40,22 +40,59 @@
 
 namespace PoDoFo {
 
-class PdfPagesTree;
-
 namespace NonPublic {
 
 // PdfHintStream is not part of the public API and is NOT exported as part of
 // the DLL/shared library interface. Do not rely on it.
 
+/** Layout of a single page in a linearized PDF file
+ *  as required for the page offset hint table.
+ */
+struct PdfHintPage {
+    PdfHintPage()
+        : nObjects( 0 ), lLength( 0 )
+    {
+    }
+
+    pdf_uint32              nObjects;         ///< number of objects in the page section, including the page object
+    pdf_uint64              lLength;          ///< length of the page section in bytes
+    std::vector<pdf_uint32> vecSharedObjects; ///< indices of the shared object hint table entries used by this page
+};
+
+typedef std::vector<PdfHintPage>       TVecHintPages;
+typedef TVecHintPages::const_iterator  TCIVecHintPages;
+
+/** The primary hint stream of a linearized PDF file.
+ *  It contains a page offset hint table and a shared object hint table
+ *  (see Annex F of the PDF specification).
+ *
+ *  All offsets and lengths passed to this class must be calculated 
+ *  as if the hint stream was not present in the file.
+ */
 class PdfHintStream : public PdfElement {
  public:
-    PdfHintStream( PdfVecObjects* pParent, PdfPagesTree* pPagesTree );
+    PdfHintStream( PdfVecObjects* pParent );
     ~PdfHintStream();
 
-    /** Create the hint stream 
-     *  \param pXRef pointer to a valid XREF table structure
+    /** Create the page offset hint table.
+     *  Has to be called before CreateSharedObjectHintTable.
+     *
+     *  \param rPages the layout of all pages in the document
+     *  \param lFirstPageOffset offset of the page object of the first page
+     */
+    void CreatePageHintTable( const TVecHintPages & rPages, pdf_uint64 lFirstPageOffset );
+
+    /** Create the shared object hint table and set the stream data
+     *  of the hint stream. Every shared object forms a group of its own.
+     *
+     *  \param rLengths the length of each object in the first page section
+     *                  followed by the length of each object in the shared objects section
+     *  \param nFirstPage the number of entries in rLengths belonging to the first page section
+     *  \param nFirstObject object number of the first object in the shared objects section
+     *  \param lFirstOffset offset of the first object in the shared objects section
      */
-    //void Create( TVecXRefTable* pXRef );
+    void CreateSharedObjectHintTable( const std::vector<pdf_uint64> & rLengths, pdf_uint32 nFirstPage,
+                                      pdf_objnum nFirstObject, pdf_uint64 lFirstOffset );
 
     /** Write a pdf_uint16 to the stream in big endian format.
      *  \param val the value to write to the stream
@@ -67,12 +104,26 @@ class PdfHintStream : public PdfElement {
      */
     void WriteUInt32( pdf_uint32 );
 
+    /** Append the nBits lowest bits of a value to the stream,
+     *  most significant bit first.
+     *  \param val the value to write to the stream
+     *  \param nBits the number of bits to write (at most 32)
+     */
+    void WriteBits( pdf_uint32 val, int nBits );
+
+    /** Pad the bits written by WriteBits to a full byte.
+     */
+    void FlushBits();
+
+    /** 
+     *  \returns the number of bits required to represent val
+     */
+    static pdf_uint16 GetBitCount( pdf_uint64 val );
+
  private:
-    //void CreatePageHintTable( TVecXRefTable* pXRef );
-    void CreateSharedObjectHintTable();
- 
- private:
-    PdfPagesTree* m_pPagesTree;
+    std::string m_buffer;
+    pdf_uint32  m_nBitBuffer;
+    int         m_nBitCount;
 };
 
 }; // end namespace NonPublic
@@ -0,0 +1,867 @@
+/***************************************************************************
+ *   Copyright (C) 2005 by Dominik Seichter                                *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ *                                                                         *
+ *   In addition, as a special exception, the copyright holders give       *
+ *   permission to link the code of portions of this program with the      *
+ *   OpenSSL library under certain conditions as described in each         *
+ *   individual source file, and distribute linked combinations            *
+ *   including the two.                                                    *
+ *   You must obey the GNU General Public License in all respects          *
+ *   for all of the code used other than OpenSSL.  If you modify           *
+ *   file(s) with this exception, you may extend this exception to your    *
+ *   version of the file(s), but you are not obligated to do so.  If you   *
+ *   do not wish to do so, delete this exception statement from your       *
+ *   version.  If you delete this exception statement from all source      *
+ *   files in the program, then also delete it here.                       *
+ ***************************************************************************/
+
+#include "PdfImageOptimizer.h"
+
+#include "base/PdfDefinesPrivate.h"
+
+#include "base/PdfArray.h"
+#include "base/PdfDictionary.h"
+#include "base/PdfFiltersPrivate.h"
+#include "base/PdfMemStream.h"
+#include "base/PdfOutputStream.h"
+#include "base/PdfVecObjects.h"
+#include "base/util/PdfMutexWrapper.h"
+#include "base/util/PdfThread.h"
+
+#include "PdfDocument.h"
+#include "PdfPage.h"
+
+#include <map>
+#include <set>
+#include <string.h>
+
+// JPEG headers already included through "base/PdfFiltersPrivate.h", if available
+
+#define PODOFO_JPEG_DESTINATION_SIZE 4096
+
+// Larger images are not optimized, so that a row of samples always fits into memory
+#define PODOFO_MAX_IMAGE_SIZE        (1 << 20)
+
+namespace PoDoFo {
+
+namespace {
+
+/** An image selected for optimization.
+ *
+ *  All members are set by the calling thread, so that the 
+ *  worker threads never have to load objects of the document.
+ */
+struct TImageCandidate {
+    PdfObject*           pObject;
+    const PdfDictionary* pDictionary; ///< the image dictionary, which may contain DecodeParms
+    const char*          pBuffer;     ///< the encoded image data
+    pdf_long             lLen;
+    TVecFilters          filters;
+    unsigned int         nWidth;
+    unsigned int         nHeight;
+    unsigned int         nComponents;
+    unsigned int         nFactor;     ///< downsample blocks of nFactor x nFactor pixels
+    bool                 bConvert;    ///< the color space may be converted
+    bool                 bLossy;      ///< the image was DCT encoded
+};
+
+/** The optimized data of an image
+ */
+struct TImageResult {
+    char*        pBuffer;             ///< allocated using podofo_malloc
+    pdf_long     lLen;
+    unsigned int nWidth;
+    unsigned int nHeight;
+    unsigned int nComponents;
+    EPdfFilter   eFilter;
+};
+
+/** State shared by all worker threads of PdfImageOptimizer::Optimize
+ */
+struct TOptimizeImagesJob {
+    ~TOptimizeImagesJob()
+    {
+        for( size_t i = 0; i < vecResults.size(); i++ )
+            podofo_free( vecResults[i].pBuffer );
+
+        for( size_t i = 0; i < vecErrors.size(); i++ )
+            delete vecErrors[i];
+    }
+
+    EPdfFilter                  eFilter;
+    int                         nJpegQuality;
+    std::vector<TImageCandidate> vecImages;
+
+    Util::PdfMutex              mutex;
+    size_t                      nNextImage; ///< guarded by mutex
+
+    std::vector<TImageResult>   vecResults; ///< one entry per image, written by one worker each
+    std::vector<PdfError*>      vecErrors;
+};
+
+/** Encodes an image row by row into memory
+ */
+class PdfImageEncoder {
+ public:
+    PdfImageEncoder( pdf_long lInitial )
+        : m_output( lInitial )
+    {
+    }
+
+    virtual ~PdfImageEncoder() { }
+
+    /** Encode one row of samples
+     */
+    virtual void WriteRow( const unsigned char* pRow ) = 0;
+
+    /** Finish encoding after the last row
+     */
+    virtual void Finish() = 0;
+
+    /**
+     *  \returns the length of the data encoded so far
+     */
+    inline pdf_long GetLength() const { return m_output.GetLength(); }
+
+    /**
+     *  \returns the encoded data, which has to be freed using podofo_free
+     */
+    inline char* TakeBuffer() { return m_output.TakeBuffer(); }
+
+ protected:
+    PdfMemoryOutputStream m_output;
+};
+
+/** Encodes an image using FlateDecode and the best PNG predictor of each row
+ */
+class PdfImageFlateEncoder : public PdfImageEncoder {
+ public:
+    PdfImageFlateEncoder( unsigned int nWidth, unsigned int nComponents, pdf_long lInitial )
+        : PdfImageEncoder( lInitial ), m_lRowLen( static_cast<pdf_long>(nWidth) * nComponents )
+    {
+        TFlateSettings settings;
+        settings.nPredictor        = 15;
+        settings.nColors           = nComponents;
+        settings.nBitsPerComponent = 8;
+        settings.nColumns          = nWidth;
+
+        TVecFilters filters;
+        filters.push_back( ePdfFilter_FlateDecode );
+        m_pStream = PdfFilterFactory::CreateEncodeStream( filters, &m_output, &settings );
+    }
+
+    virtual ~PdfImageFlateEncoder()
+    {
+        if( m_pStream )
+        {
+            // Not all rows were written, finish the filter anyways
+            try {
+                m_pStream->Close();
+            } catch( PdfError & ) {
+            }
+
+            delete m_pStream;
+        }
+    }
+
+    virtual void WriteRow( const unsigned char* pRow )
+    {
+        m_pStream->Write( reinterpret_cast<const char*>(pRow), m_lRowLen );
+    }
+
+    virtual void Finish()
+    {
+        m_pStream->Close();
+        delete m_pStream;
+        m_pStream = NULL;
+    }
+
+ private:
+    PdfOutputStream* m_pStream;
+    pdf_long         m_lRowLen;
+};
+
+#ifdef PODOFO_HAVE_JPEG_LIB
+
+/* Destination object for compressing into a PdfOutputStream */
+typedef struct {
+    struct jpeg_destination_mgr pub; /* public fields */
+    PdfOutputStream*            pStream;
+    JOCTET                      buffer[PODOFO_JPEG_DESTINATION_SIZE];
+} my_destination_mgr;
+
+typedef my_destination_mgr * my_dest_ptr;
+
+/*
+ * Initialize destination --- called by jpeg_start_compress
+ * before any data is actually written.
+ */
+METHODDEF(void)
+init_destination (j_compress_ptr cinfo)
+{
+    my_dest_ptr dest = reinterpret_cast<my_dest_ptr>(cinfo->dest);
+
+    dest->pub.next_output_byte = dest->buffer;
+    dest->pub.free_in_buffer   = PODOFO_JPEG_DESTINATION_SIZE;
+}
+
+/*
+ * Empty the output buffer --- called whenever buffer fills up.
+ */
+METHODDEF(boolean)
+empty_output_buffer (j_compress_ptr cinfo)
+{
+    my_dest_ptr dest = reinterpret_cast<my_dest_ptr>(cinfo->dest);
+
+    dest->pStream->Write( reinterpret_cast<const char*>(dest->buffer), PODOFO_JPEG_DESTINATION_SIZE );
+    dest->pub.next_output_byte = dest->buffer;
+    dest->pub.free_in_buffer   = PODOFO_JPEG_DESTINATION_SIZE;
+
+    return TRUE;
+}
+
+/*
+ * Terminate destination --- called by jpeg_finish_compress
+ * after all data has been written.
+ */
+METHODDEF(void)
+term_destination (j_compress_ptr cinfo)
+{
+    my_dest_ptr dest = reinterpret_cast<my_dest_ptr>(cinfo->dest);
+
+    dest->pStream->Write( reinterpret_cast<const char*>(dest->buffer), 
+                          PODOFO_JPEG_DESTINATION_SIZE - dest->pub.free_in_buffer );
+}
+
+/** Encodes a gray or RGB image using DCTDecode
+ */
+class PdfImageJpegEncoder : public PdfImageEncoder {
+ public:
+    PdfImageJpegEncoder( unsigned int nWidth, unsigned int nHeight, unsigned int nComponents, 
+                         int nQuality, pdf_long lInitial )
+        : PdfImageEncoder( lInitial )
+    {
+        memset( &m_cinfo, 0, sizeof( struct jpeg_compress_struct ) );
+        memset( &m_jerr, 0, sizeof( struct jpeg_error_mgr ) );
+
+        m_cinfo.err = jpeg_std_error( &m_jerr );
+        m_jerr.error_exit = &JPegErrorExit;
+        m_jerr.emit_message = &JPegErrorOutput;
+
+        jpeg_create_compress( &m_cinfo );
+
+        m_dest.pub.init_destination    = init_destination;
+        m_dest.pub.empty_output_buffer = empty_output_buffer;
+        m_dest.pub.term_destination    = term_destination;
+        m_dest.pStream                 = &m_output;
+        m_cinfo.dest = &m_dest.pub;
+
+        m_cinfo.image_width      = nWidth;
+        m_cinfo.image_height     = nHeight;
+        m_cinfo.input_components = nComponents;
+        m_cinfo.in_color_space   = nComponents == 3 ? JCS_RGB : JCS_GRAYSCALE;
+
+        jpeg_set_defaults( &m_cinfo );
+        jpeg_set_quality( &m_cinfo, nQuality, TRUE );
+        jpeg_start_compress( &m_cinfo, TRUE );
+    }
+
+    virtual ~PdfImageJpegEncoder()
+    {
+        // Also called after JPegErrorExit has destroyed m_cinfo, which is fine
+        (void) jpeg_destroy_compress( &m_cinfo );
+    }
+
+    virtual void WriteRow( const unsigned char* pRow )
+    {
+        JSAMPROW row = const_cast<JSAMPROW>(pRow);
+        jpeg_write_scanlines( &m_cinfo, &row, 1 );
+    }
+
+    virtual void Finish()
+    {
+        jpeg_finish_compress( &m_cinfo );
+    }
+
+ private:
+    struct jpeg_compress_struct m_cinfo;
+    struct jpeg_error_mgr       m_jerr;
+    my_destination_mgr          m_dest;
+};
+
+#endif // PODOFO_HAVE_JPEG_LIB
+
+/** Read exactly lLen bytes unless the stream ends before.
+ *
+ *  \returns the number of bytes read
+ */
+static pdf_long ReadFully( PdfInputStream & rStream, unsigned char* pBuffer, pdf_long lLen )
+{
+    pdf_long lTotal = 0;
+    while( lTotal < lLen )
+    {
+        const pdf_long lRead = rStream.Read( reinterpret_cast<char*>(pBuffer) + lTotal, lLen - lTotal );
+        if( lRead <= 0 )
+            break;
+
+        lTotal += lRead;
+    }
+
+    return lTotal;
+}
+
+/** Check whether all pixels of an RGB image are gray,
+ *  or of a CMYK image would be gray after conversion to RGB.
+ */
+static bool IsGrayImage( const TImageCandidate & rImage )
+{
+    PdfFilteredInputStream stream( rImage.pBuffer, rImage.lLen, rImage.filters, rImage.pDictionary );
+    const char*            pChunk;
+    pdf_long               lChunkLen;
+    unsigned int           nSample = 0;
+    unsigned char          pixel[4];
+
+    // Chunks do not end at pixel boundaries
+    while( stream.ReadChunk( &pChunk, &lChunkLen ) )
+    {
+        for( pdf_long i = 0; i < lChunkLen; i++ )
+        {
+            pixel[nSample++] = static_cast<unsigned char>(pChunk[i]);
+            if( nSample == rImage.nComponents )
+            {
+                if( pixel[0] != pixel[1] || pixel[0] != pixel[2] )
+                    return false;
+
+                nSample = 0;
+            }
+        }
+    }
+
+    return true;
+}
+
+/** Decode, downsample, convert and encode one image.
+ *
+ *  \param rImage the image
+ *  \param eFilter the filter requested by the user
+ *  \param nJpegQuality quality for DCT encoding
+ *  \param pResult receives the optimized image, pResult->pBuffer
+ *         stays NULL if the image cannot be made smaller
+ */
+static void OptimizeImage( const TImageCandidate & rImage, EPdfFilter eFilter, int nJpegQuality, 
+                           TImageResult* pResult )
+{
+    unsigned int nComponents = rImage.nComponents;
+    if( rImage.bConvert && nComponents == 4 )
+        nComponents = 3;
+    if( rImage.bConvert && nComponents == 3 && IsGrayImage( rImage ) )
+        nComponents = 1;
+
+    if( eFilter == ePdfFilter_None )
+        eFilter = rImage.bLossy ? ePdfFilter_DCTDecode : ePdfFilter_FlateDecode;
+#ifndef PODOFO_HAVE_JPEG_LIB
+    eFilter = ePdfFilter_FlateDecode;
+#endif // PODOFO_HAVE_JPEG_LIB
+    if( nComponents == 4 )
+        eFilter = ePdfFilter_FlateDecode;
+
+    // Encoding a DCT image again only loses quality, if nothing else changes
+    if( rImage.bLossy && eFilter == ePdfFilter_DCTDecode && rImage.nFactor == 1 
+        && nComponents == rImage.nComponents )
+        return;
+
+    const unsigned int nFactor    = rImage.nFactor;
+    const unsigned int nWidth     = (rImage.nWidth + nFactor - 1) / nFactor;
+    const unsigned int nHeight    = (rImage.nHeight + nFactor - 1) / nFactor;
+    const pdf_long     lInRowLen  = static_cast<pdf_long>(rImage.nWidth) * rImage.nComponents;
+
+    std::vector<unsigned char> vecInput( lInRowLen * nFactor );
+    std::vector<unsigned int>  vecSums( static_cast<size_t>(nWidth) * rImage.nComponents );
+    std::vector<unsigned char> vecSamples( vecSums.size() );
+    std::vector<unsigned char> vecOutput( static_cast<size_t>(nWidth) * nComponents );
+
+    PdfImageEncoder* pEncoder;
+#ifdef PODOFO_HAVE_JPEG_LIB
+    if( eFilter == ePdfFilter_DCTDecode )
+        pEncoder = new PdfImageJpegEncoder( nWidth, nHeight, nComponents, nJpegQuality, rImage.lLen );
+    else
+#endif // PODOFO_HAVE_JPEG_LIB
+        pEncoder = new PdfImageFlateEncoder( nWidth, nComponents, rImage.lLen );
+
+    PODOFO_UNIQUEU_PTR<PdfImageEncoder> encoder( pEncoder );
+    PdfFilteredInputStream              stream( rImage.pBuffer, rImage.lLen, rImage.filters, rImage.pDictionary );
+
+    for( unsigned int y = 0; y < rImage.nHeight; y += nFactor )
+    {
+        const unsigned int nRows = PDF_MIN( nFactor, rImage.nHeight - y );
+
+        // Images with less data than their size are left alone
+        if( ReadFully( stream, &(vecInput[0]), lInRowLen * nRows ) != lInRowLen * nRows )
+            return;
+
+        const unsigned char* pSamples = &(vecInput[0]);
+        if( nFactor > 1 )
+        {
+            // Average blocks of nFactor x nFactor pixels, the last ones may be smaller
+            std::fill( vecSums.begin(), vecSums.end(), 0 );
+            for( unsigned int r = 0; r < nRows; r++ )
+            {
+                const unsigned char* pRow = &(vecInput[0]) + r * lInRowLen;
+                for( unsigned int x = 0; x < rImage.nWidth; x++ )
+                {
+                    unsigned int* pSum = &(vecSums[0]) + (x / nFactor) * rImage.nComponents;
+                    for( unsigned int c = 0; c < rImage.nComponents; c++ )
+                        pSum[c] += *pRow++;
+                }
+            }
+
+            for( unsigned int x = 0; x < nWidth; x++ )
+            {
+                const unsigned int nCount = nRows * PDF_MIN( nFactor, rImage.nWidth - x * nFactor );
+                for( unsigned int c = 0; c < rImage.nComponents; c++ )
+                {
+                    const size_t nIndex = x * rImage.nComponents + c;
+                    vecSamples[nIndex]  = static_cast<unsigned char>( (vecSums[nIndex] + nCount / 2) / nCount );
+                }
+            }
+
+            pSamples = &(vecSamples[0]);
+        }
+
+        if( nComponents != rImage.nComponents ) 
+        {
+            for( unsigned int x = 0; x < nWidth; x++ )
+            {
+                const unsigned char* pIn  = pSamples + x * rImage.nComponents;
+                unsigned char*       pOut = &(vecOutput[0]) + x * nComponents;
+                for( unsigned int c = 0; c < nComponents; c++ )
+                {
+                    // Gray images from RGB use any component, CMYK is converted naively:
+                    // each of RGB is the inverse of the sum of its complement and black
+                    pOut[c] = rImage.nComponents == 4 ? 
+                        static_cast<unsigned char>(255 - PDF_MIN( 255, pIn[c] + pIn[3] )) : pIn[c];
+                }
+            }
+
+            pSamples = &(vecOutput[0]);
+        }
+
+        encoder->WriteRow( pSamples );
+
+        // No need to go on if the image does not get smaller
+        if( encoder->GetLength() >= rImage.lLen )
+            return;
+    }
+
+    encoder->Finish();
+    if( encoder->GetLength() >= rImage.lLen )
+        return;
+
+    pResult->lLen        = encoder->GetLength();
+    pResult->pBuffer     = encoder->TakeBuffer();
+    pResult->nWidth      = nWidth;
+    pResult->nHeight     = nHeight;
+    pResult->nComponents = nComponents;
+    pResult->eFilter     = eFilter;
+}
+
+/** Entry point of the worker threads of PdfImageOptimizer::Optimize.
+ *
+ *  The worker optimizes one image after another until all
+ *  images are done. Errors other than a PdfError leave an
+ *  image unchanged.
+ */
+static void OptimizeImagesWorker( void* pData )
+{
+    TOptimizeImagesJob* pJob = static_cast<TOptimizeImagesJob*>(pData);
+
+    for( ;; )
+    {
+        size_t nImage;
+        {
+            Util::PdfMutexWrapper wrapper( pJob->mutex );
+            nImage = pJob->nNextImage++;
+        }
+
+        if( nImage >= pJob->vecImages.size() )
+            break;
+
+        try {
+            OptimizeImage( pJob->vecImages[nImage], pJob->eFilter, pJob->nJpegQuality, &(pJob->vecResults[nImage]) );
+        } catch( PdfError & rError ) {
+            try {
+                pJob->vecErrors[nImage] = new PdfError( rError );
+            } catch( ... ) {
+            }
+        } catch( ... ) {
+        }
+    }
+}
+
+/** Lower the resolution estimated for an image, if it is smaller on this page
+ *
+ *  \param pImage an image XObject
+ *  \param dPageSize the larger side of the page in PDF units
+ *  \param rMapResolutions the lowest estimated resolution of each image
+ */
+static void AddImageResolution( const PdfObject* pImage, double dPageSize, 
+                                std::map<const PdfObject*,double> & rMapResolutions )
+{
+    const PdfObject* pWidth  = pImage->GetIndirectKey( "Width" );
+    const PdfObject* pHeight = pImage->GetIndirectKey( "Height" );
+    if( !pWidth || !pHeight || !pWidth->IsNumber() || !pHeight->IsNumber() )
+        return;
+
+    // Covering the whole page in any orientation, the image gets 
+    // at least this resolution along both of its axes
+    const double dResolution = static_cast<double>(PDF_MIN( pWidth->GetNumber(), pHeight->GetNumber() )) 
+        * 72.0 / dPageSize;
+
+    std::map<const PdfObject*,double>::iterator it = rMapResolutions.find( pImage );
+    if( it == rMapResolutions.end() )
+        rMapResolutions[pImage] = dResolution;
+    else
+        it->second = PDF_MIN( it->second, dResolution );
+}
+
+/** Estimate the resolution of all images in a resources dictionary
+ *  and in the resources of the form XObjects in it.
+ *
+ *  \param pResources a resources dictionary
+ *  \param dPageSize the larger side of the page in PDF units
+ *  \param rMapResolutions the lowest estimated resolution of each image
+ *  \param rSetForms forms already visited on this page
+ */
+static void CollectImageResolutions( const PdfObject* pResources, double dPageSize,
+                                     std::map<const PdfObject*,double> & rMapResolutions,
+                                     std::set<const PdfObject*> & rSetForms )
+{
+    const PdfObject* pXObjects = pResources && pResources->IsDictionary() ? 
+        pResources->GetIndirectKey( "XObject" ) : NULL;
+    if( !pXObjects || !pXObjects->IsDictionary() )
+        return;
+
+    const TKeyMap & rKeys = pXObjects->GetDictionary().GetKeys();
+    for( TCIKeyMap it = rKeys.begin(); it != rKeys.end(); ++it )
+    {
+        const PdfObject* pXObject = pXObjects->GetIndirectKey( it->first );
+        if( !pXObject || !pXObject->IsDictionary() )
+            continue;
+
+        const PdfObject* pSubtype = pXObject->GetIndirectKey( PdfName::KeySubtype );
+        if( !pSubtype || !pSubtype->IsName() )
+            continue;
+
+        if( pSubtype->GetName() == PdfName( "Image" ) )
+            AddImageResolution( pXObject, dPageSize, rMapResolutions );
+        else if( pSubtype->GetName() == PdfName( "Form" ) && rSetForms.insert( pXObject ).second )
+        {
+            CollectImageResolutions( pXObject->GetIndirectKey( "Resources" ), dPageSize,
+                                     rMapResolutions, rSetForms );
+        }
+    }
+}
+
+/** Check whether an object is an image which can be optimized.
+ *
+ *  \param pObject an object of the document
+ *  \param bConvertColorSpace true if color spaces may be converted
+ *  \param pImage receives everything the worker threads need to know about the image
+ *  \returns true if pObject is an image which can be optimized
+ */
+static bool IsImageCandidate( PdfObject* pObject, bool bConvertColorSpace, TImageCandidate* pImage )
+{
+    if( !pObject->IsDictionary() || !pObject->HasStream() )
+        return false;
+
+    const PdfObject* pSubtype = pObject->GetIndirectKey( PdfName::KeySubtype );
+    if( !pSubtype || !pSubtype->IsName() || pSubtype->GetName() != PdfName( "Image" ) )
+        return false;
+
+    // Only streams in memory can be replaced
+    PdfMemStream* pStream = dynamic_cast<PdfMemStream*>(pObject->GetStream());
+    if( !pStream || !pStream->GetLength() )
+        return false;
+
+    const PdfObject* pImageMask = pObject->GetIndirectKey( "ImageMask" );
+    if( pImageMask && pImageMask->IsBool() && pImageMask->GetBool() )
+        return false;
+
+    // Color key masking depends on the exact sample values
+    const PdfObject* pMask = pObject->GetIndirectKey( "Mask" );
+    if( pMask && pMask->IsArray() )
+        return false;
+
+    const PdfObject* pBits   = pObject->GetIndirectKey( "BitsPerComponent" );
+    const PdfObject* pWidth  = pObject->GetIndirectKey( "Width" );
+    const PdfObject* pHeight = pObject->GetIndirectKey( "Height" );
+    if( !pBits || !pBits->IsNumber() || pBits->GetNumber() != 8 
+        || !pWidth || !pWidth->IsNumber() || pWidth->GetNumber() <= 0 || pWidth->GetNumber() > PODOFO_MAX_IMAGE_SIZE
+        || !pHeight || !pHeight->IsNumber() || pHeight->GetNumber() <= 0 || pHeight->GetNumber() > PODOFO_MAX_IMAGE_SIZE )
+        return false;
+
+    const PdfObject* pColorSpace = pObject->GetIndirectKey( "ColorSpace" );
+    if( !pColorSpace || !pColorSpace->IsName() )
+        return false;
+
+    if( pColorSpace->GetName() == PdfName( "DeviceGray" ) )
+        pImage->nComponents = 1;
+    else if( pColorSpace->GetName() == PdfName( "DeviceRGB" ) )
+        pImage->nComponents = 3;
+    else if( pColorSpace->GetName() == PdfName( "DeviceCMYK" ) )
+        pImage->nComponents = 4;
+    else
+        return false;
+
+    try {
+        pImage->filters = PdfFilterFactory::CreateFilterList( pObject );
+    } catch( PdfError & ) {
+        // Unknown filters
+        return false;
+    }
+
+    for( TCIVecFilters it = pImage->filters.begin(); it != pImage->filters.end(); ++it )
+    {
+        PODOFO_UNIQUEU_PTR<PdfFilter> pFilter( PdfFilterFactory::Create( *it ) );
+        if( !pFilter.get() || !pFilter->CanDecode() )
+            return false;
+    }
+
+    pImage->pObject     = pObject;
+    pImage->pDictionary = &(pObject->GetDictionary());
+    pImage->pBuffer     = pStream->Get();
+    pImage->lLen        = pStream->GetLength();
+    pImage->nWidth      = static_cast<unsigned int>(pWidth->GetNumber());
+    pImage->nHeight     = static_cast<unsigned int>(pHeight->GetNumber());
+    pImage->nFactor     = 1;
+    pImage->bConvert    = bConvertColorSpace && pImage->nComponents != 1 && !pObject->GetDictionary().HasKey( "Decode" );
+    pImage->bLossy      = pImage->filters.size() && pImage->filters.back() == ePdfFilter_DCTDecode;
+
+    return true;
+}
+
+};
+
+PdfImageOptimizer::PdfImageOptimizer()
+    : m_dResolution( 0.0 ), m_bConvertColorSpace( true ), m_eFilter( ePdfFilter_None ),
+      m_nJpegQuality( 75 ), m_nThreads( 0 )
+{
+}
+
+void PdfImageOptimizer::SetResolution( double dResolution )
+{
+    if( dResolution < 0.0 )
+    {
+        PODOFO_RAISE_ERROR( ePdfError_ValueOutOfRange );
+    }
+
+    m_dResolution = dResolution;
+}
+
+void PdfImageOptimizer::SetConvertColorSpace( bool bConvert )
+{
+    m_bConvertColorSpace = bConvert;
+}
+
+void PdfImageOptimizer::SetFilter( EPdfFilter eFilter )
+{
+    if( eFilter != ePdfFilter_None && eFilter != ePdfFilter_DCTDecode && eFilter != ePdfFilter_FlateDecode )
+    {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_UnsupportedFilter, "Images can only be encoded using DCTDecode or FlateDecode" );
+    }
+
+    m_eFilter = eFilter;
+}
+
+void PdfImageOptimizer::SetJpegQuality( int nQuality )
+{
+    if( nQuality < 1 || nQuality > 100 )
+    {
+        PODOFO_RAISE_ERROR( ePdfError_ValueOutOfRange );
+    }
+
+    m_nJpegQuality = nQuality;
+}
+
+int PdfImageOptimizer::Optimize( PdfDocument* pDocument )
+{
+    if( !pDocument )
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
+    }
+
+    // Estimate the resolution of the images used on pages
+    std::map<const PdfObject*,double> mapResolutions;
+    if( m_dResolution > 0.0 )
+    {
+        for( int i = 0; i < pDocument->GetPageCount(); i++ )
+        {
+            PdfPage*    pPage     = pDocument->GetPage( i );
+            const PdfRect rBox    = pPage->GetMediaBox();
+            const double  dSize   = PDF_MAX( rBox.GetWidth(), rBox.GetHeight() );
+            if( dSize <= 0.0 )
+                continue;
+
+            std::set<const PdfObject*> setForms;
+            CollectImageResolutions( pPage->GetResources(), dSize, mapResolutions, setForms );
+        }
+    }
+
+    TOptimizeImagesJob job;
+    job.eFilter      = m_eFilter;
+    job.nJpegQuality = m_nJpegQuality;
+    job.nNextImage   = 0;
+
+    // Select the images on the calling thread, as objects and
+    // streams of a parsed document are loaded here on demand
+    std::vector<TImageCandidate>            vecCandidates;
+    std::map<const PdfObject*,unsigned int> mapMaskFactors;
+    std::set<const PdfObject*>              setMatte;
+    PdfVecObjects* pObjects = pDocument->GetObjects();
+    for( TCIVecObjects it = pObjects->begin(); it != pObjects->end(); ++it )
+    {
+        TImageCandidate image;
+        image.nFactor = 1;
+        if( IsImageCandidate( *it, m_bConvertColorSpace, &image ) )
+        {
+            std::map<const PdfObject*,double>::const_iterator itResolution = mapResolutions.find( *it );
+            if( itResolution != mapResolutions.end() )
+            {
+                // Blocks are never larger than the image
+                const double dFactor = PDF_MIN( itResolution->second / m_dResolution, 
+                                                static_cast<double>(PDF_MIN( image.nWidth, image.nHeight )) );
+                image.nFactor = static_cast<unsigned int>(PDF_MAX( dFactor, 1.0 ));
+            }
+
+            vecCandidates.push_back( image );
+        }
+
+        const PdfObject* pSubtype = (*it)->IsDictionary() ? (*it)->GetIndirectKey( PdfName::KeySubtype ) : NULL;
+        if( !pSubtype || !pSubtype->IsName() || pSubtype->GetName() != PdfName( "Image" ) )
+            continue;
+
+        // A soft mask is downsampled by the smallest factor of the images using it.
+        // With /Matte the samples of the image are premultiplied with the mask, 
+        // which needs the same size and color space, so both are left unchanged.
+        const PdfObject* pSMask = (*it)->GetIndirectKey( "SMask" );
+        if( !pSMask || !pSMask->IsDictionary() )
+            continue;
+
+        if( pSMask->GetDictionary().HasKey( "Matte" ) )
+        {
+            setMatte.insert( *it );
+            setMatte.insert( pSMask );
+        }
+
+        std::map<const PdfObject*,unsigned int>::iterator itMask = mapMaskFactors.find( pSMask );
+        if( itMask == mapMaskFactors.end() )
+            mapMaskFactors[pSMask] = image.nFactor;
+        else
+            itMask->second = PDF_MIN( itMask->second, image.nFactor );
+    }
+
+    for( size_t i = 0; i < vecCandidates.size(); i++ )
+    {
+        TImageCandidate & rImage = vecCandidates[i];
+        if( setMatte.count( rImage.pObject ) )
+            continue;
+
+        std::map<const PdfObject*,unsigned int>::const_iterator itMask = mapMaskFactors.find( rImage.pObject );
+        if( itMask != mapMaskFactors.end() )
+            rImage.nFactor = PDF_MIN( itMask->second, PDF_MIN( rImage.nWidth, rImage.nHeight ) );
+
+        job.vecImages.push_back( rImage );
+    }
+
+    TImageResult empty;
+    memset( &empty, 0, sizeof(TImageResult) );
+    job.vecResults.resize( job.vecImages.size(), empty );
+    job.vecErrors.resize( job.vecImages.size(), NULL );
+
+    int nThreads = m_nThreads > 0 ? m_nThreads : Util::PdfThread::GetProcessorCount();
+
+    // Never start more threads than there are images
+    nThreads = static_cast<int>(PODOFO_MIN( static_cast<size_t>(nThreads), job.vecImages.size() ));
+
+    // The calling thread optimizes images, too.
+    std::vector<Util::PdfThread*> vecThreads;
+    try {
+        for( int i = 1; i < nThreads; i++ )
+        {
+            Util::PdfThread* pThread = new Util::PdfThread();
+            vecThreads.push_back( pThread );
+            pThread->Start( &OptimizeImagesWorker, &job );
+        }
+    } catch( ... ) {
+        // Continue with the threads that could be started
+    }
+
+    OptimizeImagesWorker( &job );
+
+    // Deleting a thread waits for it to finish
+    for( size_t i = 0; i < vecThreads.size(); i++ )
+        delete vecThreads[i];
+
+    for( size_t i = 0; i < job.vecErrors.size(); i++ )
+    {
+        if( job.vecErrors[i] )
+        {
+            PdfError error( *job.vecErrors[i] );
+            throw error;
+        }
+    }
+
+    int nReplaced = 0;
+    for( size_t i = 0; i < job.vecResults.size(); i++ )
+    {
+        const TImageResult & rResult = job.vecResults[i];
+        if( !rResult.pBuffer )
+            continue;
+
+        PdfObject*           pObject = job.vecImages[i].pObject;
+        PdfMemoryInputStream stream( rResult.pBuffer, rResult.lLen );
+        pObject->GetStream()->SetRawData( &stream, rResult.lLen );
+
+        PdfDictionary & rDict = pObject->GetDictionary();
+        rDict.AddKey( PdfName::KeyFilter, PdfName( PdfFilterFactory::FilterTypeToName( rResult.eFilter ) ) );
+        if( rResult.eFilter == ePdfFilter_FlateDecode )
+        {
+            PdfDictionary decodeParms;
+            decodeParms.AddKey( "Predictor", static_cast<pdf_int64>(15) );
+            decodeParms.AddKey( "Colors", static_cast<pdf_int64>(rResult.nComponents) );
+            decodeParms.AddKey( "BitsPerComponent", static_cast<pdf_int64>(8) );
+            decodeParms.AddKey( "Columns", static_cast<pdf_int64>(rResult.nWidth) );
+            rDict.AddKey( "DecodeParms", decodeParms );
+        }
+        else
+            rDict.RemoveKey( "DecodeParms" );
+
+        rDict.RemoveKey( "DL" );
+        rDict.AddKey( "Width", static_cast<pdf_int64>(rResult.nWidth) );
+        rDict.AddKey( "Height", static_cast<pdf_int64>(rResult.nHeight) );
+        if( rResult.nComponents != job.vecImages[i].nComponents )
+            rDict.AddKey( "ColorSpace", PdfName( rResult.nComponents == 1 ? "DeviceGray" : "DeviceRGB" ) );
+
+        ++nReplaced;
+    }
+
+    return nReplaced;
+}
+
+};
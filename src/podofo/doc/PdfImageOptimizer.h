@@ -0,0 +1,220 @@
+/***************************************************************************
+ *   Copyright (C) 2005 by Dominik Seichter                                *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ *                                                                         *
+ *   In addition, as a special exception, the copyright holders give       *
+ *   permission to link the code of portions of this program with the      *
+ *   OpenSSL library under certain conditions as described in each         *
+ *   individual source file, and distribute linked combinations            *
+ *   including the two.                                                    *
+ *   You must obey the GNU General Public License in all respects          *
+ *   for all of the code used other than OpenSSL.  If you modify           *
+ *   file(s) with this exception, you may extend this exception to your    *
+ *   version of the file(s), but you are not obligated to do so.  If you   *
+ *   do not wish to do so, delete this exception statement from your       *
+ *   version.  If you delete this exception statement from all source      *
+ *   files in the program, then also delete it here.                       *
+ ***************************************************************************/
+
+#ifndef _PDF_IMAGE_OPTIMIZER_H_
+#define _PDF_IMAGE_OPTIMIZER_H_
+
+#include "podofo/base/PdfDefines.h"
+#include "podofo/base/PdfFilter.h"
+
+namespace PoDoFo {
+
+class PdfDocument;
+
+/** PdfImageOptimizer makes the images of a document smaller.
+ *
+ *  All image XObjects of a document with 8 bits per component in 
+ *  DeviceGray, DeviceRGB or DeviceCMYK are decoded and
+ *  - downsampled to a target resolution,
+ *  - converted to a cheaper color space: CMYK images to RGB and
+ *    RGB images, whose pixels are all gray, to DeviceGray,
+ *  - encoded again using DCTDecode or FlateDecode with a PNG predictor.
+ *
+ *  An image is only replaced if the result is smaller than the 
+ *  original data. The images are processed in parallel.
+ *
+ *  The resolution of an image is estimated from the size of the pages
+ *  which use it in their resources, assuming that the image covers
+ *  the whole page. The estimate is lower than the actual resolution
+ *  for images drawn smaller than the page, but higher for images drawn
+ *  larger than the page, e.g. clipped or scaled up images, which
+ *  may then be downsampled below the target resolution. Images which
+ *  are not used by any page (e.g. only inside annotations) are never
+ *  downsampled.
+ *
+ *  Images are downsampled by averaging blocks of n times n pixels, where
+ *  n is the largest integer which keeps the resolution at or above the target,
+ *  but at most the width and height of the image. Soft masks are downsampled
+ *  by the same n as their image. Images whose soft mask has a /Matte entry
+ *  and these soft masks are left unchanged.
+ *
+ *  Only documents holding their streams in memory (i.e. PdfMemDocument)
+ *  can be optimized.
+ *
+ *  \see PdfImage
+ */
+class PODOFO_DOC_API PdfImageOptimizer {
+ public:
+    /** Create an optimizer which does not downsample images,
+     *  converts color spaces and keeps the kind of compression
+     *  of each image.
+     */
+    PdfImageOptimizer();
+
+    /** Set the resolution images are downsampled to.
+     *
+     *  \param dResolution the target resolution in dots per inch, 
+     *                     0 disables downsampling (the default)
+     */
+    void SetResolution( double dResolution );
+
+    /**
+     *  \returns the resolution images are downsampled to in dots per inch
+     */
+    inline double GetResolution() const;
+
+    /** Enable or disable the conversion of CMYK images to RGB 
+     *  and of gray RGB images to DeviceGray. Enabled by default.
+     *
+     *  CMYK is converted without color management. Images with
+     *  a /Decode array are never converted.
+     *
+     *  \param bConvert if true color spaces are converted
+     */
+    void SetConvertColorSpace( bool bConvert );
+
+    /**
+     *  \returns true if color spaces are converted
+     */
+    inline bool GetConvertColorSpace() const;
+
+    /** Set the filter used to encode the images.
+     *
+     *  \param eFilter ePdfFilter_DCTDecode, ePdfFilter_FlateDecode or 
+     *                 ePdfFilter_None (the default) to encode images
+     *                 which were DCT encoded before using DCTDecode 
+     *                 and all other images losslessly with FlateDecode.
+     *
+     *  CMYK images and builds of PoDoFo without JPEG support always 
+     *  use FlateDecode.
+     */
+    void SetFilter( EPdfFilter eFilter );
+
+    /**
+     *  \returns the filter used to encode the images
+     */
+    inline EPdfFilter GetFilter() const;
+
+    /** Set the quality of DCT encoded images.
+     *
+     *  \param nQuality a JPEG quality from 1 (worst) to 100 (best), the default is 75
+     */
+    void SetJpegQuality( int nQuality );
+
+    /**
+     *  \returns the quality of DCT encoded images
+     */
+    inline int GetJpegQuality() const;
+
+    /** Set the number of threads used to process images. 
+     *
+     *  \param nThreads number of threads including the calling thread
+     *                  or 0 to use one thread per processor (the default)
+     */
+    inline void SetThreadCount( int nThreads );
+
+    /**
+     *  \returns the number of threads used to process images
+     *           or 0 for one thread per processor
+     */
+    inline int GetThreadCount() const;
+
+    /** Optimize all images of a document.
+     *
+     *  If any image fails to decode or encode, the error is 
+     *  thrown and the document is left unchanged.
+     *
+     *  \param pDocument the document, its streams have to be in memory
+     *  \returns the number of images which were replaced
+     */
+    int Optimize( PdfDocument* pDocument );
+
+ private:
+    double     m_dResolution;
+    bool       m_bConvertColorSpace;
+    EPdfFilter m_eFilter;
+    int        m_nJpegQuality;
+    int        m_nThreads;
+};
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+inline double PdfImageOptimizer::GetResolution() const
+{
+    return m_dResolution;
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+inline bool PdfImageOptimizer::GetConvertColorSpace() const
+{
+    return m_bConvertColorSpace;
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+inline EPdfFilter PdfImageOptimizer::GetFilter() const
+{
+    return m_eFilter;
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+inline int PdfImageOptimizer::GetJpegQuality() const
+{
+    return m_nJpegQuality;
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+inline void PdfImageOptimizer::SetThreadCount( int nThreads )
+{
+    m_nThreads = nThreads;
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+inline int PdfImageOptimizer::GetThreadCount() const
+{
+    return m_nThreads;
+}
+
+};
+
+#endif // _PDF_IMAGE_OPTIMIZER_H_
@@ -71,7 +71,8 @@ PdfMemDocument::PdfMemDocument()
 #ifdef _WIN32
       m_wchar_pszUpdatingFilename( NULL ),
 #endif
-      m_pszUpdatingFilename( NULL ), m_pUpdatingInputDevice( NULL )
+      m_pszUpdatingFilename( NULL ), m_pUpdatingInputDevice( NULL ),
+      m_bUseArena( false ), m_pArena( NULL )
 {
     m_eVersion    = ePdfVersion_Default;
     m_eWriteMode  = ePdfWriteMode_Default;
@@ -84,7 +85,8 @@ PdfMemDocument::PdfMemDocument(bool bOnlyTrailer)
 #ifdef _WIN32
       m_wchar_pszUpdatingFilename( NULL ),
 #endif
-      m_pszUpdatingFilename( NULL ), m_pUpdatingInputDevice( NULL )
+      m_pszUpdatingFilename( NULL ), m_pUpdatingInputDevice( NULL ),
+      m_bUseArena( false ), m_pArena( NULL )
 {
     m_eVersion    = ePdfVersion_Default;
     m_eWriteMode  = ePdfWriteMode_Default;
@@ -97,7 +99,8 @@ PdfMemDocument::PdfMemDocument( const char* pszFilename, bool bForUpdate )
 #ifdef _WIN32
       m_wchar_pszUpdatingFilename( NULL ),
 #endif
-      m_pszUpdatingFilename( NULL ), m_pUpdatingInputDevice( NULL )
+      m_pszUpdatingFilename( NULL ), m_pUpdatingInputDevice( NULL ),
+      m_bUseArena( false ), m_pArena( NULL )
 {
     this->Load( pszFilename, bForUpdate );
 }
@@ -107,7 +110,8 @@ PdfMemDocument::PdfMemDocument( const char* pszFilename, bool bForUpdate )
 #else
 PdfMemDocument::PdfMemDocument( const wchar_t* pszFilename, bool bForUpdate )
     : PdfDocument(), m_pEncrypt( NULL ), m_pParser( NULL ), m_bSoureHasXRefStream( false ), m_lPrevXRefOffset( -1 ),
-      m_wchar_pszUpdatingFilename( NULL ), m_pszUpdatingFilename( NULL ), m_pUpdatingInputDevice( NULL )
+      m_wchar_pszUpdatingFilename( NULL ), m_pszUpdatingFilename( NULL ), m_pUpdatingInputDevice( NULL ),
+      m_bUseArena( false ), m_pArena( NULL )
 {
     this->Load( pszFilename, bForUpdate );
 }
@@ -117,6 +121,8 @@ PdfMemDocument::PdfMemDocument( const wchar_t* pszFilename, bool bForUpdate )
 PdfMemDocument::~PdfMemDocument()
 {
     this->Clear();
+
+    delete m_pArena;
 }
 
 void PdfMemDocument::Clear() 
@@ -160,6 +166,28 @@ void PdfMemDocument::Clear()
     GetObjects().SetCanReuseObjectNumbers( true );
 
     PdfDocument::Clear();
+
+    // All objects are deleted now, so the arena can be released
+    if( m_pArena ) 
+    {
+        if( m_bUseArena )
+            m_pArena->Clear();
+        else
+        {
+            delete m_pArena;
+            m_pArena = NULL;
+        }
+    }
+}
+
+void PdfMemDocument::SetUseArena( bool bUseArena )
+{
+    m_bUseArena = bUseArena;
+
+    // Without arena, an existing one is deleted together with
+    // the objects allocated from it by Clear
+    if( m_bUseArena && !m_pArena )
+        m_pArena = new PdfArena();
 }
 
 void PdfMemDocument::InitFromParser( PdfParser* pParser )
@@ -233,7 +261,7 @@ void PdfMemDocument::InitFromParser( PdfParser* pParser )
     }
 }
 
-void PdfMemDocument::Load( const char* pszFilename, bool bForUpdate )
+void PdfMemDocument::Load( const char* pszFilename, bool bForUpdate, EPdfInputMode eMode )
 {
     if( !pszFilename || !pszFilename[0] )
     {
@@ -253,8 +281,9 @@ void PdfMemDocument::Load( const char* pszFilename, bool bForUpdate )
     // Call parse file instead of using the constructor
     // so that m_pParser is initialized for encrypted documents
     m_pParser = new PdfParser( PdfDocument::GetObjects() );
+    m_pParser->SetArena( m_pArena );
     try {
-        m_pParser->ParseFile( pszFilename, true );
+        m_pParser->ParseFile( pszFilename, true, eMode );
         InitFromParser( m_pParser );
     } catch (PdfError& e) {
         if ( e.GetError() != ePdfError_InvalidPassword )
@@ -287,12 +316,13 @@ void PdfMemDocument::Load( const wchar_t* pszFilename, bool bForUpdate )
     // Call parse file instead of using the constructor
     // so that m_pParser is initialized for encrypted documents
     m_pParser = new PdfParser( PdfDocument::GetObjects() );
+    m_pParser->SetArena( m_pArena );
     m_pParser->ParseFile( pszFilename, true );
     InitFromParser( m_pParser );
 }
 #endif // _WIN32
 
-void PdfMemDocument::LoadFromBuffer( const char* pBuffer, long lLen, bool bForUpdate )
+void PdfMemDocument::LoadFromBuffer( const char* pBuffer, long lLen, bool bForUpdate, EPdfInputMode eMode )
 {
     if( !pBuffer || !lLen )
     {
@@ -301,15 +331,19 @@ void PdfMemDocument::LoadFromBuffer( const char* pBuffer, long lLen, bool bForUp
 
     this->Clear();
 
+    // The parser and WriteUpdate share one device,
+    // so the buffer is copied at most once.
+    PdfRefCountedInputDevice device( pBuffer, lLen, eMode );
     if( bForUpdate )
     {
-        m_pUpdatingInputDevice = new PdfRefCountedInputDevice( pBuffer, lLen );
+        m_pUpdatingInputDevice = new PdfRefCountedInputDevice( device );
     }
 
     // Call parse file instead of using the constructor
     // so that m_pParser is initialized for encrypted documents
     m_pParser = new PdfParser( PdfDocument::GetObjects() );
-    m_pParser->ParseFile( pBuffer, lLen, true );
+    m_pParser->SetArena( m_pArena );
+    m_pParser->ParseFile( device, true );
     InitFromParser( m_pParser );
 }
 
@@ -325,6 +359,7 @@ void PdfMemDocument::LoadFromDevice( const PdfRefCountedInputDevice & rDevice, b
     // Call parse file instead of using the constructor
     // so that m_pParser is initialized for encrypted documents
     m_pParser = new PdfParser( PdfDocument::GetObjects() );
+    m_pParser->SetArena( m_pArena );
     m_pParser->ParseFile( rDevice, true );
     InitFromParser( m_pParser );
 }
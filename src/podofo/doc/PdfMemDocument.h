@@ -142,10 +142,14 @@ class PODOFO_DOC_API PdfMemDocument : public PdfDocument {
      *
      *  When the bForUpdate is set to true, the pszFilename is copied
      *  for later use by WriteUpdate.
+     *
+     *  If eMode is ePdfInputMode_ZeroCopy the file is mapped into memory
+     *  and objects are parsed directly from the mapping.
      *  
      *  \see SetPassword, WriteUpdate, LoadFromBuffer, LoadFromDevice
      */
-    void Load( const char* pszFilename, bool bForUpdate = false );
+    void Load( const char* pszFilename, bool bForUpdate = false, 
+               EPdfInputMode eMode = ePdfInputMode_Default );
 
 #ifdef _WIN32
     /** Load a PdfMemDocument from a file
@@ -174,17 +178,21 @@ class PODOFO_DOC_API PdfMemDocument : public PdfDocument {
      *  \param pBuffer a memory area containing the PDF data
      *  \param lLen length of the buffer
      *  \param bForUpdate whether to load for incremental update
+     *  \param eMode by default the buffer is copied. If ePdfInputMode_ZeroCopy
+     *               is passed, objects are parsed directly from pBuffer which
+     *               has to stay valid until the document is cleared or destroyed.
      *
      *  This might throw a PdfError( ePdfError_InvalidPassword ) exception
      *  if a password is required to read this PDF.
      *  Call SetPassword with the correct password in this case.
      *
-     *  When the bForUpdate is set to true, the memory buffer is copied
+     *  When the bForUpdate is set to true, the memory buffer is kept
      *  for later use by WriteUpdate.
      *  
      *  \see SetPassword, WriteUpdate, Load, LoadFromDevice
      */
-    void LoadFromBuffer( const char* pBuffer, long lLen, bool bForUpdate = false );
+    void LoadFromBuffer( const char* pBuffer, long lLen, bool bForUpdate = false, 
+                         EPdfInputMode eMode = ePdfInputMode_Default );
 
     /** Load a PdfMemDocument from a PdfRefCountedInputDevice
      *
@@ -206,6 +214,35 @@ class PODOFO_DOC_API PdfMemDocument : public PdfDocument {
      */
     inline bool IsLoaded( void ) const;
 
+    /** Allocate the objects of documents loaded by the following
+     *  calls to Load, LoadFromBuffer or LoadFromDevice from a 
+     *  memory arena owned by this document.
+     *
+     *  Parsed objects are placed contiguously in memory and
+     *  are all released at once when the document is deleted or
+     *  another document is loaded, which is considerably faster 
+     *  than freeing each object separately.
+     *
+     *  Objects of the document must not be used after the document
+     *  has been deleted or another document has been loaded, not even
+     *  if they were removed from the document. Memory released by 
+     *  FreeObjectMemory is only reused once the arena is cleared.
+     *
+     *  By default, no arena is used.
+     *
+     *  \param bUseArena if true, objects are allocated from an arena
+     *
+     *  \see PdfArena
+     */
+    void SetUseArena( bool bUseArena );
+
+    /** 
+     *  \returns true if loaded objects are allocated from a memory arena
+     *
+     *  \see SetUseArena
+     */
+    inline bool GetUseArena() const;
+
     /** Writes the complete document to a file
      *
      *  \param pszFilename filename of the document 
@@ -659,6 +696,9 @@ private:
     char *m_pszUpdatingFilename;
     PdfRefCountedInputDevice *m_pUpdatingInputDevice;
 
+    bool      m_bUseArena;
+    PdfArena* m_pArena;   ///< Owns the memory of all loaded objects if m_bUseArena is set
+
     inline bool IsLoadedForUpdate( void ) const;
 };
 
@@ -670,6 +710,14 @@ bool PdfMemDocument::IsLoaded( void ) const
     return m_pParser == NULL;
 }
 
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+bool PdfMemDocument::GetUseArena() const
+{
+    return m_bUseArena;
+}
+
 // -----------------------------------------------------
 // 
 // -----------------------------------------------------
@@ -47,6 +47,7 @@
 #include "base/PdfDictionary.h"
 #include "base/PdfFilter.h"
 #include "base/PdfName.h"
+#include "base/PdfOutputDevice.h"
 #include "base/PdfRect.h"
 #include "base/PdfStream.h"
 #include "base/PdfString.h"
@@ -424,9 +425,8 @@ void PdfPainter::SetStrokeWidth( double dWidth )
 {
     PODOFO_RAISE_LOGIC_IF( !m_pCanvas, "Call SetPage() first before doing drawing operations." );    
 
-    m_oss.str("");
-    m_oss << dWidth << " w" << std::endl;
-    m_pCanvas->Append( m_oss.str() );
+    size_t lLen = FormatOperator( 0, &dWidth, 1, "w\n" );
+    m_pCanvas->Append( m_tokenBuffer.GetBuffer(), lLen );
 }
 
 void PdfPainter::SetStrokeStyle( EPdfStrokeStyle eStyle, const char* pszCustom, bool inverted, double scale, bool subtractJoinCap)
@@ -612,23 +612,17 @@ void PdfPainter::DrawLine( double dStartX, double dStartY, double dEndX, double
 {
     PODOFO_RAISE_LOGIC_IF( !m_pCanvas, "Call SetPage() first before doing drawing operations." );    
 
-	 m_curPath.str("");
-    m_curPath
-		    << dStartX << " "
-          << dStartY
-          << " m "
-          << dEndX << " "
-          << dEndY        
-          << " l" << std::endl;
+    const double pdStart[] = { dStartX, dStartY };
+    const double pdEnd[]   = { dEndX, dEndY };
+    size_t       lLen      = FormatOperator( 0, pdStart, 2, "m " );
+    lLen = FormatOperator( lLen, pdEnd, 2, "l" );
 
-    m_oss.str("");
-    m_oss << dStartX << " "
-          << dStartY
-          << " m "
-          << dEndX << " "
-          << dEndY        
-          << " l S" << std::endl;
-    m_pCanvas->Append( m_oss.str() );
+    m_curPath.str("");
+    m_curPath.write( m_tokenBuffer.GetBuffer(), lLen );
+    m_curPath << std::endl;
+
+    m_pCanvas->Append( m_tokenBuffer.GetBuffer(), lLen );
+    m_pCanvas->Append( " S\n" );
 }
 
 void PdfPainter::Rectangle( double dX, double dY, double dWidth, double dHeight,
@@ -655,21 +649,12 @@ void PdfPainter::Rectangle( double dX, double dY, double dWidth, double dHeight,
     } 
     else 
     {
-        m_curPath 
-				  << dX << " "
-              << dY << " "
-              << dWidth << " "
-              << dHeight        
-              << " re" << std::endl;
+        const double pdOperands[] = { dX, dY, dWidth, dHeight };
+        size_t       lLen         = FormatOperator( 0, pdOperands, 4, "re\n" );
 
-    m_oss.str("");
-        m_oss << dX << " "
-            << dY << " "
-            << dWidth << " "
-            << dHeight        
-              << " re" << std::endl;
-    m_pCanvas->Append( m_oss.str() );
-}
+        m_curPath.write( m_tokenBuffer.GetBuffer(), lLen );
+        m_pCanvas->Append( m_tokenBuffer.GetBuffer(), lLen );
+    }
 }
 
 void PdfPainter::Ellipse( double dX, double dY, double dWidth, double dHeight )
@@ -881,9 +866,10 @@ void PdfPainter::MoveTextPos( double dX, double dY )
         PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
     }
 
-    m_oss.str("");
-    m_oss << dX << " " << dY << " Td" << std::endl ;
-    m_pCanvas->Append( m_oss.str() );
+    const double pdOperands[] = { dX, dY };
+    size_t       lLen         = FormatOperator( 0, pdOperands, 2, "Td\n" );
+
+    m_pCanvas->Append( m_tokenBuffer.GetBuffer(), lLen );
 }
 
 void PdfPainter::AddText( const PdfString & sText )
@@ -1005,6 +991,12 @@ std::vector<PdfString> PdfPainter::GetMultiLineTextAsLines( double dWidth, const
     PODOFO_ASSERT( converted == (rsText.GetCharacterLength() + 1) );
 
 	const pdf_utf16be* const stringUtf16Begin = &stringUtf16[0];
+
+    // Calculate the widths of all characters at once
+    std::vector<double> vecWidths( stringUtf16.size(), 0.0 );
+    if( converted > 1 ) 
+        m_pFont->GetFontMetrics()->UnicodeCharWidths( stringUtf16Begin, static_cast<unsigned int>(converted - 1), &vecWidths[0] );
+
     const pdf_utf16be* pszLineBegin = stringUtf16Begin;
     const pdf_utf16be* pszCurrentCharacter = stringUtf16Begin;
     const pdf_utf16be* pszStartOfCurrentWord  = stringUtf16Begin;
@@ -1062,7 +1054,7 @@ std::vector<PdfString> PdfPainter::GetMultiLineTextAsLines( double dWidth, const
                     dCurWidthOfLine = 0.0;
                 }
             }
-            else if( ( dCurWidthOfLine + m_pFont->GetFontMetrics()->UnicodeCharWidth( SwapCharBytesIfRequired( *pszCurrentCharacter ) ) ) > dWidth )
+            else if( ( dCurWidthOfLine + vecWidths[pszCurrentCharacter - stringUtf16Begin] ) > dWidth )
             {
                 vecLines.push_back( PdfString( pszLineBegin, pszCurrentCharacter - pszLineBegin ) );
                 if( bSkipSpaces )
@@ -1083,7 +1075,7 @@ std::vector<PdfString> PdfPainter::GetMultiLineTextAsLines( double dWidth, const
             }
             else 
             {           
-                dCurWidthOfLine += m_pFont->GetFontMetrics()->UnicodeCharWidth( SwapCharBytesIfRequired( *pszCurrentCharacter ) );
+                dCurWidthOfLine += vecWidths[pszCurrentCharacter - stringUtf16Begin];
             }
 
             startOfWord = true;
@@ -1097,7 +1089,7 @@ std::vector<PdfString> PdfPainter::GetMultiLineTextAsLines( double dWidth, const
             }
             //else do nothing
 
-            if ((dCurWidthOfLine + m_pFont->GetFontMetrics()->UnicodeCharWidth( SwapCharBytesIfRequired( *pszCurrentCharacter ))) > dWidth)
+            if ((dCurWidthOfLine + vecWidths[pszCurrentCharacter - stringUtf16Begin]) > dWidth)
             {
                 if ( pszLineBegin == pszStartOfCurrentWord )
                 {
@@ -1115,7 +1107,7 @@ std::vector<PdfString> PdfPainter::GetMultiLineTextAsLines( double dWidth, const
                         vecLines.push_back(PdfString(pszLineBegin, pszCurrentCharacter - pszLineBegin));
                         pszLineBegin = pszCurrentCharacter;
                         pszStartOfCurrentWord = pszCurrentCharacter;
-                        dCurWidthOfLine = m_pFont->GetFontMetrics()->UnicodeCharWidth( SwapCharBytesIfRequired( *pszCurrentCharacter ) );
+                        dCurWidthOfLine = vecWidths[pszCurrentCharacter - stringUtf16Begin];
                     }
                 }
                 else
@@ -1129,7 +1121,7 @@ std::vector<PdfString> PdfPainter::GetMultiLineTextAsLines( double dWidth, const
             }
             else 
             {
-                dCurWidthOfLine += m_pFont->GetFontMetrics()->UnicodeCharWidth( SwapCharBytesIfRequired( *pszCurrentCharacter ) );
+                dCurWidthOfLine += vecWidths[pszCurrentCharacter - stringUtf16Begin];
             }
         }
         ++pszCurrentCharacter;
@@ -1366,56 +1358,33 @@ void PdfPainter::LineTo( double dX, double dY )
 {
     PODOFO_RAISE_LOGIC_IF( !m_pCanvas, "Call SetPage() first before doing drawing operations." );
     
-	 m_curPath
-			 << dX << " "
-          << dY
-          << " l" << std::endl;
+    const double pdOperands[] = { dX, dY };
+    size_t       lLen         = FormatOperator( 0, pdOperands, 2, "l\n" );
 
-    m_oss.str("");
-    m_oss << dX << " "
-          << dY
-          << " l" << std::endl;
-    m_pCanvas->Append( m_oss.str() );
+    m_curPath.write( m_tokenBuffer.GetBuffer(), lLen );
+    m_pCanvas->Append( m_tokenBuffer.GetBuffer(), lLen );
 }
 
 void PdfPainter::MoveTo( double dX, double dY )
 {
     PODOFO_RAISE_LOGIC_IF( !m_pCanvas, "Call SetPage() first before doing drawing operations." );
     
-    m_curPath
-        << dX << " "
-        << dY
-        << " m" << std::endl;
+    const double pdOperands[] = { dX, dY };
+    size_t       lLen         = FormatOperator( 0, pdOperands, 2, "m\n" );
 
-    m_oss.str("");
-    m_oss << dX << " "
-          << dY
-          << " m" << std::endl;
-    m_pCanvas->Append( m_oss.str() );
+    m_curPath.write( m_tokenBuffer.GetBuffer(), lLen );
+    m_pCanvas->Append( m_tokenBuffer.GetBuffer(), lLen );
 }
 
 void PdfPainter::CubicBezierTo( double dX1, double dY1, double dX2, double dY2, double dX3, double dY3 )
 {
     PODOFO_RAISE_LOGIC_IF( !m_pCanvas, "Call SetPage() first before doing drawing operations." );
 
-	 m_curPath
-         << dX1 << " "
-         << dY1 << " "
-         << dX2 << " "
-         << dY2 << " "
-         << dX3 << " "
-         << dY3 
-         << " c" << std::endl;
+    const double pdOperands[] = { dX1, dY1, dX2, dY2, dX3, dY3 };
+    size_t       lLen         = FormatOperator( 0, pdOperands, 6, "c\n" );
 
-    m_oss.str("");
-    m_oss << dX1 << " "
-          << dY1 << " "
-          << dX2 << " "
-          << dY2 << " "
-          << dX3 << " "
-          << dY3 
-          << " c" << std::endl;
-    m_pCanvas->Append( m_oss.str() );
+    m_curPath.write( m_tokenBuffer.GetBuffer(), lLen );
+    m_pCanvas->Append( m_tokenBuffer.GetBuffer(), lLen );
 }
 
 void PdfPainter::HorizontalLineTo( double inX )
@@ -2038,5 +2007,21 @@ PdfString PdfPainter::ExpandTabs( const PdfString & rsString, pdf_long lStringLe
 #endif
 }
 
+size_t PdfPainter::FormatOperator( size_t lOffset, const double* pdOperands, int nOperands, const char* pszOperator )
+{
+    PdfOutputDevice device( &m_tokenBuffer );
+    const int       nPrecision = static_cast<int>(m_oss.precision());
+
+    device.Seek( lOffset );
+    for( int i=0;i<nOperands;i++ ) 
+    {
+        device.WriteReal( pdOperands[i], false, nPrecision );
+        device.Write( " ", 1 );
+    }
+
+    device.Write( pszOperator, strlen( pszOperator ) );
+    return device.Tell();
+}
+
 } /* namespace PoDoFo */
 
@@ -38,6 +38,7 @@
 
 #include "podofo/base/PdfRect.h"
 #include "podofo/base/PdfColor.h"
+#include "podofo/base/PdfRefCountedBuffer.h"
 
 #include <sstream>
 
@@ -831,6 +832,21 @@ class PODOFO_DOC_API PdfPainter {
      *  \see SetTabWidth
      */
     PdfString ExpandTabs( const PdfString & rsString, pdf_long lLen ) const;
+
+    /** Format real operands followed by an operator into m_tokenBuffer
+     *  using the current precision of this painter.
+     *
+     *  This is used for frequent drawing operations instead of m_oss,
+     *  as it does not need any stream formatting.
+     *
+     *  \param lOffset start writing at this offset in m_tokenBuffer,
+     *                 so that several operators can be combined
+     *  \param pdOperands array of operands, which are separated by spaces
+     *  \param nOperands number of operands in pdOperands
+     *  \param pszOperator written after the operands and a space
+     *  \returns the offset in m_tokenBuffer after the operator
+     */
+    size_t FormatOperator( size_t lOffset, const double* pdOperands, int nOperands, const char* pszOperator );
     
 #if defined(_MSC_VER)  &&  _MSC_VER <= 1200	// MSC 6.0 has a template-bug 
     PdfString ExpandTabs_char( const char* pszText, long lStringLen, int nTabCnt, const char cTab, const char cSpace ) const;
@@ -877,6 +893,10 @@ class PODOFO_DOC_API PdfPainter {
      */
     std::ostringstream  m_curPath;
 
+    /** temporary buffer for FormatOperator
+     */
+    PdfRefCountedBuffer m_tokenBuffer;
+
     /** True if should use color with ICC Profile
      */
     bool m_isCurColorICCDepend;
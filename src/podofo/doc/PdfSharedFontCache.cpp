@@ -0,0 +1,359 @@
+/***************************************************************************
+ *   Copyright (C) 2011 by Dominik Seichter                                *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ *                                                                         *
+ *   In addition, as a special exception, the copyright holders give       *
+ *   permission to link the code of portions of this program with the      *
+ *   OpenSSL library under certain conditions as described in each         *
+ *   individual source file, and distribute linked combinations            *
+ *   including the two.                                                    *
+ *   You must obey the GNU General Public License in all respects          *
+ *   for all of the code used other than OpenSSL.  If you modify           *
+ *   file(s) with this exception, you may extend this exception to your    *
+ *   version of the file(s), but you are not obligated to do so.  If you   *
+ *   do not wish to do so, delete this exception statement from your       *
+ *   version.  If you delete this exception statement from all source      *
+ *   files in the program, then also delete it here.                       *
+ ***************************************************************************/
+
+#include "PdfSharedFontCache.h"
+
+#include "base/PdfDefinesPrivate.h"
+
+#include "base/PdfInputStream.h"
+#include "base/PdfObject.h"
+#include "base/PdfOutputStream.h"
+#include "base/PdfStream.h"
+#include "base/PdfVecObjects.h"
+#include "base/util/PdfMutexWrapper.h"
+
+namespace PoDoFo {
+
+// The mutex has to be defined before the maps,
+// so that it is still alive when the maps are destroyed
+Util::PdfMutex                    PdfSharedFontCache::s_mutex;
+bool                              PdfSharedFontCache::s_bEnabled = false;
+PdfSharedFontCache::TMapFontFiles PdfSharedFontCache::s_mapFontFiles;
+PdfSharedFontCache::TMapFontPaths PdfSharedFontCache::s_mapFontPaths;
+
+PdfSharedFontFile::PdfSharedFontFile()
+    : m_pData( NULL )
+{
+}
+
+PdfSharedFontFile::PdfSharedFontFile( TSharedFontFileData* pData )
+    : m_pData( pData )
+{
+    if( m_pData )
+        m_pData->m_lRefCount++;
+}
+
+PdfSharedFontFile::PdfSharedFontFile( const PdfSharedFontFile & rhs )
+    : m_pData( NULL )
+{
+    this->operator=( rhs );
+}
+
+PdfSharedFontFile::~PdfSharedFontFile()
+{
+    this->DerefBuffer();
+}
+
+const PdfSharedFontFile & PdfSharedFontFile::operator=( const PdfSharedFontFile & rhs )
+{
+    // Self assignment is a no-op
+    if( this == &rhs )
+        return rhs;
+
+    Util::PdfMutexWrapper mutex( PdfSharedFontCache::s_mutex );
+
+    DerefBuffer();
+
+    m_pData = rhs.m_pData;
+    if( m_pData )
+        m_pData->m_lRefCount++;
+
+    return *this;
+}
+
+void PdfSharedFontFile::DerefBuffer()
+{
+    if( !m_pData ) 
+        return;
+
+    Util::PdfMutexWrapper mutex( PdfSharedFontCache::s_mutex );
+    if( !(--m_pData->m_lRefCount) )
+    {
+        podofo_free( m_pData->m_pData );
+        for( size_t i = 0; i < m_pData->m_vecEncoded.size(); i++ )
+            podofo_free( m_pData->m_vecEncoded[i].m_pData );
+        delete m_pData;
+    }
+
+    m_pData = NULL;
+}
+
+const char* PdfSharedFontFile::GetFilename() const
+{
+    return m_pData ? m_pData->m_sFilename.c_str() : NULL;
+}
+
+const char* PdfSharedFontFile::GetData() const
+{
+    return m_pData ? m_pData->m_pData : NULL;
+}
+
+pdf_long PdfSharedFontFile::GetLength() const
+{
+    return m_pData ? m_pData->m_lLen : 0;
+}
+
+bool PdfSharedFontFile::GetWidths( bool bSymbol, std::vector<double> & rvecWidth ) const
+{
+    if( !m_pData ) 
+        return false;
+
+    Util::PdfMutexWrapper mutex( PdfSharedFontCache::s_mutex );
+    if( !m_pData->m_bHasWidths[bSymbol ? 1 : 0] )
+        return false;
+
+    rvecWidth = m_pData->m_vecWidths[bSymbol ? 1 : 0];
+    return true;
+}
+
+void PdfSharedFontFile::SetWidths( bool bSymbol, const std::vector<double> & rvecWidth ) const
+{
+    if( !m_pData ) 
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
+    }
+
+    Util::PdfMutexWrapper mutex( PdfSharedFontCache::s_mutex );
+    m_pData->m_vecWidths[bSymbol ? 1 : 0]  = rvecWidth;
+    m_pData->m_bHasWidths[bSymbol ? 1 : 0] = true;
+}
+
+void PdfSharedFontFile::SetStreamData( PdfObject* pObject ) const
+{
+    if( !m_pData || !pObject ) 
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
+    }
+
+    const TFlateSettings* pSettings = pObject->GetStream()->GetFlateSettings();
+    if( !pSettings && pObject->GetOwner() )
+        pSettings = pObject->GetOwner()->GetFlateSettings();
+
+    const TFlateSettings settings = pSettings ? *pSettings : PdfFilterFactory::GetFlateSettings();
+    const EPdfFilter     eFilter  = PdfStream::eDefaultFilter;
+
+    // A predictor requires /DecodeParms, which only PdfStream writes
+    if( eFilter == ePdfFilter_None || settings.nPredictor != 1 ) 
+    {
+        pObject->GetStream()->Set( m_pData->m_pData, m_pData->m_lLen );
+        return;
+    }
+
+    const char* pEncoded    = NULL;
+    pdf_long    lEncodedLen = 0;
+    char*       pBuffer     = NULL; // encoded data, unless it is cached
+    {
+        Util::PdfMutexWrapper mutex( PdfSharedFontCache::s_mutex );
+        const TEncodedData* pCached = FindEncodedData( eFilter, settings );
+        if( pCached ) 
+        {
+            pEncoded    = pCached->m_pData;
+            lEncodedLen = pCached->m_lLen;
+        }
+    }
+
+    if( !pEncoded ) 
+    {
+        // Do not block other threads while encoding
+        PdfMemoryOutputStream stream;
+        TVecFilters           vecFilters;
+        vecFilters.push_back( eFilter );
+
+        PODOFO_UNIQUEU_PTR<PdfOutputStream> pEncodeStream( 
+            PdfFilterFactory::CreateEncodeStream( vecFilters, &stream, &settings ) );
+        pEncodeStream->Write( m_pData->m_pData, m_pData->m_lLen );
+        pEncodeStream->Close();
+
+        lEncodedLen = stream.GetLength();
+        pBuffer     = stream.TakeBuffer();
+        pEncoded    = pBuffer;
+
+        // The cached data is never replaced, as other threads might 
+        // still use it. If another thread was faster, its data is kept.
+        Util::PdfMutexWrapper mutex( PdfSharedFontCache::s_mutex );
+        if( !FindEncodedData( eFilter, settings ) ) 
+        {
+            TEncodedData encoded;
+            encoded.m_eFilter  = eFilter;
+            encoded.m_settings = settings;
+            encoded.m_pData    = pBuffer;
+            encoded.m_lLen     = lEncodedLen;
+            m_pData->m_vecEncoded.push_back( encoded );
+            pBuffer = NULL;
+        }
+    }
+
+    try { 
+        pObject->GetDictionary().AddKey( PdfName::KeyFilter, PdfName( PdfFilterFactory::FilterTypeToName( eFilter ) ) );
+
+        PdfMemoryInputStream stream( pEncoded, lEncodedLen );
+        pObject->GetStream()->SetRawData( &stream, lEncodedLen );
+    } catch( PdfError & e ) {
+        podofo_free( pBuffer );
+        e.AddToCallstack( __FILE__, __LINE__ );
+        throw e;
+    }
+
+    podofo_free( pBuffer );
+}
+
+const PdfSharedFontFile::TEncodedData* PdfSharedFontFile::FindEncodedData( EPdfFilter eFilter, 
+                                                                           const TFlateSettings & rSettings ) const
+{
+    std::vector<TEncodedData>::const_iterator it = m_pData->m_vecEncoded.begin();
+    for( ; it != m_pData->m_vecEncoded.end(); ++it ) 
+    {
+        // Only FlateDecode depends on the settings
+        if( (*it).m_eFilter == eFilter && 
+            (eFilter != ePdfFilter_FlateDecode || 
+             ((*it).m_settings.nLevel == rSettings.nLevel && (*it).m_settings.eStrategy == rSettings.eStrategy)) )
+            return &(*it);
+    }
+
+    return NULL;
+}
+
+void PdfSharedFontCache::SetEnabled( bool bEnabled )
+{
+    Util::PdfMutexWrapper mutex( s_mutex );
+    s_bEnabled = bEnabled;
+}
+
+bool PdfSharedFontCache::IsEnabled()
+{
+    Util::PdfMutexWrapper mutex( s_mutex );
+    return s_bEnabled;
+}
+
+PdfSharedFontFile PdfSharedFontCache::GetFontFile( const char* pszFilename )
+{
+    if( !pszFilename ) 
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
+    }
+
+    {
+        Util::PdfMutexWrapper mutex( s_mutex );
+        TMapFontFiles::const_iterator it = s_mapFontFiles.find( pszFilename );
+        if( it != s_mapFontFiles.end() )
+            return (*it).second;
+    }
+
+    // Do not block other threads while reading the file,
+    // if another thread was faster its file is used
+    PdfSharedFontFile file = ReadFontFile( pszFilename );
+
+    Util::PdfMutexWrapper mutex( s_mutex );
+    std::pair<TMapFontFiles::iterator,bool> inserted = 
+        s_mapFontFiles.insert( TMapFontFiles::value_type( pszFilename, file ) );
+    return (*inserted.first).second;
+}
+
+PdfSharedFontFile PdfSharedFontCache::ReadFontFile( const char* pszFilename )
+{
+    PdfFileInputStream stream( pszFilename );
+    pdf_long           lLen = stream.GetFileLength();
+    if( lLen < 0 ) 
+    {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDeviceOperation, pszFilename );
+    }
+
+    char* pBuffer = static_cast<char*>(podofo_malloc( lLen ? lLen : 1 ));
+    if( !pBuffer ) 
+    {
+        PODOFO_RAISE_ERROR( ePdfError_OutOfMemory );
+    }
+
+    try { 
+        pdf_long lRead = 0;
+        while( lRead < lLen ) 
+        {
+            pdf_long lChunk = stream.Read( pBuffer + lRead, lLen - lRead );
+            if( lChunk <= 0 ) 
+            {
+                PODOFO_RAISE_ERROR_INFO( ePdfError_UnexpectedEOF, pszFilename );
+            }
+
+            lRead += lChunk;
+        }
+    } catch( PdfError & e ) {
+        podofo_free( pBuffer );
+        e.AddToCallstack( __FILE__, __LINE__ );
+        throw e;
+    }
+
+    PdfSharedFontFile::TSharedFontFileData* pData = new PdfSharedFontFile::TSharedFontFileData();
+    pData->m_sFilename     = pszFilename;
+    pData->m_pData         = pBuffer;
+    pData->m_lLen          = lLen;
+    pData->m_lRefCount     = 0;
+    pData->m_bHasWidths[0] = false;
+    pData->m_bHasWidths[1] = false;
+
+    Util::PdfMutexWrapper mutex( s_mutex );
+    return PdfSharedFontFile( pData );
+}
+
+bool PdfSharedFontCache::GetFontPath( const char* pszFontName, bool bBold, bool bItalic, std::string & rsPath )
+{
+    Util::PdfMutexWrapper mutex( s_mutex );
+    TMapFontPaths::const_iterator it = s_mapFontPaths.find( GetFontPathKey( pszFontName, bBold, bItalic ) );
+    if( it == s_mapFontPaths.end() )
+        return false;
+
+    rsPath = (*it).second;
+    return true;
+}
+
+void PdfSharedFontCache::AddFontPath( const char* pszFontName, bool bBold, bool bItalic, const std::string & rsPath )
+{
+    Util::PdfMutexWrapper mutex( s_mutex );
+    s_mapFontPaths[GetFontPathKey( pszFontName, bBold, bItalic )] = rsPath;
+}
+
+void PdfSharedFontCache::EmptyCache()
+{
+    Util::PdfMutexWrapper mutex( s_mutex );
+    s_mapFontFiles.clear();
+    s_mapFontPaths.clear();
+}
+
+std::string PdfSharedFontCache::GetFontPathKey( const char* pszFontName, bool bBold, bool bItalic )
+{
+    std::string sKey = pszFontName ? pszFontName : "";
+    sKey += bBold   ? "|B" : "|-";
+    sKey += bItalic ? "I"  : "-";
+    return sKey;
+}
+
+};
@@ -0,0 +1,268 @@
+/***************************************************************************
+ *   Copyright (C) 2011 by Dominik Seichter                                *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ *                                                                         *
+ *   In addition, as a special exception, the copyright holders give       *
+ *   permission to link the code of portions of this program with the      *
+ *   OpenSSL library under certain conditions as described in each         *
+ *   individual source file, and distribute linked combinations            *
+ *   including the two.                                                    *
+ *   You must obey the GNU General Public License in all respects          *
+ *   for all of the code used other than OpenSSL.  If you modify           *
+ *   file(s) with this exception, you may extend this exception to your    *
+ *   version of the file(s), but you are not obligated to do so.  If you   *
+ *   do not wish to do so, delete this exception statement from your       *
+ *   version.  If you delete this exception statement from all source      *
+ *   files in the program, then also delete it here.                       *
+ ***************************************************************************/
+
+#ifndef _PDF_SHARED_FONT_CACHE_H_
+#define _PDF_SHARED_FONT_CACHE_H_
+
+#include "podofo/base/PdfDefines.h"
+#include "podofo/base/PdfFilter.h"
+#include "podofo/base/util/PdfMutex.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace PoDoFo {
+
+class PdfObject;
+class PdfSharedFontCache;
+
+/**
+ * A handle to the contents of a font file, which are shared
+ * by all documents of the process using the PdfSharedFontCache.
+ *
+ * This class is reference counted and can be copied freely.
+ * The font data is never changed after the file was read,
+ * so it can be accessed from several threads at once.
+ *
+ * \see PdfSharedFontCache
+ */
+class PODOFO_DOC_API PdfSharedFontFile {
+    friend class PdfSharedFontCache;
+
+ public:
+    /** Create an invalid handle which refers to no font file
+     */
+    PdfSharedFontFile();
+
+    /** Copy an existing handle
+     */
+    PdfSharedFontFile( const PdfSharedFontFile & rhs );
+
+    ~PdfSharedFontFile();
+
+    const PdfSharedFontFile & operator=( const PdfSharedFontFile & rhs );
+
+    /** 
+     *  \returns true if this handle refers to a font file
+     */
+    inline bool IsValid() const;
+
+    /** 
+     *  \returns the filename of the font file
+     */
+    const char* GetFilename() const;
+
+    /** 
+     *  \returns the contents of the font file
+     */
+    const char* GetData() const;
+
+    /** 
+     *  \returns the length of the font file in bytes
+     */
+    pdf_long GetLength() const;
+
+    /** Get the cached widths of the first characters of this font,
+     *  as calculated by the first PdfFontMetricsFreetype using this file.
+     *
+     *  \param bSymbol the widths of the symbol charmap or the unicode charmap
+     *  \param rvecWidth the widths are copied to this vector
+     *
+     *  \returns true if widths were cached
+     */
+    bool GetWidths( bool bSymbol, std::vector<double> & rvecWidth ) const;
+
+    /** Cache the widths of the first characters of this font,
+     *  so that they have to be calculated only once per process.
+     *
+     *  \param bSymbol the widths of the symbol charmap or the unicode charmap
+     *  \param rvecWidth the widths to cache
+     */
+    void SetWidths( bool bSymbol, const std::vector<double> & rvecWidth ) const;
+
+    /** Set the contents of the font file as stream of an object, 
+     *  encoded using PdfStream::eDefaultFilter.
+     *
+     *  The Flate settings of the stream or of the document owning it
+     *  apply, like for any other stream. The encoded font data is cached
+     *  for each filter and Flate settings, so that a font file is 
+     *  compressed only once per process and settings when it is
+     *  embedded into many documents. Data for settings with a predictor
+     *  is not cached.
+     *
+     *  \param pObject the stream of this object is set
+     */
+    void SetStreamData( PdfObject* pObject ) const;
+
+ private:
+    struct TEncodedData {
+        EPdfFilter     m_eFilter;
+        TFlateSettings m_settings;
+        char*          m_pData;
+        pdf_long       m_lLen;
+    };
+
+    struct TSharedFontFileData {
+        std::string         m_sFilename;
+        char*               m_pData;
+        pdf_long            m_lLen;
+        long                m_lRefCount;
+
+        bool                m_bHasWidths[2];  ///< Indexed by the symbol flag
+        std::vector<double> m_vecWidths[2];
+
+        std::vector<TEncodedData> m_vecEncoded;  ///< Encodings of m_pData, never changed once added
+    };
+
+    /** Take a reference to some font data,
+     *  the mutex of the PdfSharedFontCache has to be locked.
+     */
+    explicit PdfSharedFontFile( TSharedFontFileData* pData );
+
+    /**
+     * Destroy the font data if the reference count is 0
+     */
+    void DerefBuffer();
+
+    /** Find cached encoded data,
+     *  the mutex of the PdfSharedFontCache has to be locked.
+     *
+     *  \returns the data encoded using eFilter and rSettings or NULL
+     */
+    const TEncodedData* FindEncodedData( EPdfFilter eFilter, const TFlateSettings & rSettings ) const;
+
+ private:
+    TSharedFontFileData* m_pData;
+};
+
+/**
+ * A process wide cache of font data which can be shared by all
+ * documents, e.g. by a service which creates many short lived documents
+ * using the same fonts.
+ *
+ * If the cache is enabled, every PdfFontCache reads a font file only 
+ * once per process and shares the fontconfig lookups and the widths 
+ * calculated for it. Every document still creates its own FreeType
+ * face and PdfFont objects from the shared data.
+ *
+ * All methods of this class are thread safe.
+ * The cache is disabled by default.
+ */
+class PODOFO_DOC_API PdfSharedFontCache {
+ public:
+    /** Enable or disable the shared font cache.
+     *  Disabling the cache does not free any data cached so far.
+     *
+     *  \param bEnabled if true all font caches share their font data
+     *
+     *  \see EmptyCache
+     */
+    static void SetEnabled( bool bEnabled );
+
+    /** 
+     *  \returns true if the shared font cache is enabled
+     */
+    static bool IsEnabled();
+
+    /** Get the shared contents of a font file,
+     *  the file is read on first use.
+     *
+     *  \param pszFilename filename of a font file
+     *
+     *  \returns a handle to the contents of the font file
+     */
+    static PdfSharedFontFile GetFontFile( const char* pszFilename );
+
+    /** Get a cached path to the font file of a fontname
+     *
+     *  \param pszFontName a fontname
+     *  \param bBold if true search for a bold font
+     *  \param bItalic if true search for an italic font
+     *  \param rsPath the cached path is written to this string,
+     *                it may be empty if no font file was found for the fontname
+     *
+     *  \returns true if a path was cached
+     */
+    static bool GetFontPath( const char* pszFontName, bool bBold, bool bItalic, std::string & rsPath );
+
+    /** Cache the path to the font file of a fontname
+     *
+     *  \param pszFontName a fontname
+     *  \param bBold if true the path is the one of a bold font
+     *  \param bItalic if true the path is the one of an italic font
+     *  \param rsPath path to a font file or an empty string if none was found
+     */
+    static void AddFontPath( const char* pszFontName, bool bBold, bool bItalic, const std::string & rsPath );
+
+    /** Remove all font files and paths from the cache.
+     *  Font files are freed once they are not used
+     *  by any font anymore.
+     */
+    static void EmptyCache();
+
+ private:
+    /** No instances of this class can be created
+     */
+    PdfSharedFontCache();
+
+    static std::string GetFontPathKey( const char* pszFontName, bool bBold, bool bItalic );
+
+    /** Read the contents of a font file into memory
+     */
+    static PdfSharedFontFile ReadFontFile( const char* pszFilename );
+
+ private:
+    typedef std::map<std::string,PdfSharedFontFile> TMapFontFiles;
+    typedef std::map<std::string,std::string>       TMapFontPaths;
+
+    static Util::PdfMutex s_mutex;
+    static bool           s_bEnabled;
+
+    static TMapFontFiles  s_mapFontFiles;  ///< Cached font files by filename
+    static TMapFontPaths  s_mapFontPaths;  ///< Cached paths by fontname and style
+
+    friend class PdfSharedFontFile;
+};
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+bool PdfSharedFontFile::IsValid() const
+{
+    return m_pData != NULL;
+}
+
+}; // PoDoFo
+
+#endif // _PDF_SHARED_FONT_CACHE_H_
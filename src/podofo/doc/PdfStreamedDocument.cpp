@@ -81,6 +81,11 @@ void PdfStreamedDocument::Close()
     this->GetObjects()->Finish();
 }
 
+void PdfStreamedDocument::SetStreamMemoryBudget( pdf_long lMemoryBudget )
+{
+    m_pWriter->SetStreamMemoryBudget( lMemoryBudget );
+}
+
 
 
 };
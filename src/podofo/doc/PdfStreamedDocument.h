@@ -137,6 +137,20 @@ class PODOFO_DOC_API PdfStreamedDocument : public PdfDocument {
      */
     void Close();
 
+    /** Limit the memory used by streams which cannot be written 
+     *  immediately, e.g. images and fonts created while a page is drawn.
+     *
+     *  Streams which would exceed the budget are moved to a temporary file,
+     *  so the memory used does not grow with the size of the document.
+     *  Call this before creating any pages.
+     *
+     *  \param lMemoryBudget number of bytes these streams may keep in
+     *                       memory together or -1 for no limit (the default)
+     *
+     *  \see PdfSpoolStreamFactory
+     */
+    void SetStreamMemoryBudget( pdf_long lMemoryBudget );
+
     /** Get the write mode used for wirting the PDF
      *  \returns the write mode
      */
@@ -39,13 +39,16 @@
 #include "base/PdfVersion.h"
 #include "base/PdfDefines.h"
 #include "base/Pdf3rdPtyForwardDecl.h"
+#include "base/PdfArena.h"
 #include "base/PdfArray.h"
 #include "base/PdfCanvas.h"
+#include "base/PdfCMap.h"
 #include "base/PdfColor.h"
 #include "base/PdfContentsTokenizer.h"
 #include "base/PdfData.h"
 #include "base/PdfDataType.h"
 #include "base/PdfDate.h"
+#include "base/PdfDeferredStream.h"
 #include "base/PdfDictionary.h"
 #include "base/PdfEncodingFactory.h"
 #include "base/PdfEncoding.h"
@@ -71,6 +74,7 @@
 #include "base/PdfRefCountedBuffer.h"
 #include "base/PdfRefCountedInputDevice.h"
 #include "base/PdfReference.h"
+#include "base/PdfSpoolStream.h"
 #include "base/PdfStream.h"
 #include "base/PdfString.h"
 #include "base/PdfTokenizer.h"
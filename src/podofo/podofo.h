@@ -80,6 +80,7 @@
 #include "doc/PdfHintStream.h"
 #include "doc/PdfIdentityEncoding.h"
 #include "doc/PdfImage.h"
+#include "doc/PdfImageOptimizer.h"
 #include "doc/PdfInfo.h"
 #include "doc/PdfMemDocument.h"
 #include "doc/PdfNamesTree.h"
@@ -90,6 +91,7 @@
 #include "doc/PdfPainter.h"
 #include "doc/PdfPainterMM.h"
 #include "doc/PdfShadingPattern.h"
+#include "doc/PdfSharedFontCache.h"
 #include "doc/PdfSignatureField.h"
 #include "doc/PdfSignOutputDevice.h"
 #include "doc/PdfStreamedDocument.h"
@@ -0,0 +1,158 @@
+/***************************************************************************
+ *   Copyright (C) 2005 by Dominik Seichter                                *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "../PdfTest.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <sstream>
+#include <vector>
+
+using namespace PoDoFo;
+
+#define NUM_PAGES          200
+#define NUM_FONTS_PER_PAGE 50
+
+/** Create a document where every page uses
+ *  its own font dictionaries, like some generators do.
+ */
+static void CreateDocument( PdfRefCountedBuffer & rBuffer, pdf_long & rlLen )
+{
+    PdfMemDocument doc;
+
+    for( int i=0;i<NUM_PAGES;i++ ) 
+    {
+        PdfPage*      pPage = doc.CreatePage( PdfPage::CreateStandardPageSize( ePdfPageSize_A4 ) );
+        PdfDictionary fonts;
+        for( int j=0;j<NUM_FONTS_PER_PAGE;j++ ) 
+        {
+            PdfObject* pFont = doc.GetObjects().CreateObject( "Font" );
+            pFont->GetDictionary().AddKey( PdfName::KeySubtype, PdfName( "Type1" ) );
+            pFont->GetDictionary().AddKey( "BaseFont", PdfName( j % 2 ? "Helvetica" : "Times-Roman" ) );
+
+            std::ostringstream oss;
+            oss << "F" << j;
+            fonts.AddKey( oss.str(), pFont->Reference() );
+        }
+        pPage->GetResources()->GetDictionary().AddKey( "Font", fonts );
+    }
+
+    PdfOutputDevice device( &rBuffer );
+    doc.Write( &device );
+    rlLen = device.GetLength();
+}
+
+/** Collect the font objects used on all pages of the document
+ */
+static void CollectFontObjects( PdfMemDocument & rDoc, std::vector<PdfObject*> & rFontObjects )
+{
+    for( int i=0;i<rDoc.GetPageCount();i++ ) 
+    {
+        PdfPage*   pPage      = rDoc.GetPage( i );
+        PdfObject* pResources = pPage->GetResources();
+        PdfObject* pFonts     = pResources ? pResources->GetIndirectKey( "Font" ) : NULL;
+        if( !pFonts || !pFonts->IsDictionary() )
+            continue;
+
+        TCIKeyMap it = pFonts->GetDictionary().GetKeys().begin();
+        while( it != pFonts->GetDictionary().GetKeys().end() )
+        {
+            if( (*it).second->IsReference() )
+            {
+                PdfObject* pFontObject = rDoc.GetObjects().GetObject( (*it).second->GetReference() );
+                if( pFontObject )
+                    rFontObjects.push_back( pFontObject );
+            }
+            ++it;
+        }
+    }
+}
+
+/** Resolve all font objects through the font cache of the document
+ */
+static void ResolveFonts( PdfMemDocument & rDoc, const std::vector<PdfObject*> & rFontObjects, 
+                          std::vector<PdfFont*> & rFonts )
+{
+    std::vector<PdfObject*>::const_iterator it = rFontObjects.begin();
+
+    rFonts.clear();
+    while( it != rFontObjects.end() )
+    {
+        rFonts.push_back( rDoc.GetFont( *it ) );
+        ++it;
+    }
+}
+
+static double Seconds( clock_t start ) 
+{
+    return static_cast<double>(clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main( int argc, char* argv[] )
+{
+    printf("Font Cache Benchmark\n");
+    printf("====================\n");
+
+    PdfMemDocument          doc;
+    std::vector<PdfObject*> fontObjects;
+    std::vector<PdfFont*>   firstFonts;
+    std::vector<PdfFont*>   secondFonts;
+    clock_t                 start;
+
+    if( argc > 1 )
+    {
+        // Resolve the fonts of an existing file
+        printf("Loading %s\n", argv[1] );
+        TEST_SAFE_OP( doc.Load( argv[1] ) );
+    }
+    else
+    {
+        PdfRefCountedBuffer buffer;
+        pdf_long            lLen = 0;
+
+        start = clock();
+        TEST_SAFE_OP( CreateDocument( buffer, lLen ) );
+        printf("Creating %i pages:       %.3fs\n", NUM_PAGES, Seconds( start ) );
+
+        TEST_SAFE_OP( doc.LoadFromBuffer( buffer.GetBuffer(), static_cast<long>(lLen) ) );
+    }
+
+    TEST_SAFE_OP( CollectFontObjects( doc, fontObjects ) );
+
+    // The first pass creates a font for every font dictionary
+    start = clock();
+    TEST_SAFE_OP( ResolveFonts( doc, fontObjects, firstFonts ) );
+    printf("Resolving %i fonts:     %.3fs\n", static_cast<int>(fontObjects.size()), Seconds( start ) );
+
+    // The second pass finds all of them in the cache
+    start = clock();
+    TEST_SAFE_OP( ResolveFonts( doc, fontObjects, secondFonts ) );
+    printf("Resolving cached fonts:   %.3fs\n", Seconds( start ) );
+
+    if( firstFonts != secondFonts ) 
+    {
+        fprintf( stderr, "The cache returned different fonts in the second pass\n" );
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,205 @@
+/***************************************************************************
+ *   Copyright (C) 2005 by Dominik Seichter                                *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "../PdfTest.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace PoDoFo;
+
+#define BUFFER_SIZE 4096
+#define NUM_VALUES  1000000
+
+/** Create a list of numbers as they typically appear
+ *  in content streams: coordinates, widths and colors.
+ */
+static void CreateValues( std::vector<double> & rValues )
+{
+    srand( 42 );
+
+    rValues.reserve( NUM_VALUES );
+    for( int i=0;i<NUM_VALUES;i++ ) 
+    {
+        double dValue;
+        switch( i % 4 ) 
+        {
+            case 0:
+                dValue = static_cast<double>(rand() % 1000000) / 1000.0;
+                break;
+            case 1:
+                dValue = -static_cast<double>(rand() % 100000) / 100.0;
+                break;
+            case 2:
+                dValue = static_cast<double>(rand()) / RAND_MAX;
+                break;
+            default:
+                dValue = static_cast<double>(rand() % 1000);
+                break;
+        }
+
+        rValues.push_back( dValue );
+    }
+}
+
+static double Seconds( clock_t start ) 
+{
+    return static_cast<double>(clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main( int, char** )
+{
+    printf("Real Number Benchmark\n");
+    printf("=====================\n");
+
+    std::vector<double>      values;
+    std::vector<std::string> oldStrings;
+    std::vector<std::string> newStrings;
+    char                     buffer[PDF_REAL_BUFFER_LEN];
+    clock_t                  start;
+    int                      nErrors = 0;
+
+    CreateValues( values );
+    oldStrings.reserve( values.size() );
+    newStrings.reserve( values.size() );
+
+    // Formatting using a stream imbued with the C locale
+    start = clock();
+    for( std::vector<double>::const_iterator it = values.begin(); it != values.end(); ++it ) 
+    {
+        std::ostringstream oss;
+        PdfLocaleImbue( oss );
+        oss << std::fixed << *it;
+        oldStrings.push_back( oss.str() );
+    }
+    printf("ostringstream format:     %.3fs\n", Seconds( start ) );
+
+    start = clock();
+    for( std::vector<double>::const_iterator it = values.begin(); it != values.end(); ++it ) 
+    {
+        size_t lLen = PdfLocaleFormatReal( *it, buffer, PDF_REAL_BUFFER_LEN, false );
+        newStrings.push_back( std::string( buffer, lLen ) );
+    }
+    printf("PdfLocaleFormatReal:      %.3fs\n", Seconds( start ) );
+
+    for( size_t i=0;i<values.size();i++ ) 
+    {
+        if( oldStrings[i] != newStrings[i] ) 
+        {
+            if( nErrors++ < 10 )
+                fprintf( stderr, "Format mismatch: %s != %s\n", 
+                         oldStrings[i].c_str(), newStrings[i].c_str() );
+        }
+    }
+
+    // Parsing using a stream imbued with the C locale
+    double dSum = 0.0;
+    std::vector<double> oldValues;
+    std::vector<double> newValues;
+    oldValues.reserve( values.size() );
+    newValues.reserve( values.size() );
+
+    start = clock();
+    std::istringstream iss;
+    PdfLocaleImbue( iss );
+    for( std::vector<std::string>::const_iterator it = oldStrings.begin(); it != oldStrings.end(); ++it ) 
+    {
+        double dValue = 0.0;
+        iss.clear();
+        iss.str( *it );
+        iss >> dValue;
+        oldValues.push_back( dValue );
+    }
+    printf("istringstream parse:      %.3fs\n", Seconds( start ) );
+
+    start = clock();
+    for( std::vector<std::string>::const_iterator it = oldStrings.begin(); it != oldStrings.end(); ++it ) 
+    {
+        double dValue = 0.0;
+        PdfLocaleParseReal( it->c_str(), it->length(), dValue );
+        newValues.push_back( dValue );
+    }
+    printf("PdfLocaleParseReal:       %.3fs\n", Seconds( start ) );
+
+    for( size_t i=0;i<values.size();i++ ) 
+    {
+        dSum += newValues[i];
+        if( oldValues[i] != newValues[i] ) 
+        {
+            if( nErrors++ < 10 )
+                fprintf( stderr, "Parse mismatch: %s: %.17g != %.17g\n", 
+                         oldStrings[i].c_str(), oldValues[i], newValues[i] );
+        }
+    }
+
+    // Tokenizing a synthetic content stream
+    std::string content;
+    for( size_t i=0;i<values.size();i++ ) 
+    {
+        if( i % 6 == 0 )
+            content += "[ ";
+
+        content += newStrings[i];
+        content += ( i % 6 == 5 ) ? " ]\n" : " ";
+    }
+
+    if( values.size() % 6 )
+        content += "]\n";
+
+    start = clock();
+    try {
+        PdfRefCountedInputDevice device( content.c_str(), content.length() );
+        PdfRefCountedBuffer      tokenBuffer( BUFFER_SIZE );
+        PdfTokenizer             tokenizer( device, tokenBuffer );
+        PdfVariant               variant;
+        int                      nNumbers = 0;
+
+        while( nNumbers < NUM_VALUES )
+        {
+            tokenizer.GetNextVariant( variant, NULL );
+            nNumbers += static_cast<int>(variant.GetArray().size());
+        }
+
+        if( nNumbers != NUM_VALUES ) 
+        {
+            fprintf( stderr, "Tokenizer found %i numbers instead of %i\n", nNumbers, NUM_VALUES );
+            ++nErrors;
+        }
+    } catch( PdfError & e ) {
+        e.PrintErrorMsg();
+        return e.GetError();
+    }
+    printf("Tokenizing content:       %.3fs\n", Seconds( start ) );
+
+    printf("Checksum: %f\n", dSum );
+    if( nErrors ) 
+    {
+        fprintf( stderr, "%i mismatches found\n", nErrors );
+        return 1;
+    }
+
+    printf("Success.\n");
+    return 0;
+}
@@ -19,6 +19,7 @@
  ***************************************************************************/
 
 #include "DeviceTest.h"
+#include "TestUtils.h"
 #include <podofo.h>
 
 #include <stdio.h>
@@ -120,3 +121,65 @@ void DeviceTest::testDevices()
     
 }
 
+void DeviceTest::testInputDevice( PdfInputDevice & rDevice, const char* pszExpected )
+{
+    const std::streamoff lLen = strlen( pszExpected );
+    char buffer[BUFFER_SIZE];
+
+    CPPUNIT_ASSERT_EQUAL( static_cast<std::streamoff>(0), rDevice.Tell() );
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(pszExpected[0]), rDevice.Look() );
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(pszExpected[0]), rDevice.GetChar() );
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(pszExpected[1]), rDevice.GetChar() );
+    CPPUNIT_ASSERT_EQUAL( static_cast<std::streamoff>(2), rDevice.Tell() );
+
+    rDevice.Seek( -3, std::ios_base::end );
+    CPPUNIT_ASSERT_EQUAL( static_cast<std::streamoff>(3), rDevice.Read( buffer, BUFFER_SIZE ) );
+    CPPUNIT_ASSERT( memcmp( buffer, pszExpected + lLen - 3, 3 ) == 0 );
+    CPPUNIT_ASSERT( rDevice.Eof() );
+    CPPUNIT_ASSERT_EQUAL( EOF, rDevice.GetChar() );
+
+    rDevice.Seek( 0 );
+    CPPUNIT_ASSERT( !rDevice.Eof() );
+    CPPUNIT_ASSERT_EQUAL( lLen, rDevice.Read( buffer, lLen ) );
+    CPPUNIT_ASSERT( memcmp( buffer, pszExpected, lLen ) == 0 );
+}
+
+void DeviceTest::testInputDevices()
+{
+    const char* pszTestString = "%PDF-1.4 Hello World Device!";
+    const size_t lLen         = strlen( pszTestString );
+
+    printf("-> Testing PdfInputDevice on a copied buffer\n");
+    PdfInputDevice copied( pszTestString, lLen );
+    CPPUNIT_ASSERT( copied.GetBuffer() != NULL );
+    CPPUNIT_ASSERT( copied.GetBuffer() != pszTestString );
+    CPPUNIT_ASSERT_EQUAL( lLen, copied.GetBufferLength() );
+    testInputDevice( copied, pszTestString );
+
+    printf("-> Testing PdfInputDevice on a borrowed buffer\n");
+    PdfInputDevice borrowed( pszTestString, lLen, ePdfInputMode_ZeroCopy );
+    CPPUNIT_ASSERT( borrowed.GetBuffer() == pszTestString );
+    testInputDevice( borrowed, pszTestString );
+
+    std::string sFilename = TestUtils::getTempFilename();
+    FILE* hFile = fopen( sFilename.c_str(), "wb" );
+    CPPUNIT_ASSERT( hFile != NULL );
+    fwrite( pszTestString, 1, lLen, hFile );
+    fclose( hFile );
+
+    printf("-> Testing PdfInputDevice on a file\n");
+    {
+        PdfInputDevice file( sFilename.c_str() );
+        CPPUNIT_ASSERT( file.GetBuffer() == NULL );
+        CPPUNIT_ASSERT_EQUAL( static_cast<size_t>(0), file.GetBufferLength() );
+        testInputDevice( file, pszTestString );
+    }
+
+    printf("-> Testing PdfInputDevice on a mapped file\n");
+    {
+        PdfInputDevice mapped( sFilename.c_str(), ePdfInputMode_ZeroCopy );
+        testInputDevice( mapped, pszTestString );
+    }
+
+    TestUtils::deleteFile( sFilename.c_str() );
+}
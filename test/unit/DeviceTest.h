@@ -23,16 +23,23 @@
 
 #include <cppunit/extensions/HelperMacros.h>
 
+#include <podofo.h>
+
 class DeviceTest : public CppUnit::TestFixture
 {
     CPPUNIT_TEST_SUITE( DeviceTest );
     CPPUNIT_TEST( testDevices );
+    CPPUNIT_TEST( testInputDevices );
     CPPUNIT_TEST_SUITE_END();
 public:
     void setUp();
     void tearDown();
 
     void testDevices();
+    void testInputDevices();
+
+private:
+    void testInputDevice( PoDoFo::PdfInputDevice & rDevice, const char* pszExpected );
 };
 
 #endif // _DEVICE_TEST_H_
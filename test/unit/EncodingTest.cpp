@@ -34,6 +34,7 @@ inline std::ostream& operator<<(std::ostream& o, const PdfVariant& s)
 // Needs to be included after the redefinition of operator<<
 // or it won't compile using clang
 #include "EncodingTest.h"
+#include "TestUtils.h"
 
 // Registers the fixture into the 'registry'
 CPPUNIT_TEST_SUITE_REGISTRATION( EncodingTest );
@@ -287,6 +288,19 @@ void EncodingTest::testUnicodeNames()
     }
 
     CPPUNIT_ASSERT_EQUAL_MESSAGE( "Compared codes count", 65422, nCount );
+
+    // Alternative names are only found in the complete list of names
+    CPPUNIT_ASSERT_EQUAL( PdfDifferenceEncoding::NameToUnicodeID( PdfName( "ff" ) ),
+                          PdfDifferenceEncoding::NameToUnicodeID( PdfName( "f_f" ) ) );
+    CPPUNIT_ASSERT_EQUAL( PdfDifferenceEncoding::NameToUnicodeID( PdfName( "fl" ) ),
+                          PdfDifferenceEncoding::NameToUnicodeID( PdfName( "f_l" ) ) );
+    CPPUNIT_ASSERT_EQUAL( PdfDifferenceEncoding::NameToUnicodeID( PdfName( "quotedbl" ) ),
+                          PdfDifferenceEncoding::NameToUnicodeID( PdfName( "\"" ) ) );
+    CPPUNIT_ASSERT_EQUAL( PdfDifferenceEncoding::NameToUnicodeID( PdfName( "exclam" ) ),
+                          PdfDifferenceEncoding::NameToUnicodeID( PdfName( "exclamsmall" ) ) );
+    CPPUNIT_ASSERT( PdfDifferenceEncoding::NameToUnicodeID( PdfName( "female" ) ) != 0 );
+    CPPUNIT_ASSERT_EQUAL( static_cast<pdf_utf16be>(0),
+                          PdfDifferenceEncoding::NameToUnicodeID( PdfName( "nosuchglyphname" ) ) );
 }
 
 void EncodingTest::testGetCharCode()
@@ -412,6 +426,110 @@ void EncodingTest::testToUnicodeParse()
     }
 }
 
+void EncodingTest::testCMapDecode()
+{
+    const char* pszCMap = 
+        "/CMapName /Test-CMap def\n"
+        "2 begincodespacerange\n"
+        "<00> <7F>\n"
+        "<8000> <FFFF>\n"
+        "endcodespacerange\n"
+        "3 beginbfchar\n"
+        "<41> <0041>\n"
+        "<42> <00660069>\n"
+        "<8001> <4E2D>\n"
+        "endbfchar\n"
+        "2 beginbfrange\n"
+        "<60> <62> <0061>\n"
+        "<9000> <9002> [<0031> <0032> <0033>]\n"
+        "endbfrange\n"
+        "1 begincidrange\n"
+        "<8000> <80FF> 100\n"
+        "endcidrange\n";
+
+    PdfCMap cmap = PdfCMapCache::GetCMap( pszCMap, strlen( pszCMap ) );
+    CPPUNIT_ASSERT( cmap.IsValid() );
+    CPPUNIT_ASSERT( cmap.HasCodeSpaceRanges() );
+    CPPUNIT_ASSERT( cmap.HasUnicodeMappings() );
+    CPPUNIT_ASSERT( cmap.HasCIDMappings() );
+    CPPUNIT_ASSERT_EQUAL( std::string( "Test-CMap" ), cmap.GetName() );
+
+    // Codes with 1 and 2 bytes are read using the codespace ranges
+    const char        encoded[] = "\x41\x42\x80\x01\x61\x90\x02\x7f";
+    const pdf_utf16be expected[] = { 0x0041, 0x0066, 0x0069, 0x4E2D, 0x0062, 0x0033, 0x0000 };
+    const pdf_long    lExpected  = sizeof(expected) / sizeof(pdf_utf16be);
+    pdf_utf16be       buffer[16];
+
+    CPPUNIT_ASSERT_EQUAL( lExpected, cmap.DecodeToUnicode( encoded, sizeof(encoded) - 1, buffer, 16 ) );
+    for( pdf_long i = 0; i < lExpected; i++ ) 
+    {
+        pdf_utf16be expects = expected[i];
+#ifdef PODOFO_IS_LITTLE_ENDIAN
+        expects = (expects << 8) | (expects >> 8 );
+#endif
+        CPPUNIT_ASSERT_EQUAL( expects, buffer[i] );
+    }
+
+    // A buffer which is too small is filled and the required length returned
+    buffer[2] = 0xffff;
+    CPPUNIT_ASSERT_EQUAL( lExpected, cmap.DecodeToUnicode( encoded, sizeof(encoded) - 1, buffer, 2 ) );
+    CPPUNIT_ASSERT_EQUAL( static_cast<pdf_utf16be>(0xffff), buffer[2] );
+
+    PdfString unicode = cmap.DecodeToUnicode( PdfString( encoded, sizeof(encoded) - 1 ) );
+    CPPUNIT_ASSERT( unicode.IsUnicode() );
+    CPPUNIT_ASSERT_EQUAL( static_cast<pdf_long>(lExpected * sizeof(pdf_utf16be)), unicode.GetLength() );
+
+    CPPUNIT_ASSERT_EQUAL( static_cast<pdf_utf16be>(0x0063), cmap.GetUnicodeValue( 0x62 ) );
+    CPPUNIT_ASSERT_EQUAL( static_cast<pdf_utf16be>(0x0000), cmap.GetUnicodeValue( 0x63 ) );
+
+    pdf_uint32 nCode = 0;
+    CPPUNIT_ASSERT( cmap.GetCode( 0x0062, &nCode ) );
+    CPPUNIT_ASSERT_EQUAL( static_cast<pdf_uint32>(0x61), nCode );
+
+    // CIDs
+    const char encodedCIDs[] = "\x80\x00\x80\x10\x41";
+    pdf_uint32 cids[3];
+    CPPUNIT_ASSERT_EQUAL( static_cast<pdf_long>(3), cmap.DecodeToCIDs( encodedCIDs, sizeof(encodedCIDs) - 1, cids, 3 ) );
+    CPPUNIT_ASSERT_EQUAL( static_cast<pdf_uint32>(100), cids[0] );
+    CPPUNIT_ASSERT_EQUAL( static_cast<pdf_uint32>(116), cids[1] );
+    CPPUNIT_ASSERT_EQUAL( static_cast<pdf_uint32>(0), cids[2] );
+
+    // The same CMap is compiled only once
+    PdfCMap cmap2 = PdfCMapCache::GetCMap( pszCMap, strlen( pszCMap ) );
+    CPPUNIT_ASSERT( cmap == cmap2 );
+
+    // Predefined CMaps
+    PdfCMap identity = PdfCMapCache::GetPredefinedCMap( PdfName( "Identity-H" ) );
+    CPPUNIT_ASSERT( identity.IsValid() );
+    CPPUNIT_ASSERT_EQUAL( static_cast<pdf_uint32>(0x1234), identity.GetCID( 0x1234 ) );
+    CPPUNIT_ASSERT( !PdfCMapCache::GetPredefinedCMap( PdfName( "Unknown-CMap" ) ).IsValid() );
+    CPPUNIT_ASSERT( !PdfCMapCache::GetPredefinedCMap( PdfName( "../../etc/passwd" ) ).IsValid() );
+
+    // A CMap which was not found is found after its directory was added
+    std::string sFilename  = TestUtils::getTempFilename();
+    size_t      nSeparator = sFilename.find_last_of( "/\\" );
+    CPPUNIT_ASSERT( nSeparator != std::string::npos );
+    PdfName     fileCMap( sFilename.substr( nSeparator + 1 ) );
+    CPPUNIT_ASSERT( !PdfCMapCache::GetPredefinedCMap( fileCMap ).IsValid() );
+
+    FILE* hFile = fopen( sFilename.c_str(), "wb" );
+    CPPUNIT_ASSERT( hFile != NULL );
+    fwrite( pszCMap, 1, strlen( pszCMap ), hFile );
+    fclose( hFile );
+
+    PdfCMapCache::AddCMapDirectory( sFilename.substr( 0, nSeparator ).c_str() );
+    PdfCMap loaded = PdfCMapCache::GetPredefinedCMap( fileCMap );
+
+    // Do not search the temporary directory in other tests
+    PdfCMapCache::ClearCMapDirectories();
+    PdfCMapCache::EmptyCache();
+    PdfCMap removed = PdfCMapCache::GetPredefinedCMap( fileCMap );
+    TestUtils::deleteFile( sFilename.c_str() );
+    CPPUNIT_ASSERT( !removed.IsValid() );
+    CPPUNIT_ASSERT( loaded.IsValid() );
+    CPPUNIT_ASSERT_EQUAL( static_cast<pdf_uint32>(116), loaded.GetCID( 0x8010 ) );
+}
+
 bool EncodingTest::outofRangeHelper( PdfEncoding* pEncoding, std::string & rMsg, const char* pszName )
 {
     bool exception = false;
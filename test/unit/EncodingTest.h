@@ -38,6 +38,7 @@ class EncodingTest : public CppUnit::TestFixture
   CPPUNIT_TEST( testUnicodeNames );
   CPPUNIT_TEST( testGetCharCode );
   CPPUNIT_TEST( testToUnicodeParse );
+  CPPUNIT_TEST( testCMapDecode );
   CPPUNIT_TEST_SUITE_END();
 
  public:
@@ -50,6 +51,7 @@ class EncodingTest : public CppUnit::TestFixture
   void testUnicodeNames();
   void testGetCharCode();
   void testToUnicodeParse();
+  void testCMapDecode();
 
  private:
 
@@ -19,10 +19,14 @@
  ***************************************************************************/
 
 #include "FilterTest.h"
+#include "cppunitextensions.h"
 
 #include <cppunit/Asserter.h>
 
 #include <stdlib.h>
+#include <time.h>
+
+#include <sstream>
 
 // prefer std::unique_ptr over std::auto_ptr
 #ifdef PODOFO_HAVE_UNIQUE_PTR
@@ -139,3 +143,444 @@ void FilterTest::testCCITT()
 
 
 }
+
+void FilterTest::testFilteredInputStream()
+{
+    // A stream with two filters is decoded in small chunks, the predictor
+    // of the second filter is taken from a DecodeParms array
+    std::string  sData;
+    unsigned int nRandom = 1;
+    for( int i = 0; i < 50000; i++ )
+    {
+        nRandom = nRandom * 1103515245 + 12345;
+        sData += static_cast<char>( ( nRandom >> 16 ) & 0xff );
+    }
+
+    PdfVecObjects objects;
+    objects.SetAutoDelete( true );
+    PdfObject* pObj = objects.CreateObject();
+
+    TFlateSettings settings;
+    settings.nPredictor = 12;
+    settings.nColumns   = 100;
+    TVecFilters vecFlate;
+    vecFlate.push_back( ePdfFilter_FlateDecode );
+    pObj->GetStream()->SetFlateSettings( &settings );
+    pObj->GetStream()->Set( sData.c_str(), sData.size(), vecFlate );
+    pObj->GetStream()->SetFlateSettings( NULL );
+
+    char*    pBuffer;
+    pdf_long lLen;
+    char*    pHex;
+    pdf_long lHexLen;
+    pObj->GetStream()->GetCopy( &pBuffer, &lLen );
+    PODOFO_UNIQUEU_PTR<PdfFilter> pHexFilter( PdfFilterFactory::Create( ePdfFilter_ASCIIHexDecode ) );
+    pHexFilter->Encode( pBuffer, lLen, &pHex, &lHexLen );
+    podofo_free( pBuffer );
+
+    PdfMemoryInputStream hexStream( pHex, lHexLen );
+    pObj->GetStream()->SetRawData( &hexStream );
+    podofo_free( pHex );
+
+    PdfArray filters;
+    filters.push_back( PdfName( "ASCIIHexDecode" ) );
+    filters.push_back( PdfName( "FlateDecode" ) );
+    pObj->GetDictionary().AddKey( PdfName::KeyFilter, filters );
+    PdfArray decodeParms;
+    decodeParms.push_back( PdfVariant::NullValue );
+    decodeParms.push_back( pObj->GetDictionary().GetKey( "DecodeParms" )->GetDictionary() );
+    pObj->GetDictionary().AddKey( "DecodeParms", decodeParms );
+
+    PODOFO_UNIQUEU_PTR<PdfFilteredInputStream> pInput( pObj->GetStream()->CreateFilteredInputStream() );
+    std::string sDecoded;
+    const char* pChunk;
+    pdf_long    lChunkLen;
+    int         nChunks = 0;
+    while( pInput->ReadChunk( &pChunk, &lChunkLen ) )
+    {
+        CPPUNIT_ASSERT( lChunkLen > 0 );
+        CPPUNIT_ASSERT( lChunkLen < static_cast<pdf_long>(sData.size()) );
+        sDecoded.append( pChunk, lChunkLen );
+        ++nChunks;
+    }
+    CPPUNIT_ASSERT( nChunks > 1 );
+    CPPUNIT_ASSERT( sData == sDecoded );
+
+    // Read() gives the same data using a small buffer
+    pInput.reset( pObj->GetStream()->CreateFilteredInputStream() );
+    sDecoded.clear();
+    char buffer[333];
+    while( ( lChunkLen = pInput->Read( buffer, sizeof(buffer) ) ) > 0 )
+        sDecoded.append( buffer, lChunkLen );
+    CPPUNIT_ASSERT( sData == sDecoded );
+
+    pObj->GetStream()->GetFilteredCopy( &pBuffer, &lLen );
+    CPPUNIT_ASSERT( sData == std::string( pBuffer, lLen ) );
+    podofo_free( pBuffer );
+
+    // A wrong /DL is only a hint for the size of the buffer
+    const pdf_int64 lDecodedLengths[] = { static_cast<pdf_int64>(1) << 40, 1 };
+    for( size_t i = 0; i < sizeof(lDecodedLengths) / sizeof(pdf_int64); i++ )
+    {
+        pObj->GetDictionary().AddKey( "DL", PdfVariant( lDecodedLengths[i] ) );
+        pObj->GetStream()->GetFilteredCopy( &pBuffer, &lLen );
+        CPPUNIT_ASSERT( sData == std::string( pBuffer, lLen ) );
+        podofo_free( pBuffer );
+    }
+}
+
+std::string FilterTest::DecodeInBlocks( EPdfFilter eFilter, const std::string & sEncoded, size_t lBlockSize )
+{
+    PODOFO_UNIQUEU_PTR<PdfFilter> pFilter( PdfFilterFactory::Create( eFilter ) );
+    PdfMemoryOutputStream         output;
+
+    pFilter->BeginDecode( &output );
+    for( size_t i = 0; i < sEncoded.size(); i += lBlockSize )
+        pFilter->DecodeBlock( sEncoded.data() + i, PDF_MIN( lBlockSize, sEncoded.size() - i ) );
+    pFilter->EndDecode();
+
+    return std::string( output.GetBuffer(), output.GetLength() );
+}
+
+void FilterTest::testAsciiAndRunLength()
+{
+    // Known encodings with whitespace, end of data markers
+    // and incomplete final groups, split at every position
+    const std::string sHex( "48 65\n6c6C6\r\n>4142" );
+    const std::string sA85( "87cURz D]o\n~>garbage" );
+    const std::string sA85Padded( "s8W,uJ,~>" );
+    const char        rle[] = { 2, 'a', 'b', 'c', static_cast<char>(254), 'x', 0, 'y', static_cast<char>(128), 'z' };
+    const std::string sRLE( rle, sizeof(rle) );
+    for( size_t lBlock = 1; lBlock <= 4; lBlock++ )
+    {
+        CPPUNIT_ASSERT( DecodeInBlocks( ePdfFilter_ASCIIHexDecode, sHex, lBlock ) == "Hell`" );
+        CPPUNIT_ASSERT( DecodeInBlocks( ePdfFilter_ASCII85Decode, sA85, lBlock ) == std::string( "Hell\0\0\0\0o!", 10 ) );
+        CPPUNIT_ASSERT( DecodeInBlocks( ePdfFilter_ASCII85Decode, sA85Padded, lBlock ) == "\xff\xff\xff\xfe\x80" );
+        CPPUNIT_ASSERT( DecodeInBlocks( ePdfFilter_RunLengthDecode, sRLE, lBlock ) == "abcxxxy" );
+    }
+
+    // Round trip a large buffer with runs, zero groups and noise
+    // and report the throughput of each filter
+    std::string  sData;
+    unsigned int nRandom = 1;
+    while( sData.size() < 4 * 1024 * 1024 )
+    {
+        nRandom = nRandom * 1103515245 + 12345;
+        const char c = static_cast<char>( ( nRandom >> 16 ) & 0xff );
+        switch( ( nRandom >> 24 ) & 3 )
+        {
+            case 0:  sData.append( ( nRandom >> 8 ) & 0x1ff, c ); break;
+            case 1:  sData.append( ( nRandom >> 8 ) & 0x0f, '\0' ); break;
+            default: sData += c; break;
+        }
+    }
+
+    const EPdfFilter aFilters[] = { ePdfFilter_ASCIIHexDecode, ePdfFilter_ASCII85Decode, ePdfFilter_RunLengthDecode };
+    for( size_t i = 0; i < sizeof(aFilters) / sizeof(aFilters[0]); i++ )
+    {
+        PODOFO_UNIQUEU_PTR<PdfFilter> pFilter( PdfFilterFactory::Create( aFilters[i] ) );
+        char*    pEncoded;
+        pdf_long lEncoded;
+
+        clock_t start = clock();
+        pFilter->Encode( sData.c_str(), sData.size(), &pEncoded, &lEncoded );
+        const std::string sEncoded( pEncoded, lEncoded );
+        podofo_free( pEncoded );
+        clock_t encoded = clock();
+        const std::string sDecoded = DecodeInBlocks( aFilters[i], sEncoded, 4093 );
+        clock_t decoded = clock();
+
+        printf( "\t-> Filter %i: %li bytes encoded to %li bytes, encoding %.1f MB/s, decoding %.1f MB/s\n",
+                aFilters[i], static_cast<long>(sData.size()), static_cast<long>(lEncoded),
+                sData.size() / 1048576.0 / ( static_cast<double>(encoded - start + 1) / CLOCKS_PER_SEC ),
+                sData.size() / 1048576.0 / ( static_cast<double>(decoded - encoded + 1) / CLOCKS_PER_SEC ) );
+
+        CPPUNIT_ASSERT( sData == sDecoded );
+    }
+}
+
+void FilterTest::testImageCodecs()
+{
+    // An 8x8 pixel grey JPEG image
+    static const unsigned char s_jpeg[] = {
+        0xff, 0xd8, 0xff, 0xe0, 0x00, 0x10, 0x4a, 0x46, 0x49, 0x46, 0x00, 0x01, 0x01, 0x00, 0x00, 0x01,
+        0x00, 0x01, 0x00, 0x00, 0xff, 0xdb, 0x00, 0x43, 0x00, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+        0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+        0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+        0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+        0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0xff, 0xc0, 0x00, 0x0b, 0x08, 0x00, 0x08,
+        0x00, 0x08, 0x01, 0x01, 0x11, 0x00, 0xff, 0xc4, 0x00, 0x14, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xc4, 0x00, 0x14,
+        0x10, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0xff, 0xda, 0x00, 0x08, 0x01, 0x01, 0x00, 0x00, 0x3f, 0x00, 0x3f, 0xff, 0xd9
+    };
+    const std::string sJpeg( reinterpret_cast<const char*>(s_jpeg), sizeof(s_jpeg) );
+
+    PdfVecObjects objects;
+    objects.SetAutoDelete( true );
+    PdfObject* pObj = objects.CreateObject();
+
+    // The only filter is the image codec: the data is passed on as it is
+    PdfMemoryInputStream jpegStream( sJpeg.c_str(), sJpeg.size() );
+    pObj->GetStream()->SetRawData( &jpegStream );
+    pObj->GetDictionary().AddKey( PdfName::KeyFilter, PdfName( "DCTDecode" ) );
+
+    PdfMemoryOutputStream output;
+    CPPUNIT_ASSERT_EQUAL( ePdfFilter_DCTDecode, pObj->GetStream()->GetEncodedImageCopy( &output ) );
+    CPPUNIT_ASSERT( sJpeg == std::string( output.GetBuffer(), output.GetLength() ) );
+
+    // Filters applied on top of the image codec are decoded
+    char*    pHex;
+    pdf_long lHexLen;
+    PODOFO_UNIQUEU_PTR<PdfFilter> pHexFilter( PdfFilterFactory::Create( ePdfFilter_ASCIIHexDecode ) );
+    pHexFilter->Encode( sJpeg.c_str(), sJpeg.size(), &pHex, &lHexLen );
+    PdfMemoryInputStream hexStream( pHex, lHexLen );
+    pObj->GetStream()->SetRawData( &hexStream );
+    podofo_free( pHex );
+
+    PdfArray filters;
+    filters.push_back( PdfName( "ASCIIHexDecode" ) );
+    filters.push_back( PdfName( "DCTDecode" ) );
+    pObj->GetDictionary().AddKey( PdfName::KeyFilter, filters );
+
+    PdfMemoryOutputStream wrapped;
+    CPPUNIT_ASSERT_EQUAL( ePdfFilter_DCTDecode, pObj->GetStream()->GetEncodedImageCopy( &wrapped ) );
+    CPPUNIT_ASSERT( sJpeg == std::string( wrapped.GetBuffer(), wrapped.GetLength() ) );
+
+    // Decoding the image gives the grey samples
+    PODOFO_UNIQUEU_PTR<PdfFilter> pDCTFilter( PdfFilterFactory::Create( ePdfFilter_DCTDecode ) );
+    if( pDCTFilter.get() )
+    {
+        char*    pDecoded;
+        pdf_long lDecoded;
+        pObj->GetStream()->GetFilteredCopy( &pDecoded, &lDecoded );
+        CPPUNIT_ASSERT( std::string( 64, static_cast<char>(0x80) ) == std::string( pDecoded, lDecoded ) );
+        podofo_free( pDecoded );
+    }
+    else
+        printf("!!! ePdfFilter_DCTDecode not implemented skipping decoding test!\n");
+
+    // Streams without an image codec are decoded completely
+    pObj->GetDictionary().AddKey( PdfName::KeyFilter, PdfName( "ASCIIHexDecode" ) );
+    PdfMemoryOutputStream decoded;
+    CPPUNIT_ASSERT_EQUAL( ePdfFilter_None, pObj->GetStream()->GetEncodedImageCopy( &decoded ) );
+    CPPUNIT_ASSERT( sJpeg == std::string( decoded.GetBuffer(), decoded.GetLength() ) );
+}
+
+void FilterTest::testWriteCompressedStreams()
+{
+    // Uncompressed streams are flate compressed before writing,
+    // the same way with one and with several threads
+    class ThreadCountGuard {
+     public:
+        ThreadCountGuard() : m_nThreads( PdfWriter::GetThreadCount() ) { }
+        ~ThreadCountGuard() { PdfWriter::SetThreadCount( m_nThreads ); }
+
+     private:
+        int m_nThreads;
+    } guard;
+
+    std::vector<std::string> vecData;
+    for( int i = 0; i < 10; i++ )
+    {
+        std::ostringstream oss;
+        for( int j = 0; j < 500; j++ )
+            oss << i << " " << j << " m " << j * 7 % 100 << " l S\n";
+        vecData.push_back( oss.str() );
+    }
+
+    std::string sOutput[2];
+    for( int nPass = 0; nPass < 2; nPass++ )
+    {
+        PdfMemDocument doc;
+        TVecFilters    vecNoFilters;
+        for( size_t i = 0; i < vecData.size(); i++ )
+        {
+            PdfObject* pObj = doc.GetObjects().CreateObject();
+            pObj->GetStream()->Set( vecData[i].c_str(), vecData[i].size(), vecNoFilters );
+        }
+        PdfObject* pMetadata = doc.GetObjects().CreateObject( "Metadata" );
+        pMetadata->GetStream()->Set( "<x:xmpmeta/>", 12, vecNoFilters );
+
+        PdfWriter::SetThreadCount( nPass == 0 ? 1 : 4 );
+
+        PdfRefCountedBuffer buffer;
+        PdfOutputDevice     device( &buffer );
+        PdfWriter           writer( &doc.GetObjects(), doc.GetTrailer() );
+        writer.SetCompressStreams( true );
+        writer.Write( &device );
+        sOutput[nPass].assign( buffer.GetBuffer(), static_cast<size_t>(device.GetLength()) );
+    }
+    CPPUNIT_ASSERT_EQUAL( sOutput[0].size(), sOutput[1].size() );
+
+    PdfMemDocument reread;
+    reread.LoadFromBuffer( sOutput[1].c_str(), static_cast<long>(sOutput[1].size()) );
+
+    size_t nData = 0;
+    for( size_t i = 0; i < reread.GetObjects().GetSize(); i++ )
+    {
+        PdfObject* pObj = reread.GetObjects()[i];
+        if( !pObj->HasStream() )
+            continue;
+
+        char*    pBuffer;
+        pdf_long lLen;
+        pObj->GetStream()->GetFilteredCopy( &pBuffer, &lLen );
+        std::string sData( pBuffer, lLen );
+        podofo_free( pBuffer );
+
+        if( pObj->GetDictionary().HasKey( "Type" ) )
+        {
+            // Metadata is never compressed
+            CPPUNIT_ASSERT( !pObj->GetDictionary().HasKey( "Filter" ) );
+            CPPUNIT_ASSERT_EQUAL( std::string( "<x:xmpmeta/>" ), sData );
+        }
+        else
+        {
+            CPPUNIT_ASSERT( pObj->GetDictionary().GetKey( "Filter" )->GetName() == PdfName( "FlateDecode" ) );
+            CPPUNIT_ASSERT( nData < vecData.size() );
+            CPPUNIT_ASSERT_EQUAL( vecData[nData++], sData );
+        }
+    }
+    CPPUNIT_ASSERT_EQUAL( vecData.size(), nData );
+}
+
+void FilterTest::testFlateSettings()
+{
+    // The compression level of a document is used for its streams
+    // and whole buffers are compressed by the registered encoder
+    class CountingEncoder : public PdfFlateEncoder {
+     public:
+        CountingEncoder() : nCalls( 0 ), nLevel( 0 )
+        {
+            PdfFilterFactory::SetFlateEncoder( this );
+        }
+
+        ~CountingEncoder()
+        {
+            PdfFilterFactory::SetFlateEncoder( NULL );
+        }
+
+        virtual void Encode( const char* pInBuffer, pdf_long lInLen, char** ppOutBuffer,
+                             pdf_long* plOutLen, const TFlateSettings & rSettings ) const
+        {
+            ++nCalls;
+            nLevel = rSettings.nLevel;
+            PdfFilterFactory::SetFlateEncoder( NULL );
+            PdfFilterFactory::GetFlateEncoder()->Encode( pInBuffer, lInLen, ppOutBuffer, plOutLen, rSettings );
+            PdfFilterFactory::SetFlateEncoder( this );
+        }
+
+        mutable int nCalls;
+        mutable int nLevel;
+    };
+
+    std::ostringstream oss;
+    for( int i = 0; i < 2000; i++ )
+        oss << "0 0 m " << i % 50 << " " << i % 70 << " l S\n";
+    const std::string sData = oss.str();
+
+    CountingEncoder encoder;
+    pdf_long        lLength[2];
+    const int       nLevels[2] = { 0, 9 };
+    for( int nPass = 0; nPass < 2; nPass++ )
+    {
+        TFlateSettings settings( nLevels[nPass], ePdfFlateStrategy_Default );
+        PdfMemDocument doc;
+        doc.GetObjects().SetFlateSettings( &settings );
+
+        PdfObject* pObj = doc.GetObjects().CreateObject();
+        pObj->GetStream()->Set( sData.c_str(), sData.size() );
+        CPPUNIT_ASSERT_EQUAL( nPass + 1, encoder.nCalls );
+        CPPUNIT_ASSERT_EQUAL( nLevels[nPass], encoder.nLevel );
+
+        lLength[nPass] = pObj->GetStream()->GetLength();
+        CPPUNIT_ASSERT_EQUAL( lLength[nPass], pObj->GetDictionary().GetKey( PdfName::KeyLength )->GetNumber() );
+
+        char*    pBuffer;
+        pdf_long lLen;
+        pObj->GetStream()->GetFilteredCopy( &pBuffer, &lLen );
+        std::string sDecoded( pBuffer, lLen );
+        podofo_free( pBuffer );
+        CPPUNIT_ASSERT_EQUAL( sData, sDecoded );
+
+        doc.GetObjects().SetFlateSettings( NULL );
+    }
+
+    // Level 0 only stores the data
+    CPPUNIT_ASSERT( lLength[0] > static_cast<pdf_long>(sData.size()) );
+    CPPUNIT_ASSERT( lLength[1] < lLength[0] / 10 );
+}
+
+void FilterTest::testPredictors()
+{
+    // PNG rows are prefixed with their predictor: a sub row and an up row
+    const char aRows[] = { 1, 1, 1, 1, 1, 2, 1, 1, 1, 1 };
+    PdfVecObjects objects;
+    objects.SetAutoDelete( true );
+    PdfObject* pObj = objects.CreateObject();
+    pObj->GetStream()->Set( aRows, sizeof(aRows) );
+
+    PdfDictionary decodeParms;
+    decodeParms.AddKey( "Predictor", static_cast<pdf_int64>(15) );
+    decodeParms.AddKey( "Columns", static_cast<pdf_int64>(4) );
+    pObj->GetDictionary().AddKey( "DecodeParms", decodeParms );
+
+    char*    pBuffer;
+    pdf_long lLen;
+    pObj->GetStream()->GetFilteredCopy( &pBuffer, &lLen );
+    std::string sDecoded( pBuffer, lLen );
+    podofo_free( pBuffer );
+    CPPUNIT_ASSERT_EQUAL( std::string( "\x01\x02\x03\x04\x02\x03\x04\x05", 8 ), sDecoded );
+
+    // Every predictor and bit depth survives encoding and decoding
+    const int aPredictors[]       = { 2, 10, 11, 12, 13, 14, 15 };
+    const int aBitsPerComponent[] = { 1, 2, 4, 8, 16 };
+    for( size_t p = 0; p < sizeof(aPredictors) / sizeof(int); p++ )
+    {
+        for( size_t b = 0; b < sizeof(aBitsPerComponent) / sizeof(int); b++ )
+        {
+            TFlateSettings settings;
+            settings.nPredictor        = aPredictors[p];
+            settings.nColors           = 3;
+            settings.nBitsPerComponent = aBitsPerComponent[b];
+            settings.nColumns          = 7;
+
+            const int nRowLen = ( settings.nColumns * settings.nColors * settings.nBitsPerComponent + 7 ) / 8;
+            std::string sData;
+            for( int i = 0; i < nRowLen * 5; i++ )
+                sData += static_cast<char>( ( i * 37 + i / nRowLen * 11 ) & 0xff );
+
+            PdfObject*  pPredicted = objects.CreateObject();
+            TVecFilters vecFlate;
+            vecFlate.push_back( ePdfFilter_FlateDecode );
+            pPredicted->GetStream()->SetFlateSettings( &settings );
+            pPredicted->GetStream()->Set( sData.c_str(), sData.size(), vecFlate );
+            pPredicted->GetStream()->SetFlateSettings( NULL );
+
+            const PdfObject* pDecodeParms = pPredicted->GetDictionary().GetKey( "DecodeParms" );
+            CPPUNIT_ASSERT( pDecodeParms != NULL );
+            CPPUNIT_ASSERT_EQUAL( static_cast<pdf_int64>(aPredictors[p]),
+                                  pDecodeParms->GetDictionary().GetKey( "Predictor" )->GetNumber() );
+
+            pPredicted->GetStream()->GetFilteredCopy( &pBuffer, &lLen );
+            sDecoded.assign( pBuffer, lLen );
+            podofo_free( pBuffer );
+            CPPUNIT_ASSERT( sData == sDecoded );
+        }
+    }
+
+    // A predictor with more than one filter is refused before the stream is changed
+    TFlateSettings settings;
+    settings.nPredictor = 12;
+    TVecFilters vecFilters;
+    vecFilters.push_back( ePdfFilter_ASCIIHexDecode );
+    vecFilters.push_back( ePdfFilter_FlateDecode );
+    pObj = objects.CreateObject();
+    pObj->GetStream()->SetFlateSettings( &settings );
+    CPPUNIT_ASSERT_THROW_WITH_ERROR_TYPE( pObj->GetStream()->BeginAppend( vecFilters ),
+                                          PdfError,
+                                          ePdfError_InvalidPredictor );
+    CPPUNIT_ASSERT( !pObj->GetDictionary().HasKey( PdfName::KeyFilter ) );
+    pObj->GetStream()->SetFlateSettings( NULL );
+}
@@ -32,6 +32,12 @@ class FilterTest : public CppUnit::TestFixture
   CPPUNIT_TEST_SUITE( FilterTest );
   CPPUNIT_TEST( testFilters );
   CPPUNIT_TEST( testCCITT );
+  CPPUNIT_TEST( testFilteredInputStream );
+  CPPUNIT_TEST( testAsciiAndRunLength );
+  CPPUNIT_TEST( testImageCodecs );
+  CPPUNIT_TEST( testWriteCompressedStreams );
+  CPPUNIT_TEST( testFlateSettings );
+  CPPUNIT_TEST( testPredictors );
   CPPUNIT_TEST_SUITE_END();
 
  public:
@@ -42,8 +48,26 @@ class FilterTest : public CppUnit::TestFixture
 
   void testCCITT();
 
+  void testFilteredInputStream();
+
+  void testAsciiAndRunLength();
+
+  void testImageCodecs();
+
+  void testWriteCompressedStreams();
+
+  void testFlateSettings();
+
+  void testPredictors();
+
  private:
   void TestFilter( PoDoFo::EPdfFilter eFilter, const char * pTestBuffer, const long lTestLength );
+
+  /** Decode data passing it to the filter in blocks of lBlockSize bytes.
+   *
+   *  \returns the decoded data
+   */
+  std::string DecodeInBlocks( PoDoFo::EPdfFilter eFilter, const std::string & sEncoded, size_t lBlockSize );
 };
 
 #endif // _FILTER_TEST_H_
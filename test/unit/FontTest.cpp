@@ -144,6 +144,94 @@ void FontTest::testCreateFontFtFace()
     }
 }
 
+void FontTest::testSharedFontCache()
+{
+    PdfSharedFontCache::SetEnabled( true );
+
+    try {
+        PdfMemDocument doc1;
+        PdfMemDocument doc2;
+        PdfFont* pFont1 = doc1.CreateFont( "Arial", false, false, new PdfIdentityEncoding() );
+        PdfFont* pFont2 = doc2.CreateFont( "Arial", false, false, new PdfIdentityEncoding() );
+        CPPUNIT_ASSERT( pFont1 != NULL );
+        CPPUNIT_ASSERT( pFont2 != NULL );
+
+        const PdfFontMetrics* pMetrics1 = pFont1->GetFontMetrics();
+        const PdfFontMetrics* pMetrics2 = pFont2->GetFontMetrics();
+        // Both documents use the same font data
+        CPPUNIT_ASSERT( pMetrics1->GetFontData() != NULL );
+        CPPUNIT_ASSERT_EQUAL( pMetrics1->GetFontData(), pMetrics2->GetFontData() );
+        CPPUNIT_ASSERT_EQUAL( pMetrics1->GetFontDataLen(), pMetrics2->GetFontDataLen() );
+        CPPUNIT_ASSERT_EQUAL( std::string( pMetrics1->GetFontname() ), std::string( pMetrics2->GetFontname() ) );
+
+        for( int i = 0; i < 256; i++ ) 
+            CPPUNIT_ASSERT_EQUAL( pMetrics1->CharWidth( static_cast<unsigned char>(i) ), 
+                                  pMetrics2->CharWidth( static_cast<unsigned char>(i) ) );
+
+        // The shared data stays valid after the cache was emptied
+        PdfSharedFontCache::EmptyCache();
+        FT_Library             library = doc1.GetFontLibrary();
+        PdfFontMetricsFreetype metrics( &library, 
+                                        PdfSharedFontCache::GetFontFile( pMetrics1->GetFilename() ), false );
+        CPPUNIT_ASSERT_EQUAL( std::string( pMetrics1->GetFontname() ), std::string( metrics.GetFontname() ) );
+        CPPUNIT_ASSERT( metrics.GetFontData() != pMetrics1->GetFontData() );
+        CPPUNIT_ASSERT_EQUAL( pMetrics1->GetFontDataLen(), metrics.GetFontDataLen() );
+    } catch( PdfError & ) {
+        PdfSharedFontCache::SetEnabled( false );
+        PdfSharedFontCache::EmptyCache();
+        throw;
+    }
+
+    PdfSharedFontCache::SetEnabled( false );
+    PdfSharedFontCache::EmptyCache();
+}
+
+void FontTest::testSharedFontCacheFlateSettings()
+{
+    PdfSharedFontCache::SetEnabled( true );
+
+    try {
+        // The embedded font file of each document uses its own settings
+        TFlateSettings store( 0 );
+        PdfMemDocument doc1;
+        PdfMemDocument doc2;
+        doc2.GetObjects().SetFlateSettings( &store );
+
+        PdfFont* pFont1 = doc1.CreateFont( "Arial" );
+        PdfFont* pFont2 = doc2.CreateFont( "Arial" );
+        CPPUNIT_ASSERT( pFont1 != NULL );
+        CPPUNIT_ASSERT( pFont2 != NULL );
+        CPPUNIT_ASSERT_EQUAL( pFont1->GetFontMetrics()->GetFontData(), pFont2->GetFontMetrics()->GetFontData() );
+
+        const PdfObject* pFile1 = GetFontFile( doc1 );
+        const PdfObject* pFile2 = GetFontFile( doc2 );
+        CPPUNIT_ASSERT( pFile1 != NULL );
+        CPPUNIT_ASSERT( pFile2 != NULL );
+        CPPUNIT_ASSERT( pFile1->GetStream()->GetLength() < pFile2->GetStream()->GetLength() );
+
+        doc2.GetObjects().SetFlateSettings( NULL );
+    } catch( PdfError & ) {
+        PdfSharedFontCache::SetEnabled( false );
+        PdfSharedFontCache::EmptyCache();
+        throw;
+    }
+
+    PdfSharedFontCache::SetEnabled( false );
+    PdfSharedFontCache::EmptyCache();
+}
+
+const PdfObject* FontTest::GetFontFile( PdfMemDocument & rDoc )
+{
+    TCIVecObjects it = rDoc.GetObjects().begin();
+    for( ; it != rDoc.GetObjects().end(); ++it ) 
+    {
+        if( (*it)->IsDictionary() && (*it)->GetDictionary().HasKey( "Length1" ) )
+            return *it;
+    }
+
+    return NULL;
+}
+
 bool FontTest::GetFontInfo( FcPattern* pFont, std::string & rsFamily, std::string & rsPath, 
                             bool & rbBold, bool & rbItalic )
 {
@@ -215,3 +303,85 @@ void FontTest::testBig2Little()
             throw;
     }
 }
+
+void FontTest::testUnicodeCharWidths()
+{
+    PdfMemDocument doc;
+    PdfFont* pFont = doc.CreateFont( "Arial", false, false, false, new PdfIdentityEncoding() );
+    CPPUNIT_ASSERT( pFont != NULL );
+    pFont->SetFontSize( 12.0 );
+
+    // Latin, cyrillic and greek characters followed by a surrogate pair (U+1D400)
+    const pdf_utf8 szText[] = "Hello \xd0\x9f\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82 \xce\xb1\xce\xb2\xce\xb3 \xf0\x9d\x90\x80!";
+    PdfString               sText( szText );
+    const pdf_utf16be*      pszText = sText.GetUnicode();
+    unsigned int            nLength = sText.GetUnicodeLength();
+    std::vector<double>     vecWidths( nLength );
+
+    const PdfFontMetrics* pMetrics = pFont->GetFontMetrics();
+    pMetrics->UnicodeCharWidths( pszText, nLength, &vecWidths[0] );
+
+    double dSum = 0.0;
+    for( unsigned int i = 0; i < nLength; i++ ) 
+    {
+#ifdef PODOFO_IS_LITTLE_ENDIAN
+        unsigned short uChar = static_cast<unsigned short>(((pszText[i] & 0x00ff) << 8 | (pszText[i] & 0xff00) >> 8));
+#else
+        unsigned short uChar = static_cast<unsigned short>(pszText[i]);
+#endif // PODOFO_IS_LITTLE_ENDIAN
+
+        if( uChar >= 0xdc00 && uChar <= 0xdfff )
+            // The width of a surrogate pair is given for its first code unit
+            CPPUNIT_ASSERT_EQUAL( 0.0, vecWidths[i] );
+        else if( uChar < 0xd800 || uChar > 0xdbff )
+            CPPUNIT_ASSERT_DOUBLES_EQUAL( pMetrics->UnicodeCharWidth( uChar ), vecWidths[i], 1e-9 );
+
+        dSum += vecWidths[i];
+    }
+
+    // Cached widths stay the same
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( vecWidths[7], pMetrics->UnicodeCharWidth( 0x0440 ), 1e-9 );
+    CPPUNIT_ASSERT( vecWidths[7] > 0.0 );
+
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( dSum, pMetrics->StringWidth( pszText, nLength ), 1e-9 );
+}
+
+void FontTest::testFontCacheRenumber()
+{
+    PdfVecObjects objects;
+    objects.SetAutoDelete( true );
+
+    PdfFontCache  cache( &objects );
+    PdfDictionary dictionary;
+    PdfObject     trailer( dictionary );
+    PdfObject*    pUnused = objects.CreateObject( "Unused" );
+    PdfObject*    pFonts[2];
+    for( int i = 0; i < 2; i++ ) 
+    {
+        pFonts[i] = objects.CreateObject( "Font" );
+        pFonts[i]->GetDictionary().AddKey( PdfName::KeySubtype, PdfName( "Type1" ) );
+        pFonts[i]->GetDictionary().AddKey( "BaseFont", PdfName( i ? "Helvetica" : "Times-Roman" ) );
+        trailer.GetDictionary().AddKey( i ? "F1" : "F0", pFonts[i]->Reference() );
+
+        // Another object between the fonts, so that the fonts get
+        // numbers of objects which are not in the cache
+        objects.CreateObject( "Filler" );
+    }
+
+    PdfFont* pCached[2];
+    for( int i = 0; i < 2; i++ ) 
+    {
+        pCached[i] = cache.GetFont( pFonts[i] );
+        CPPUNIT_ASSERT( pCached[i] != NULL );
+        CPPUNIT_ASSERT( pCached[i] == cache.GetFont( pFonts[i] ) );
+    }
+
+    // Renumbering moves all fonts to new numbers
+    delete objects.RemoveObject( pUnused->Reference() );
+    PdfReference oldReference = pFonts[0]->Reference();
+    objects.RenumberObjects( &trailer );
+    CPPUNIT_ASSERT( oldReference != pFonts[0]->Reference() );
+
+    for( int i = 0; i < 2; i++ ) 
+        CPPUNIT_ASSERT( pCached[i] == cache.GetFont( pFonts[i] ) );
+}
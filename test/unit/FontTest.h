@@ -37,8 +37,12 @@ class FontTest : public CppUnit::TestFixture
 #if defined(PODOFO_HAVE_FONTCONFIG)
   CPPUNIT_TEST( testFonts );
   CPPUNIT_TEST( testCreateFontFtFace );
+  CPPUNIT_TEST( testSharedFontCache );
+  CPPUNIT_TEST( testSharedFontCacheFlateSettings );
 #endif
   CPPUNIT_TEST( testBig2Little );
+  CPPUNIT_TEST( testUnicodeCharWidths );
+  CPPUNIT_TEST( testFontCacheRenumber );
   CPPUNIT_TEST_SUITE_END();
 
  public:
@@ -48,8 +52,12 @@ class FontTest : public CppUnit::TestFixture
 #if defined(PODOFO_HAVE_FONTCONFIG)
   void testFonts();
   void testCreateFontFtFace();
+  void testSharedFontCache();
+  void testSharedFontCacheFlateSettings();
 #endif
   void testBig2Little();
+  void testUnicodeCharWidths();
+  void testFontCacheRenumber();
 
 private:
 #if defined(PODOFO_HAVE_FONTCONFIG)
@@ -57,6 +65,8 @@ private:
 
     bool GetFontInfo( FcPattern* pFont, std::string & rsFamily, std::string & rsPath, 
                       bool & rbBold, bool & rbItalic );
+
+    const PoDoFo::PdfObject* GetFontFile( PoDoFo::PdfMemDocument & rDoc );
 #endif
 
 private:
@@ -76,3 +76,186 @@ void PageTest::testEmptyContentsStream()
     TestUtils::deleteFile( sFilename.c_str() );
 }
 
+
+void PageTest::testImageOptimizer()
+{
+    PdfMemDocument doc;
+    PdfPage*       pPage = doc.CreatePage( PdfPage::CreateStandardPageSize( ePdfPageSize_A4 ) );
+
+    // A gray RGB image covering the page at about 100 dpi
+    const unsigned int nWidth  = 1200;
+    const unsigned int nHeight = 1600;
+    std::string sGray;
+    for( unsigned int y = 0; y < nHeight; y++ )
+        for( unsigned int x = 0; x < nWidth; x++ )
+            sGray.append( 3, static_cast<char>( ( x / 2 + y / 2 ) % 256 ) );
+
+    PdfImage grayImage( &doc );
+    PdfMemoryInputStream grayStream( sGray.c_str(), sGray.size() );
+    grayImage.SetImageData( nWidth, nHeight, 8, &grayStream );
+
+    PdfPainter painter;
+    painter.SetPage( pPage );
+    painter.DrawImage( 0.0, 0.0, &grayImage );
+    painter.FinishPage();
+
+    // A CMYK image, which is not used on any page
+    std::string  sCmyk;
+    unsigned int nRandom = 1;
+    for( int i = 0; i < 64 * 64 * 4; i++ )
+    {
+        nRandom = nRandom * 1103515245 + 12345;
+        sCmyk += static_cast<char>( ( nRandom >> 16 ) & 0x7f );
+    }
+
+    PdfImage cmykImage( &doc );
+    cmykImage.SetImageColorSpace( ePdfColorSpace_DeviceCMYK );
+    PdfMemoryInputStream cmykStream( sCmyk.c_str(), sCmyk.size() );
+    cmykImage.SetImageData( 64, 64, 8, &cmykStream );
+
+    PdfImageOptimizer optimizer;
+    optimizer.SetResolution( 50.0 );
+    CPPUNIT_ASSERT_EQUAL( 2, optimizer.Optimize( &doc ) );
+
+    // Downsampled by averaging 2x2 pixels and converted to gray
+    PdfObject* pGray = grayImage.GetObject();
+    CPPUNIT_ASSERT_EQUAL( static_cast<pdf_int64>(nWidth / 2), pGray->GetDictionary().GetKey( "Width" )->GetNumber() );
+    CPPUNIT_ASSERT_EQUAL( static_cast<pdf_int64>(nHeight / 2), pGray->GetDictionary().GetKey( "Height" )->GetNumber() );
+    CPPUNIT_ASSERT( PdfName( "DeviceGray" ) == pGray->GetDictionary().GetKey( "ColorSpace" )->GetName() );
+
+    char*    pBuffer;
+    pdf_long lLen;
+    pGray->GetStream()->GetFilteredCopy( &pBuffer, &lLen );
+    CPPUNIT_ASSERT_EQUAL( static_cast<pdf_long>(nWidth / 2 * nHeight / 2), lLen );
+    bool bEqual = true;
+    for( unsigned int y = 0; y < nHeight / 2; y++ )
+        for( unsigned int x = 0; x < nWidth / 2; x++ )
+            bEqual = bEqual && static_cast<unsigned char>(pBuffer[y * (nWidth / 2) + x]) == ( x + y ) % 256;
+    podofo_free( pBuffer );
+    CPPUNIT_ASSERT( bEqual );
+
+    // Converted to RGB without downsampling
+    PdfObject* pCmyk = cmykImage.GetObject();
+    CPPUNIT_ASSERT_EQUAL( static_cast<pdf_int64>(64), pCmyk->GetDictionary().GetKey( "Width" )->GetNumber() );
+    CPPUNIT_ASSERT( PdfName( "DeviceRGB" ) == pCmyk->GetDictionary().GetKey( "ColorSpace" )->GetName() );
+
+    pCmyk->GetStream()->GetFilteredCopy( &pBuffer, &lLen );
+    CPPUNIT_ASSERT_EQUAL( static_cast<pdf_long>(64 * 64 * 3), lLen );
+    for( int i = 0; i < 64 * 64; i++ )
+    {
+        for( int c = 0; c < 3; c++ )
+        {
+            const int nExpected = 255 - PDF_MIN( 255, static_cast<int>(sCmyk[i * 4 + c]) + static_cast<int>(sCmyk[i * 4 + 3]) );
+            bEqual = bEqual && static_cast<unsigned char>(pBuffer[i * 3 + c]) == nExpected;
+        }
+    }
+    podofo_free( pBuffer );
+    CPPUNIT_ASSERT( bEqual );
+
+    // Nothing is left to optimize
+    CPPUNIT_ASSERT_EQUAL( 0, optimizer.Optimize( &doc ) );
+}
+
+void PageTest::testImageOptimizerSoftMask()
+{
+    PdfMemDocument doc;
+    PdfPage*       pPage = doc.CreatePage( PdfPage::CreateStandardPageSize( ePdfPageSize_A4 ) );
+
+    // Two images covering the page at about 100 dpi with soft masks
+    // of half their size, one of them premultiplied using /Matte
+    const unsigned int nWidth  = 1200;
+    const unsigned int nHeight = 1600;
+    std::string sImage;
+    for( unsigned int y = 0; y < nHeight; y++ )
+        for( unsigned int x = 0; x < nWidth; x++ )
+            sImage.append( 3, static_cast<char>( ( x / 2 + y / 2 ) % 256 ) );
+
+    std::string sMask;
+    for( unsigned int y = 0; y < nHeight / 2; y++ )
+        for( unsigned int x = 0; x < nWidth / 2; x++ )
+            sMask += static_cast<char>( ( x / 2 + y / 2 ) % 256 );
+
+    PdfImage* apImages[2];
+    PdfImage* apMasks[2];
+    PdfPainter painter;
+    painter.SetPage( pPage );
+    for( int i = 0; i < 2; i++ )
+    {
+        apMasks[i] = new PdfImage( &doc );
+        apMasks[i]->SetImageColorSpace( ePdfColorSpace_DeviceGray );
+        PdfMemoryInputStream maskStream( sMask.c_str(), sMask.size() );
+        apMasks[i]->SetImageData( nWidth / 2, nHeight / 2, 8, &maskStream );
+
+        apImages[i] = new PdfImage( &doc );
+        PdfMemoryInputStream imageStream( sImage.c_str(), sImage.size() );
+        apImages[i]->SetImageData( nWidth, nHeight, 8, &imageStream );
+        apImages[i]->SetImageSoftmask( apMasks[i] );
+
+        painter.DrawImage( 0.0, 0.0, apImages[i] );
+    }
+
+    PdfArray matte;
+    matte.push_back( PdfVariant( 0.0 ) );
+    matte.push_back( PdfVariant( 0.0 ) );
+    matte.push_back( PdfVariant( 0.0 ) );
+    apMasks[1]->GetObject()->GetDictionary().AddKey( "Matte", matte );
+
+    painter.FinishPage();
+
+    PdfImageOptimizer optimizer;
+    optimizer.SetResolution( 50.0 );
+    optimizer.SetConvertColorSpace( false );
+    // The soft mask is downsampled by the factor of its image, not by its own resolution
+    CPPUNIT_ASSERT_EQUAL( 2, optimizer.Optimize( &doc ) );
+
+    PdfObject* pImage = apImages[0]->GetObject();
+    CPPUNIT_ASSERT_EQUAL( static_cast<pdf_int64>(nWidth / 2), pImage->GetDictionary().GetKey( "Width" )->GetNumber() );
+    PdfObject* pMask = apMasks[0]->GetObject();
+    CPPUNIT_ASSERT_EQUAL( static_cast<pdf_int64>(nWidth / 4), pMask->GetDictionary().GetKey( "Width" )->GetNumber() );
+    CPPUNIT_ASSERT_EQUAL( static_cast<pdf_int64>(nHeight / 4), pMask->GetDictionary().GetKey( "Height" )->GetNumber() );
+
+    // Premultiplied images and their soft masks are left unchanged
+    pImage = apImages[1]->GetObject();
+    CPPUNIT_ASSERT_EQUAL( static_cast<pdf_int64>(nWidth), pImage->GetDictionary().GetKey( "Width" )->GetNumber() );
+    pMask = apMasks[1]->GetObject();
+    CPPUNIT_ASSERT_EQUAL( static_cast<pdf_int64>(nWidth / 2), pMask->GetDictionary().GetKey( "Width" )->GetNumber() );
+
+    for( int i = 0; i < 2; i++ )
+    {
+        delete apImages[i];
+        delete apMasks[i];
+    }
+}
+
+void PageTest::testImageOptimizerLowResolution()
+{
+    PdfMemDocument doc;
+    PdfPage*       pPage = doc.CreatePage( PdfPage::CreateStandardPageSize( ePdfPageSize_A4 ) );
+
+    // Blocks of a very low target resolution are limited to the size of the image
+    std::string  sNoise;
+    unsigned int nRandom = 1;
+    for( int i = 0; i < 64 * 48; i++ )
+    {
+        nRandom = nRandom * 1103515245 + 12345;
+        sNoise += static_cast<char>( ( nRandom >> 16 ) & 0xff );
+    }
+
+    PdfImage image( &doc );
+    image.SetImageColorSpace( ePdfColorSpace_DeviceGray );
+    PdfMemoryInputStream stream( sNoise.c_str(), sNoise.size() );
+    image.SetImageData( 64, 48, 8, &stream );
+
+    PdfPainter painter;
+    painter.SetPage( pPage );
+    painter.DrawImage( 0.0, 0.0, &image );
+    painter.FinishPage();
+
+    PdfImageOptimizer optimizer;
+    optimizer.SetResolution( 1e-6 );
+    CPPUNIT_ASSERT_EQUAL( 1, optimizer.Optimize( &doc ) );
+
+    PdfObject* pImage = image.GetObject();
+    CPPUNIT_ASSERT_EQUAL( static_cast<pdf_int64>(2), pImage->GetDictionary().GetKey( "Width" )->GetNumber() );
+    CPPUNIT_ASSERT_EQUAL( static_cast<pdf_int64>(1), pImage->GetDictionary().GetKey( "Height" )->GetNumber() );
+}
@@ -34,6 +34,9 @@ class PageTest : public CppUnit::TestFixture
   CPPUNIT_TEST_SUITE( PageTest );
   CPPUNIT_TEST( testEmptyContents );
   CPPUNIT_TEST( testEmptyContentsStream );
+  CPPUNIT_TEST( testImageOptimizer );
+  CPPUNIT_TEST( testImageOptimizerSoftMask );
+  CPPUNIT_TEST( testImageOptimizerLowResolution );
   CPPUNIT_TEST_SUITE_END();
 
  public:
@@ -42,6 +45,9 @@ class PageTest : public CppUnit::TestFixture
 
   void testEmptyContents();
   void testEmptyContentsStream();
+  void testImageOptimizer();
+  void testImageOptimizerSoftMask();
+  void testImageOptimizerLowResolution();
 };
 
 #endif // _PAGE_TEST_H_
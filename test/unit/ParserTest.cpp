@@ -31,6 +31,7 @@
 */
 
 #include "ParserTest.h"
+#include "TestUtils.h"
 
 #include <cppunit/Asserter.h>
 
@@ -2812,6 +2813,399 @@ void ParserTest::testRoundTripIndirectTrailerID()
     }
 }
 
+void ParserTest::testParallelReadObjects()
+{
+    // more objects than parsed by a single worker thread,
+    // some of them with streams and an indirect /Length
+    const int nObjects = 300;
+    std::ostringstream oss;
+    std::vector<int> objPos;
+    oss << "%PDF-1.4\n";
+
+    for ( int i = 1; i < nObjects; i++ ) {
+        objPos.push_back( oss.tellp() );
+        oss << i << " 0 obj\n";
+        if ( i == 1 )
+            oss << "<</Type /Catalog /Pages 2 0 R>>\n";
+        else if ( i == 2 )
+            oss << "<</Type /Pages /Count 0 /Kids []>>\n";
+        else if ( i == 3 )
+            oss << "5\n";
+        else if ( i % 3 == 0 )
+            oss << "<</Length 3 0 R>>\nstream\nHello\nendstream\n";
+        else
+            oss << "[" << i << " (String " << i << ") /Name" << i << " " << i * 0.5 << " 1 0 R]\n";
+        oss << "endobj\n";
+    }
+
+    int nXrefPos = oss.tellp();
+    oss << "xref\n";
+    oss << "0 " << nObjects << "\n";
+    oss << "0000000000 65535 f \n";
+    char objRec[21];
+    for ( int i = 0; i < nObjects - 1; i++ ) {
+        snprintf( objRec, 21, "%010d 00000 n \n", objPos[i] );
+        oss << objRec;
+    }
+    oss << "trailer <</Size " << nObjects << " /Root 1 0 R>>\n"
+        << "startxref\n"
+        << nXrefPos << "\n"
+        << "%%EOF\n";
+
+    std::string sInBuf = oss.str();
+    int nOldThreadCount = PoDoFo::PdfParser::GetThreadCount();
+    try {
+        PoDoFo::PdfVecObjects sequential;
+        PoDoFo::PdfParser::SetThreadCount( 1 );
+        PoDoFo::PdfParser sequentialParser( &sequential );
+        sequentialParser.ParseFile( sInBuf.c_str(), sInBuf.size(), false );
+
+        PoDoFo::PdfVecObjects parallel;
+        PoDoFo::PdfParser::SetThreadCount( 4 );
+        PoDoFo::PdfParser parallelParser( &parallel );
+        parallelParser.ParseFile( sInBuf.c_str(), sInBuf.size(), false );
+
+        CPPUNIT_ASSERT_EQUAL( sequential.GetSize(), parallel.GetSize() );
+        for ( size_t i = 0; i < sequential.GetSize(); i++ ) {
+            PoDoFo::PdfObject* pSequential = sequential[i];
+            PoDoFo::PdfObject* pParallel = parallel[i];
+            CPPUNIT_ASSERT( pSequential->Reference() == pParallel->Reference() );
+
+            std::string sSequential;
+            std::string sParallel;
+            pSequential->ToString( sSequential );
+            pParallel->ToString( sParallel );
+            CPPUNIT_ASSERT_EQUAL( sSequential, sParallel );
+
+            CPPUNIT_ASSERT_EQUAL( pSequential->HasStream(), pParallel->HasStream() );
+            if ( pSequential->HasStream() ) {
+                PoDoFo::pdf_long lLen;
+                char* pBuffer;
+                pParallel->GetStream()->GetFilteredCopy( &pBuffer, &lLen );
+                CPPUNIT_ASSERT_EQUAL( std::string( "Hello" ), std::string( pBuffer, lLen ) );
+                PoDoFo::podofo_free( pBuffer );
+            }
+        }
+    } catch ( PoDoFo::PdfError& error ) {
+        PoDoFo::PdfParser::SetThreadCount( nOldThreadCount );
+        CPPUNIT_FAIL( "Unexpected PdfError" );
+    }
+
+    PoDoFo::PdfParser::SetThreadCount( nOldThreadCount );
+}
+
+void ParserTest::testWriteLinearized()
+{
+    // write a small multi-page document linearized and check the result
+    // starts with the linearization dictionary and parses back unchanged
+    try {
+        PoDoFo::PdfMemDocument doc;
+        PoDoFo::PdfFont* pFont = doc.CreateFont( "Helvetica", false, false, false,
+                                                 PoDoFo::PdfEncodingFactory::GlobalWinAnsiEncodingInstance(),
+                                                 PoDoFo::PdfFontCache::eFontCreationFlags_AutoSelectBase14 );
+        for ( int i = 0; i < 3; i++ ) {
+            PoDoFo::PdfPage* pPage = doc.CreatePage( PoDoFo::PdfPage::CreateStandardPageSize( PoDoFo::ePdfPageSize_A4 ) );
+            PoDoFo::PdfPainter painter;
+            painter.SetPage( pPage );
+            painter.SetFont( pFont );
+            painter.DrawText( 100.0, 700.0, "Linearized" );
+            painter.FinishPage();
+        }
+
+        PoDoFo::PdfReference catalogRef = doc.GetCatalog()->Reference();
+        size_t nObjects = doc.GetObjects().GetSize();
+
+        PoDoFo::PdfRefCountedBuffer buffer;
+        PoDoFo::PdfOutputDevice device( &buffer );
+        PoDoFo::PdfWriter writer( &doc.GetObjects(), doc.GetTrailer() );
+        writer.SetLinearized( true );
+        writer.Write( &device );
+
+        // writing must not renumber the objects of the document
+        CPPUNIT_ASSERT( doc.GetCatalog()->Reference() == catalogRef );
+        CPPUNIT_ASSERT_EQUAL( nObjects, doc.GetObjects().GetSize() );
+
+        std::string sOutput( buffer.GetBuffer(), static_cast<size_t>(device.GetLength()) );
+        CPPUNIT_ASSERT( sOutput.find( "/Linearized" ) < 1024 );
+
+        PoDoFo::PdfMemDocument reread;
+        reread.LoadFromBuffer( sOutput.c_str(), static_cast<long>(sOutput.size()) );
+        CPPUNIT_ASSERT_EQUAL( 3, reread.GetPageCount() );
+        CPPUNIT_ASSERT_EQUAL( nObjects + 2, reread.GetObjects().GetSize() );
+
+        PoDoFo::PdfObject* pLinearize = NULL;
+        PoDoFo::TCIVecObjects it = reread.GetObjects().begin();
+        for ( ; it != reread.GetObjects().end(); ++it ) {
+            if ( (*it)->IsDictionary() && (*it)->GetDictionary().HasKey( "Linearized" ) )
+                pLinearize = *it;
+        }
+        CPPUNIT_ASSERT( pLinearize != NULL );
+        CPPUNIT_ASSERT_EQUAL( static_cast<PoDoFo::pdf_int64>(sOutput.size()),
+                              pLinearize->GetDictionary().GetKey( "L" )->GetNumber() );
+        CPPUNIT_ASSERT_EQUAL( static_cast<PoDoFo::pdf_int64>(3),
+                              pLinearize->GetDictionary().GetKey( "N" )->GetNumber() );
+    } catch ( PoDoFo::PdfError& error ) {
+        CPPUNIT_FAIL( "Unexpected PdfError" );
+    }
+}
+
+void ParserTest::testWriteObjectStreams()
+{
+    // write all objects which are not streams to object streams holding
+    // at most two objects and compare with a file without object streams
+    try {
+        PoDoFo::PdfMemDocument doc;
+        for ( int i = 0; i < 3; i++ ) {
+            PoDoFo::PdfPage* pPage = doc.CreatePage( PoDoFo::PdfPage::CreateStandardPageSize( PoDoFo::ePdfPageSize_A4 ) );
+            PoDoFo::PdfPainter painter;
+            painter.SetPage( pPage );
+            painter.Rectangle( 10.0 * i, 10.0, 100.0, 100.0 );
+            painter.Fill();
+            painter.FinishPage();
+        }
+        size_t nObjects = doc.GetObjects().GetSize();
+        size_t nObjectCount = doc.GetObjects().GetObjectCount();
+
+        PoDoFo::PdfRefCountedBuffer plainBuffer;
+        PoDoFo::PdfOutputDevice plainDevice( &plainBuffer );
+        PoDoFo::PdfWriter plainWriter( &doc.GetObjects(), doc.GetTrailer() );
+        plainWriter.SetUseXRefStream( true );
+        plainWriter.Write( &plainDevice );
+
+        PoDoFo::PdfRefCountedBuffer packedBuffer;
+        PoDoFo::PdfOutputDevice packedDevice( &packedBuffer );
+        PoDoFo::PdfWriter packedWriter( &doc.GetObjects(), doc.GetTrailer() );
+        packedWriter.SetObjectStreamSize( 2 );
+        CPPUNIT_ASSERT( packedWriter.GetUseXRefStream() );
+        packedWriter.Write( &packedDevice );
+
+        // neither the object streams nor the XRef streams are added to the document,
+        // and their object numbers are given back for the next write
+        CPPUNIT_ASSERT_EQUAL( nObjects, doc.GetObjects().GetSize() );
+        CPPUNIT_ASSERT_EQUAL( nObjectCount, doc.GetObjects().GetObjectCount() );
+
+        std::string sPacked( packedBuffer.GetBuffer(), static_cast<size_t>(packedDevice.GetLength()) );
+        CPPUNIT_ASSERT( sPacked.find( "/ObjStm" ) != std::string::npos );
+
+        PoDoFo::PdfMemDocument plain;
+        plain.LoadFromBuffer( plainBuffer.GetBuffer(), static_cast<long>(plainDevice.GetLength()) );
+        PoDoFo::PdfMemDocument packed;
+        packed.LoadFromBuffer( sPacked.c_str(), static_cast<long>(sPacked.size()) );
+        CPPUNIT_ASSERT_EQUAL( 3, packed.GetPageCount() );
+
+        PoDoFo::TCIVecObjects it = doc.GetObjects().begin();
+        for ( ; it != doc.GetObjects().end(); ++it ) {
+            // the modification date of the info dictionary is updated when loading
+            if ( (*it) == doc.GetInfo()->GetObject() )
+                continue;
+
+            PoDoFo::PdfObject* pPlain = plain.GetObjects().GetObject( (*it)->Reference() );
+            PoDoFo::PdfObject* pPacked = packed.GetObjects().GetObject( (*it)->Reference() );
+            CPPUNIT_ASSERT( pPlain != NULL );
+            CPPUNIT_ASSERT( pPacked != NULL );
+
+            std::string sPlainObject;
+            std::string sPackedObject;
+            pPlain->ToString( sPlainObject );
+            pPacked->ToString( sPackedObject );
+            CPPUNIT_ASSERT_EQUAL( sPlainObject, sPackedObject );
+        }
+    } catch ( PoDoFo::PdfError& error ) {
+        CPPUNIT_FAIL( "Unexpected PdfError" );
+    }
+}
+
+void ParserTest::testWriteObjectStreamsFreeObjects()
+{
+    // free object numbers with a generation > 0, as in a loaded document,
+    // must neither be used for object streams nor be removed from the free list
+    try {
+        PoDoFo::PdfMemDocument doc;
+        doc.CreatePage( PoDoFo::PdfPage::CreateStandardPageSize( PoDoFo::ePdfPageSize_A4 ) );
+        std::vector<PoDoFo::PdfReference> vecRefs;
+        for ( int i = 0; i < 4; i++ )
+            vecRefs.push_back( doc.GetObjects().CreateObject( PoDoFo::PdfVariant( static_cast<PoDoFo::pdf_int64>(i) ) )->Reference() );
+        for ( int i = 0; i < 4; i += 2 ) {
+            delete doc.GetObjects().RemoveObject( vecRefs[i], false );
+            doc.GetObjects().AddFreeObject( PoDoFo::PdfReference( vecRefs[i].ObjectNumber(), 1 ) );
+        }
+        PoDoFo::TPdfReferenceList lstFree = doc.GetObjects().GetFreeObjects();
+        CPPUNIT_ASSERT_EQUAL( static_cast<size_t>(2), lstFree.size() );
+
+        PoDoFo::PdfRefCountedBuffer buffer;
+        PoDoFo::PdfOutputDevice device( &buffer );
+        PoDoFo::PdfWriter writer( &doc.GetObjects(), doc.GetTrailer() );
+        writer.SetObjectStreamSize( 2 );
+        writer.Write( &device );
+
+        CPPUNIT_ASSERT( lstFree == doc.GetObjects().GetFreeObjects() );
+
+        std::string sOutput( buffer.GetBuffer(), static_cast<size_t>(device.GetLength()) );
+        CPPUNIT_ASSERT( sOutput.find( "/ObjStm" ) != std::string::npos );
+        CPPUNIT_ASSERT( sOutput.find( " 1 obj" ) == std::string::npos );
+
+        PoDoFo::PdfMemDocument loaded;
+        loaded.LoadFromBuffer( sOutput.c_str(), static_cast<long>(sOutput.size()) );
+        CPPUNIT_ASSERT_EQUAL( 1, loaded.GetPageCount() );
+
+        PoDoFo::TCIVecObjects it = doc.GetObjects().begin();
+        for ( ; it != doc.GetObjects().end(); ++it ) {
+            PoDoFo::PdfObject* pLoaded = loaded.GetObjects().GetObject( (*it)->Reference() );
+            CPPUNIT_ASSERT( pLoaded != NULL );
+            if ( (*it)->IsNumber() )
+                CPPUNIT_ASSERT_EQUAL( (*it)->GetNumber(), pLoaded->GetNumber() );
+        }
+    } catch ( PoDoFo::PdfError& error ) {
+        CPPUNIT_FAIL( "Unexpected PdfError" );
+    }
+}
+
+void ParserTest::testObjectLookup()
+{
+    // look up objects with dense, sparse and reused object numbers
+    PoDoFo::PdfVecObjects objects;
+    objects.SetAutoDelete( true );
+
+    for ( int i = 0; i < 100; i++ )
+        objects.CreateObject();
+
+    PoDoFo::PdfObject* pSparse = new PoDoFo::PdfObject( PoDoFo::PdfReference( 1000000, 0 ), static_cast<const char*>(NULL) );
+    objects.push_back( pSparse );
+    PoDoFo::PdfObject* pGeneration = new PoDoFo::PdfObject( PoDoFo::PdfReference( 50, 1 ), static_cast<const char*>(NULL) );
+    objects.push_back( pGeneration );
+
+    for ( PoDoFo::pdf_objnum i = 1; i <= 100; i++ ) {
+        PoDoFo::PdfObject* pObj = objects.GetObject( PoDoFo::PdfReference( i, 0 ) );
+        CPPUNIT_ASSERT( pObj != NULL );
+        CPPUNIT_ASSERT( pObj->Reference() == PoDoFo::PdfReference( i, 0 ) );
+    }
+
+    CPPUNIT_ASSERT( objects.GetObject( PoDoFo::PdfReference( 1000000, 0 ) ) == pSparse );
+    CPPUNIT_ASSERT( objects.GetObject( PoDoFo::PdfReference( 50, 1 ) ) == pGeneration );
+    CPPUNIT_ASSERT( objects.GetObject( PoDoFo::PdfReference( 101, 0 ) ) == NULL );
+    CPPUNIT_ASSERT( objects.GetObject( PoDoFo::PdfReference( 1, 1 ) ) == NULL );
+    CPPUNIT_ASSERT_EQUAL( static_cast<size_t>(50), objects.GetIndex( PoDoFo::PdfReference( 50, 1 ) ) );
+
+    delete objects.RemoveObject( PoDoFo::PdfReference( 50, 0 ) );
+    CPPUNIT_ASSERT( objects.GetObject( PoDoFo::PdfReference( 50, 0 ) ) == NULL );
+    CPPUNIT_ASSERT( objects.GetObject( PoDoFo::PdfReference( 50, 1 ) ) == pGeneration );
+
+    // the free object number is reused
+    PoDoFo::PdfObject* pReused = objects.CreateObject();
+    CPPUNIT_ASSERT( pReused->Reference() == PoDoFo::PdfReference( 50, 0 ) );
+    CPPUNIT_ASSERT( objects.GetObject( PoDoFo::PdfReference( 50, 0 ) ) == pReused );
+}
+
+void ParserTest::testArenaLoad()
+{
+    // a document loaded into an arena has the same objects as one
+    // loaded from the heap and can be loaded again into the same arena
+    try {
+        PoDoFo::PdfMemDocument doc;
+        for ( int i = 0; i < 5; i++ ) {
+            PoDoFo::PdfObject* pObj = doc.GetObjects().CreateObject();
+            pObj->GetDictionary().AddKey( "Name", PoDoFo::PdfName( "Value" ) );
+            pObj->GetDictionary().AddKey( "String", PoDoFo::PdfString( "A string, long enough not to fit into any small buffer" ) );
+            PoDoFo::PdfArray array;
+            array.push_back( PoDoFo::PdfVariant( static_cast<PoDoFo::pdf_int64>(i) ) );
+            array.push_back( PoDoFo::PdfVariant( 0.5 ) );
+            array.push_back( PoDoFo::PdfReference( 1, 0 ) );
+            pObj->GetDictionary().AddKey( "Array", array );
+        }
+        doc.CreatePage( PoDoFo::PdfPage::CreateStandardPageSize( PoDoFo::ePdfPageSize_A4 ) );
+
+        PoDoFo::PdfRefCountedBuffer buffer;
+        PoDoFo::PdfOutputDevice device( &buffer );
+        doc.Write( &device );
+        std::string sOutput( buffer.GetBuffer(), static_cast<size_t>(device.GetLength()) );
+
+        PoDoFo::PdfMemDocument heap;
+        heap.LoadFromBuffer( sOutput.c_str(), static_cast<long>(sOutput.size()) );
+
+        PoDoFo::PdfMemDocument arena;
+        CPPUNIT_ASSERT( !arena.GetUseArena() );
+        arena.SetUseArena( true );
+        CPPUNIT_ASSERT( arena.GetUseArena() );
+
+        for ( int nLoad = 0; nLoad < 2; nLoad++ ) {
+            arena.LoadFromBuffer( sOutput.c_str(), static_cast<long>(sOutput.size()) );
+            CPPUNIT_ASSERT_EQUAL( 1, arena.GetPageCount() );
+            CPPUNIT_ASSERT_EQUAL( heap.GetObjects().GetSize(), arena.GetObjects().GetSize() );
+
+            for ( size_t i = 0; i < heap.GetObjects().GetSize(); i++ ) {
+                std::string sHeap;
+                std::string sArena;
+                heap.GetObjects()[i]->ToString( sHeap );
+                arena.GetObjects()[i]->ToString( sArena );
+                CPPUNIT_ASSERT_EQUAL( sHeap, sArena );
+            }
+        }
+    } catch ( PoDoFo::PdfError& error ) {
+        CPPUNIT_FAIL( "Unexpected PdfError" );
+    }
+
+    // objects created from the heap and from an arena can be mixed
+    PoDoFo::PdfArena arena;
+    PoDoFo::PdfObject* pHeap = new PoDoFo::PdfObject();
+    {
+        PoDoFo::PdfArenaScope scope( &arena );
+        CPPUNIT_ASSERT( PoDoFo::PdfArena::GetCurrent() == &arena );
+
+        PoDoFo::PdfObject* pArena = new PoDoFo::PdfObject( *pHeap );
+        pArena->GetDictionary().AddKey( "Key", PoDoFo::PdfString( "Value" ) );
+        pHeap->GetDictionary().AddKey( "Key", *pArena );
+        CPPUNIT_ASSERT( arena.GetSize() > 0 );
+        delete pArena;
+    }
+    CPPUNIT_ASSERT( PoDoFo::PdfArena::GetCurrent() == NULL );
+    CPPUNIT_ASSERT( pHeap->GetDictionary().GetKey( "Key" )->IsDictionary() );
+    delete pHeap;
+
+    arena.Clear();
+    CPPUNIT_ASSERT_EQUAL( static_cast<size_t>(0), arena.GetSize() );
+}
+
+void ParserTest::testArenaLoadOnDemand()
+{
+    // objects loaded on demand one by one continue to fill the chunks
+    // of the arena, so it does not grow larger than for loading all at once
+    try {
+        PoDoFo::PdfMemDocument doc;
+        for ( int i = 0; i < 2000; i++ ) {
+            PoDoFo::PdfObject* pObj = doc.GetObjects().CreateObject();
+            pObj->GetDictionary().AddKey( "Name", PoDoFo::PdfName( "Value" ) );
+            pObj->GetDictionary().AddKey( "Number", PoDoFo::PdfVariant( static_cast<PoDoFo::pdf_int64>(i) ) );
+        }
+
+        PoDoFo::PdfRefCountedBuffer buffer;
+        PoDoFo::PdfOutputDevice device( &buffer );
+        doc.Write( &device );
+        std::string sOutput( buffer.GetBuffer(), static_cast<size_t>(device.GetLength()) );
+
+        size_t nSize[2];
+        for ( int nLoadOnDemand = 0; nLoadOnDemand < 2; nLoadOnDemand++ ) {
+            PoDoFo::PdfArena arena;
+            PoDoFo::PdfVecObjects objects;
+            objects.SetAutoDelete( true );
+
+            PoDoFo::PdfParser parser( &objects );
+            parser.SetArena( &arena );
+            parser.ParseFile( sOutput.c_str(), static_cast<long>(sOutput.size()), nLoadOnDemand == 1 );
+
+            PoDoFo::TCIVecObjects it = objects.begin();
+            for ( ; it != objects.end(); ++it )
+                CPPUNIT_ASSERT( (*it)->IsDictionary() );
+
+            nSize[nLoadOnDemand] = arena.GetSize();
+        }
+
+        CPPUNIT_ASSERT( nSize[0] > 0 );
+        CPPUNIT_ASSERT( nSize[1] <= nSize[0] + 65536 );
+    } catch ( PoDoFo::PdfError& error ) {
+        CPPUNIT_FAIL( "Unexpected PdfError" );
+    }
+}
+
 std::string ParserTest::generateXRefEntries( size_t count )
 {
     std::string strXRefEntries;
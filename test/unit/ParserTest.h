@@ -50,6 +50,13 @@ class ParserTest : public CppUnit::TestFixture
     CPPUNIT_TEST( testNestedOutlines );
     CPPUNIT_TEST( testLoopingOutlines );
     CPPUNIT_TEST( testRoundTripIndirectTrailerID );
+    CPPUNIT_TEST( testParallelReadObjects );
+    CPPUNIT_TEST( testWriteLinearized );
+    CPPUNIT_TEST( testWriteObjectStreams );
+    CPPUNIT_TEST( testWriteObjectStreamsFreeObjects );
+    CPPUNIT_TEST( testObjectLookup );
+    CPPUNIT_TEST( testArenaLoad );
+    CPPUNIT_TEST( testArenaLoadOnDemand );
     CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -101,6 +108,13 @@ public:
     void testLoopingOutlines();
 
     void testRoundTripIndirectTrailerID();
+    void testParallelReadObjects();
+    void testWriteLinearized();
+    void testWriteObjectStreams();
+    void testWriteObjectStreamsFreeObjects();
+    void testObjectLookup();
+    void testArenaLoad();
+    void testArenaLoadOnDemand();
 
 private:
     std::string generateXRefEntries( size_t count );
@@ -0,0 +1,256 @@
+/***************************************************************************
+ *   Copyright (C) 2007 by Dominik Seichter                                *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "StreamTest.h"
+#include "TestUtils.h"
+
+#include <stdio.h>
+
+using namespace PoDoFo;
+
+CPPUNIT_TEST_SUITE_REGISTRATION( StreamTest );
+
+void StreamTest::setUp()
+{
+}
+
+void StreamTest::tearDown()
+{
+}
+
+void StreamTest::testStreamMemoryBudget()
+{
+    // streams created while another stream of a streamed document is written
+    // are moved to a temporary file as soon as they exceed the memory budget
+    std::vector<std::string> vecData;
+    unsigned int nRandom = 1;
+    for ( int i = 0; i < 5; i++ ) {
+        std::string sData;
+        for ( int j = 0; j < 20000; j++ ) {
+            nRandom = nRandom * 1103515245 + 12345;
+            sData += static_cast<char>( ( nRandom >> 16 ) & 0xff );
+        }
+        vecData.push_back( sData );
+    }
+
+    std::vector<PdfEncrypt*> vecEncrypt;
+    vecEncrypt.push_back( NULL );
+#ifndef PODOFO_HAVE_OPENSSL_NO_RC4
+    vecEncrypt.push_back( PdfEncrypt::CreatePdfEncrypt( "", "podofo", PdfEncrypt::ePdfPermissions_Print,
+                                                        PdfEncrypt::ePdfEncryptAlgorithm_RC4V2,
+                                                        PdfEncrypt::ePdfKeyLength_128 ) );
+#endif // PODOFO_HAVE_OPENSSL_NO_RC4
+
+    for ( size_t nEncrypt = 0; nEncrypt < vecEncrypt.size(); nEncrypt++ ) {
+        PdfRefCountedBuffer buffer;
+        PdfOutputDevice device( &buffer );
+        {
+            PdfStreamedDocument doc( &device, ePdfVersion_1_5, vecEncrypt[nEncrypt] );
+            doc.SetStreamMemoryBudget( 30000 );
+
+            PdfObject* pContents = doc.GetObjects()->CreateObject();
+            pContents->GetStream()->BeginAppend();
+            for ( size_t i = 0; i < vecData.size(); i++ ) {
+                PdfObject* pObj = doc.GetObjects()->CreateObject();
+                TVecFilters vecFilters;
+                if ( i % 2 )
+                    vecFilters.push_back( ePdfFilter_FlateDecode );
+                pObj->GetStream()->Set( vecData[i].c_str(), vecData[i].size(), vecFilters );
+                pObj->GetDictionary().AddKey( "Index", static_cast<pdf_int64>(i) );
+
+                // only the first stream fits into the budget
+                PdfSpoolStream* pStream = dynamic_cast<PdfSpoolStream*>( pObj->GetStream() );
+                CPPUNIT_ASSERT( pStream );
+                CPPUNIT_ASSERT_EQUAL( i > 0, pStream->IsSpooled() );
+
+                pContents->GetStream()->Append( "0 0 m\n" );
+            }
+            pContents->GetStream()->EndAppend();
+            doc.Close();
+        }
+
+        PdfMemDocument reread;
+        reread.LoadFromBuffer( buffer.GetBuffer(), static_cast<long>(device.GetLength()) );
+
+        size_t nData = 0;
+        for ( size_t i = 0; i < reread.GetObjects().GetSize(); i++ ) {
+            PdfObject* pObj = reread.GetObjects()[i];
+            if ( !pObj->IsDictionary() || !pObj->GetDictionary().HasKey( "Index" ) )
+                continue;
+
+            pdf_long lLen;
+            char* pBuffer;
+            pObj->GetStream()->GetFilteredCopy( &pBuffer, &lLen );
+            std::string sData( pBuffer, lLen );
+            podofo_free( pBuffer );
+
+            CPPUNIT_ASSERT( vecData[static_cast<size_t>(pObj->GetDictionary().GetKey( "Index" )->GetNumber())] == sData );
+            ++nData;
+        }
+        CPPUNIT_ASSERT_EQUAL( vecData.size(), nData );
+
+        delete vecEncrypt[nEncrypt];
+    }
+}
+
+void StreamTest::testDeferredStreams()
+{
+    // the data of deferred streams is read from a file or an input stream
+    // only when the document is written
+    std::string sData;
+    unsigned int nRandom = 1;
+    for ( int i = 0; i < 100000; i++ ) {
+        nRandom = nRandom * 1103515245 + 12345;
+        sData += static_cast<char>( ( nRandom >> 16 ) & 0xff );
+    }
+
+    std::string sFilename = TestUtils::getTempFilename();
+    FILE* hFile = fopen( sFilename.c_str(), "wb" );
+    CPPUNIT_ASSERT( hFile != NULL );
+    fwrite( "head", 1, 4, hFile );
+    fwrite( sData.c_str(), 1, sData.size(), hFile );
+    fwrite( "tail", 1, 4, hFile );
+    fclose( hFile );
+
+    PdfRefCountedBuffer buffer;
+    PdfOutputDevice device( &buffer );
+    try {
+        PdfMemDocument doc;
+        TVecFilters vecFlate;
+        vecFlate.push_back( ePdfFilter_FlateDecode );
+
+        PdfObject* pObj = doc.GetObjects().CreateObject();
+        pObj->GetDictionary().AddKey( "Index", PdfVariant( static_cast<pdf_int64>(0) ) );
+        PdfDeferredStream* pStream = pObj->CreateDeferredStream();
+        pStream->SetSource( new PdfFileStreamSource( sFilename.c_str(), 4, sData.size() ), vecFlate );
+        CPPUNIT_ASSERT( pStream->HasSource() );
+
+        // the data can be read before the document is written
+        pdf_long lLen;
+        char* pBuffer;
+        pStream->GetFilteredCopy( &pBuffer, &lLen );
+        CPPUNIT_ASSERT( sData == std::string( pBuffer, lLen ) );
+        podofo_free( pBuffer );
+
+        pObj = doc.GetObjects().CreateObject();
+        pObj->GetDictionary().AddKey( "Index", PdfVariant( static_cast<pdf_int64>(1) ) );
+        pObj->CreateDeferredStream()->SetRawSource( new PdfFileStreamSource( sFilename.c_str(), 4, sData.size() ) );
+        CPPUNIT_ASSERT_EQUAL( static_cast<pdf_long>(sData.size()), pObj->GetStream()->GetLength() );
+
+        pObj = doc.GetObjects().CreateObject();
+        pObj->GetDictionary().AddKey( "Index", PdfVariant( static_cast<pdf_int64>(2) ) );
+        PdfInputStream* pInput = new PdfMemoryInputStream( sData.c_str(), sData.size() );
+        pObj->CreateDeferredStream()->SetSource( new PdfInputStreamSource( pInput ), vecFlate );
+
+        doc.Write( &device );
+    } catch( PdfError & e ) {
+        TestUtils::deleteFile( sFilename.c_str() );
+        throw e;
+    }
+    TestUtils::deleteFile( sFilename.c_str() );
+
+    PdfMemDocument reread;
+    reread.LoadFromBuffer( buffer.GetBuffer(), static_cast<long>(device.GetLength()) );
+
+    size_t nData = 0;
+    for ( size_t i = 0; i < reread.GetObjects().GetSize(); i++ ) {
+        PdfObject* pObj = reread.GetObjects()[i];
+        if ( !pObj->IsDictionary() || !pObj->GetDictionary().HasKey( "Index" ) )
+            continue;
+
+        // the streams are compressed unless their source is used raw
+        CPPUNIT_ASSERT_EQUAL( pObj->GetDictionary().GetKey( "Index" )->GetNumber() != 1,
+                              pObj->GetDictionary().HasKey( PdfName::KeyFilter ) );
+        CPPUNIT_ASSERT( pObj->GetDictionary().GetKey( PdfName::KeyLength )->IsReference() );
+
+        pdf_long lLen;
+        char* pBuffer;
+        pObj->GetStream()->GetFilteredCopy( &pBuffer, &lLen );
+        std::string sDecoded( pBuffer, lLen );
+        podofo_free( pBuffer );
+
+        CPPUNIT_ASSERT( sData == sDecoded );
+        ++nData;
+    }
+    CPPUNIT_ASSERT_EQUAL( static_cast<size_t>(3), nData );
+}
+
+void StreamTest::testDeferredStreamsLinearized()
+{
+    // a linearized PdfWriter writes all objects twice, but the source
+    // of a deferred stream is read and encoded only once
+    std::string sData;
+    for ( int i = 0; i < 10000; i++ )
+        sData += static_cast<char>( 'a' + i % 26 );
+
+    PdfMemDocument doc;
+    doc.CreatePage( PdfPage::CreateStandardPageSize( ePdfPageSize_A4 ) );
+
+    TVecFilters vecFlate;
+    vecFlate.push_back( ePdfFilter_FlateDecode );
+
+    PdfObject* pObj = doc.GetObjects().CreateObject();
+    pObj->GetDictionary().AddKey( "Index", PdfVariant( static_cast<pdf_int64>(0) ) );
+    PdfInputStream* pInput = new PdfMemoryInputStream( sData.c_str(), sData.size() );
+    pObj->CreateDeferredStream()->SetSource( new PdfInputStreamSource( pInput ), vecFlate );
+
+    PdfRefCountedBuffer buffer;
+    PdfOutputDevice device( &buffer );
+    PdfWriter writer( &doc.GetObjects(), doc.GetTrailer() );
+    writer.SetLinearized( true );
+    writer.Write( &device );
+
+    std::string sOutput( buffer.GetBuffer(), static_cast<size_t>(device.GetLength()) );
+    CPPUNIT_ASSERT( sOutput.find( "/Linearized" ) < 1024 );
+
+    PdfMemDocument reread;
+    reread.LoadFromBuffer( sOutput.c_str(), static_cast<long>(sOutput.size()) );
+
+    size_t nData = 0;
+    for ( size_t i = 0; i < reread.GetObjects().GetSize(); i++ ) {
+        pObj = reread.GetObjects()[i];
+        if ( !pObj->IsDictionary() || !pObj->GetDictionary().HasKey( "Index" ) )
+            continue;
+
+        pdf_long lLen;
+        char* pBuffer;
+        pObj->GetStream()->GetFilteredCopy( &pBuffer, &lLen );
+        std::string sDecoded( pBuffer, lLen );
+        podofo_free( pBuffer );
+
+        CPPUNIT_ASSERT( sData == sDecoded );
+        ++nData;
+    }
+    CPPUNIT_ASSERT_EQUAL( static_cast<size_t>(1), nData );
+}
+
+void StreamTest::testReplaceDeferredStream()
+{
+    // replacing a deferred stream by another one keeps its length object
+    PdfMemDocument doc;
+    PdfObject* pObj = doc.GetObjects().CreateObject();
+    pObj->CreateDeferredStream();
+    PdfReference lengthRef = pObj->GetDictionary().GetKey( PdfName::KeyLength )->GetReference();
+    size_t nObjects = doc.GetObjects().GetSize();
+
+    pObj->CreateDeferredStream();
+    CPPUNIT_ASSERT_EQUAL( nObjects, doc.GetObjects().GetSize() );
+    CPPUNIT_ASSERT( lengthRef == pObj->GetDictionary().GetKey( PdfName::KeyLength )->GetReference() );
+}
@@ -0,0 +1,50 @@
+/***************************************************************************
+ *   Copyright (C) 2007 by Dominik Seichter                                *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef _STREAM_TEST_H_
+#define _STREAM_TEST_H_
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <podofo.h>
+
+/** This test tests the PdfStream implementations
+ *  other than PdfMemStream
+ */
+class StreamTest : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE( StreamTest );
+  CPPUNIT_TEST( testStreamMemoryBudget );
+  CPPUNIT_TEST( testDeferredStreams );
+  CPPUNIT_TEST( testDeferredStreamsLinearized );
+  CPPUNIT_TEST( testReplaceDeferredStream );
+  CPPUNIT_TEST_SUITE_END();
+
+ public:
+  void setUp();
+  void tearDown();
+
+  void testStreamMemoryBudget();
+  void testDeferredStreams();
+  void testDeferredStreamsLinearized();
+  void testReplaceDeferredStream();
+};
+
+#endif // _STREAM_TEST_H_
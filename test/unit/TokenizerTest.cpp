@@ -138,7 +138,11 @@ void TokenizerTest::testNumbers()
     Test( "-2.970000", ePdfDataType_Real );
     Test( "0", ePdfDataType_Number );
     Test( "4.", ePdfDataType_Real, "4.000000" );
-
+    Test( "-.5", ePdfDataType_Real, "-0.500000" );
+    Test( "+12.", ePdfDataType_Real, "12.000000" );
+    Test( ".0078125", ePdfDataType_Real, "0.007812" );
+    Test( "123456789.987654321", ePdfDataType_Real, "123456789.987654" );
+    Test( "0.0000004", ePdfDataType_Real, "0.000000" );
 }
 
 void TokenizerTest::testReference()
@@ -208,6 +212,27 @@ void TokenizerTest::TestStream( const char* pszBuffer, const char* pszTokens[] )
 
     // We are at the end, so GetNextToken has to return false!
     CPPUNIT_ASSERT_EQUAL( tokenizer.GetNextToken( pszCur, &eType ), false );
+
+    // The same tokens have to be read in place from the buffer
+    PdfTokenizer  inPlace( pszBuffer, lLen );
+    size_t        lTokenLen;
+    for( i = 0; pszTokens[i]; i++ )
+    {
+        CPPUNIT_ASSERT_EQUAL( inPlace.GetNextTokenInPlace( pszCur, lTokenLen, &eType ), true );
+        CPPUNIT_ASSERT_EQUAL( std::string( pszCur, lTokenLen ), std::string( pszTokens[i] ) );
+    }
+    CPPUNIT_ASSERT_EQUAL( inPlace.GetNextTokenInPlace( pszCur, lTokenLen, &eType ), false );
+
+    // ... and from a device that is not held in memory
+    std::istringstream stream( std::string( pszBuffer, lLen ) );
+    PdfTokenizer  streamed( PdfRefCountedInputDevice( new PdfInputDevice( &stream ) ), 
+                            PdfRefCountedBuffer( 4096 ) );
+    for( i = 0; pszTokens[i]; i++ )
+    {
+        CPPUNIT_ASSERT_EQUAL( streamed.GetNextToken( pszCur, &eType ), true );
+        CPPUNIT_ASSERT_EQUAL( std::string( pszCur ), std::string( pszTokens[i] ) );
+    }
+    CPPUNIT_ASSERT_EQUAL( streamed.GetNextToken( pszCur, &eType ), false );
 }
 
 void TokenizerTest::TestStreamIsNextToken( const char* pszBuffer, const char* pszTokens[] )
@@ -262,3 +287,87 @@ void TokenizerTest::testLocale()
 
     setlocale( LC_ALL, old );
 }
+
+void TokenizerTest::testContiguousDevice()
+{
+    // Strings and hex strings are read in place from memory devices,
+    // the result has to be the same as for stream based devices
+    const char* pszBuffer = "[ (Hallo (Welt) \\) \\101\\n!) <41 42\n43 4> /Name%comment\r\n"
+                            "<< /Key (A\\\r\nB) >> 1 0 R 3.5 ]";
+    const size_t lLen = strlen( pszBuffer );
+
+    PdfVariant   inMemory;
+    PdfTokenizer memoryTokenizer( pszBuffer, lLen );
+    memoryTokenizer.GetNextVariant( inMemory, NULL );
+
+    PdfVariant         streamed;
+    std::istringstream stream( std::string( pszBuffer, lLen ) );
+    PdfTokenizer       streamTokenizer( PdfRefCountedInputDevice( new PdfInputDevice( &stream ) ), 
+                                        PdfRefCountedBuffer( 4096 ) );
+    streamTokenizer.GetNextVariant( streamed, NULL );
+
+    std::string sMemory;
+    std::string sStreamed;
+    inMemory.ToString( sMemory );
+    streamed.ToString( sStreamed );
+
+    CPPUNIT_ASSERT_EQUAL( sStreamed, sMemory );
+    CPPUNIT_ASSERT_EQUAL( static_cast<size_t>(6), inMemory.GetArray().size() );
+    CPPUNIT_ASSERT_EQUAL( std::string( "Hallo (Welt) ) A\n!" ), inMemory.GetArray()[0].GetString().GetStringUtf8() );
+    CPPUNIT_ASSERT_EQUAL( std::string( "ABC@" ), inMemory.GetArray()[1].GetString().GetStringUtf8() );
+}
+
+void TokenizerTest::testStreamedContents()
+{
+    // Contents streams are decoded while they are tokenized, which has
+    // to give the same result as tokenizing the decoded data in memory.
+    // The contents span many decode blocks and contain inline images.
+    std::ostringstream contents;
+    for( int i = 0; i < 2000; i++ )
+    {
+        contents << "q 1 0 0 1 " << i << " " << (i * 7) % 800 << " cm BT /F1 12 Tf ("
+                 << "Line " << i << ") Tj ET Q\n";
+        if( i % 250 == 0 )
+            contents << "BI /W 4 /H 1 /BPC 8 /CS /G ID \001EI\376 EI\nq Q\n";
+    }
+    const std::string sContents = contents.str();
+
+    PdfMemDocument doc;
+    PdfPage*       pPage = doc.CreatePage( PdfPage::CreateStandardPageSize( ePdfPageSize_A4 ) );
+    pPage->GetContents()->GetStream()->Set( sContents.c_str(), static_cast<pdf_long>(sContents.size()) );
+    CPPUNIT_ASSERT( pPage->GetContents()->GetStream()->GetLength() < static_cast<pdf_long>(sContents.size()) );
+
+    PdfContentsTokenizer streamed( pPage );
+    PdfContentsTokenizer inMemory( sContents.c_str(), static_cast<long>(sContents.size()) );
+
+    EPdfContentsType eStreamed, eInMemory;
+    const char*      pszStreamed;
+    const char*      pszInMemory;
+    PdfVariant       streamedVar, inMemoryVar;
+    int              nImages = 0;
+    while( inMemory.ReadNext( eInMemory, pszInMemory, inMemoryVar ) )
+    {
+        CPPUNIT_ASSERT( streamed.ReadNext( eStreamed, pszStreamed, streamedVar ) );
+        CPPUNIT_ASSERT_EQUAL( eInMemory, eStreamed );
+        if( eInMemory == ePdfContentsType_Keyword )
+        {
+            CPPUNIT_ASSERT_EQUAL( std::string( pszInMemory ), std::string( pszStreamed ) );
+        }
+        else
+        {
+            std::string sStreamed;
+            std::string sInMemory;
+            streamedVar.ToString( sStreamed );
+            inMemoryVar.ToString( sInMemory );
+            CPPUNIT_ASSERT_EQUAL( sInMemory, sStreamed );
+            if( eInMemory == ePdfContentsType_ImageData )
+            {
+                CPPUNIT_ASSERT_EQUAL( std::string( "\001EI\376 " ), sStreamed );
+                ++nImages;
+            }
+        }
+    }
+
+    CPPUNIT_ASSERT( !streamed.ReadNext( eStreamed, pszStreamed, streamedVar ) );
+    CPPUNIT_ASSERT_EQUAL( 8, nImages );
+}
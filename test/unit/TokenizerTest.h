@@ -47,6 +47,8 @@ class TokenizerTest : public CppUnit::TestFixture
   CPPUNIT_TEST( testComments );
   CPPUNIT_TEST( testDictionary );
   CPPUNIT_TEST( testLocale );
+  CPPUNIT_TEST( testContiguousDevice );
+  CPPUNIT_TEST( testStreamedContents );
   CPPUNIT_TEST_SUITE_END();
 
  public:
@@ -68,6 +70,10 @@ class TokenizerTest : public CppUnit::TestFixture
 
   void testLocale();
 
+  void testContiguousDevice();
+
+  void testStreamedContents();
+
  private:
   void Test( const char* pszString, PoDoFo::EPdfDataType eDataType, const char* pszExpected = NULL );
 
@@ -253,3 +253,37 @@ void VariantTest::testIsDirtyFalse()
     CPPUNIT_ASSERT_EQUAL( static_cast<long>(pStream->GetLength()), 9381L );
     CPPUNIT_ASSERT_EQUAL_MESSAGE( "STREAM    IsDirty() == false", false, parser.IsDirty() );
 }
+
+void VariantTest::testRealFormatting()
+{
+    const struct {
+        double      dValue;
+        const char* pszClean;
+        const char* pszCompact;
+    } tests[] = {
+        { 1.0,        "1.000000",     " 1"        },
+        { -2.5,       "-2.500000",    " -2.5"     },
+        { 0.0078125,  "0.007812",     " 0.007812" },
+        { -0.0,       "-0.000000",    " -0"       },
+        { 0.0000001,  "0.000000",     " 0"        },
+        { 612.125,    "612.125000",   " 612.125"  },
+        { 1e15,       "1000000000000000.000000", " 1000000000000000" },
+    };
+
+    for( size_t i=0;i<sizeof(tests)/sizeof(tests[0]);i++ ) 
+    {
+        std::string sClean;
+        std::string sCompact;
+        PdfVariant  variant( tests[i].dValue );
+
+        variant.ToString( sClean, ePdfWriteMode_Clean );
+        // Compact mode writes a separating space in front of numbers
+        variant.ToString( sCompact, ePdfWriteMode_Compact );
+        CPPUNIT_ASSERT_EQUAL( std::string( tests[i].pszClean ), sClean );
+        CPPUNIT_ASSERT_EQUAL( std::string( tests[i].pszCompact ), sCompact );
+
+        double dParsed = 0.0;
+        size_t lLen    = PdfLocaleParseReal( sClean.c_str(), sClean.length(), dParsed );
+        CPPUNIT_ASSERT_EQUAL( sClean.length(), lLen );
+    }
+}
@@ -33,6 +33,7 @@ class VariantTest : public CppUnit::TestFixture
   CPPUNIT_TEST( testNameObject );
   CPPUNIT_TEST( testIsDirtyTrue );
   CPPUNIT_TEST( testIsDirtyFalse );
+  CPPUNIT_TEST( testRealFormatting );
   CPPUNIT_TEST_SUITE_END();
 
  public:
@@ -46,6 +47,8 @@ class VariantTest : public CppUnit::TestFixture
   void testIsDirtyTrue();
   void testIsDirtyFalse();
 
+  void testRealFormatting();
+
  private:
 };
 
@@ -40,8 +40,6 @@ ImageExtractor::~ImageExtractor()
 
 void ImageExtractor::Init( const char* pszInput, const char* pszOutput, int* pnNum )
 {
-    PdfObject*  pObj  = NULL;
-
     if( !pszInput || !pszOutput )
     {
         PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
@@ -66,20 +64,13 @@ void ImageExtractor::Init( const char* pszInput, const char* pszOutput, int* pnN
             if( ( pObjType && pObjType->IsName() && ( pObjType->GetName().GetName() == "XObject" ) ) ||
                 ( pObjSubType && pObjSubType->IsName() && ( pObjSubType->GetName().GetName() == "Image" ) ) )
             {
-                pObj = (*it)->GetDictionary().GetKey( PdfName::KeyFilter );
-                if( pObj && pObj->IsArray() && pObj->GetArray().GetSize() == 1 && 
-                    pObj->GetArray()[0].IsName() && (pObj->GetArray()[0].GetName().GetName() == "DCTDecode") )
-                    pObj = &pObj->GetArray()[0];
-
-                if( pObj && pObj->IsName() && ( pObj->GetName().GetName() == "DCTDecode" ) )
-                {
-                    // The only filter is JPEG -> create a JPEG file
-                    ExtractImage( *it, true );
-                }
+                // Images encoded with an image codec are written to a file of
+                // that format, decoding only any filters applied on top of it
+                TVecFilters vecFilters = PdfFilterFactory::CreateFilterList( *it );
+                if( vecFilters.size() && PdfFilterFactory::IsImageCodec( vecFilters.back() ) )
+                    ExtractImage( *it, vecFilters.back() );
                 else
-                {
-                    ExtractImage( *it, false );
-                }
+                    ExtractImage( *it, ePdfFilter_None );
                 
                 document.FreeObjectMemory( *it );
             }
@@ -89,31 +80,40 @@ void ImageExtractor::Init( const char* pszInput, const char* pszOutput, int* pnN
     }
 }
 
-void ImageExtractor::ExtractImage( PdfObject* pObject, bool bJpeg )
+void ImageExtractor::ExtractImage( PdfObject* pObject, EPdfFilter eCodec )
 {
-    FILE*       hFile        = NULL;
-    const char* pszExtension = bJpeg ? "jpg" : "ppm"; 
+    const char* pszExtension;
+    switch( eCodec ) 
+    {
+        case ePdfFilter_DCTDecode:      pszExtension = "jpg";   break;
+        case ePdfFilter_JPXDecode:      pszExtension = "jp2";   break;
+        case ePdfFilter_JBIG2Decode:    pszExtension = "jbig2"; break;
+        case ePdfFilter_CCITTFaxDecode: pszExtension = "ccitt"; break;
+        default:                        pszExtension = "ppm";   break;
+    }
 
     // Do not overwrite existing files:
     do {
         snprintf( m_szBuffer, MAX_PATH, "%s/pdfimage_%04i.%s", m_pszOutputDirectory, m_nCount++, pszExtension );
     } while( FileExists( m_szBuffer ) );
 
-    hFile = fopen( m_szBuffer, "wb" );
-    if( !hFile )
-    {
-        PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
-    }
-
     printf("-> Writing image object %s to the file: %s\n", pObject->Reference().ToString().c_str(), m_szBuffer);
 
-    if( bJpeg ) 
+    if( eCodec != ePdfFilter_None ) 
     {
-        PdfMemStream* pStream = dynamic_cast<PdfMemStream*>(pObject->GetStream());
-        fwrite( pStream->Get(), pStream->GetLength(), sizeof(char), hFile );
+        // The encoded image is written as it is
+        PdfFileOutputStream stream( m_szBuffer );
+        pObject->GetStream()->GetEncodedImageCopy( &stream );
+        stream.Close();
     }
     else
     {
+        FILE* hFile = fopen( m_szBuffer, "wb" );
+        if( !hFile )
+        {
+            PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
+        }
+
         //long lBitsPerComponent = pObject->GetDictionary().GetKey( PdfName("BitsPerComponent" ) )->GetNumber();
         // TODO: Handle colorspaces
 
@@ -131,9 +131,9 @@ void ImageExtractor::ExtractImage( PdfObject* pObject, bool bJpeg )
         pObject->GetStream()->GetFilteredCopy( &pBuffer, &lLen );
         fwrite( pBuffer, lLen, sizeof(char), hFile );
         free( pBuffer );
-    }
 
-    fclose( hFile );
+        fclose( hFile );
+    }
 
     ++m_nSuccess;
 }
@@ -54,10 +54,12 @@ class ImageExtractor {
     /** Extracts the image form the given PdfObject
      *  which has to be an XObject with Subtype "Image"
      *  \param pObject a handle to a PDF object
-     *  \param bJpeg if true extract as a jpeg, otherwise create a ppm
+     *  \param eCodec if the image is encoded with an image codec like
+     *                DCTDecode it is extracted without decoding it,
+     *                for ePdfFilter_None a ppm is created
      *  \returns ErrOk on success
      */
-    void ExtractImage( PoDoFo::PdfObject* pObject, bool bJpeg );
+    void ExtractImage( PoDoFo::PdfObject* pObject, PoDoFo::EPdfFilter eCodec );
 
     /** This function checks wether a file with the 
      *  given filename does exist.